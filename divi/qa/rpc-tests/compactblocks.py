@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The DIVI developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#
+# Test relay of new blocks as compact blocks: nodes 0, 1 and 2 rebuild
+# them from their mempools, node 3 runs an older protocol version and
+# still gets full blocks.  Logs the bytes node 1 received for a block and
+# how long the block took to reach node 2.
+#
+
+from test_framework import BitcoinTestFramework
+from util import *
+import time
+
+class CompactBlocksTest(BitcoinTestFramework):
+
+    def setup_nodes(self):
+        args = [[], [], [], ["-protocolversion=70916"]]
+        return start_nodes(4, self.options.tmpdir, args)
+
+    def run_test(self):
+        self.nodes[0].setgenerate(30)
+        sync_blocks(self.nodes)
+
+        addresses = [node.getnewaddress() for node in self.nodes]
+        for i in range(100):
+            self.nodes[0].sendtoaddress(addresses[i % len(addresses)], 1)
+        sync_mempools(self.nodes)
+
+        bytesBefore = self.nodes[1].getnettotals()["totalbytesrecv"]
+        startTime = time.time()
+        blockHash = self.nodes[0].setgenerate(1)[0]
+        while self.nodes[2].getbestblockhash() != blockHash:
+            time.sleep(0.05)
+        propagationTime = time.time() - startTime
+        sync_blocks(self.nodes)
+        bytesReceived = self.nodes[1].getnettotals()["totalbytesrecv"] - bytesBefore
+
+        blockSize = len(self.nodes[0].getblock(blockHash, False)) // 2
+        print("Block of {} bytes and {} transactions, node 1 received {} bytes, reached node 2 in {:.3f}s".format(
+            blockSize, len(self.nodes[0].getblock(blockHash)["tx"]), bytesReceived, propagationTime))
+        assert_greater_than(blockSize // 2, bytesReceived)
+
+        for node in self.nodes:
+            assert_equal(node.getbestblockhash(), blockHash)
+            assert_equal(len(node.getrawmempool()), 0)
+
+if __name__ == '__main__':
+    CompactBlocksTest().main()
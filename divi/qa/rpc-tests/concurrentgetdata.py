@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The DIVI developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#
+# Test serving blocks from several message handler threads at once.
+# Node 0 keeps mining while nodes 1, 2 and 3 download its chain, so the
+# getdata handlers look up block status while new blocks are connected.
+# Every node has to end up with the same, fully readable chain.
+#
+
+from test_framework import BitcoinTestFramework
+from util import *
+
+class ConcurrentGetDataTest(BitcoinTestFramework):
+
+    def setup_network(self):
+        args = [["-msghandlerthreads=8"]] + [["-msghandlerthreads=4"]] * 3
+        self.nodes = start_nodes(4, self.options.tmpdir, args)
+        self.is_network_split = False
+
+    def run_test(self):
+        self.nodes[0].setgenerate(80)
+        for i in range(1, 4):
+            connect_nodes(self.nodes[i], 0)
+        for _ in range(20):
+            self.nodes[0].setgenerate(1)
+        sync_blocks(self.nodes)
+
+        bestBlock = self.nodes[0].getbestblockhash()
+        height = self.nodes[0].getblockcount()
+        assert_equal(height, 100)
+        for node in self.nodes[1:]:
+            assert_equal(node.getbestblockhash(), bestBlock)
+            for h in range(1, height + 1, 7):
+                blockHash = node.getblockhash(h)
+                assert_equal(node.getblock(blockHash, False), self.nodes[0].getblock(blockHash, False))
+            for peer in node.getpeerinfo():
+                assert_equal(peer.get("banscore", 0), 0)
+
+if __name__ == '__main__':
+    ConcurrentGetDataTest().main()
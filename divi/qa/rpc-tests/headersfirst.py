@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The DIVI developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#
+# Test headers-first sync on a proof-of-stake chain.  Node 3 starts out
+# disconnected and then downloads the chain of nodes 0, 1 and 2 from all
+# of them.  Afterwards node 0 stakes a fork off an earlier block, which
+# the other nodes only accept after checking every stake in full.  None
+# of this may cost a peer any ban score.
+#
+
+from test_framework import BitcoinTestFramework
+from util import *
+
+from PowToPosTransition import createPoSStacks, generatePoSBlocks
+
+class HeadersFirstTest(BitcoinTestFramework):
+
+    def setup_network(self):
+        self.nodes = start_nodes(4, self.options.tmpdir, [["-debug=net"]] * 4)
+        connect_nodes_bi(self.nodes, 0, 1)
+        connect_nodes_bi(self.nodes, 1, 2)
+        connect_nodes_bi(self.nodes, 0, 2)
+        self.is_network_split = False
+
+    def assert_no_ban_scores(self):
+        for node in self.nodes:
+            for peer in node.getpeerinfo():
+                assert_equal(peer.get("banscore", 0), 0)
+
+    def run_test(self):
+        stakers = self.nodes[:3]
+        createPoSStacks(stakers, stakers)
+        generatePoSBlocks(stakers, 0, 50)
+
+        bestBlock = self.nodes[0].getblockheader(self.nodes[0].getbestblockhash())
+        set_node_times(self.nodes, bestBlock["time"])
+        assert_equal(self.nodes[3].getblockcount(), 0)
+        for i in range(3):
+            connect_nodes(self.nodes[3], i)
+        sync_blocks(self.nodes)
+        assert_equal(self.nodes[3].getbestblockhash(), self.nodes[0].getbestblockhash())
+        assert_equal(len(self.nodes[3].getchaintips()), 1)
+        self.assert_no_ban_scores()
+
+        # Node 0 drops its last blocks and stakes a longer fork on top of
+        # their parent.  The fork does not extend the tip of the other nodes.
+        forkHeight = self.nodes[0].getblockcount() - 3
+        replacedTip = self.nodes[0].getbestblockhash()
+        self.nodes[0].invalidateblock(self.nodes[0].getblockhash(forkHeight + 1))
+        assert_equal(self.nodes[0].getblockcount(), forkHeight)
+        generatePoSBlocks(self.nodes, 0, 5)
+
+        forkTip = self.nodes[0].getbestblockhash()
+        for node in self.nodes:
+            assert_equal(node.getbestblockhash(), forkTip)
+            assert_equal(node.getblockcount(), forkHeight + 5)
+        tips = self.nodes[3].getchaintips()
+        assert_equal(len(tips), 2)
+        assert_equal(tips[1]["hash"], replacedTip)
+        assert_equal(tips[1]["status"], "valid-fork")
+        self.assert_no_ban_scores()
+
+if __name__ == '__main__':
+    HeadersFirstTest().main()
@@ -18,15 +18,17 @@ class RawTransactionsTest (BitcoinTestFramework):
         self.is_network_split = False
         self.sync_all ()
 
-    def find_output (self, node, value):
+    def find_output (self, node, value, exclude=[]):
         """
         Finds an unspent output owned by the node with the exact
-        desired value.  Asserts that one is available.
+        desired value, other than the ones in exclude.  Asserts that
+        one is available.
         """
 
         for u in node.listunspent ():
-            if u["amount"] == value:
-                return {"txid": u["txid"], "vout": u["vout"]}
+            coin = {"txid": u["txid"], "vout": u["vout"]}
+            if u["amount"] == value and coin not in exclude:
+                return coin
 
         raise AssertionError ("no output with value %s found" % str (value))
 
@@ -134,6 +136,44 @@ class RawTransactionsTest (BitcoinTestFramework):
         assert_equal (self.nodes[0].getbalance ("test"), 50)
         assert_equal (self.nodes[1].getbalance ("test"), 149)
 
+        # Submit a batch in which the second transaction spends the first
+        # and the third is not signed.
+        addr = self.nodes[0].getnewaddress ("batch")
+        script = self.nodes[0].validateaddress (addr)["scriptPubKey"]
+        parentCoin = self.find_output (self.nodes[0], 100)
+        parent = self.nodes[0].createrawtransaction ([parentCoin], {addr: 99})
+        parent = self.nodes[0].signrawtransaction (parent)["hex"]
+        parentTxid = self.nodes[0].decoderawtransaction (parent)["txid"]
+        prevout = {"txid": parentTxid, "vout": 0}
+        child = self.nodes[0].createrawtransaction ([prevout], {addr: 98})
+        prevout["scriptPubKey"] = script
+        child = self.nodes[0].signrawtransaction (child, [prevout])["hex"]
+        unsignedCoin = self.find_output (self.nodes[0], 100, [parentCoin])
+        unsigned = self.nodes[0].createrawtransaction ([unsignedCoin], {addr: 99})
+        results = self.nodes[0].sendrawtransactions ([parent, child, unsigned])
+        assert_equal ([r["accepted"] for r in results], [True, True, False])
+        assert_equal (results[0]["txid"], parentTxid)
+        assert "error" in results[2]
+        assert_equal (set (self.nodes[0].getrawmempool ()),
+                      set ([parentTxid, results[1]["txid"]]))
+        self.nodes[0].setgenerate ( 1)
+        sync_blocks (self.nodes)
+        assert_equal (self.nodes[0].getrawmempool (), [])
+
+        # A child is rejected together with its unsigned parent, also when
+        # the parent's scripts only fail after both entered the mempool.
+        unsignedParent = self.nodes[0].createrawtransaction ([unsignedCoin], {addr: 99})
+        unsignedParentTxid = self.nodes[0].decoderawtransaction (unsignedParent)["txid"]
+        prevout = {"txid": unsignedParentTxid, "vout": 0}
+        child = self.nodes[0].createrawtransaction ([prevout], {addr: 98})
+        prevout["scriptPubKey"] = script
+        child = self.nodes[0].signrawtransaction (child, [prevout])["hex"]
+        results = self.nodes[0].sendrawtransactions ([unsignedParent, child])
+        assert_equal ([r["accepted"] for r in results], [False, False])
+        assert "error" in results[0]
+        assert "error" in results[1]
+        assert_equal (self.nodes[0].getrawmempool (), [])
+
 
 if __name__ == '__main__':
     RawTransactionsTest ().main ()
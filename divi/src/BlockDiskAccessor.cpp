@@ -9,6 +9,10 @@
 #include <chainparams.h>
 #include <Logging.h>
 #include <BlockUndo.h>
+#include <defaultValues.h>
+#include <primitives/block.h>
+#include <protocol.h>
+#include <string.h>
 
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes)
@@ -73,4 +77,56 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex)
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*) : GetHash() doesn't match index");
     }
     return true;
-}
\ No newline at end of file
+}
+bool ReadRawBlockFromDisk(CDataStream& rawBlock, const CDiskBlockPos& pos)
+{
+    rawBlock.clear();
+
+    // The block is preceded by the index header written in WriteBlockToDisk
+    const unsigned int indexHeaderSize = MESSAGE_START_SIZE + sizeof(unsigned int);
+    if (pos.nPos < indexHeaderSize)
+        return error("%s : Invalid block position %u", __func__, pos.nPos);
+
+    // Open history file to read
+    CAutoFile filein(OpenBlockFile(CDiskBlockPos(pos.nFile, pos.nPos - indexHeaderSize), true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("ReadRawBlockFromDisk : OpenBlockFile failed");
+
+    try {
+        MessageStartChars messageStart;
+        unsigned int nSize;
+        filein >> FLATDATA(messageStart) >> nSize;
+        if (memcmp(messageStart, Params().MessageStart(), MESSAGE_START_SIZE) != 0)
+            return error("%s : Block magic mismatch at %u", __func__, pos.nPos);
+        if (nSize > MAX_BLOCK_SIZE_CURRENT)
+            return error("%s : Block size %u too large at %u", __func__, nSize, pos.nPos);
+
+        rawBlock.resize(nSize);
+        filein.read(&rawBlock[0], nSize);
+    } catch (std::exception& e) {
+        return error("%s : I/O error - %s", __func__, e.what());
+    }
+
+    return true;
+}
+
+bool ReadRawBlockFromDisk(CDataStream& rawBlock, const CBlockIndex* pindex)
+{
+    if (!ReadRawBlockFromDisk(rawBlock, pindex->GetBlockPos()))
+        return false;
+
+    // Only the header is deserialized, to check that this is the indexed block
+    CBlockHeader header;
+    const size_t rawBlockSize = rawBlock.size();
+    try {
+        rawBlock >> header;
+    } catch (std::exception& e) {
+        return error("%s : Deserialize error - %s", __func__, e.what());
+    }
+    rawBlock.Rewind(rawBlockSize - rawBlock.size());
+    if (header.GetHash() != pindex->GetBlockHash()) {
+        LogPrintf("%s : block=%s index=%s\n", __func__, header.GetHash(), pindex->GetBlockHash());
+        return error("ReadRawBlockFromDisk(CDataStream&, CBlockIndex*) : GetHash() doesn't match index");
+    }
+    return true;
+}
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <I_BlockDataReader.h>
 class CBlock;
+class CDataStream;
 struct CDiskBlockPos;
 class CBlockIndex;
 
@@ -11,4 +12,8 @@ bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex);
+/** Reads the serialized block as it is stored on disk, which is also its
+ *  network serialization, without deserializing the transactions.  */
+bool ReadRawBlockFromDisk(CDataStream& rawBlock, const CDiskBlockPos& pos);
+bool ReadRawBlockFromDisk(CDataStream& rawBlock, const CBlockIndex* pindex);
 #endif // BLOCK_DISK_ACCESSOR_H
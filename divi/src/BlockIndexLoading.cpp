@@ -17,6 +17,7 @@
 #include <ChainSyncHelpers.h>
 #include <clientversion.h>
 #include <coins.h>
+#include <LotteryCoinstakeScriptPool.h>
 #include <Settings.h>
 #include <streams.h>
 #include <TransactionLocationReference.h>
@@ -46,6 +47,7 @@ static void InitializeBlockIndexGlobalData(BlockMap& blockIndicesByHash)
     const std::vector<std::pair<int, CBlockIndex*> > heightSortedBlockIndices = ComputeHeightSortedBlockIndices(blockIndicesByHash);
     auto& blockIndexCandidates = GetBlockIndexCandidates();
     auto& blockIndexSuccessorsByPrevBlockIndex = GetBlockIndexSuccessorsByPreviousBlockIndex();
+    size_t lotteryCoinstakesUsage = 0u;
     for(const PAIRTYPE(int, CBlockIndex*) & item: heightSortedBlockIndices)
     {
         CBlockIndex* pindex = item.second;
@@ -71,9 +73,13 @@ static void InitializeBlockIndexGlobalData(BlockMap& blockIndicesByHash)
             CBlockIndex* pAncestor = pindex->GetAncestor(pindex->vLotteryWinnersCoinstakes.height());
             pindex->vLotteryWinnersCoinstakes.updateShallowDataStore(pAncestor->vLotteryWinnersCoinstakes);
         }
-        if (pindex->IsValid(BLOCK_VALID_TREE))
+        lotteryCoinstakesUsage += pindex->vLotteryWinnersCoinstakes.DynamicMemoryUsage();
+        if (pindex->IsValid(BLOCK_VALID_TREE) && !pindex->BlockProofIsPending())
             updateBestHeaderBlockIndex(pindex,false);
     }
+    const LotteryCoinstakeScriptPool& lotteryScripts = LotteryCoinstakeScriptPool::instance();
+    LogPrintf("%s: lottery winners use %u bytes, with %u interned payment scripts using %u bytes\n",
+        __func__, lotteryCoinstakesUsage, lotteryScripts.size(), lotteryScripts.DynamicMemoryUsage());
 }
 static bool VerifyAllBlockFilesArePresent(const BlockMap& blockIndicesByHash)
 {
@@ -86,6 +86,19 @@ public:
     }
 };
 
+CachedTransactionSelection::CachedTransactionSelection(
+    ): isValid(false)
+    , tipHash()
+    , mempoolTransactionsUpdated(0u)
+    , transactionsAndFees()
+{
+}
+
+bool CachedTransactionSelection::Matches(const uint256& currentTipHash, uint64_t currentTransactionsUpdated) const
+{
+    return isValid && tipHash == currentTipHash && mempoolTransactionsUpdated == currentTransactionsUpdated;
+}
+
 BlockMemoryPoolTransactionCollector::BlockMemoryPoolTransactionCollector(
     const Settings& settings,
     const CCoinsViewCache& baseCoinsViewCache,
@@ -103,6 +116,7 @@ BlockMemoryPoolTransactionCollector::BlockMemoryPoolTransactionCollector(
     , blockMaxSize_(GetMaxBlockSize(settings,DEFAULT_BLOCK_MAX_SIZE, MAX_BLOCK_SIZE_CURRENT))
     , blockPrioritySize_(GetBlockPrioritySize(settings,DEFAULT_BLOCK_PRIORITY_SIZE, blockMaxSize_))
     , blockMinSize_(GetBlockMinSize(settings,DEFAULT_BLOCK_MIN_SIZE, blockMaxSize_))
+    , cachedSelection_()
 {
     assert( blockMaxSize_ <= MAX_BLOCK_SIZE_CURRENT );
 }
@@ -110,13 +124,13 @@ BlockMemoryPoolTransactionCollector::BlockMemoryPoolTransactionCollector(
 void BlockMemoryPoolTransactionCollector::RecordOrphanTransaction(
     std::shared_ptr<COrphan>& porphan,
     const CTransaction& tx,
-    const CTxIn& txin,
+    const uint256& parentHash,
     DependingTransactionsMap& dependentTransactions) const
 {
     if (porphan == nullptr)
         porphan = std::make_shared<COrphan>(&tx);
-    dependentTransactions[txin.prevout.hash].push_back(porphan);
-    porphan->setDependsOn.insert(txin.prevout.hash);
+    dependentTransactions[parentHash].push_back(porphan);
+    porphan->setDependsOn.insert(parentHash);
 }
 
 void BlockMemoryPoolTransactionCollector::ComputeTransactionPriority(
@@ -192,44 +206,25 @@ void BlockMemoryPoolTransactionCollector::AddTransactionToBlock(
 std::vector<TxPriority> BlockMemoryPoolTransactionCollector::ComputeMempoolTransactionPriorities(
     const int& nHeight,
     DependingTransactionsMap& dependentTransactions,
-    const CCoinsViewCache& view) const
+    bool& skippedNonFinalTransactions) const
 {
     std::vector<TxPriority> vecPriority;
     vecPriority.reserve(mempool_.mapTx.size());
     for (auto mi = mempool_.mapTx.begin(); mi != mempool_.mapTx.end(); ++mi) {
-        const CTransaction& tx = mi->second.GetTx();
-        if (tx.IsCoinBase() || tx.IsCoinStake() || !IsFinalTx(mainCS_,tx, activeChain_, nHeight)){
+        const CTransaction& tx = mi->GetTx();
+        if (tx.IsCoinBase() || tx.IsCoinStake()){
             continue;
         }
-
-        std::shared_ptr<COrphan> porphan;
-        bool fMissingInputs = false;
-        for (const CTxIn& txin : tx.vin) {
-
-            // Read prev transaction
-            if (!view.HaveCoins(txin.prevout.hash)) {
-                CTransaction prevTx;
-                if(!mempool_.lookupOutpoint(txin.prevout.hash, prevTx)) {
-                    // This should never happen; all transactions in the memory
-                    // pool should connect to either transactions in the chain
-                    // or other transactions in the memory pool.
-                    LogPrintf("ERROR: %s - mempool transaction missing input\n",__func__);
-                    fMissingInputs = true;
-                    break;
-                }
-
-                // Has to wait for dependencies
-                RecordOrphanTransaction(porphan, tx, txin, dependentTransactions);
-                continue;
-            }
-
-            const CCoins* coins = view.AccessCoins(txin.prevout.hash);
-            assert(coins);
-        }
-        if (fMissingInputs) {
+        if (!IsFinalTx(mainCS_,tx, activeChain_, nHeight)){
+            skippedNonFinalTransactions = true;
             continue;
         }
-        ComputeTransactionPriority(mi->second, nHeight, porphan.get(), vecPriority);
+
+        // Transactions spending from the pool have to wait for their in-pool parents
+        std::shared_ptr<COrphan> porphan;
+        for (const auto& parent : mempool_.GetMemPoolParents(mi))
+            RecordOrphanTransaction(porphan, tx, parent->GetTx().GetHash(), dependentTransactions);
+        ComputeTransactionPriority(*mi, nHeight, porphan.get(), vecPriority);
     }
     return vecPriority;
 }
@@ -341,27 +336,56 @@ std::vector<PrioritizedTransactionData> BlockMemoryPoolTransactionCollector::Pri
     return prioritizedTransactions;
 }
 
-void BlockMemoryPoolTransactionCollector::AddTransactionsToBlockIfPossible(
+std::vector<PrioritizedTransactionData> BlockMemoryPoolTransactionCollector::SelectTransactionsForBlock(
     const int& nHeight,
     CCoinsViewCache& view,
-    CBlock& block) const
+    bool& skippedNonFinalTransactions) const
 {
     DependingTransactionsMap dependentTransactions;
 
     std::vector<TxPriority> vecPriority =
-        ComputeMempoolTransactionPriorities(nHeight, dependentTransactions, view);
+        ComputeMempoolTransactionPriorities(nHeight, dependentTransactions, skippedNonFinalTransactions);
 
-    std::vector<PrioritizedTransactionData> prioritizedTransactions =
-        PrioritizeTransactionsByBlockSpaceUsage(
+    return PrioritizeTransactionsByBlockSpaceUsage(
             vecPriority,
             nHeight,
             view,
             dependentTransactions);
+}
+
+void BlockMemoryPoolTransactionCollector::AddTransactionsToBlockIfPossible(
+    const int& nHeight,
+    CBlock& block) const
+{
+    // The selection only depends on the tip and the pool, so the staking
+    // loop can keep reusing it between blocks instead of rebuilding it.
+    // Transactions locked until a time can become final without either of
+    // them changing, so a selection that left any out is not kept.
+    const uint256 tipHash = activeChain_.Tip()->GetBlockHash();
+    const uint64_t mempoolTransactionsUpdated = mempool_.GetTransactionsUpdated();
+    if(!cachedSelection_.Matches(tipHash, mempoolTransactionsUpdated))
+    {
+        CCoinsViewCache view(&baseCoinsViewCache_);
+        bool skippedNonFinalTransactions = false;
+        const std::vector<PrioritizedTransactionData> prioritizedTransactions =
+            SelectTransactionsForBlock(nHeight, view, skippedNonFinalTransactions);
+
+        cachedSelection_.isValid = !skippedNonFinalTransactions;
+        cachedSelection_.tipHash = tipHash;
+        cachedSelection_.mempoolTransactionsUpdated = mempoolTransactionsUpdated;
+        cachedSelection_.transactionsAndFees.clear();
+        cachedSelection_.transactionsAndFees.reserve(prioritizedTransactions.size());
+        for(const PrioritizedTransactionData& txData: prioritizedTransactions)
+            cachedSelection_.transactionsAndFees.emplace_back(*txData.tx, txData.fee);
+    }
+    else
+    {
+        LogPrint("minting","%s: reusing %u cached transactions\n",__func__, cachedSelection_.transactionsAndFees.size());
+    }
 
-    for(const PrioritizedTransactionData& txData: prioritizedTransactions)
+    for(const auto& transactionAndFee: cachedSelection_.transactionsAndFees)
     {
-        const CTransaction& tx = *txData.tx;
-        AddTransactionToBlock(tx, txData.fee, block);
+        AddTransactionToBlock(transactionAndFee.first, transactionAndFee.second, block);
     }
     if(block.IsProofOfWork()) block.vtx[0] = CMutableTransaction(block.vtx[0]);
 }
@@ -375,9 +399,8 @@ bool BlockMemoryPoolTransactionCollector::CollectTransactionsIntoBlock(
     CBlock& block = pblocktemplate.block;
     if(block.vtx.size() < 1) return false; // Block reward transaction must be set first
     const int nHeight = pblocktemplate.previousBlockIndex->nHeight + 1;
-    CCoinsViewCache view(&baseCoinsViewCache_);
 
-    AddTransactionsToBlockIfPossible(nHeight, view, block);
+    AddTransactionsToBlockIfPossible(nHeight, block);
 
     LogPrint("minting","%s: block tostring %s\n",__func__, block);
     return true;
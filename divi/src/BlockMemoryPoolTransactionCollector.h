@@ -4,11 +4,14 @@
 #include <amount.h>
 #include <FeeRate.h>
 #include <uint256.h>
+#include <primitives/transaction.h>
 
 #include <list>
+#include <map>
 #include <memory>
 #include <set>
 #include <stdint.h>
+#include <utility>
 #include <vector>
 
 #include <boost/tuple/tuple.hpp>
@@ -71,6 +74,20 @@ public:
 class TxPriorityCompare;
 class CChain;
 
+/** The transactions last collected into a block template, reused for as long
+ *  as neither the chain tip nor the memory pool have changed since.  Never
+ *  valid for a selection that skipped non-final transactions.  */
+struct CachedTransactionSelection
+{
+    bool isValid;
+    uint256 tipHash;
+    uint64_t mempoolTransactionsUpdated;
+    std::vector<std::pair<CTransaction, CAmount>> transactionsAndFees;
+
+    CachedTransactionSelection();
+    bool Matches(const uint256& currentTipHash, uint64_t currentTransactionsUpdated) const;
+};
+
 class BlockMemoryPoolTransactionCollector: public I_BlockTransactionCollector
 {
 private:
@@ -85,12 +102,13 @@ private:
     const unsigned blockMaxSize_;
     const unsigned blockPrioritySize_;
     const unsigned blockMinSize_;
+    mutable CachedTransactionSelection cachedSelection_;
 
 private:
     void RecordOrphanTransaction(
         std::shared_ptr<COrphan>& porphan,
         const CTransaction& tx,
-        const CTxIn& txin,
+        const uint256& parentHash,
         DependingTransactionsMap& mapDependers) const;
 
     void ComputeTransactionPriority(
@@ -117,7 +135,7 @@ private:
     std::vector<TxPriority> ComputeMempoolTransactionPriorities(
         const int& nHeight,
         DependingTransactionsMap& mapDependers,
-        const CCoinsViewCache& view) const;
+        bool& skippedNonFinalTransactions) const;
 
     bool ShouldSwitchToPriotizationByFee(
         const uint64_t& currentBlockSize,
@@ -128,9 +146,12 @@ private:
         const int& nHeight,
         CCoinsViewCache& view,
         DependingTransactionsMap& mapDependers) const;
-    void AddTransactionsToBlockIfPossible(
+    std::vector<PrioritizedTransactionData> SelectTransactionsForBlock(
         const int& nHeight,
         CCoinsViewCache& view,
+        bool& skippedNonFinalTransactions) const;
+    void AddTransactionsToBlockIfPossible(
+        const int& nHeight,
         CBlock& block) const;
 public:
     BlockMemoryPoolTransactionCollector(
@@ -0,0 +1,19 @@
+#include <BlockProofDeferral.h>
+
+#include <chain.h>
+#include <defaultValues.h>
+
+bool BlockProofCanWaitForParent(const CChain& activeChain, const CBlockIndex* syncedHeader)
+{
+    if (syncedHeader == nullptr || syncedHeader->pprev == nullptr)
+        return false;
+
+    const CBlockIndex* parent = syncedHeader->pprev;
+    if (activeChain.Contains(parent) || (parent->nStatus & BLOCK_FAILED_MASK))
+        return false;
+
+    const CBlockIndex* tip = activeChain.Tip();
+    if (tip == nullptr || syncedHeader->nHeight > tip->nHeight + static_cast<int>(BLOCK_DOWNLOAD_WINDOW))
+        return false;
+    return syncedHeader->GetAncestor(tip->nHeight) == tip;
+}
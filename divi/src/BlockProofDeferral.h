@@ -0,0 +1,12 @@
+#ifndef BLOCK_PROOF_DEFERRAL_H
+#define BLOCK_PROOF_DEFERRAL_H
+class CBlockIndex;
+class CChain;
+
+/** Whether the stake of a block that arrives ahead of the active chain may be
+ *  checked once its parent is connected.  Only blocks whose header was synced
+ *  beforehand, that descend from the active tip and lie within the download
+ *  window qualify.  Blocks forking off below the active tip are checked in
+ *  full when they arrive.  */
+bool BlockProofCanWaitForParent(const CChain& activeChain, const CBlockIndex* syncedHeader);
+#endif// BLOCK_PROOF_DEFERRAL_H
@@ -170,4 +170,18 @@ bool BlockProofVerifier::verifyBlockProof(
     const CBlock& block) const
 {
     return CheckWork(chainParameters_,difficultyAdjuster_,posGenerator_,blockIndicesByHash_,settings_,block,chainTip);
-}
\ No newline at end of file
+}
+bool BlockProofVerifier::verifyBlockHeaderDifficulty(
+    const CBlockIndex* chainTip,
+    const CBlockHeader& blockHeader) const
+{
+    if (chainTip == NULL)
+        return error("%s : null pindexPrev for block %s", __func__, blockHeader.GetHash());
+
+    const unsigned int nBitsRequired = difficultyAdjuster_.computeNextBlockDifficulty(chainTip);
+    if(blockHeader.nBits != nBitsRequired) return false;
+    // The stake of a proof-of-stake header can only be checked with the block's coinstake
+    if(chainTip->nHeight + 1 <= chainParameters_.LAST_POW_BLOCK())
+        return CheckProofOfWork(blockHeader.GetHash(),blockHeader.nBits,chainParameters_);
+    return true;
+}
@@ -12,6 +12,7 @@ class I_ProofOfStakeGenerator;
 class BlockMap;
 class Settings;
 class CBlock;
+class CBlockHeader;
 class CBlockIndex;
 
 class BlockProofVerifier final: public I_BlockProofVerifier
@@ -32,5 +33,8 @@ public:
     bool verifyBlockProof(
         const CBlockIndex* chainTip,
         const CBlock& block) const override;
+    bool verifyBlockHeaderDifficulty(
+        const CBlockIndex* chainTip,
+        const CBlockHeader& blockHeader) const override;
 };
 #endif // BLOCK_PROOF_VERIFIER_H
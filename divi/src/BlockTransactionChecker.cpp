@@ -49,11 +49,31 @@ BlockTransactionChecker::BlockTransactionChecker(
     , state_(state)
     , pindex_(pindex)
     , view_(view)
+    , blockIndexMap_(blockIndexMap)
     , txInputChecker_(view_,blockIndexMap,state_)
+    , prevalidator_(block_)
     , txLocationRecorder_(pindex_,block_.vtx.size())
 {
 }
 
+namespace
+{
+
+template <typename Entry>
+void AppendEntries(const std::vector<Entry>& entries, std::vector<Entry>& destination)
+{
+    destination.insert(destination.end(), entries.begin(), entries.end());
+}
+
+void AppendIndexUpdates(const IndexDatabaseUpdates& updates, IndexDatabaseUpdates& destination)
+{
+    AppendEntries(updates.addressIndex, destination.addressIndex);
+    AppendEntries(updates.addressUnspentIndex, destination.addressUnspentIndex);
+    AppendEntries(updates.spentIndex, destination.spentIndex);
+}
+
+} // anonymous namespace
+
 bool BlockTransactionChecker::CheckCoinstakeForVaults(
     const CTransaction& tx,
     const CBlockRewards& expectedRewards,
@@ -120,6 +140,8 @@ bool BlockTransactionChecker::Check(const CBlockRewards& nExpectedMint, IndexDat
     if (activation_.IsActive(Fork::LimitTransferVerify))
         flags |= SCRIPT_VERIFY_LIMIT_TRANSFER;
 
+    prevalidator_.Prevalidate(pindex_, view_, blockIndexMap_, flags, nExpectedMint, indexDatabaseUpdates);
+
     for (unsigned int i = 0; i < block_.vtx.size(); i++) {
         const CTransaction& tx = block_.vtx[i];
         const TransactionLocationReference txLocationRef(tx, pindex_->nHeight, i);
@@ -133,20 +155,46 @@ bool BlockTransactionChecker::Check(const CBlockRewards& nExpectedMint, IndexDat
         {
             return false;
         }
-        if(!txInputChecker_.CheckInputsAndUpdateCoinSupplyRecords(tx, flags, pindex_))
+        BlockTransactionPrevalidator::Result* prevalidated = prevalidator_.GetResult(i);
+        if(prevalidated != nullptr)
         {
-            return false;
+            // The pre-block coins were checked; InputsAreValid above made sure
+            // no earlier transaction of this block spent them since
+            if(!prevalidated->inputsAreValid)
+            {
+                state_ = prevalidated->state;
+                return false;
+            }
+            TransactionInputChecker::RecordCoinSupplyChange(tx, prevalidated->inputAmount, pindex_);
+            txInputChecker_.ScheduleBackgroundThreadScriptChecking(prevalidated->scriptChecks);
         }
-        if (!tx.IsCoinBase())
+        else
         {
-            txInputChecker_.ScheduleBackgroundThreadScriptChecking();
+            if(!txInputChecker_.CheckInputsAndUpdateCoinSupplyRecords(tx, flags, pindex_))
+            {
+                return false;
+            }
+            if (!tx.IsCoinBase())
+            {
+                txInputChecker_.ScheduleBackgroundThreadScriptChecking();
+            }
         }
-        if (!CheckCoinstakeForVaults(tx, nExpectedMint, view_)) {
+        const bool vaultCoinstakeIsValid = prevalidated != nullptr
+            ? prevalidated->vaultCoinstakeIsValid
+            : CheckCoinstakeForVaults(tx, nExpectedMint, view_);
+        if (!vaultCoinstakeIsValid) {
             return state_.DoS(100, error("%s : coinstake is invalid for vault",__func__),
                             REJECT_INVALID, "bad-coinstake-vault-spend");
         }
 
-        IndexDatabaseUpdateCollector::RecordTransaction(tx,txLocationRef,view_, indexDatabaseUpdates);
+        if(prevalidated != nullptr)
+        {
+            AppendIndexUpdates(prevalidated->indexDatabaseUpdates, indexDatabaseUpdates);
+        }
+        else
+        {
+            IndexDatabaseUpdateCollector::RecordTransaction(tx,txLocationRef,view_, indexDatabaseUpdates);
+        }
         view_.UpdateWithConfirmedTransaction(tx,pindex_->nHeight, blockundo_.vtxundo[i>0u? i-1: 0u]);
         txLocationRecorder_.RecordTxLocationData(tx,indexDatabaseUpdates.txLocationData);
     }
@@ -8,6 +8,7 @@
 #include <ForkActivation.h>
 #include <TransactionInputChecker.h>
 #include <IndexDatabaseUpdates.h>
+#include <BlockTransactionPrevalidator.h>
 
 class BlockMap;
 class CBlockIndex;
@@ -41,7 +42,9 @@ private:
     CValidationState& state_;
     CBlockIndex* pindex_;
     CCoinsViewCache& view_;
+    const BlockMap& blockIndexMap_;
     TransactionInputChecker txInputChecker_;
+    BlockTransactionPrevalidator prevalidator_;
     TransactionLocationRecorder txLocationRecorder_;
 
 public:
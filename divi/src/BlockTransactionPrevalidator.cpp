@@ -0,0 +1,251 @@
+#include <BlockTransactionPrevalidator.h>
+
+#include <BlockTransactionChecker.h>
+#include <IndexDatabaseUpdateCollector.h>
+#include <Logging.h>
+#include <TransactionInputChecker.h>
+#include <TransactionLocationReference.h>
+#include <ThreadManagementHelpers.h>
+#include <UtxoCheckingAndUpdating.h>
+#include <chain.h>
+#include <checkqueue.h>
+#include <coins.h>
+#include <defaultValues.h>
+#include <primitives/block.h>
+#include <utiltime.h>
+
+#include <map>
+#include <set>
+#include <boost/thread.hpp>
+
+namespace
+{
+
+/** Read-only view of the coins spent by the prevalidated transactions, as
+ *  they were before the block.  The entries point into the coins cache the
+ *  block is connected on, which must not be modified while checks run.  */
+class PreBlockCoinsSnapshot final: public CCoinsView
+{
+private:
+    const uint256 bestBlock_;
+    std::map<uint256, const CCoins*> coins_;
+
+public:
+    explicit PreBlockCoinsSnapshot(const uint256& bestBlock): bestBlock_(bestBlock), coins_()
+    {
+    }
+
+    bool Add(const CCoinsViewCache& view, const uint256& txid)
+    {
+        if (coins_.count(txid) > 0)
+            return true;
+        const CCoins* coins = view.AccessCoins(txid);
+        if (coins == nullptr)
+            return false;
+        coins_[txid] = coins;
+        return true;
+    }
+
+    bool GetCoins(const uint256& txid, CCoins& coins) const override
+    {
+        const auto it = coins_.find(txid);
+        if (it == coins_.end())
+            return false;
+        coins = *it->second;
+        return true;
+    }
+
+    bool HaveCoins(const uint256& txid) const override
+    {
+        return coins_.count(txid) > 0;
+    }
+
+    uint256 GetBestBlock() const override
+    {
+        return bestBlock_;
+    }
+
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override
+    {
+        return false;
+    }
+};
+
+struct PrevalidationContext
+{
+    const CBlock& block;
+    const CBlockIndex* pindex;
+    const PreBlockCoinsSnapshot& snapshot;
+    const BlockMap& blockIndexMap;
+    const unsigned flags;
+    const CBlockRewards& expectedRewards;
+    const std::vector<std::unique_ptr<BlockTransactionPrevalidator::Result>>& results;
+};
+
+class TransactionPrevalidationCheck
+{
+private:
+    const PrevalidationContext* context_;
+    unsigned transactionIndex_;
+
+public:
+    TransactionPrevalidationCheck(): context_(nullptr), transactionIndex_(0u)
+    {
+    }
+    TransactionPrevalidationCheck(
+        const PrevalidationContext& context,
+        unsigned transactionIndex
+        ): context_(&context)
+        , transactionIndex_(transactionIndex)
+    {
+    }
+
+    bool operator()()
+    {
+        const CTransaction& tx = context_->block.vtx[transactionIndex_];
+        BlockTransactionPrevalidator::Result& result = *context_->results[transactionIndex_];
+
+        CCoinsViewCache view(&context_->snapshot);
+        CAmount txFees = 0;
+        result.inputsAreValid = CheckInputs(
+            tx, result.state, view, context_->blockIndexMap, txFees, result.inputAmount,
+            true, context_->flags, &result.scriptChecks, true);
+        if (result.inputsAreValid)
+        {
+            result.vaultCoinstakeIsValid = BlockTransactionChecker::CheckCoinstakeForVaults(tx, context_->expectedRewards, view);
+            const TransactionLocationReference txLocationRef(tx, context_->pindex->nHeight, transactionIndex_);
+            IndexDatabaseUpdateCollector::RecordTransaction(tx, txLocationRef, view, result.indexDatabaseUpdates);
+        }
+        // Failures are reported by the serial pass, in block order
+        return true;
+    }
+
+    void swap(TransactionPrevalidationCheck& other)
+    {
+        std::swap(context_, other.context_);
+        std::swap(transactionIndex_, other.transactionIndex_);
+    }
+};
+
+CCheckQueue<TransactionPrevalidationCheck> prevalidationqueue(4, MAX_SCRIPTCHECK_THREADS);
+
+void ThreadTransactionPrevalidation()
+{
+    RenameThread("divi-txprecheck");
+    prevalidationqueue.Thread();
+}
+
+} // anonymous namespace
+
+BlockTransactionPrevalidator::Result::Result(
+    const IndexDatabaseUpdates& indexingOptions
+    ): state()
+    , inputsAreValid(false)
+    , vaultCoinstakeIsValid(false)
+    , inputAmount(0)
+    , scriptChecks()
+    , indexDatabaseUpdates(
+        indexingOptions.blockIndex_,
+        indexingOptions.addressIndexingEnabled_,
+        indexingOptions.spentIndexingEnabled_)
+{
+}
+
+void BlockTransactionPrevalidator::InitializeThreads(boost::thread_group& threadGroup)
+{
+    for (int i = 0; i < TransactionInputChecker::GetScriptCheckingThreadCount() - 1; i++)
+        threadGroup.create_thread(&ThreadTransactionPrevalidation);
+}
+
+bool BlockTransactionPrevalidator::ShouldRunInParallel(unsigned numberOfIndependentTransactions)
+{
+    return TransactionInputChecker::GetScriptCheckingThreadCount() > 0 &&
+        numberOfIndependentTransactions >= MIN_TRANSACTIONS_FOR_PARALLEL_PREVALIDATION;
+}
+
+BlockTransactionPrevalidator::BlockTransactionPrevalidator(
+    const CBlock& block
+    ): block_(block)
+    , results_()
+{
+}
+
+BlockTransactionPrevalidator::~BlockTransactionPrevalidator()
+{
+}
+
+void BlockTransactionPrevalidator::Prevalidate(
+    const CBlockIndex* pindex,
+    const CCoinsViewCache& view,
+    const BlockMap& blockIndexMap,
+    unsigned flags,
+    const CBlockRewards& expectedRewards,
+    const IndexDatabaseUpdates& indexingOptions)
+{
+    results_.clear();
+    if (!ShouldRunInParallel(block_.vtx.size()))
+        return;
+
+    const int64_t nTimeStart = GetTimeMicros();
+    std::set<uint256> blockTxids;
+    std::map<COutPoint, unsigned> numberOfSpendsByOutpoint;
+    for (const CTransaction& tx : block_.vtx) {
+        blockTxids.insert(tx.GetHash());
+        if (tx.IsCoinBase())
+            continue;
+        for (const CTxIn& input : tx.vin)
+            ++numberOfSpendsByOutpoint[input.prevout];
+    }
+
+    // Only transactions whose inputs all existed before the block, and are
+    // spent by no other transaction of the block, can be checked out of
+    // order; everything else stays with the serial pass, which sees the
+    // coins in block order and rejects double spends.
+    PreBlockCoinsSnapshot snapshot(view.GetBestBlock());
+    std::vector<unsigned> independentTransactions;
+    for (unsigned i = 0; i < block_.vtx.size(); i++) {
+        const CTransaction& tx = block_.vtx[i];
+        if (tx.IsCoinBase())
+            continue;
+        bool isIndependent = true;
+        for (const CTxIn& input : tx.vin) {
+            if (blockTxids.count(input.prevout.hash) > 0 ||
+                numberOfSpendsByOutpoint[input.prevout] > 1u ||
+                !snapshot.Add(view, input.prevout.hash)) {
+                isIndependent = false;
+                break;
+            }
+        }
+        if (isIndependent)
+            independentTransactions.push_back(i);
+    }
+    if (!ShouldRunInParallel(independentTransactions.size()))
+        return;
+
+    results_.resize(block_.vtx.size());
+    std::vector<TransactionPrevalidationCheck> checks;
+    checks.reserve(independentTransactions.size());
+    const PrevalidationContext context = {block_, pindex, snapshot, blockIndexMap, flags, expectedRewards, results_};
+    for (const unsigned transactionIndex : independentTransactions) {
+        results_[transactionIndex].reset(new Result(indexingOptions));
+        checks.emplace_back(context, transactionIndex);
+    }
+
+    CCheckQueueControl<TransactionPrevalidationCheck> control(&prevalidationqueue);
+    control.Add(checks);
+    control.Wait();
+
+    CCheckQueueRoundStats stats;
+    if (control.GetRoundStats(stats))
+    {
+        LogPrint("bench", "    - Prevalidate %u of %u txs: %.2fms, parallelism %.2f of %u threads\n",
+            stats.nChecks, block_.vtx.size(), (GetTimeMicros() - nTimeStart) * 0.001, stats.Parallelism(), stats.nThreads);
+    }
+}
+
+BlockTransactionPrevalidator::Result* BlockTransactionPrevalidator::GetResult(unsigned transactionIndex) const
+{
+    if (transactionIndex >= results_.size())
+        return nullptr;
+    return results_[transactionIndex].get();
+}
@@ -0,0 +1,70 @@
+#ifndef BLOCK_TRANSACTION_PREVALIDATOR_H
+#define BLOCK_TRANSACTION_PREVALIDATOR_H
+#include <memory>
+#include <vector>
+
+#include <amount.h>
+#include <IndexDatabaseUpdates.h>
+#include <scriptCheck.h>
+#include <ValidationState.h>
+
+class BlockMap;
+class CBlock;
+class CBlockIndex;
+class CBlockRewards;
+class CCoinsViewCache;
+
+namespace boost
+{
+class thread_group;
+} // namespace boost
+
+/** Runs the contextual checks of a block's transactions that only read coins
+ *  created before the block (input amounts, fees, maturity, vault coinstake
+ *  rules, script check setup and address/spent index collection) on several
+ *  threads, ahead of the serial pass that updates the coins view.  Transactions
+ *  spending outputs of the same block, and the coinbase, are left to the
+ *  serial pass.  */
+class BlockTransactionPrevalidator
+{
+public:
+    struct Result
+    {
+        CValidationState state;
+        bool inputsAreValid;
+        bool vaultCoinstakeIsValid;
+        CAmount inputAmount;
+        std::vector<CScriptCheck> scriptChecks;
+        IndexDatabaseUpdates indexDatabaseUpdates;
+
+        explicit Result(const IndexDatabaseUpdates& indexingOptions);
+    };
+
+private:
+    const CBlock& block_;
+    std::vector<std::unique_ptr<Result>> results_;
+
+    static bool ShouldRunInParallel(unsigned numberOfIndependentTransactions);
+
+public:
+    static void InitializeThreads(boost::thread_group& threadGroup);
+
+    explicit BlockTransactionPrevalidator(const CBlock& block);
+    ~BlockTransactionPrevalidator();
+
+    /** Must be called before the view is modified for this block. Does
+     *  nothing when there are too few independent transactions or no
+     *  script checking threads to spread them over.  */
+    void Prevalidate(
+        const CBlockIndex* pindex,
+        const CCoinsViewCache& view,
+        const BlockMap& blockIndexMap,
+        unsigned flags,
+        const CBlockRewards& expectedRewards,
+        const IndexDatabaseUpdates& indexingOptions);
+
+    /** Returns the checks done ahead of time for the given transaction, or
+     *  null if the serial pass has to do them.  */
+    Result* GetResult(unsigned transactionIndex) const;
+};
+#endif// BLOCK_TRANSACTION_PREVALIDATOR_H
@@ -0,0 +1,43 @@
+#ifndef BLOCK_TRANSACTIONS_H
+#define BLOCK_TRANSACTIONS_H
+#include <primitives/transaction.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <vector>
+
+/** Asks for the transactions of a compact block that could not be found
+ *  in the mempool, by their index in the block ("getblocktxn").  */
+struct BlockTransactionsRequest
+{
+    uint256 blockHash;
+    std::vector<uint32_t> indices;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(blockHash);
+        READWRITE(indices);
+    }
+};
+
+/** The answer to a BlockTransactionsRequest, with the transactions in the
+ *  order they were asked for ("blocktxn").  */
+struct BlockTransactions
+{
+    uint256 blockHash;
+    std::vector<CTransaction> transactions;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(blockHash);
+        READWRITE(transactions);
+    }
+};
+#endif// BLOCK_TRANSACTIONS_H
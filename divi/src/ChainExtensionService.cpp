@@ -22,6 +22,9 @@
 #include <txdb.h>
 #include <BlockIndexLotteryUpdater.h>
 #include <I_BlockProofVerifier.h>
+#include <BlockProofDeferral.h>
+#include <CoinsPrefetcher.h>
+#include <timedata.h>
 
 #include <StakeModifierIntervalHelpers.h>
 #include <ForkActivation.h>
@@ -210,7 +213,6 @@ void SetStakeModifiersForNewBlockIndex(const BlockMap& blockIndicesByHash, CBloc
 
 CBlockIndex* AddToBlockIndex(
     ChainstateManager& chainstate,
-    const BlockIndexLotteryUpdater& lotteryUpdater,
     const CChainParams& chainParameters,
     const CSporkManager& sporkManager,
     const CBlock& block)
@@ -230,6 +232,8 @@ CBlockIndex* AddToBlockIndex(
     // to avoid miners withholding blocks but broadcasting headers, to get a
     // competitive advantage.
     pindexNew->nSequenceId = 0;
+    // Readers without cs_main must not see the new entry before it is linked
+    boost::unique_lock<boost::shared_mutex> blockIndexLock(chainstate.BlockIndexAccess());
     const auto mi = blockMap.insert(std::make_pair(hash, pindexNew)).first;
 
     pindexNew->phashBlock = &((*mi).first);
@@ -242,6 +246,14 @@ CBlockIndex* AddToBlockIndex(
         //update previous block pointer
         pindexNew->pprev->pnext = pindexNew;
 
+        // Headers carry no coinstake, the block type follows from the height.
+        // Their stake is checked with the block, AcceptBlock clears the flag
+        // for blocks whose stake it has checked already.
+        if (pindexNew->nHeight > chainParameters.LAST_POW_BLOCK()) {
+            pindexNew->SetProofOfStake();
+            pindexNew->SetBlockProofPending(true);
+        }
+
         // ppcoin: compute chain trust score
         pindexNew->bnChainTrust = (pindexNew->pprev ? pindexNew->pprev->bnChainTrust : 0) + pindexNew->GetBlockTrust();
 
@@ -252,25 +264,49 @@ CBlockIndex* AddToBlockIndex(
         // ppcoin: compute stake modifier
         SetStakeModifiersForNewBlockIndex(blockMap, pindexNew);
     }
+    blockIndexLock.unlock();
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + pindexNew->getBlockProof();
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
-    updateBestHeaderBlockIndex(pindexNew,true);
+    // Forged stakes cost nothing, only checked headers may become the best header
+    if (!pindexNew->BlockProofIsPending())
+        updateBestHeaderBlockIndex(pindexNew,true);
 
     //update previous block pointer
     if (pindexNew->nHeight)
         pindexNew->pprev->pnext = pindexNew;
 
-    lotteryUpdater.UpdateBlockIndexLotteryWinners(block,pindexNew);
+    // Lottery winners need the block's coinstake, they are computed once the data arrives
+    pindexNew->SetLotteryWinnersPending(true);
 
     BlockFileHelpers::RecordDirtyBlockIndex(pindexNew);
 
     return pindexNew;
 }
 
+void UpdateLotteryWinnersIfParentIsKnown(
+    const BlockIndexLotteryUpdater& lotteryUpdater,
+    const CBlock& block,
+    CBlockIndex* pindex)
+{
+    if (!pindex->LotteryWinnersArePending())
+        return;
+    const CBlockIndex* pindexPrev = pindex->pprev;
+    if (pindexPrev != NULL && pindexPrev->LotteryWinnersArePending())
+        return;
+
+    lotteryUpdater.UpdateBlockIndexLotteryWinners(block,pindex);
+    pindex->SetLotteryWinnersPending(false);
+    BlockFileHelpers::RecordDirtyBlockIndex(pindex);
+}
+
 bool ReceivedBlockTransactions(const CChain& chain, const CBlock& block, CBlockIndex* pindexNew, const CDiskBlockPos& pos)
 {
     if (block.IsProofOfStake())
+    {
         pindexNew->SetProofOfStake();
+        pindexNew->prevoutStake = block.vtx[1].vin[0].prevout;
+        pindexNew->nStakeTime = block.nTime;
+    }
     pindexNew->nTx = block.vtx.size();
     pindexNew->nChainTx = 0;
     pindexNew->nFile = pos.nFile;
@@ -382,7 +418,6 @@ bool ContextualCheckBlock(CCriticalSection& mainCriticalSection,const CChain& ch
 
 bool AcceptBlockHeader(
     CCriticalSection& mainCriticalSection,
-    const BlockIndexLotteryUpdater& blockIndexLotteryUpdater,
     const CChainParams& chainParameters,
     const Settings& settings,
     const CBlock& block,
@@ -420,7 +455,7 @@ bool AcceptBlockHeader(
         pindexPrev = (*mi).second;
         if (pindexPrev->nStatus & BLOCK_FAILED_MASK)
         {
-            return state.DoS(100, error("%s : prev block height=%d hash=%s is invalid, unable to add block %s", __func__, pindexPrev->nHeight, block.hashPrevBlock, block.GetHash()),
+            return state.DoS(100, error("%s : prev block height=%d hash=%s is invalid, unable to add block %s", __func__, pindexPrev->nHeight, block.hashPrevBlock, hash),
                              REJECT_INVALID, "bad-prevblk");
         }
 
@@ -430,7 +465,7 @@ bool AcceptBlockHeader(
         return false;
 
     if (pindex == NULL)
-        pindex = AddToBlockIndex(chainstate, blockIndexLotteryUpdater,chainParameters,sporkManager, block);
+        pindex = AddToBlockIndex(chainstate,chainParameters,sporkManager, block);
 
     if (ppindex)
         *ppindex = pindex;
@@ -456,32 +491,42 @@ bool AcceptBlock(
     const auto& blockMap = chainstate.GetBlockMap();
 
     CBlockIndex*& pindex = *ppindex;
+    const uint256 blockHash = block.GetHash();
 
     // Get prev block index
     CBlockIndex* pindexPrev = NULL;
-    if (block.GetHash() != chainParameters.HashGenesisBlock()) {
+    if (blockHash != chainParameters.HashGenesisBlock()) {
         const auto mi = blockMap.find(block.hashPrevBlock);
         if (mi == blockMap.end())
             return state.DoS(0, error("%s : prev block %s not found", __func__, block.hashPrevBlock), 0, "bad-prevblk");
         pindexPrev = (*mi).second;
         if (pindexPrev->nStatus & BLOCK_FAILED_MASK)
         {
-            return state.DoS(100, error("%s : prev block %s is invalid, unable to add block %s", __func__, block.hashPrevBlock, block.GetHash()),
+            return state.DoS(100, error("%s : prev block %s is invalid, unable to add block %s", __func__, block.hashPrevBlock, blockHash),
                              REJECT_INVALID, "bad-prevblk");
         }
     }
 
-    const uint256 blockHash = block.GetHash();
+    // The stake of a block can only be looked up once its parent is connected.
+    // Blocks synced as headers and downloaded ahead of the active tip are
+    // checked when they are connected, all others are checked here.
+    bool proofIsPending = false;
     if (blockHash != chainParameters.HashGenesisBlock())
     {
-        if(!blockProofVerifier.verifyBlockProof(pindexPrev,block))
+        const auto syncedHeader = blockMap.find(blockHash);
+        proofIsPending = syncedHeader != blockMap.end() &&
+            BlockProofCanWaitForParent(chainstate.ActiveChain(), syncedHeader->second);
+        const bool proofIsValid = proofIsPending
+            ? blockProofVerifier.verifyBlockHeaderDifficulty(pindexPrev,block)
+            : blockProofVerifier.verifyBlockProof(pindexPrev,block);
+        if(!proofIsValid)
         {
             LogPrintf("WARNING: %s: check difficulty check failed for %s block %s\n",__func__, block.IsProofOfWork()?"PoW":"PoS", blockHash);
             return false;
         }
     }
 
-    if (!AcceptBlockHeader(mainCriticalSection, blockIndexLotteryUpdater, chainParameters, settings, block, chainstate, sporkManager, state, &pindex))
+    if (!AcceptBlockHeader(mainCriticalSection, chainParameters, settings, block, chainstate, sporkManager, state, &pindex))
         return false;
 
     if (pindex->nStatus & BLOCK_HAVE_DATA) {
@@ -489,6 +534,8 @@ bool AcceptBlock(
         // return state.DoS(20, error("AcceptBlock() : already have block %d %s", pindex->nHeight, pindex->GetBlockHash()), REJECT_DUPLICATE, "duplicate");
         return true;
     }
+    pindex->SetBlockProofPending(proofIsPending);
+    UpdateLotteryWinnersIfParentIsKnown(blockIndexLotteryUpdater, block, pindex);
 
     if (!ContextualCheckBlock(mainCriticalSection,chainstate.ActiveChain(), block, state, pindex->pprev))
     {
@@ -498,6 +545,8 @@ bool AcceptBlock(
         }
         return false;
     }
+    if (!proofIsPending)
+        updateBestHeaderBlockIndex(pindex,true);
 
     int nHeight = pindex->nHeight;
 
@@ -549,6 +598,8 @@ bool ChainExtensionService::transitionToMostWorkChainTip(
             if (pindexMostWork == NULL || pindexMostWork == chain.Tip())
                 return true;
 
+            coinsPrefetcher_->prefetchInputsOfNextBlocks(chain, pindexMostWork);
+
             const CBlock* connectingBlock = (pblock && pblock->GetHash() == pindexMostWork->GetBlockHash())? pblock : nullptr;
             if (!chainTransitionMediator_->transitionActiveChainToMostWorkChain(state, pindexMostWork, connectingBlock))
                 return false;
@@ -610,7 +661,9 @@ ChainExtensionService::ChainExtensionService(
             mainNotificationSignals_,
             peerIdByBlockHash,
             sporkManager_,
-            chainstate_))
+            chainstate_,
+            blockProofVerifier_,
+            *blockIndexLotteryUpdater_))
     , chainTransitionMediator_(
         new MostWorkChainTransitionMediator(
             settings_,
@@ -619,11 +672,16 @@ ChainExtensionService::ChainExtensionService(
             blockIndexSuccessors_,
             blockIndexCandidates_,
             *chainTipManager_))
+    , coinsPrefetcher_(
+        new CoinsPrefetcher(
+            chainstate_,
+            std::max<int64_t>(0, settings_.GetArg("-prefetchblocks", DEFAULT_PREFETCH_BLOCKS))))
 {
 }
 
 ChainExtensionService::~ChainExtensionService()
 {
+    coinsPrefetcher_.reset();
     chainTransitionMediator_.reset();
     chainTipManager_.reset();
     blockIndexLotteryUpdater_.reset();
@@ -640,6 +698,42 @@ std::pair<CBlockIndex*, bool> ChainExtensionService::assignBlockIndex(
     return result;
 }
 
+std::pair<CBlockIndex*, bool> ChainExtensionService::assignBlockIndexToHeader(
+    const CBlock& blockHeader,
+    CValidationState& state) const
+{
+    AssertLockHeld(mainCriticalSection_);
+    std::pair<CBlockIndex*, bool> result(nullptr,false);
+
+    const auto& blockMap = chainstate_.GetBlockMap();
+    const uint256 blockHash = blockHeader.GetHash();
+    if (blockHash != chainParameters_.HashGenesisBlock() && blockMap.count(blockHash) == 0)
+    {
+        const auto mi = blockMap.find(blockHeader.hashPrevBlock);
+        if (mi == blockMap.end())
+        {
+            state.DoS(0, error("%s : prev block %s not found", __func__, blockHeader.hashPrevBlock), 0, "bad-prevblk");
+            return result;
+        }
+        const CBlockIndex* pindexPrev = mi->second;
+        const bool isProofOfStake = pindexPrev->nHeight + 1 > chainParameters_.LAST_POW_BLOCK();
+        if (blockHeader.GetBlockTime() > GetAdjustedTime() + (isProofOfStake ? settings_.MaxFutureBlockDrift() : 7200))
+        {
+            state.Invalid(error("%s : block timestamp too far in the future",__func__), REJECT_INVALID, "time-too-new");
+            return result;
+        }
+        if (!blockProofVerifier_.verifyBlockHeaderDifficulty(pindexPrev,blockHeader))
+        {
+            state.DoS(50, error("%s : incorrect difficulty for header %s", __func__, blockHash), REJECT_INVALID, "bad-diffbits");
+            return result;
+        }
+    }
+
+    result.second = AcceptBlockHeader(
+        mainCriticalSection_, chainParameters_, settings_, blockHeader, chainstate_, sporkManager_, state, &result.first);
+    return result;
+}
+
 bool ChainExtensionService::updateActiveChain(
     CValidationState& state,
     const CBlock* pblock) const
@@ -721,7 +815,8 @@ bool ChainExtensionService::connectGenesisBlock() const
                 return error("%s : FindBlockPos failed",__func__);
             if (!WriteBlockToDisk(block, blockPos))
                 return error("%s : writing genesis block to disk failed",__func__);
-            CBlockIndex* pindex = AddToBlockIndex(chainstate_, *blockIndexLotteryUpdater_, chainParameters_,sporkManager_,block);
+            CBlockIndex* pindex = AddToBlockIndex(chainstate_, chainParameters_,sporkManager_,block);
+            UpdateLotteryWinnersIfParentIsKnown(*blockIndexLotteryUpdater_, block, pindex);
             if (!ReceivedBlockTransactions(chainstate_.ActiveChain(),block, pindex, blockPos))
                 return error("%s : genesis block not accepted",__func__);
             if (!updateActiveChain(state, &block))
@@ -23,6 +23,7 @@ class I_SuperblockSubsidyContainer;
 class I_BlockIncentivesPopulator;
 class BlockIndexLotteryUpdater;
 class I_BlockProofVerifier;
+class CoinsPrefetcher;
 
 class ChainExtensionService final: public I_ChainExtensionService
 {
@@ -40,6 +41,7 @@ private:
     std::unique_ptr<BlockIndexLotteryUpdater> blockIndexLotteryUpdater_;
     std::unique_ptr<I_ChainTipManager> chainTipManager_;
     std::unique_ptr<I_MostWorkChainTransitionMediator> chainTransitionMediator_;
+    std::unique_ptr<CoinsPrefetcher> coinsPrefetcher_;
 
     bool transitionToMostWorkChainTip(
         CValidationState& state,
@@ -67,6 +69,9 @@ public:
         CBlock& block,
         CValidationState& state,
         CDiskBlockPos* dbp) const override;
+    std::pair<CBlockIndex*, bool> assignBlockIndexToHeader(
+        const CBlock& blockHeader,
+        CValidationState& state) const override;
     bool updateActiveChain(
         CValidationState& state,
         const CBlock* pblock) const override;
@@ -21,6 +21,10 @@ void updateBestHeaderBlockIndex(const CBlockIndex* otherBlockIndex, bool compare
         pindexBestHeader = otherBlockIndex;
     }
 }
+const CBlockIndex* GetBestHeaderBlockIndex()
+{
+    return pindexBestHeader;
+}
 int GetBestHeaderBlockHeight()
 {
     return pindexBestHeader? pindexBestHeader->nHeight: -1;
@@ -6,6 +6,7 @@ class CCriticalSection;
 class Settings;
 void InitializeBestHeaderBlockIndex();
 void updateBestHeaderBlockIndex(const CBlockIndex* otherBlockIndex, bool compareByWorkOnly);
+const CBlockIndex* GetBestHeaderBlockIndex();
 int GetBestHeaderBlockHeight();
 int64_t GetBestHeaderBlocktime();
 bool IsInitialBlockDownload(CCriticalSection& mainCriticalSection, const Settings& settings);
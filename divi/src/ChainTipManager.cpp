@@ -22,6 +22,9 @@
 #include <utiltime.h>
 #include <BlockInvalidationHelpers.h>
 #include <MempoolConsensus.h>
+#include <I_BlockProofVerifier.h>
+#include <BlockIndexLotteryUpdater.h>
+#include <BlockFileHelpers.h>
 
 namespace
 {
@@ -31,13 +34,17 @@ void static UpdateTip(const CBlockIndex* pindexNew, CCriticalSection& mainCritic
 {
     ChainstateManager::Reference chainstate;
     auto& chain = chainstate->ActiveChain();
-    chain.SetTip(pindexNew);
+    {
+        boost::unique_lock<boost::shared_mutex> blockIndexLock(chainstate->BlockIndexAccess());
+        chain.SetTip(pindexNew);
+    }
 
     // New best block
-    LogPrintf("%s: new best=%s  height=%d  log2_work=%.8g  tx=%lu  date=%s cache=%u\n", __func__,
+    LogPrintf("%s: new best=%s  height=%d  log2_work=%.8g  tx=%lu  date=%s cache=%.1fMiB(%utx)\n", __func__,
               chain.Tip()->GetBlockHash(), chain.Height(), log(chain.Tip()->nChainWork.getdouble()) / log(2.0), (unsigned long)chain.Tip()->nChainTx,
               DateTimeStrFormat("%Y-%m-%d %H:%M:%S", chain.Tip()->GetBlockTime()),
-               (unsigned int)chainstate->CoinsTip().GetCacheSize());
+              chainstate->CoinsTip().DynamicMemoryUsage() * (1.0 / (1<<20)),
+              (unsigned int)chainstate->CoinsTip().GetCacheSize());
 
 
     // Check the version of the last 100 blocks to see if we need to upgrade:
@@ -74,7 +81,9 @@ ChainTipManager::ChainTipManager(
     MainNotificationSignals& mainNotificationSignals,
     std::map<uint256, NodeId>& peerIdByBlockHash,
     const CSporkManager& sporkManager,
-    ChainstateManager& chainstate
+    ChainstateManager& chainstate,
+    const I_BlockProofVerifier& blockProofVerifier,
+    const BlockIndexLotteryUpdater& blockIndexLotteryUpdater
     ): settings_(settings)
     , mainCriticalSection_(mainCriticalSection)
     , mempool_(mempool)
@@ -82,6 +91,8 @@ ChainTipManager::ChainTipManager(
     , peerIdByBlockHash_(peerIdByBlockHash)
     , sporkManager_(sporkManager)
     , chainstate_(chainstate)
+    , blockProofVerifier_(blockProofVerifier)
+    , blockIndexLotteryUpdater_(blockIndexLotteryUpdater)
     , blockDiskReader_(new BlockDiskDataReader() )
     , blockConnectionService_(
         new BlockConnectionService(
@@ -102,6 +113,28 @@ ChainTipManager::~ChainTipManager()
     blockDiskReader_.reset();
 }
 
+bool ChainTipManager::resolvePendingBlockChecks(CValidationState& state, const CBlock& block, CBlockIndex* blockIndex) const
+{
+    if (!blockIndex->BlockProofIsPending() && !blockIndex->LotteryWinnersArePending())
+        return true;
+
+    if (blockIndex->BlockProofIsPending())
+    {
+        if (!blockProofVerifier_.verifyBlockProof(blockIndex->pprev, block))
+            return state.DoS(100, error("%s : proof of %s block %s failed", __func__, block.IsProofOfWork()? "work":"stake", blockIndex->GetBlockHash()),
+                             REJECT_INVALID, "bad-blk-proof");
+        blockIndex->SetBlockProofPending(false);
+        updateBestHeaderBlockIndex(blockIndex,true);
+    }
+    if (blockIndex->LotteryWinnersArePending())
+    {
+        blockIndexLotteryUpdater_.UpdateBlockIndexLotteryWinners(block, blockIndex);
+        blockIndex->SetLotteryWinnersPending(false);
+    }
+    BlockFileHelpers::RecordDirtyBlockIndex(blockIndex);
+    return true;
+}
+
 bool ChainTipManager::connectTip(CValidationState& state,const CBlock* pblock, CBlockIndex* blockIndex) const
 {
     AssertLockHeld(mainCriticalSection_);
@@ -120,7 +153,8 @@ bool ChainTipManager::connectTip(CValidationState& state,const CBlock* pblock, C
     }
     // Apply the block atomically to the chain state.
     {
-        bool rv = blockConnectionService_->ConnectBlock(*pblock,state,blockIndex,false);
+        bool rv = resolvePendingBlockChecks(state, *pblock, blockIndex) &&
+            blockConnectionService_->ConnectBlock(*pblock,state,blockIndex,false);
         if (!rv) {
             if (state.IsInvalid())
                 InvalidBlockFound(peerIdByBlockHash_,IsInitialBlockDownload(mainCriticalSection_,settings_),settings_,mainCriticalSection_,blockIndex, state);
@@ -19,6 +19,10 @@ class BlockConnectionService;
 class CChainParams;
 class I_SuperblockSubsidyContainer;
 class I_BlockIncentivesPopulator;
+class I_BlockProofVerifier;
+class BlockIndexLotteryUpdater;
+class CBlock;
+class CBlockIndex;
 
 class ChainTipManager final: public I_ChainTipManager
 {
@@ -30,8 +34,12 @@ private:
     std::map<uint256, NodeId>& peerIdByBlockHash_;
     const CSporkManager& sporkManager_;
     ChainstateManager& chainstate_;
+    const I_BlockProofVerifier& blockProofVerifier_;
+    const BlockIndexLotteryUpdater& blockIndexLotteryUpdater_;
     std::unique_ptr<I_BlockDataReader> blockDiskReader_;
     std::unique_ptr<const BlockConnectionService> blockConnectionService_;
+
+    bool resolvePendingBlockChecks(CValidationState& state, const CBlock& block, CBlockIndex* blockIndex) const;
 public:
     ChainTipManager(
         const CChainParams& chainParameters,
@@ -43,7 +51,9 @@ public:
         MainNotificationSignals& mainNotificationSignals,
         std::map<uint256, NodeId>& peerIdByBlockHash,
         const CSporkManager& sporkManager,
-        ChainstateManager& chainstate);
+        ChainstateManager& chainstate,
+        const I_BlockProofVerifier& blockProofVerifier,
+        const BlockIndexLotteryUpdater& blockIndexLotteryUpdater);
     ~ChainTipManager();
     bool connectTip(CValidationState& state, const CBlock* pblock, CBlockIndex* blockIndex) const override;
     bool disconnectTip(CValidationState& state, const bool updateCoinDatabaseOnly) const override;
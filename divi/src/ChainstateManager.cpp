@@ -57,15 +57,15 @@ bool CCoinsViewErrorCatcher::GetCoins(const uint256& txid, CCoins& coins) const
 
 } // anonymous namespace
 
-ChainstateManager::ChainstateManager (const size_t blockTreeCache, const size_t coinDbCache,size_t viewCacheSize,
-                                      const bool fMemory, const bool fWipe)
+ChainstateManager::ChainstateManager (const size_t blockTreeCache, const size_t coinDbCache,size_t viewCacheUsage,
+                                      const bool fMemory, const bool fWipe, const bool perOutpointCoinsDb)
   : blockMap(new BlockMap ()),
     activeChain(new CChain ()),
     blockTree(new CBlockTreeDB (blockTreeCache, fMemory, fWipe)),
-    coinsDbView(new CCoinsViewDB (*blockMap, coinDbCache, fMemory, fWipe)),
+    coinsDbView(new CCoinsViewDB (*blockMap, coinDbCache, fMemory, fWipe, perOutpointCoinsDb)),
     coinsCatcher(new CCoinsViewErrorCatcher (coinsDbView.get ())),
     coinsTip(new CCoinsViewCache (coinsCatcher.get ())),
-    viewCacheSize_(viewCacheSize),
+    viewCacheUsage_(viewCacheUsage),
     refs(0)
 {
   LOCK (instanceLock);
@@ -96,6 +96,12 @@ const CCoinsViewDB& ChainstateManager::GetNonCatchingCoinsView () const
   return *coinsDbView;
 }
 
+bool ChainstateManager::UpgradeCoinsDatabase ()
+{
+  assert (coinsTip->GetCacheSize () == 0);
+  return coinsDbView->UpgradeToPerOutpointLayout ();
+}
+
 ChainstateManager& ChainstateManager::Get ()
 {
   LOCK (instanceLock);
@@ -4,6 +4,8 @@
 #include <atomic>
 #include <memory>
 
+#include <boost/thread/shared_mutex.hpp>
+
 class BlockMap;
 class CBlockTreeDB;
 class CChain;
@@ -27,7 +29,20 @@ private:
   std::unique_ptr<CCoinsViewDB> coinsDbView;
   std::unique_ptr<CCoinsView> coinsCatcher;
   std::unique_ptr<CCoinsViewCache> coinsTip;
-  const size_t viewCacheSize_;
+  /** Byte budget for the dynamic memory usage of coinsTip.  */
+  const size_t viewCacheUsage_;
+
+  /** Lets readers that do not hold cs_main (like the message handlers
+   *  answering getblocks and getheaders) look at the block-index map, the
+   *  active chain and the header fields of block indices.  Code changing either takes it
+   *  exclusively, in addition to cs_main.  Block indices are never freed
+   *  while the node runs, so pointers found under the shared lock remain
+   *  valid after it is released.
+   *
+   *  It does not cover what changes on existing block indices, such as
+   *  nStatus, nFlags and the disk position of blocks not yet stored, nor
+   *  pindexBestHeader.  Reading those still requires cs_main.  */
+  mutable boost::shared_mutex blockIndexAccess;
 
   /** A refcount for the instance.  We use it to enforce that the
    *  singleton instance is no longer referenced by anything when it
@@ -38,13 +53,15 @@ public:
 
   class Reference;
 
-  explicit ChainstateManager (size_t blockTreeCache, size_t coinDbCache,size_t viewCacheSize,
-                              bool fMemory, bool fWipe);
+  explicit ChainstateManager (size_t blockTreeCache, size_t coinDbCache,size_t viewCacheUsage,
+                              bool fMemory, bool fWipe, bool perOutpointCoinsDb = false);
   ~ChainstateManager ();
 
-  inline const size_t& GetNominalViewCacheSize() const
+  /** Returns the number of bytes the coins tip cache may use before it
+   *  needs to be trimmed or flushed.  */
+  inline const size_t& GetNominalViewCacheUsage() const
   {
-    return viewCacheSize_;
+    return viewCacheUsage_;
   }
 
   inline BlockMap&
@@ -95,10 +112,21 @@ public:
     return *coinsTip;
   }
 
+  /** See blockIndexAccess for what the lock does and does not cover.  */
+  inline boost::shared_mutex&
+  BlockIndexAccess () const
+  {
+    return blockIndexAccess;
+  }
+
   /** Returns a coins view that is not catching errors in GetCoins.  This is
    *  used during initialisation for verifying the DB.  */
   const CCoinsViewDB& GetNonCatchingCoinsView () const;
 
+  /** Converts the coins database to the per-outpoint layout if that was
+   *  requested.  Must be called before the coins tip holds any entries.  */
+  bool UpgradeCoinsDatabase ();
+
   /** Returns the singleton instance of the ChainstateManager that exists
    *  at the moment.  It must be constructed at the moment.  */
   static ChainstateManager& Get ();
@@ -0,0 +1,159 @@
+#include <CoinsPrefetcher.h>
+
+#include <BlockDiskAccessor.h>
+#include <ChainstateManager.h>
+#include <Logging.h>
+#include <chain.h>
+#include <coins.h>
+#include <defaultValues.h>
+#include <primitives/block.h>
+#include <txdb.h>
+#include <utiltime.h>
+
+#include <algorithm>
+#include <set>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+namespace
+{
+
+/** Reads every strideth txid, starting at offset, from the coins database. */
+void ReadCoinsFromDatabase(
+    const CCoinsView& coinsDb,
+    const std::vector<uint256>& txids,
+    const unsigned offset,
+    const unsigned stride,
+    std::vector<CCoins>& coins,
+    std::vector<char>& found)
+{
+    for (unsigned index = offset; index < txids.size(); index += stride)
+    {
+        try
+        {
+            found[index] = coinsDb.GetCoins(txids[index], coins[index]);
+        }
+        catch (const std::runtime_error&)
+        {
+            // Prefetching is best-effort; the regular lookup during connect reports the error
+            found[index] = false;
+        }
+    }
+}
+
+} // anonymous namespace
+
+CoinsPrefetcher::CoinsPrefetcher(
+    ChainstateManager& chainstate,
+    unsigned maxBlocksAhead
+    ): coinsDb_(chainstate.GetNonCatchingCoinsView())
+    , coinsTip_(chainstate.CoinsTip())
+    , maxBlocksAhead_(maxBlocksAhead)
+    , lastPrefetchedBlockIndex_(nullptr)
+{
+}
+
+void CoinsPrefetcher::collectBlocksToPrefetch(
+    const CChain& chain,
+    const CBlockIndex* mostWorkBlockIndex,
+    std::vector<const CBlockIndex*>& blockIndices) const
+{
+    blockIndices.clear();
+    const CBlockIndex* tip = chain.Tip();
+    // Reorgs change the coins in ways the database does not reflect yet; let them go the regular way
+    if (maxBlocksAhead_ == 0 || tip == nullptr || mostWorkBlockIndex->GetAncestor(tip->nHeight) != tip)
+        return;
+
+    int startingHeight = tip->nHeight;
+    if (lastPrefetchedBlockIndex_ != nullptr &&
+        lastPrefetchedBlockIndex_->nHeight > startingHeight &&
+        mostWorkBlockIndex->GetAncestor(lastPrefetchedBlockIndex_->nHeight) == lastPrefetchedBlockIndex_)
+    {
+        startingHeight = lastPrefetchedBlockIndex_->nHeight;
+    }
+    const int targetHeight = std::min<int>(tip->nHeight + maxBlocksAhead_, mostWorkBlockIndex->nHeight);
+    for (const CBlockIndex* pindex = mostWorkBlockIndex->GetAncestor(targetHeight);
+         pindex != nullptr && pindex->nHeight > startingHeight;
+         pindex = pindex->pprev)
+    {
+        blockIndices.push_back(pindex);
+    }
+    std::reverse(blockIndices.begin(), blockIndices.end());
+}
+
+void CoinsPrefetcher::collectMissingInputs(
+    const std::vector<const CBlockIndex*>& blockIndices,
+    std::vector<uint256>& txids) const
+{
+    std::set<uint256> createdInWindow;
+    std::set<uint256> missing;
+    for (const CBlockIndex* pindex : blockIndices)
+    {
+        CBlock block;
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA) || !ReadBlockFromDisk(block, pindex))
+            break;
+        lastPrefetchedBlockIndex_ = pindex;
+        for (const CTransaction& tx : block.vtx)
+        {
+            if (!tx.IsCoinBase())
+            {
+                for (const CTxIn& txin : tx.vin)
+                {
+                    const uint256& txid = txin.prevout.hash;
+                    if (createdInWindow.count(txid) == 0 && !coinsTip_.HaveCoinsInCache(txid))
+                        missing.insert(txid);
+                }
+            }
+            createdInWindow.insert(tx.GetHash());
+        }
+    }
+    txids.assign(missing.begin(), missing.end());
+}
+
+void CoinsPrefetcher::prefetchInputsOfNextBlocks(
+    const CChain& chain,
+    const CBlockIndex* mostWorkBlockIndex) const
+{
+    std::vector<const CBlockIndex*> blockIndices;
+    collectBlocksToPrefetch(chain, mostWorkBlockIndex, blockIndices);
+    if (blockIndices.empty())
+        return;
+
+    const int64_t nStart = GetTimeMicros();
+    std::vector<uint256> txids;
+    collectMissingInputs(blockIndices, txids);
+    if (txids.empty())
+        return;
+
+    std::vector<CCoins> coins(txids.size());
+    std::vector<char> found(txids.size(), false);
+    const unsigned threadCount = std::min<unsigned>(
+        COINS_PREFETCH_THREADS,
+        (txids.size() + MIN_COINS_PER_PREFETCH_THREAD - 1) / MIN_COINS_PER_PREFETCH_THREAD);
+    if (threadCount <= 1)
+    {
+        ReadCoinsFromDatabase(coinsDb_, txids, 0u, 1u, coins, found);
+    }
+    else
+    {
+        boost::thread_group readers;
+        for (unsigned offset = 0; offset < threadCount; ++offset)
+        {
+            readers.create_thread(
+                boost::bind(&ReadCoinsFromDatabase, boost::cref(coinsDb_), boost::cref(txids), offset, threadCount, boost::ref(coins), boost::ref(found)));
+        }
+        readers.join_all();
+    }
+
+    unsigned prefetchedCount = 0;
+    for (unsigned index = 0; index < txids.size(); ++index)
+    {
+        if (!found[index])
+            continue;
+        coinsTip_.CacheCoinsFromParent(txids[index], coins[index]);
+        ++prefetchedCount;
+    }
+    LogPrint("bench", "- Prefetch %u of %u coins for %u blocks on %u threads: %.2fms\n",
+        prefetchedCount, txids.size(), blockIndices.size(), std::max(1u, threadCount), (GetTimeMicros() - nStart) * 0.001);
+}
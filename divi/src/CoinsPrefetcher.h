@@ -0,0 +1,42 @@
+#ifndef COINS_PREFETCHER_H
+#define COINS_PREFETCHER_H
+#include <vector>
+
+class CBlockIndex;
+class CChain;
+class CCoinsView;
+class CCoinsViewCache;
+class ChainstateManager;
+class uint256;
+
+/** Loads the coins spent by the blocks about to be connected into the coins
+ *  tip cache, reading them from the coins database on several threads, so
+ *  that connecting those blocks does not wait on one disk read per input. */
+class CoinsPrefetcher
+{
+private:
+    const CCoinsView& coinsDb_;
+    CCoinsViewCache& coinsTip_;
+    const unsigned maxBlocksAhead_;
+    mutable const CBlockIndex* lastPrefetchedBlockIndex_;
+
+    void collectBlocksToPrefetch(
+        const CChain& chain,
+        const CBlockIndex* mostWorkBlockIndex,
+        std::vector<const CBlockIndex*>& blockIndices) const;
+    void collectMissingInputs(
+        const std::vector<const CBlockIndex*>& blockIndices,
+        std::vector<uint256>& txids) const;
+
+public:
+    CoinsPrefetcher(
+        ChainstateManager& chainstate,
+        unsigned maxBlocksAhead);
+
+    /** Must be called with cs_main held, so that neither the cache nor the
+     *  database change while coins are read. */
+    void prefetchInputsOfNextBlocks(
+        const CChain& chain,
+        const CBlockIndex* mostWorkBlockIndex) const;
+};
+#endif// COINS_PREFETCHER_H
@@ -0,0 +1,54 @@
+#include <CompactBlock.h>
+
+#include <hash.h>
+#include <version.h>
+
+constexpr unsigned CompactBlock::MIN_TRANSACTION_SIZE;
+constexpr unsigned CompactBlock::MAX_TRANSACTIONS;
+
+CompactBlock::CompactBlock(
+    ): header()
+    , vchBlockSig()
+    , nonce(0)
+    , shortTxIds()
+    , prefilledTransactions()
+{
+}
+
+CompactBlock::CompactBlock(
+    const CBlock& block,
+    uint64_t nonceIn
+    ): header(block.GetBlockHeader())
+    , vchBlockSig(block.vchBlockSig)
+    , nonce(nonceIn)
+    , shortTxIds()
+    , prefilledTransactions()
+{
+    // The coinbase and the coinstake can not be in the receiver's mempool
+    const uint32_t numberOfPrefilledTransactions = std::min<size_t>(block.vtx.size(), block.IsProofOfStake()? 2u: 1u);
+    for (uint32_t index = 0; index < numberOfPrefilledTransactions; ++index)
+        prefilledTransactions.push_back(PrefilledTransaction{index, block.vtx[index]});
+
+    const std::pair<uint64_t, uint64_t> keys = GetShortTxIdKeys();
+    shortTxIds.reserve(block.vtx.size() - numberOfPrefilledTransactions);
+    for (size_t index = numberOfPrefilledTransactions; index < block.vtx.size(); ++index)
+        shortTxIds.push_back(GetShortTxId(keys, block.vtx[index].GetHash()));
+}
+
+std::pair<uint64_t, uint64_t> CompactBlock::GetShortTxIdKeys() const
+{
+    CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
+    hasher << header << nonce;
+    const uint256 keySource = hasher.GetHash();
+    return std::make_pair(keySource.Get64(0), keySource.Get64(1));
+}
+
+uint64_t CompactBlock::GetShortTxId(const std::pair<uint64_t, uint64_t>& keys, const uint256& txid)
+{
+    return SipHashUint256(keys.first, keys.second, txid) & 0xffffffffffffULL;
+}
+
+size_t CompactBlock::BlockTransactionCount() const
+{
+    return shortTxIds.size() + prefilledTransactions.size();
+}
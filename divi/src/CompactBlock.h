@@ -0,0 +1,87 @@
+#ifndef COMPACT_BLOCK_H
+#define COMPACT_BLOCK_H
+#include <defaultValues.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <ios>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+/** A transaction of a compact block that is sent in full, at its index in the block. */
+struct PrefilledTransaction
+{
+    uint32_t index;
+    CTransaction tx;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(VARINT(index));
+        READWRITE(tx);
+    }
+};
+
+/** A block announced as its header and signature, with 6-byte short ids in
+ *  place of the transactions the receiver most likely has in its mempool.
+ *  The coinbase, and the coinstake of proof-of-stake blocks, are never in
+ *  a mempool and are always prefilled.
+ *  Short ids are SipHash-2-4 of the txid, keyed by the hash of the header
+ *  and a per-message nonce, so that collisions can not be precomputed.  */
+class CompactBlock
+{
+public:
+    /** A transaction takes at least this many bytes, which bounds the
+     *  number of short ids a valid compact block can have.  */
+    static constexpr unsigned MIN_TRANSACTION_SIZE = 10;
+    static constexpr unsigned MAX_TRANSACTIONS = MAX_BLOCK_SIZE_CURRENT / MIN_TRANSACTION_SIZE;
+
+    CBlockHeader header;
+    std::vector<unsigned char> vchBlockSig;
+    uint64_t nonce;
+    std::vector<uint64_t> shortTxIds;
+    std::vector<PrefilledTransaction> prefilledTransactions;
+
+    CompactBlock();
+    CompactBlock(const CBlock& block, uint64_t nonceIn);
+
+    /** Keys of the short id SipHash for this header and nonce. */
+    std::pair<uint64_t, uint64_t> GetShortTxIdKeys() const;
+    static uint64_t GetShortTxId(const std::pair<uint64_t, uint64_t>& keys, const uint256& txid);
+
+    size_t BlockTransactionCount() const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(header);
+        READWRITE(vchBlockSig);
+        READWRITE(nonce);
+
+        if (ser_action.ForRead()) {
+            const uint64_t numberOfShortTxIds = ReadCompactSize(s);
+            if (numberOfShortTxIds > MAX_TRANSACTIONS)
+                throw std::ios_base::failure("compact block has too many short ids");
+            shortTxIds.resize(numberOfShortTxIds);
+        } else {
+            WriteCompactSize(s, shortTxIds.size());
+        }
+        for (uint64_t& shortTxId : shortTxIds) {
+            uint32_t lowBits = shortTxId & 0xffffffff;
+            uint16_t highBits = (shortTxId >> 32) & 0xffff;
+            READWRITE(lowBits);
+            READWRITE(highBits);
+            shortTxId = (static_cast<uint64_t>(highBits) << 32) | lowBits;
+        }
+
+        READWRITE(prefilledTransactions);
+    }
+};
+#endif// COMPACT_BLOCK_H
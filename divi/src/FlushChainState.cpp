@@ -11,6 +11,7 @@
 #include <ValidationState.h>
 #include <chain.h>
 #include <defaultValues.h>
+#include <Logging.h>
 
 bool FlushStateToDisk(
     ChainstateManager& chainstate,
@@ -25,8 +26,22 @@ bool FlushStateToDisk(
 
     static int64_t nLastWrite = 0;
     try {
-        if ((mode == FLUSH_STATE_ALWAYS) ||
-            ((mode == FLUSH_STATE_PERIODIC || mode == FLUSH_STATE_IF_NEEDED) && coinsTip.GetCacheSize() > chainstate.GetNominalViewCacheSize() ) ||
+        const size_t cacheUsageBudget = chainstate.GetNominalViewCacheUsage();
+        if (mode != FLUSH_STATE_ALWAYS && coinsTip.DynamicMemoryUsage() > cacheUsageBudget)
+        {
+            // Coins that were only read (e.g. inputs of a block that is already
+            // connected) can be dropped without touching the database. Only if
+            // that is not enough do we pay for a full write of the cache.
+            const unsigned int evicted = coinsTip.UncacheNonDirtyEntries();
+            LogPrint("coindb", "%s: evicted %u clean coins cache entries, usage now %u bytes (budget %u)\n",
+                     __func__, evicted, coinsTip.DynamicMemoryUsage(), cacheUsageBudget);
+        }
+        const size_t cacheUsage = coinsTip.DynamicMemoryUsage();
+        // The cache is large and close to the limit, but we have time now (not in the middle of a block processing).
+        const bool fCacheLarge = mode == FLUSH_STATE_PERIODIC && cacheUsage * 10 > cacheUsageBudget * 9;
+        // The cache is over the limit, we have to write now.
+        const bool fCacheCritical = mode == FLUSH_STATE_IF_NEEDED && cacheUsage > cacheUsageBudget;
+        if ((mode == FLUSH_STATE_ALWAYS) || fCacheLarge || fCacheCritical ||
             (mode == FLUSH_STATE_PERIODIC && GetTimeMicros() > nLastWrite + DATABASE_WRITE_INTERVAL * 1000000))
         {
             // Typical CCoins structures on disk are around 100 bytes in size.
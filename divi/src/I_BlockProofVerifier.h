@@ -2,6 +2,7 @@
 #define I_BLOCK_PROOF_VERIFIER_H
 class CBlockIndex;
 class CBlock;
+class CBlockHeader;
 
 class I_BlockProofVerifier
 {
@@ -10,5 +11,8 @@ public:
     virtual bool verifyBlockProof(
         const CBlockIndex* chainTip,
         const CBlock& block) const = 0;
+    virtual bool verifyBlockHeaderDifficulty(
+        const CBlockIndex* chainTip,
+        const CBlockHeader& blockHeader) const = 0;
 };
 #endif// I_BLOCK_PROOF_VERIFIER_H
\ No newline at end of file
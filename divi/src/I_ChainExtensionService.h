@@ -18,6 +18,12 @@ public:
         CValidationState& state,
         CDiskBlockPos* dbp) const = 0;
 
+    /** Adds a block index for a header received ahead of its block data.
+     *  Its proof of stake is checked once the block itself arrives.  */
+    virtual std::pair<CBlockIndex*, bool> assignBlockIndexToHeader(
+        const CBlock& blockHeader,
+        CValidationState& state) const = 0;
+
     virtual bool updateActiveChain(
         CValidationState& state,
         const CBlock* pblock) const = 0;
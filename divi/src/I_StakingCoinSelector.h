@@ -2,14 +2,36 @@
 #define I_STAKING_COIN_SELECTOR_H
 #include <StakableCoin.h>
 #include <set>
+#include <limits>
+#include <stdint.h>
 #include <keystore.h>
 #include <I_KeypoolReserver.h>
 
+/** Describes until when a selection of stake coins stays current: the
+ *  wallet version it was made at, and the height and adjusted time at which
+ *  the first coin left out for its depth or its age becomes stakable.  */
+struct StakeCoinsSelectionValidity
+{
+    uint64_t walletVersion;
+    int nextMaturityHeight;
+    int64_t nextCoinAgeTime;
+
+    StakeCoinsSelectionValidity(
+        ): walletVersion(0u)
+        , nextMaturityHeight(std::numeric_limits<int>::max())
+        , nextCoinAgeTime(std::numeric_limits<int64_t>::max())
+    {
+    }
+};
+
 class I_StakingCoinSelector
 {
 public:
     virtual ~I_StakingCoinSelector(){}
-    virtual bool SelectStakeCoins(std::set<StakableCoin>&) const = 0;
+    virtual bool SelectStakeCoins(std::set<StakableCoin>&, StakeCoinsSelectionValidity&) const = 0;
+    /** Changes whenever a wallet transaction, coin lock or staking script that
+     *  the stakable coins depend on changes.  */
+    virtual uint64_t GetStakableCoinsVersion() const = 0;
     virtual bool HasAgedCoins() const = 0;
     virtual bool CanStakeCoins() const = 0;
 };
@@ -18,4 +40,4 @@ class I_StakingWallet: public virtual CKeyStore, public I_StakingCoinSelector, p
 public:
     virtual ~I_StakingWallet(){}
 };
-#endif// I_STAKING_COIN_SELECTOR_H
\ No newline at end of file
+#endif// I_STAKING_COIN_SELECTOR_H
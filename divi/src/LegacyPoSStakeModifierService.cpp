@@ -11,9 +11,34 @@ LegacyPoSStakeModifierService::LegacyPoSStakeModifierService(
     const CChain& activeChain
     ): blockIndexByHash_(blockIndexByHash)
     , activeChain_(activeChain)
+    , cs_selectedBlocks_()
+    , selectedBlockByConfirmationBlock_()
 {
 }
 
+const CBlockIndex* LegacyPoSStakeModifierService::FindCachedSelection(const uint256& hashBlockFrom) const
+{
+    LOCK(cs_selectedBlocks_);
+    const auto it = selectedBlockByConfirmationBlock_.find(hashBlockFrom);
+    if (it == selectedBlockByConfirmationBlock_.end())
+        return nullptr;
+    // Reorganized away, so the blocks following the confirmation may differ
+    if (!activeChain_.Contains(it->second))
+    {
+        selectedBlockByConfirmationBlock_.erase(it);
+        return nullptr;
+    }
+    return it->second;
+}
+
+void LegacyPoSStakeModifierService::CacheSelection(const uint256& hashBlockFrom, const CBlockIndex* selectedBlock) const
+{
+    LOCK(cs_selectedBlocks_);
+    if (selectedBlockByConfirmationBlock_.size() >= MAX_CACHED_STAKE_MODIFIER_SELECTIONS)
+        selectedBlockByConfirmationBlock_.clear();
+    selectedBlockByConfirmationBlock_[hashBlockFrom] = selectedBlock;
+}
+
 std::pair<uint64_t,bool> LegacyPoSStakeModifierService::getStakeModifier(const StakingData& stakingData) const
 {
     const uint256& blockHash = stakingData.blockHashOfFirstConfirmationBlock_;
@@ -28,6 +53,10 @@ std::pair<uint64_t,bool> LegacyPoSStakeModifierService::getStakeModifier(const S
 
 uint64_t LegacyPoSStakeModifierService::GetKernelStakeModifier(const uint256& hashBlockFrom) const
 {
+    const CBlockIndex* cachedSelection = FindCachedSelection(hashBlockFrom);
+    if (cachedSelection)
+        return cachedSelection->nStakeModifier;
+
     const CBlockIndex& stakeTransactionBlockIndex = *(blockIndexByHash_.find(hashBlockFrom)->second);
     int64_t timeStampOfSelectedBlock = stakeTransactionBlockIndex.GetBlockTime();
     const int64_t timeWindowForSelectingStakeModifier = GetStakeModifierSelectionInterval();
@@ -52,5 +81,8 @@ uint64_t LegacyPoSStakeModifierService::GetKernelStakeModifier(const uint256& ha
             timeStampOfSelectedBlock = pindex->GetBlockTime();
         }
     }
+    // Only found selections are cached, a search running into the tip can
+    // still end differently once more blocks arrive
+    CacheSelection(hashBlockFrom, pindex);
     return pindex->nStakeModifier;
 }
@@ -1,20 +1,34 @@
 #ifndef LEGACY_POS_STAKE_MODIFIER_SERVICE_H
 #define LEGACY_POS_STAKE_MODIFIER_SERVICE_H
 #include <stdint.h>
+#include <map>
 #include <I_PoSStakeModifierService.h>
+#include <sync.h>
+#include <uint256.h>
 
-class uint256;
 class StakingData;
 class BlockMap;
 class CChain;
+class CBlockIndex;
 class LegacyPoSStakeModifierService: public I_PoSStakeModifierService
 {
 private:
     const BlockMap& blockIndexByHash_;
     const CChain& activeChain_;
 
+    /** Block whose stake modifier was selected for coins confirmed in a given
+     *  block. An entry stays valid for as long as the selected block is part
+     *  of the active chain, since the search only ever looks at the blocks
+     *  leading up to it.  */
+    mutable CCriticalSection cs_selectedBlocks_;
+    mutable std::map<uint256, const CBlockIndex*> selectedBlockByConfirmationBlock_;
+
+    const CBlockIndex* FindCachedSelection(const uint256& hashBlockFrom) const;
+    void CacheSelection(const uint256& hashBlockFrom, const CBlockIndex* selectedBlock) const;
     uint64_t GetKernelStakeModifier(const uint256& hashBlockFrom) const;
 public:
+    static const unsigned MAX_CACHED_STAKE_MODIFIER_SELECTIONS = 100000u;
+
     LegacyPoSStakeModifierService(const BlockMap& blockIndexByHash, const CChain& activeChain);
     virtual std::pair<uint64_t,bool> getStakeModifier(const StakingData& stakinData) const;
 };
@@ -0,0 +1,74 @@
+#include <LotteryCoinstakeScriptPool.h>
+
+#include <algorithm>
+#include <hash.h>
+#include <memusage.h>
+#include <script/script.h>
+
+namespace
+{
+/** Released scripts are only purged once the pool doubled in size, so the
+ *  cost of the purge is spread over the insertions that made it necessary.  */
+constexpr size_t MIN_ENTRIES_BEFORE_PURGE = 1024;
+}
+
+LotteryCoinstakeScriptPool::LotteryCoinstakeScriptPool(
+    ): cs_scripts_()
+    , scriptsByHash_()
+    , entriesAfterLastPurge_(0u)
+{
+}
+
+LotteryCoinstakeScriptPool& LotteryCoinstakeScriptPool::instance()
+{
+    static LotteryCoinstakeScriptPool pool;
+    return pool;
+}
+
+void LotteryCoinstakeScriptPool::purgeReleasedScripts()
+{
+    for(auto it = scriptsByHash_.begin(); it != scriptsByHash_.end();)
+    {
+        if(it->second.expired())
+            it = scriptsByHash_.erase(it);
+        else
+            ++it;
+    }
+    entriesAfterLastPurge_ = scriptsByHash_.size();
+}
+
+std::shared_ptr<const CScript> LotteryCoinstakeScriptPool::Intern(const CScript& script)
+{
+    const uint160 scriptHash = Hash160(script.begin(), script.end());
+    LOCK(cs_scripts_);
+    std::weak_ptr<const CScript>& pooledScript = scriptsByHash_[scriptHash];
+    std::shared_ptr<const CScript> internedScript = pooledScript.lock();
+    if(internedScript && *internedScript == script)
+        return internedScript;
+
+    internedScript = std::make_shared<const CScript>(script);
+    if(pooledScript.expired())
+        pooledScript = internedScript;
+    if(scriptsByHash_.size() >= 2 * std::max(entriesAfterLastPurge_, MIN_ENTRIES_BEFORE_PURGE))
+        purgeReleasedScripts();
+    return internedScript;
+}
+
+size_t LotteryCoinstakeScriptPool::size() const
+{
+    LOCK(cs_scripts_);
+    return scriptsByHash_.size();
+}
+
+size_t LotteryCoinstakeScriptPool::DynamicMemoryUsage() const
+{
+    LOCK(cs_scripts_);
+    size_t usage = memusage::DynamicUsage(scriptsByHash_);
+    for(const auto& pooledScript: scriptsByHash_)
+    {
+        const std::shared_ptr<const CScript> script = pooledScript.second.lock();
+        if(script)
+            usage += memusage::MallocUsage(sizeof(CScript) + 2 * sizeof(void*)) + memusage::DynamicUsage(*script);
+    }
+    return usage;
+}
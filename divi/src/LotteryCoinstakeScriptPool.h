@@ -0,0 +1,34 @@
+#ifndef LOTTERY_COINSTAKE_SCRIPT_POOL_H
+#define LOTTERY_COINSTAKE_SCRIPT_POOL_H
+#include <map>
+#include <memory>
+#include <stddef.h>
+#include <sync.h>
+#include <uint256.h>
+
+class CScript;
+
+/** Keeps a single copy of every payment script that is currently among the
+ *  lottery winners of some block index, keyed by the hash of the script.
+ *  Consecutive blocks carry mostly the same winners, so the block indices
+ *  share the scripts instead of holding a copy each.  Scripts that are not
+ *  referenced anymore are released.  */
+class LotteryCoinstakeScriptPool
+{
+private:
+    mutable CCriticalSection cs_scripts_;
+    std::map<uint160, std::weak_ptr<const CScript>> scriptsByHash_;
+    size_t entriesAfterLastPurge_;
+
+    void purgeReleasedScripts();
+
+public:
+    LotteryCoinstakeScriptPool();
+
+    static LotteryCoinstakeScriptPool& instance();
+
+    std::shared_ptr<const CScript> Intern(const CScript& script);
+    size_t size() const;
+    size_t DynamicMemoryUsage() const;
+};
+#endif// LOTTERY_COINSTAKE_SCRIPT_POOL_H
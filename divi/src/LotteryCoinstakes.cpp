@@ -1,7 +1,30 @@
 #include <LotteryCoinstakes.h>
 
+#include <LotteryCoinstakeScriptPool.h>
+#include <memusage.h>
+
+namespace
+{
+/** Entries without winners of their own, in particular every shallow copy
+ *  read from disk before it is linked to its ancestor, share one instance.  */
+const std::shared_ptr<const InternedLotteryCoinstakes>& EmptyCoinstakes()
+{
+    static const std::shared_ptr<const InternedLotteryCoinstakes> emptyCoinstakes =
+        std::make_shared<const InternedLotteryCoinstakes>();
+    return emptyCoinstakes;
+}
+
+std::shared_ptr<const InternedLotteryCoinstakes> InternCoinstakes(const LotteryCoinstakes& coinstakes)
+{
+    if(coinstakes.empty()) return EmptyCoinstakes();
+    std::shared_ptr<InternedLotteryCoinstakes> internedCoinstakes = std::make_shared<InternedLotteryCoinstakes>();
+    LotteryCoinstakeData::internCoinstakes(coinstakes, *internedCoinstakes);
+    return internedCoinstakes;
+}
+} // anonymous namespace
+
 LotteryCoinstakeData::LotteryCoinstakeData(
-    ): storage(std::make_shared<LotteryCoinstakes>())
+    ): storage(EmptyCoinstakes())
     , heightOfDataStorage(0)
     , storageIsLocal(true)
 {
@@ -9,12 +32,23 @@ LotteryCoinstakeData::LotteryCoinstakeData(
 LotteryCoinstakeData::LotteryCoinstakeData(
     int height,
     const LotteryCoinstakes& coinstakes
-    ): storage(std::make_shared<LotteryCoinstakes>(coinstakes))
+    ): storage(InternCoinstakes(coinstakes))
     , heightOfDataStorage(height)
     , storageIsLocal(true)
 {
 }
 
+void LotteryCoinstakeData::internCoinstakes(const LotteryCoinstakes& coinstakes, InternedLotteryCoinstakes& internedCoinstakes)
+{
+    LotteryCoinstakeScriptPool& scriptPool = LotteryCoinstakeScriptPool::instance();
+    internedCoinstakes.clear();
+    internedCoinstakes.reserve(coinstakes.size());
+    for(const LotteryCoinstake& coinstake: coinstakes)
+    {
+        internedCoinstakes.emplace_back(coinstake.first, scriptPool.Intern(coinstake.second));
+    }
+}
+
 bool LotteryCoinstakeData::IsValid() const
 {
     return static_cast<bool>(storage.get());
@@ -30,9 +64,15 @@ int LotteryCoinstakeData::height() const
     return heightOfDataStorage;
 }
 
-const LotteryCoinstakes& LotteryCoinstakeData::getLotteryCoinstakes() const
+LotteryCoinstakes LotteryCoinstakeData::getLotteryCoinstakes() const
 {
-    return *storage;
+    LotteryCoinstakes coinstakes;
+    coinstakes.reserve(storage->size());
+    for(const InternedLotteryCoinstake& coinstake: *storage)
+    {
+        coinstakes.emplace_back(coinstake.first, *coinstake.second);
+    }
+    return coinstakes;
 }
 void LotteryCoinstakeData::updateShallowDataStore(LotteryCoinstakeData& other)
 {
@@ -47,7 +87,7 @@ void LotteryCoinstakeData::clear()
 {
     heightOfDataStorage =0;
     storageIsLocal = true;
-    storage = std::make_shared<LotteryCoinstakes>();
+    storage = EmptyCoinstakes();
 }
 
 LotteryCoinstakeData LotteryCoinstakeData::getShallowCopy() const
@@ -55,4 +95,10 @@ LotteryCoinstakeData LotteryCoinstakeData::getShallowCopy() const
     LotteryCoinstakeData copy = *this;
     copy.MarkAsShallowStorage();
     return copy;
-}
\ No newline at end of file
+}
+
+size_t LotteryCoinstakeData::DynamicMemoryUsage() const
+{
+    if(!storageIsLocal || storage->empty()) return 0u;
+    return memusage::MallocUsage(sizeof(InternedLotteryCoinstakes) + 2 * sizeof(void*)) + memusage::DynamicUsage(*storage);
+}
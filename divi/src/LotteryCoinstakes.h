@@ -8,11 +8,15 @@
 #include <serialize.h>
 typedef std::pair<uint256,CScript> LotteryCoinstake;
 typedef std::vector<LotteryCoinstake> LotteryCoinstakes;
+/** Compact in-memory form of the winners; the payment scripts come from the
+ *  LotteryCoinstakeScriptPool and are shared between block indices.  */
+typedef std::pair<uint256,std::shared_ptr<const CScript>> InternedLotteryCoinstake;
+typedef std::vector<InternedLotteryCoinstake> InternedLotteryCoinstakes;
 
 struct LotteryCoinstakeData
 {
 public:
-    std::shared_ptr<LotteryCoinstakes> storage;
+    std::shared_ptr<const InternedLotteryCoinstakes> storage;
     int heightOfDataStorage;
     bool storageIsLocal;
 
@@ -26,10 +30,14 @@ public:
     bool IsValid() const;
     void MarkAsShallowStorage();
     int height() const;
-    const LotteryCoinstakes& getLotteryCoinstakes() const;
+    LotteryCoinstakes getLotteryCoinstakes() const;
     void updateShallowDataStore(LotteryCoinstakeData& other);
     void clear();
     LotteryCoinstakeData getShallowCopy() const;
+    /** Memory held by this entry alone, excluding the pooled scripts and
+     *  storage that is shared with the ancestor it is a shallow copy of.  */
+    size_t DynamicMemoryUsage() const;
+    static void internCoinstakes(const LotteryCoinstakes& coinstakes, InternedLotteryCoinstakes& internedCoinstakes);
 
     ADD_SERIALIZE_METHODS;
     template <typename Stream, typename Operation>
@@ -40,17 +48,17 @@ public:
         {
             if(!ser_action.ForRead())
             {
-                LotteryCoinstakes& coinstakes = *storage;
+                LotteryCoinstakes coinstakes = getLotteryCoinstakes();
                 READWRITE(coinstakes);
             }
             else
             {
-                storage.reset();
-                storage = std::make_shared<LotteryCoinstakes>();
-                LotteryCoinstakes& coinstakes = *storage;
+                LotteryCoinstakes coinstakes;
                 READWRITE(coinstakes);
+                std::shared_ptr<InternedLotteryCoinstakes> internedCoinstakes = std::make_shared<InternedLotteryCoinstakes>();
+                internCoinstakes(coinstakes, *internedCoinstakes);
+                storage = internedCoinstakes;
             }
-
         }
         READWRITE(heightOfDataStorage);
     }
@@ -10,6 +10,34 @@
 #include <BlockDiskAccessor.h>
 #include <I_SuperblockHeightValidator.h>
 #include <ForkActivation.h>
+#include <functional>
+
+namespace
+{
+
+/** Upper bound on the scores kept for one lottery cycle; every qualifying
+ *  coinstake of a cycle is scored once, including those of competing forks.  */
+constexpr size_t MAX_CACHED_LOTTERY_SCORES = 100000;
+
+RankedScoreAwareCoinstakes RankCoinstakes(
+    const LotteryCoinstakes& updatedCoinstakes,
+    const std::function<uint256(const uint256&)>& scoreOfCoinstake)
+{
+    RankedScoreAwareCoinstakes rankedScoreAwareCoinstakes;
+    std::set<CScript> paymentScripts;
+    for(const auto& lotteryCoinstake : updatedCoinstakes)
+    {
+        RankAwareScore rankedScore = {
+            scoreOfCoinstake(lotteryCoinstake.first),
+            rankedScoreAwareCoinstakes.size(),
+            paymentScripts.count(lotteryCoinstake.second)>0  };
+        rankedScoreAwareCoinstakes.emplace(lotteryCoinstake.first, std::move(rankedScore));
+        paymentScripts.insert(lotteryCoinstake.second);
+    }
+    return rankedScoreAwareCoinstakes;
+}
+
+} // anonymous namespace
 
 LotteryWinnersCalculator::LotteryWinnersCalculator(
     int startOfLotteryBlocks,
@@ -20,6 +48,11 @@ LotteryWinnersCalculator::LotteryWinnersCalculator(
     , activeChain_(activeChain)
     , sporkManager_(sporkManager)
     , superblockHeightValidator_(superblockHeightValidator)
+    , cs_lotteryCycleCache_()
+    , scoresLotteryBlockHash_()
+    , scoreByCoinstakeHash_()
+    , vetoingBlockHashes_()
+    , vetoedPaymentScripts_()
 {
 }
 
@@ -72,21 +105,28 @@ bool LotteryWinnersCalculator::IsPaymentScriptVetoed(const CScript& paymentScrip
     const int lotteryBlockPaymentCycle = superblockHeightValidator_.GetLotteryBlockPaymentCycle(blockHeight);
     const int nLastLotteryHeight = std::max(startOfLotteryBlocks_,  lotteryBlockPaymentCycle* ((blockHeight - 1) / lotteryBlockPaymentCycle) );
     constexpr int numberOfLotteryCyclesToVetoFor = 3;
+    std::vector<const CBlockIndex*> vetoingBlocks;
+    std::vector<uint256> vetoingBlockHashes;
     for (int lotteryCycleCount = 0; lotteryCycleCount < numberOfLotteryCyclesToVetoFor; ++lotteryCycleCount)
     {
         const CBlockIndex* blockIndexPreceedingPriorLotteryBlock = activeChain_[ nLastLotteryHeight-lotteryBlockPaymentCycle*lotteryCycleCount-1];
-        if(!blockIndexPreceedingPriorLotteryBlock)
+        if(!blockIndexPreceedingPriorLotteryBlock) break;
+        vetoingBlocks.push_back(blockIndexPreceedingPriorLotteryBlock);
+        vetoingBlockHashes.push_back(blockIndexPreceedingPriorLotteryBlock->GetBlockHash());
+    }
+
+    LOCK(cs_lotteryCycleCache_);
+    if(vetoingBlockHashes != vetoingBlockHashes_)
+    {
+        vetoedPaymentScripts_.clear();
+        for(const CBlockIndex* vetoingBlock: vetoingBlocks)
         {
-            return false;
+            for(const LotteryCoinstake& previousWinner: vetoingBlock->vLotteryWinnersCoinstakes.getLotteryCoinstakes())
+                vetoedPaymentScripts_.insert(previousWinner.second);
         }
-        const LotteryCoinstakes& previousWinners = blockIndexPreceedingPriorLotteryBlock->vLotteryWinnersCoinstakes.getLotteryCoinstakes();
-        LotteryCoinstakes::const_iterator it = std::find_if(previousWinners.begin(),previousWinners.end(),
-            [&paymentScript](const LotteryCoinstake& coinstake){
-                return coinstake.second == paymentScript;
-            });
-        if(it != previousWinners.end()) return true;
+        vetoingBlockHashes_.swap(vetoingBlockHashes);
     }
-    return false;
+    return vetoedPaymentScripts_.count(paymentScript) > 0;
 }
 
 static void SortCoinstakesByScore(const RankedScoreAwareCoinstakes& rankedScoreAwareCoinstakes, LotteryCoinstakes& updatedCoinstakes)
@@ -137,18 +177,40 @@ bool LotteryWinnersCalculator::TopElevenBestCoinstakesNeedUpdating(
 
 RankedScoreAwareCoinstakes LotteryWinnersCalculator::computeRankedScoreAwareCoinstakes(const uint256& lastLotteryBlockHash, const LotteryCoinstakes& updatedCoinstakes)
 {
-    RankedScoreAwareCoinstakes rankedScoreAwareCoinstakes;
-    std::set<CScript> paymentScripts;
-    for(const auto& lotteryCoinstake : updatedCoinstakes)
+    return RankCoinstakes(updatedCoinstakes,
+        [&lastLotteryBlockHash](const uint256& coinstakeHash)
+        {
+            return LotteryWinnersCalculator::CalculateLotteryScore(coinstakeHash, lastLotteryBlockHash);
+        });
+}
+
+RankedScoreAwareCoinstakes LotteryWinnersCalculator::rankCoinstakesWithCachedScores(
+    const uint256& lastLotteryBlockHash,
+    const LotteryCoinstakes& updatedCoinstakes) const
+{
+    LOCK(cs_lotteryCycleCache_);
+    if(scoresLotteryBlockHash_ != lastLotteryBlockHash || scoreByCoinstakeHash_.size() >= MAX_CACHED_LOTTERY_SCORES)
     {
-        RankAwareScore rankedScore = {
-            LotteryWinnersCalculator::CalculateLotteryScore(lotteryCoinstake.first, lastLotteryBlockHash),
-            rankedScoreAwareCoinstakes.size(),
-            paymentScripts.count(lotteryCoinstake.second)>0  };
-        rankedScoreAwareCoinstakes.emplace(lotteryCoinstake.first, std::move(rankedScore));
-        paymentScripts.insert(lotteryCoinstake.second);
+        scoreByCoinstakeHash_.clear();
+        scoresLotteryBlockHash_ = lastLotteryBlockHash;
     }
-    return rankedScoreAwareCoinstakes;
+    return RankCoinstakes(updatedCoinstakes,
+        [this, &lastLotteryBlockHash](const uint256& coinstakeHash)
+        {
+            auto it = scoreByCoinstakeHash_.find(coinstakeHash);
+            if(it == scoreByCoinstakeHash_.end())
+            {
+                it = scoreByCoinstakeHash_.emplace(
+                    coinstakeHash, LotteryWinnersCalculator::CalculateLotteryScore(coinstakeHash, lastLotteryBlockHash)).first;
+            }
+            return it->second;
+        });
+}
+
+size_t LotteryWinnersCalculator::GetCachedLotteryScoreCount(const uint256& lastLotteryBlockHash) const
+{
+    LOCK(cs_lotteryCycleCache_);
+    return scoresLotteryBlockHash_ == lastLotteryBlockHash ? scoreByCoinstakeHash_.size() : 0u;
 }
 
 bool LotteryWinnersCalculator::UpdateCoinstakes(int nextBlockHeight, LotteryCoinstakes& updatedCoinstakes) const
@@ -162,7 +224,7 @@ bool LotteryWinnersCalculator::UpdateCoinstakes(int nextBlockHeight, LotteryCoin
     }
 
     RankedScoreAwareCoinstakes rankedScoreAwareCoinstakes =
-        computeRankedScoreAwareCoinstakes(lastLotteryBlockIndex->GetBlockHash(), updatedCoinstakes);
+        rankCoinstakesWithCachedScores(lastLotteryBlockIndex->GetBlockHash(), updatedCoinstakes);
     SortCoinstakesByScore(rankedScoreAwareCoinstakes,updatedCoinstakes);
 
     return TopElevenBestCoinstakesNeedUpdating(
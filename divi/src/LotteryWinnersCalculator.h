@@ -2,6 +2,10 @@
 #define LOTTERY_WINNERS_CALCULATOR_H
 #include <LotteryCoinstakes.h>
 #include <amount.h>
+#include <map>
+#include <set>
+#include <vector>
+#include <sync.h>
 
 class CBlockIndex;
 class CTransaction;
@@ -23,8 +27,20 @@ private:
     const CChain& activeChain_;
     const CSporkManager& sporkManager_;
     const I_SuperblockHeightValidator& superblockHeightValidator_;
+
+    /** Scores only depend on the coinstake and the last lottery block, so
+     *  they are kept for the running lottery cycle, together with the
+     *  payment scripts of the winners that are vetoed during it.  */
+    mutable CCriticalSection cs_lotteryCycleCache_;
+    mutable uint256 scoresLotteryBlockHash_;
+    mutable std::map<uint256,uint256> scoreByCoinstakeHash_;
+    mutable std::vector<uint256> vetoingBlockHashes_;
+    mutable std::set<CScript> vetoedPaymentScripts_;
+
     CAmount minimumCoinstakeForTicket(int nHeight) const;
     bool IsPaymentScriptVetoed(const CScript& paymentScript, const int blockHeight) const;
+    RankedScoreAwareCoinstakes rankCoinstakesWithCachedScores(
+        const uint256& lastLotteryBlockHash, const LotteryCoinstakes& updatedCoinstakes) const;
     bool TopElevenBestCoinstakesNeedUpdating(
         bool trimDuplicates,
         const RankedScoreAwareCoinstakes& rankedScoreAwareCoinstakes,
@@ -41,6 +57,8 @@ public:
     bool IsCoinstakeValidForLottery(const CTransaction &tx, int nHeight) const;
     const CBlockIndex* GetLastLotteryBlockIndexBeforeHeight(int blockHeight) const;
     bool UpdateCoinstakes(int nextBlockHeight, LotteryCoinstakes& updatedCoinstakes) const;
+    /** Number of scores kept for the cycle that follows the given lottery block */
+    size_t GetCachedLotteryScoreCount(const uint256& lastLotteryBlockHash) const;
     LotteryCoinstakeData CalculateUpdatedLotteryWinners(const CTransaction& coinMintTransaction, const LotteryCoinstakeData& previousBlockLotteryCoinstakeData, int nHeight) const;
 };
 #endif // LOTTERY_WINNERS_CALCULATOR_H
@@ -1,5 +1,7 @@
 #include <MemPoolEntry.h>
 
+#include <assert.h>
+#include <memusage.h>
 #include <serialize.h>
 #include <version.h>
 
@@ -21,6 +23,20 @@ static unsigned int CalculateModifiedSize(const CTransaction& tx, unsigned int n
     return nTxSize;
 }
 
+static size_t RecursiveDynamicUsage(const CTransaction& tx)
+{
+    size_t usage = memusage::DynamicUsage(tx.vin) + memusage::DynamicUsage(tx.vout);
+    for (const CTxIn& input : tx.vin) {
+        const std::vector<unsigned char>& script = input.scriptSig;
+        usage += memusage::DynamicUsage(script);
+    }
+    for (const CTxOut& output : tx.vout) {
+        const std::vector<unsigned char>& script = output.scriptPubKey;
+        usage += memusage::DynamicUsage(script);
+    }
+    return usage;
+}
+
 CTxMemPoolEntry::CTxMemPoolEntry(
     const CTransaction& _tx,
     const CAmount& _nFee,
@@ -31,13 +47,23 @@ CTxMemPoolEntry::CTxMemPoolEntry(
     , nFee(_nFee)
     , nTxSize(0u)
     , nModSize(0u)
+    , nUsageSize(RecursiveDynamicUsage(_tx))
     , nTime(_nTime)
     , initialCoinAgePerByteOfInputs(0.0)
     , nHeight(_nHeight)
+    , feeDelta(0)
+    , nCountWithDescendants(1u)
+    , nSizeWithDescendants(0u)
+    , nModFeesWithDescendants(_nFee)
+    , nCountWithAncestors(1u)
+    , nSizeWithAncestors(0u)
+    , nModFeesWithAncestors(_nFee)
 {
     nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
     nModSize = CalculateModifiedSize(tx,nTxSize);
     initialCoinAgePerByteOfInputs = nModSize? _initialCoinAgeOfInputs/ nModSize: 0.0;
+    nSizeWithDescendants = nTxSize;
+    nSizeWithAncestors = nTxSize;
 }
 
 CTxMemPoolEntry::CTxMemPoolEntry(const CTxMemPoolEntry& other)
@@ -50,4 +76,28 @@ double CTxMemPoolEntry::ComputeInputCoinAgePerByte(unsigned int currentHeight) c
     CAmount nValueIn = tx.GetValueOut() + nFee;
     double deltaCoinAgePerByteOfInputs = nModSize > 0u? ((double)(currentHeight - nHeight) * nValueIn) / nModSize : 0.0;
     return initialCoinAgePerByteOfInputs + deltaCoinAgePerByteOfInputs;
-}
\ No newline at end of file
+}
+void CTxMemPoolEntry::UpdateDescendantState(int64_t modifySize, CAmount modifyFee, int64_t modifyCount)
+{
+    nSizeWithDescendants += modifySize;
+    assert(int64_t(nSizeWithDescendants) > 0);
+    nModFeesWithDescendants += modifyFee;
+    nCountWithDescendants += modifyCount;
+    assert(int64_t(nCountWithDescendants) > 0);
+}
+
+void CTxMemPoolEntry::UpdateAncestorState(int64_t modifySize, CAmount modifyFee, int64_t modifyCount)
+{
+    nSizeWithAncestors += modifySize;
+    assert(int64_t(nSizeWithAncestors) > 0);
+    nModFeesWithAncestors += modifyFee;
+    nCountWithAncestors += modifyCount;
+    assert(int64_t(nCountWithAncestors) > 0);
+}
+
+void CTxMemPoolEntry::UpdateFeeDelta(CAmount newFeeDelta)
+{
+    nModFeesWithDescendants += newFeeDelta - feeDelta;
+    nModFeesWithAncestors += newFeeDelta - feeDelta;
+    feeDelta = newFeeDelta;
+}
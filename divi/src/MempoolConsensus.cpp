@@ -1,5 +1,7 @@
 #include <MempoolConsensus.h>
 
+#include <list>
+#include <map>
 #include <sync.h>
 #include <primitives/transaction.h>
 #include <defaultValues.h>
@@ -16,6 +18,8 @@
 #include <coins.h>
 #include <TransactionOpCounting.h>
 #include <UtxoCheckingAndUpdating.h>
+#include <TransactionInputChecker.h>
+#include <blockmap.h>
 #include <script/SignatureCheckers.h>
 #include <ValidationState.h>
 #include <Logging.h>
@@ -265,14 +269,13 @@ bool CheckFeesPaidAreAcceptable(
     return true;
 }
 
-bool MempoolConsensus::AcceptToMemoryPool(CTxMemPool& pool, CValidationState& state, const CTransaction& tx, bool fLimitFree, bool* pfMissingInputs, bool ignoreFees)
+/** Checks that only need the transaction itself and the pool **/
+static bool CheckTransactionBeforeFetchingInputs(
+    CTxMemPool& pool,
+    CValidationState& state,
+    const CTransaction& tx,
+    bool requireStandard)
 {
-    AssertLockHeld(cs_main);
-    if (pfMissingInputs)
-        *pfMissingInputs = false;
-
-    const bool requireStandard = !settings.GetBoolArg("-acceptnonstandard", false);
-
     if (!CheckTransaction(tx, state))
         return state.DoS(100, error("%s: : CheckTransaction failed",__func__), REJECT_INVALID, "bad-tx");
 
@@ -312,8 +315,159 @@ bool MempoolConsensus::AcceptToMemoryPool(CTxMemPool& pool, CValidationState& st
             }
         }
     }
+    return true;
+}
+
+/** Brings the inputs of tx into view, which has to be backed by the pool **/
+static bool FetchTransactionInputs(
+    CValidationState& state,
+    const CTransaction& tx,
+    CCoinsViewCache& view,
+    bool* pfMissingInputs,
+    CAmount& nValueIn)
+{
+    const uint256 hash = tx.GetHash();
+    // do we already have it?
+    if (view.HaveCoins(hash))
+    {
+        LogPrint("mempool","%s - tx %s outputs already exist\n",__func__,hash);
 
+        return false;
+    }
 
+    // do all inputs exist?
+    // Note that this does not check for the presence of actual outputs (see the next check for that),
+    // only helps filling in pfMissingInputs (to determine missing vs spent).
+    for (const CTxIn txin : tx.vin) {
+        if (!view.HaveCoins(txin.prevout.hash)) {
+            if (pfMissingInputs)
+                *pfMissingInputs = true;
+            LogPrint("mempool","%s - unknown tx %s input\n",__func__, txin.prevout.hash);
+            return false;
+        }
+    }
+
+    // are the actual inputs available?
+    if (!view.HaveInputs(tx))
+        return state.Invalid(error("%s : inputs already spent",__func__),
+                             REJECT_DUPLICATE, "bad-txns-inputs-spent");
+
+    // Bring the best block into scope
+    view.GetBestBlock();
+
+    nValueIn = view.GetValueIn(tx);
+    return true;
+}
+
+/** Standardness and sigop limits of the fetched inputs **/
+static bool CheckFetchedInputsAreStandard(
+    CValidationState& state,
+    const CTransaction& tx,
+    const CCoinsViewCache& view,
+    bool requireStandard)
+{
+    // Check for non-standard pay-to-script-hash in inputs
+    if (requireStandard && !MempoolConsensus::AreInputsStandard(tx, view))
+        return error("%s: : nonstandard transaction input",__func__);
+
+    // Check that the transaction doesn't have an excessive number of
+    // sigops, making it impossible to mine. Since the coinbase transaction
+    // itself can contain sigops MAX_TX_SIGOPS is less than
+    // MAX_BLOCK_SIGOPS; we still consider this an invalid rather than
+    // merely non-standard transaction.
+    unsigned int nSigOps = GetLegacySigOpCount(tx);
+    unsigned int nMaxSigOps = MAX_TX_SIGOPS_CURRENT;
+    nSigOps += GetP2SHSigOpCount(tx, view);
+    if(nSigOps > nMaxSigOps)
+        return state.DoS(0,
+                         error("%s : too many sigops %s, %d > %d",
+                                __func__,
+                               tx.GetHash(), nSigOps, nMaxSigOps),
+                         REJECT_NONSTANDARD, "bad-txns-too-many-sigops");
+    return true;
+}
+
+/** Relay fee, priority and pool minimum fee requirements of the new entry **/
+static bool CheckEntryPaysEnoughFees(
+    CTxMemPool& pool,
+    CValidationState& state,
+    const CTxMemPoolEntry& entry,
+    bool fLimitFree,
+    size_t maxMempoolSize)
+{
+    const uint256 hash = entry.GetTx().GetHash();
+    // Don't accept it if it can't get into a block
+    if (!CheckFeesPaidAreAcceptable(entry,fLimitFree,state,pool))
+    {
+        LogPrint("mempool","%s - Conflicting tx spending same inputs%s",__func__, hash);
+        return false;
+    }
+
+    // Once the pool has been trimmed, new transactions have to pay more
+    // than the packages that were evicted to make room
+    double dPriorityDelta = 0;
+    CAmount nFeeDelta = 0;
+    pool.ApplyDeltas(hash, dPriorityDelta, nFeeDelta);
+    const CAmount mempoolRejectFee = pool.GetMinFee(maxMempoolSize).GetFee(entry.GetTxSize());
+    if (mempoolRejectFee > 0 && entry.GetFee() + nFeeDelta < mempoolRejectFee)
+        return state.DoS(0, error("%s : mempool min fee not met %s, %d < %d",__func__,
+                                    hash, entry.GetFee() + nFeeDelta, mempoolRejectFee),
+                         REJECT_INSUFFICIENTFEE, "mempool min fee not met");
+    return true;
+}
+
+/** Script verification of the inputs; with pvChecks set, only the checks
+ *  against the standard flags are appended to it to be run later instead of
+ *  being run right away **/
+static bool CheckInputScripts(
+    CValidationState& state,
+    const CTransaction& tx,
+    const CCoinsViewCache& view,
+    const BlockMap& blockMap,
+    std::vector<CScriptCheck>* pvChecks)
+{
+    const uint256 hash = tx.GetHash();
+    // Check against previous transactions
+    // This is done last to help prevent CPU exhaustion denial-of-service attacks.
+    if (!CheckInputs(tx, state, view, blockMap, true, STANDARD_SCRIPT_VERIFY_FLAGS, pvChecks)) {
+        return error("%s: : ConnectInputs failed %s",__func__, hash);
+    }
+    // The deferred checks have not run yet, a failure is diagnosed when the
+    // caller repeats this serially
+    if (pvChecks)
+        return true;
+
+    // Check again against just the consensus-critical mandatory script
+    // verification flags, in case of bugs in the standard flags that cause
+    // transactions to pass as valid when they're actually invalid. For
+    // instance the STRICTENC flag was incorrectly allowing certain
+    // CHECKSIG NOT scripts to pass, even though they were invalid.
+    //
+    // There is a similar check in CreateNewBlock() to prevent creating
+    // invalid blocks, however allowing such transactions into the mempool
+    // can be exploited as a DoS attack.
+    if (!CheckInputs(tx, state, view, blockMap, true, MANDATORY_SCRIPT_VERIFY_FLAGS, pvChecks)) {
+        return error("%s: : BUG! PLEASE REPORT THIS! ConnectInputs failed against MANDATORY but not STANDARD flags %s",__func__, hash);
+    }
+    return true;
+}
+
+bool MempoolConsensus::AcceptToMemoryPool(CTxMemPool& pool, CValidationState& state, const CTransaction& tx, bool fLimitFree, bool* pfMissingInputs, bool ignoreFees)
+{
+    return AcceptToMemoryPoolWithTime(pool, state, tx, fLimitFree, GetTime(), pfMissingInputs, ignoreFees);
+}
+
+bool MempoolConsensus::AcceptToMemoryPoolWithTime(CTxMemPool& pool, CValidationState& state, const CTransaction& tx, bool fLimitFree, int64_t nAcceptTime, bool* pfMissingInputs, bool ignoreFees)
+{
+    AssertLockHeld(cs_main);
+    if (pfMissingInputs)
+        *pfMissingInputs = false;
+
+    const bool requireStandard = !settings.GetBoolArg("-acceptnonstandard", false);
+    if (!CheckTransactionBeforeFetchingInputs(pool, state, tx, requireStandard))
+        return false;
+
+    const uint256 hash = tx.GetHash();
     {
         const ChainstateManager::Reference chainstate;
 
@@ -325,98 +479,154 @@ bool MempoolConsensus::AcceptToMemoryPool(CTxMemPool& pool, CValidationState& st
             const CCoinsViewMemPool viewMemPool(&chainstate->CoinsTip(), pool);
             temporaryBacking.SetBackend(viewMemPool);
 
-            // do we already have it?
-            if (view.HaveCoins(hash))
-            {
-                LogPrint("mempool","%s - tx %s outputs already exist\n",__func__,hash);
-
+            if (!FetchTransactionInputs(state, tx, view, pfMissingInputs, nValueIn))
                 return false;
-            }
-
-            // do all inputs exist?
-            // Note that this does not check for the presence of actual outputs (see the next check for that),
-            // only helps filling in pfMissingInputs (to determine missing vs spent).
-            for (const CTxIn txin : tx.vin) {
-                if (!view.HaveCoins(txin.prevout.hash)) {
-                    if (pfMissingInputs)
-                        *pfMissingInputs = true;
-                    LogPrint("mempool","%s - unknown tx %s input\n",__func__, txin.prevout.hash);
-                    return false;
-                }
-            }
-
-            // are the actual inputs available?
-            if (!view.HaveInputs(tx))
-                return state.Invalid(error("%s : inputs already spent",__func__),
-                                     REJECT_DUPLICATE, "bad-txns-inputs-spent");
-
-            // Bring the best block into scope
-            view.GetBestBlock();
-
-            nValueIn = view.GetValueIn(tx);
 
             // we have all inputs cached now, so switch back to dummy, so we don't need to keep lock on mempool
             temporaryBacking.DettachBackend();
         }
 
-        // Check for non-standard pay-to-script-hash in inputs
-        if (requireStandard && !MempoolConsensus::AreInputsStandard(tx, view))
-            return error("%s: : nonstandard transaction input",__func__);
-
-        // Check that the transaction doesn't have an excessive number of
-        // sigops, making it impossible to mine. Since the coinbase transaction
-        // itself can contain sigops MAX_TX_SIGOPS is less than
-        // MAX_BLOCK_SIGOPS; we still consider this an invalid rather than
-        // merely non-standard transaction.
-        {
-            unsigned int nSigOps = GetLegacySigOpCount(tx);
-            unsigned int nMaxSigOps = MAX_TX_SIGOPS_CURRENT;
-            nSigOps += GetP2SHSigOpCount(tx, view);
-            if(nSigOps > nMaxSigOps)
-                return state.DoS(0,
-                                 error("%s : too many sigops %s, %d > %d",
-                                        __func__,
-                                       hash, nSigOps, nMaxSigOps),
-                                 REJECT_NONSTANDARD, "bad-txns-too-many-sigops");
-        }
+        if (!CheckFetchedInputsAreStandard(state, tx, view, requireStandard))
+            return false;
 
         const CAmount nFees = nValueIn - tx.GetValueOut();
         const int64_t height = chainstate->ActiveChain().Height();
         const double coinAge = view.ComputeInputCoinAge(tx, height);
-        CTxMemPoolEntry entry(tx, nFees, GetTime(), coinAge, height);
+        CTxMemPoolEntry entry(tx, nFees, nAcceptTime, coinAge, height);
 
-        // Don't accept it if it can't get into a block
-        // but prioritise dstx and don't check fees for it
-        if (!ignoreFees && !CheckFeesPaidAreAcceptable(entry,fLimitFree,state,pool))
-        {
-            LogPrint("mempool","%s - Conflicting tx spending same inputs%s",__func__, hash);
+        // Prioritise dstx and don't check fees for it
+        const size_t maxMempoolSize = settings.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+        if (!ignoreFees && !CheckEntryPaysEnoughFees(pool, state, entry, fLimitFree, maxMempoolSize))
             return false;
-        }
-
-        // Check against previous transactions
-        // This is done last to help prevent CPU exhaustion denial-of-service attacks.
-        if (!CheckInputs(tx, state, view, chainstate->GetBlockMap(), true, STANDARD_SCRIPT_VERIFY_FLAGS)) {
-            return error("%s: : ConnectInputs failed %s",__func__, hash);
-        }
 
-        // Check again against just the consensus-critical mandatory script
-        // verification flags, in case of bugs in the standard flags that cause
-        // transactions to pass as valid when they're actually invalid. For
-        // instance the STRICTENC flag was incorrectly allowing certain
-        // CHECKSIG NOT scripts to pass, even though they were invalid.
-        //
-        // There is a similar check in CreateNewBlock() to prevent creating
-        // invalid blocks, however allowing such transactions into the mempool
-        // can be exploited as a DoS attack.
-        if (!CheckInputs(tx, state, view, chainstate->GetBlockMap(), true, MANDATORY_SCRIPT_VERIFY_FLAGS)) {
-            return error("%s: : BUG! PLEASE REPORT THIS! ConnectInputs failed against MANDATORY but not STANDARD flags %s",__func__, hash);
-        }
+        if (!CheckInputScripts(state, tx, view, chainstate->GetBlockMap(), nullptr))
+            return false;
 
         // Store transaction in memory
         pool.addUnchecked(hash, entry);
+
+        std::list<CTransaction> evicted;
+        pool.TrimToSize(maxMempoolSize, evicted);
+        if (!pool.exists(hash))
+            return state.DoS(0, error("%s : mempool full, %s evicted right away",__func__, hash),
+                             REJECT_INSUFFICIENTFEE, "mempool full");
     }
 
     GetMainNotificationInterface().SyncTransactions(std::vector<CTransaction>({tx}), NULL,TransactionSyncType::MEMPOOL_TX_ADD);
 
     return true;
-}
\ No newline at end of file
+}
+
+MempoolConsensus::TransactionAcceptanceResult::TransactionAcceptanceResult(
+    ): state()
+    , accepted(false)
+    , missingInputs(false)
+{
+}
+
+unsigned MempoolConsensus::AcceptTransactionsToMemoryPool(
+    CTxMemPool& pool,
+    const std::vector<std::pair<CTransaction, int64_t>>& transactionsWithAcceptTime,
+    bool fLimitFree,
+    std::vector<TransactionAcceptanceResult>& results,
+    bool ignoreFees)
+{
+    AssertLockHeld(cs_main);
+    results.assign(transactionsWithAcceptTime.size(), TransactionAcceptanceResult());
+    if (transactionsWithAcceptTime.empty())
+        return 0u;
+
+    const bool requireStandard = !settings.GetBoolArg("-acceptnonstandard", false);
+    const size_t maxMempoolSize = settings.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+    const bool deferScriptChecks = TransactionInputChecker::GetScriptCheckingThreadCount() > 0;
+    const ChainstateManager::Reference chainstate;
+    const BlockMap& blockMap = chainstate->GetBlockMap();
+    const int64_t height = chainstate->ActiveChain().Height();
+
+    std::vector<CTransaction> acceptedTransactions;
+    {
+        // The pool stays locked for the whole batch, so that all transactions
+        // share one view and later ones can spend the outputs of earlier ones.
+        LOCK(pool.cs);
+        const CCoinsViewMemPool viewMemPool(&chainstate->CoinsTip(), pool);
+        CCoinsViewCache view(&viewMemPool);
+
+        CValidationState scriptCheckingState;
+        TransactionInputChecker scriptChecker(view, blockMap, scriptCheckingState);
+        std::map<uint256, unsigned> addedTransactionIndices;
+        for (unsigned transactionIndex = 0; transactionIndex < transactionsWithAcceptTime.size(); ++transactionIndex)
+        {
+            const CTransaction& tx = transactionsWithAcceptTime[transactionIndex].first;
+            TransactionAcceptanceResult& result = results[transactionIndex];
+            CAmount nValueIn = 0;
+            if (!CheckTransactionBeforeFetchingInputs(pool, result.state, tx, requireStandard) ||
+                !FetchTransactionInputs(result.state, tx, view, &result.missingInputs, nValueIn) ||
+                !CheckFetchedInputsAreStandard(result.state, tx, view, requireStandard))
+            {
+                continue;
+            }
+
+            const CAmount nFees = nValueIn - tx.GetValueOut();
+            const double coinAge = view.ComputeInputCoinAge(tx, height);
+            CTxMemPoolEntry entry(tx, nFees, transactionsWithAcceptTime[transactionIndex].second, coinAge, height);
+            if (!ignoreFees && !CheckEntryPaysEnoughFees(pool, result.state, entry, fLimitFree, maxMempoolSize))
+                continue;
+
+            std::vector<CScriptCheck> scriptChecks;
+            if (!CheckInputScripts(result.state, tx, view, blockMap, deferScriptChecks? &scriptChecks: nullptr))
+                continue;
+            scriptChecker.ScheduleBackgroundThreadScriptChecking(scriptChecks);
+
+            pool.addUnchecked(tx.GetHash(), entry);
+            addedTransactionIndices[tx.GetHash()] = transactionIndex;
+            result.accepted = true;
+        }
+
+        if (!scriptChecker.WaitForScriptsToBeChecked())
+        {
+            // Find the failing transactions one by one; removing them from the
+            // pool also removes the transactions of the batch that spend them.
+            for (unsigned transactionIndex = 0; transactionIndex < results.size(); ++transactionIndex)
+            {
+                const CTransaction& tx = transactionsWithAcceptTime[transactionIndex].first;
+                TransactionAcceptanceResult& result = results[transactionIndex];
+                if (!result.accepted || CheckInputScripts(result.state, tx, view, blockMap, nullptr))
+                    continue;
+
+                std::list<CTransaction> removed;
+                pool.remove(tx, removed, true);
+                for (const CTransaction& removedTx : removed)
+                {
+                    const auto it = addedTransactionIndices.find(removedTx.GetHash());
+                    if (it == addedTransactionIndices.end())
+                        continue;
+                    TransactionAcceptanceResult& removedResult = results[it->second];
+                    removedResult.accepted = false;
+                    removedResult.missingInputs = it->second != transactionIndex;
+                }
+            }
+        }
+
+        std::list<CTransaction> evicted;
+        pool.TrimToSize(maxMempoolSize, evicted);
+        for (unsigned transactionIndex = 0; transactionIndex < results.size(); ++transactionIndex)
+        {
+            const CTransaction& tx = transactionsWithAcceptTime[transactionIndex].first;
+            TransactionAcceptanceResult& result = results[transactionIndex];
+            if (!result.accepted)
+                continue;
+            if (!pool.exists(tx.GetHash()))
+            {
+                result.accepted = false;
+                result.state.DoS(0, error("%s : mempool full, %s evicted right away",__func__, tx.GetHash()),
+                                 REJECT_INSUFFICIENTFEE, "mempool full");
+                continue;
+            }
+            acceptedTransactions.push_back(tx);
+        }
+    }
+
+    if (!acceptedTransactions.empty())
+        GetMainNotificationInterface().SyncTransactions(acceptedTransactions, NULL, TransactionSyncType::MEMPOOL_TX_ADD);
+    return acceptedTransactions.size();
+}
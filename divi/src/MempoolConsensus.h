@@ -1,9 +1,12 @@
 #ifndef MEMPOOL_CONSENSUS_H
 #define MEMPOOL_CONSENSUS_H
+#include <stdint.h>
 #include <string>
-class CTransaction;
+#include <utility>
+#include <vector>
+#include <primitives/transaction.h>
+#include <ValidationState.h>
 class CCoinsViewCache;
-class CValidationState;
 class CTxMemPool;
 namespace MempoolConsensus
 {
@@ -31,5 +34,30 @@ namespace MempoolConsensus
     bool IsStandardTx(const CTransaction& tx, std::string& reason);
     /** (try to) add transaction to memory pool **/
     bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState& state, const CTransaction& tx, bool fLimitFree, bool* pfMissingInputs = nullptr, bool ignoreFees = false);
+    /** As AcceptToMemoryPool, but the entry is recorded as having entered the pool at nAcceptTime **/
+    bool AcceptToMemoryPoolWithTime(CTxMemPool& pool, CValidationState& state, const CTransaction& tx, bool fLimitFree, int64_t nAcceptTime, bool* pfMissingInputs = nullptr, bool ignoreFees = false);
+
+    /** Outcome for one transaction of AcceptTransactionsToMemoryPool **/
+    struct TransactionAcceptanceResult
+    {
+        CValidationState state;
+        bool accepted;
+        bool missingInputs;
+
+        TransactionAcceptanceResult();
+    };
+    /**
+     * Accepts a batch of transactions, each with the time it is recorded as
+     * having entered the pool, in the given order.  The pool is locked once
+     * and one coins view is shared by the whole batch, so transactions can
+     * spend outputs of earlier ones, and script checks run on the script
+     * checking threads.  Returns the number of accepted transactions.
+     **/
+    unsigned AcceptTransactionsToMemoryPool(
+        CTxMemPool& pool,
+        const std::vector<std::pair<CTransaction, int64_t>>& transactionsWithAcceptTime,
+        bool fLimitFree,
+        std::vector<TransactionAcceptanceResult>& results,
+        bool ignoreFees = false);
 }
 #endif// MEMPOOL_CONSENSUS_H
\ No newline at end of file
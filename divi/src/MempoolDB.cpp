@@ -0,0 +1,167 @@
+#include <MempoolDB.h>
+
+#include <algorithm>
+#include <string.h>
+#include <utility>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include <DataDirectory.h>
+#include <Logging.h>
+#include <MempoolConsensus.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <defaultValues.h>
+#include <serialize.h>
+#include <streams.h>
+#include <sync.h>
+#include <txmempool.h>
+#include <util.h>
+#include <utiltime.h>
+
+extern CCriticalSection cs_main;
+
+namespace
+{
+
+constexpr uint64_t MEMPOOL_DUMP_VERSION = 1;
+
+/** Orders the pool entries such that every transaction comes after the
+ *  ones it spends from the pool, so they can be accepted again in order.
+ *  A transaction always has more in-pool ancestors than any of its parents.  */
+void OrderParentsFirst(
+    const indexed_transaction_set& mapTx,
+    std::vector<const CTxMemPoolEntry*>& orderedEntries)
+{
+    orderedEntries.reserve(mapTx.size());
+    for (const CTxMemPoolEntry& entry : mapTx)
+        orderedEntries.push_back(&entry);
+    std::stable_sort(orderedEntries.begin(), orderedEntries.end(),
+        [](const CTxMemPoolEntry* a, const CTxMemPoolEntry* b) {
+            return a->GetCountWithAncestors() < b->GetCountWithAncestors();
+        });
+}
+
+} // anonymous namespace
+
+MempoolDB::MempoolDB(): pathMempool_(GetDataDir() / "mempool.dat")
+{
+}
+
+MempoolDB::MempoolDB(const boost::filesystem::path& pathMempool): pathMempool_(pathMempool)
+{
+}
+
+bool MempoolDB::Write(const CTxMemPool& mempool) const
+{
+    const int64_t nStart = GetTimeMillis();
+
+    std::map<uint256, CAmount> feeDeltas;
+    mempool.queryFeeDeltas(feeDeltas);
+
+    // Serialize under the pool lock, write the file without it
+    CDataStream ssMempool(SER_DISK, CLIENT_VERSION);
+    uint64_t numberOfTransactions = 0;
+    ssMempool << MEMPOOL_DUMP_VERSION;
+    ssMempool << FLATDATA(Params().MessageStart());
+    ssMempool << feeDeltas;
+    {
+        LOCK(mempool.cs);
+        std::vector<const CTxMemPoolEntry*> orderedEntries;
+        OrderParentsFirst(mempool.mapTx, orderedEntries);
+        numberOfTransactions = orderedEntries.size();
+        ssMempool << numberOfTransactions;
+        for (const CTxMemPoolEntry* entry : orderedEntries)
+            ssMempool << entry->GetTx() << entry->GetTime();
+    }
+
+    const boost::filesystem::path pathTmp = pathMempool_.string() + ".new";
+    FILE* file = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull())
+        return error("%s : Failed to open file %s", __func__, pathTmp.string());
+
+    try {
+        fileout << ssMempool;
+    } catch (std::exception& e) {
+        return error("%s : Serialize or I/O error - %s", __func__, e.what());
+    }
+    FileCommit(fileout.Get());
+    fileout.fclose();
+    if (!RenameOver(pathTmp, pathMempool_))
+        return error("%s : Rename-into-place failed", __func__);
+
+    LogPrintf("Dumped %u mempool transactions to disk: %dms\n", numberOfTransactions, GetTimeMillis() - nStart);
+    return true;
+}
+
+bool MempoolDB::Load(CTxMemPool& mempool, const std::function<bool()>& interruptRequested) const
+{
+    // Nothing was dumped yet, e.g. on the first start
+    if (!boost::filesystem::exists(pathMempool_)) {
+        LogPrint("mempool", "%s : No mempool dump at %s\n", __func__, pathMempool_.string());
+        return true;
+    }
+
+    FILE* file = fopen(pathMempool_.string().c_str(), "rb");
+    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("%s : Failed to open file %s", __func__, pathMempool_.string());
+
+    const int64_t nStart = GetTimeMillis();
+    unsigned numberAccepted = 0;
+    unsigned numberFailed = 0;
+    unsigned numberAlreadyPresent = 0;
+    try {
+        uint64_t version;
+        filein >> version;
+        if (version != MEMPOOL_DUMP_VERSION)
+            return error("%s : Unknown mempool dump version %u", __func__, version);
+
+        unsigned char pchMsgTmp[4];
+        filein >> FLATDATA(pchMsgTmp);
+        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
+            return error("%s : Invalid network magic number", __func__);
+
+        // Deltas go first, so that prioritised transactions pass the fee checks again
+        std::map<uint256, CAmount> feeDeltas;
+        filein >> feeDeltas;
+        for (const auto& feeDelta : feeDeltas)
+            mempool.PrioritiseTransaction(feeDelta.first, feeDelta.second);
+
+        uint64_t numberOfTransactions;
+        filein >> numberOfTransactions;
+        std::vector<std::pair<CTransaction, int64_t> > batch;
+        batch.reserve(MEMPOOL_LOAD_BATCH_SIZE);
+        uint64_t numberRead = 0;
+        while (numberRead < numberOfTransactions && !interruptRequested()) {
+            batch.clear();
+            for (; batch.size() < MEMPOOL_LOAD_BATCH_SIZE && numberRead < numberOfTransactions; ++numberRead) {
+                batch.emplace_back();
+                filein >> batch.back().first >> batch.back().second;
+            }
+
+            LOCK(cs_main);
+            std::vector<std::pair<CTransaction, int64_t> > newTransactions;
+            newTransactions.reserve(batch.size());
+            for (const auto& dumpedTransaction : batch) {
+                if (mempool.exists(dumpedTransaction.first.GetHash()))
+                    ++numberAlreadyPresent;
+                else
+                    newTransactions.push_back(dumpedTransaction);
+            }
+            constexpr const bool limitFreeTxProcessing = false;
+            std::vector<MempoolConsensus::TransactionAcceptanceResult> results;
+            const unsigned numberAcceptedInBatch =
+                MempoolConsensus::AcceptTransactionsToMemoryPool(mempool, newTransactions, limitFreeTxProcessing, results);
+            numberAccepted += numberAcceptedInBatch;
+            numberFailed += newTransactions.size() - numberAcceptedInBatch;
+        }
+    } catch (std::exception& e) {
+        return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+
+    LogPrintf("Imported mempool transactions from disk: %u accepted, %u failed, %u already present: %dms\n",
+        numberAccepted, numberFailed, numberAlreadyPresent, GetTimeMillis() - nStart);
+    return true;
+}
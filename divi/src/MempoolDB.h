@@ -0,0 +1,29 @@
+#ifndef MEMPOOL_DB_H
+#define MEMPOOL_DB_H
+#include <functional>
+#include <boost/filesystem/path.hpp>
+
+class CTxMemPool;
+
+/** Access to the dump of the memory pool (mempool.dat) that is written at
+ *  shutdown and reloaded, revalidating every transaction against the current
+ *  chain, at the next start.  */
+class MempoolDB
+{
+private:
+    boost::filesystem::path pathMempool_;
+
+public:
+    MempoolDB();
+    explicit MempoolDB(const boost::filesystem::path& pathMempool);
+
+    /** Writes the transactions of the pool, parents before children, with
+     *  the time they entered it and the fee deltas set by prioritisetransaction.  */
+    bool Write(const CTxMemPool& mempool) const;
+
+    /** Reads the dump back in batches, taking cs_main for each batch only,
+     *  and stops early once interruptRequested returns true.  A missing dump
+     *  is not an error, the pool is simply left as it is.  */
+    bool Load(CTxMemPool& mempool, const std::function<bool()>& interruptRequested) const;
+};
+#endif// MEMPOOL_DB_H
@@ -21,6 +21,8 @@ uint64_t nLocalHostNonce = 0;
 // These quantities are measured in bytes
 unsigned int MaxSendBufferSize() { return 1000 * settings.GetArg("-maxsendbuffer", 1 * 1000); }
 unsigned int MaxReceiveBufferSize() { return 1000 * settings.GetArg("-maxreceivebuffer", 5 * 1000); }
+// typical socket buffer is 8K-64K
+constexpr int MAXIMUM_BYTES_PER_READ = 0x10000;
 
 CNetMessage::CNetMessage(int nTypeIn, int nVersionIn) : hdrbuf(nTypeIn, nVersionIn), vRecv(nTypeIn, nVersionIn)
 {
@@ -239,7 +241,7 @@ void QueuedMessageConnection::CloseCommsChannel()
 }
 
 // requires LOCK(cs_vSend)
-void QueuedMessageConnection::SendData()
+bool QueuedMessageConnection::SendData()
 {
     AssertLockHeld(cs_vSend);
     std::deque<CSerializeData>::iterator it = vSendMsg.begin();
@@ -272,19 +274,20 @@ void QueuedMessageConnection::SendData()
         }
     }
 
-    if (it == vSendMsg.end()) {
+    const bool sentEverything = it == vSendMsg.end();
+    if (sentEverything) {
         assert(nSendOffset == 0);
         assert(nSendSize == 0);
     }
     vSendMsg.erase(vSendMsg.begin(), it);
+    return sentEverything;
 }
 
 // Requires LOCK(cs_vRecvMsg)
-void QueuedMessageConnection::ReceiveData(boost::condition_variable& messageHandlerCondition)
+int QueuedMessageConnection::ReceiveData(boost::condition_variable& messageHandlerCondition)
 {
     AssertLockHeld(cs_vRecvMsg);
-    // typical socket buffer is 8K-64K
-    char pchBuf[0x10000];
+    char pchBuf[MAXIMUM_BYTES_PER_READ];
     int nBytes = channel_.receiveData(&pchBuf[0], sizeof(pchBuf));
     if (nBytes > 0) {
         if (!ConvertDataBufferToNetworkMessage(pchBuf, nBytes,messageHandlerCondition))
@@ -301,6 +304,7 @@ void QueuedMessageConnection::ReceiveData(boost::condition_variable& messageHand
         // error
         CloseCommsAndDisconnect();
     }
+    return nBytes;
 }
 
 bool QueuedMessageConnection::TrySendData()
@@ -319,6 +323,35 @@ bool QueuedMessageConnection::TryReceiveData(boost::condition_variable& messageH
     return true;
 }
 
+bool QueuedMessageConnection::ReceiveAvailableData(boost::condition_variable& messageHandlerCondition)
+{
+    TRY_LOCK(cs_vRecvMsg, lockRecv);
+    if (!lockRecv)
+        return false;
+    while (!fDisconnect && channel_.isValid())
+    {
+        if (!IsAvailableToReceive())
+            return false;
+        // A short read means the channel has been drained
+        if (ReceiveData(messageHandlerCondition) < MAXIMUM_BYTES_PER_READ)
+            break;
+    }
+    return true;
+}
+bool QueuedMessageConnection::SendQueuedData(bool& channelWouldBlock)
+{
+    TRY_LOCK(cs_vSend, lockSend);
+    if (!lockSend)
+        return false;
+    channelWouldBlock = !SendData() && channel_.isValid();
+    return true;
+}
+bool QueuedMessageConnection::HasQueuedSendData()
+{
+    TRY_LOCK(cs_vSend, lockSend);
+    return !lockSend || IsAvailableToSend();
+}
+
 void QueuedMessageConnection::CloseCommsAndDisconnect()
 {
     fDisconnect = true;
@@ -644,6 +677,18 @@ bool CNode::TryReceiveData(boost::condition_variable& messageHandlerCondition)
 {
     return messageConnection_.TryReceiveData(messageHandlerCondition);
 }
+bool CNode::ReceiveAvailableData(boost::condition_variable& messageHandlerCondition)
+{
+    return messageConnection_.ReceiveAvailableData(messageHandlerCondition);
+}
+bool CNode::SendQueuedData(bool& channelWouldBlock)
+{
+    return messageConnection_.SendQueuedData(channelWouldBlock);
+}
+bool CNode::HasQueuedSendData()
+{
+    return messageConnection_.HasQueuedSendData();
+}
 NodeBufferStatus CNode::GetSendBufferStatus() const
 {
     return messageConnection_.GetSendBufferStatus();
@@ -674,6 +719,10 @@ void CNode::LogMessageSize(unsigned int messageDataSize) const
     LogPrint("net", "(%d bytes) peer=%d\n", messageDataSize, id);
 }
 
+CCriticalSection& CNode::GetMessageProcessingLock()
+{
+    return cs_messageProcessing;
+}
 void CNode::ProcessReceiveMessages(bool& shouldSleep)
 {
     TRY_LOCK(messageConnection_.GetReceiveLock(), lockRecv);
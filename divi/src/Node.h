@@ -134,8 +134,9 @@ private:
 
     size_t GetSendBufferSize() const;
 
-    void SendData();
-    void ReceiveData(boost::condition_variable& messageHandlerCondition);
+    /** Returns true if the whole send queue went out. */
+    bool SendData();
+    int ReceiveData(boost::condition_variable& messageHandlerCondition);
     bool ConvertDataBufferToNetworkMessage(const char* pch, unsigned int nBytes,boost::condition_variable& messageHandlerCondition);
     unsigned int GetTotalRecvSize();
 
@@ -161,6 +162,16 @@ public:
     void CloseCommsAndDisconnect();
     bool TrySendData();
     bool TryReceiveData(boost::condition_variable& messageHandlerCondition);
+    /** Used with edge-triggered socket events, which report readiness only once:
+     *  reads until the channel is drained, and returns false if data may be left
+     *  because the receive buffer is full or busy.  */
+    bool ReceiveAvailableData(boost::condition_variable& messageHandlerCondition);
+    /** Used with edge-triggered socket events: returns false if the send buffer
+     *  is busy and nothing was sent, otherwise sets channelWouldBlock when data
+     *  is left because the channel takes no more for now.  */
+    bool SendQueuedData(bool& channelWouldBlock);
+    /** True if the send buffer is not empty, or busy being filled. */
+    bool HasQueuedSendData();
 
     bool IsAvailableToReceive();
     bool IsAvailableToSend();
@@ -194,6 +205,9 @@ private:
     I_CommunicationChannel& channel_;
     QueuedMessageConnection messageConnection_;
     std::deque<CInv> vRecvGetData;
+    /** Held by the message handler worker that currently processes and
+     *  sends this peer's messages, so they stay in order.  */
+    CCriticalSection cs_messageProcessing;
     int nVersion;
     uint64_t nServices;
     int64_t nTimeConnected;
@@ -226,6 +240,9 @@ public:
     CommsMode SelectCommunicationMode();
     bool TrySendData();
     bool TryReceiveData(boost::condition_variable& messageHandlerCondition);
+    bool ReceiveAvailableData(boost::condition_variable& messageHandlerCondition);
+    bool SendQueuedData(bool& channelWouldBlock);
+    bool HasQueuedSendData();
     NodeBufferStatus GetSendBufferStatus() const;
     void SetInboundSerializationVersion(int versionNumber);
     void SetOutboundSerializationVersion(int versionNumber);
@@ -311,6 +328,7 @@ public:
         LogMessageSize(messageDataSize);
     }
 
+    CCriticalSection& GetMessageProcessingLock();
     void ProcessReceiveMessages(bool& shouldSleep);
     void ProcessSendMessages(bool trickle);
     void AdvertizeLocalAddress(int64_t rebroadcastTimestamp);
@@ -1,9 +1,9 @@
 #include <NodeState.h>
 
-#include <OrphanTransactions.h>
 #include <addrman.h>
 #include <Logging.h>
 #include <chain.h>
+#include <PartiallyDownloadedBlock.h>
 
 /** Number of nodes with fSyncStarted. */
 int CNodeState::countOfNodesAlreadySyncing = 0;
@@ -24,6 +24,12 @@ CNodeState::CNodeState(
     , hashLastUnknownBlock(uint256(0))
     , pindexLastCommonBlock(nullptr)
     , fPreferredDownload(false)
+    , fHeadersRequested(false)
+    , fHeadersSyncPaused(false)
+    , nUnconnectingHeaders(0)
+    , nNonImprovingHeaders(0)
+    , requestedCompactBlocks()
+    , partiallyDownloadedBlock()
 {
 }
 
@@ -38,7 +44,6 @@ void CNodeState::Finalize()
     if (nMisbehavior == 0 && fCurrentlyConnected) {
         addressManager_.Connected(address);
     }
-    EraseOrphansFor(nodeId);
 }
 bool CNodeState::Syncing() const
 {
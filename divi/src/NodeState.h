@@ -3,12 +3,15 @@
 #include <vector>
 #include <string>
 #include <list>
+#include <set>
+#include <memory>
 #include <NodeId.h>
 #include <uint256.h>
 #include <netbase.h>
 
 class CBlockIndex;
 class CAddrMan;
+class PartiallyDownloadedBlock;
 /**
  * Maintain validation-specific state about nodes, protected by cs_main, instead
  * by CNode's own locks. This simplifies asynchronous operation, where
@@ -44,6 +47,18 @@ public:
     const CBlockIndex* pindexLastCommonBlock;
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload;
+    //! Whether we sent this peer a getheaders that it has not answered yet.
+    bool fHeadersRequested;
+    //! Whether we stopped taking headers from this peer until the unverified stakes ahead of our tip are checked.
+    bool fHeadersSyncPaused;
+    //! Headers messages in a row from this peer that did not connect to our block index.
+    int nUnconnectingHeaders;
+    //! Headers from this peer that extended chains with no more work than our active tip.
+    unsigned nNonImprovingHeaders;
+    //! Compact blocks we asked this peer for that it has not sent yet.
+    std::set<uint256> requestedCompactBlocks;
+    //! The compact block from this peer that waits for the transactions we asked for.
+    std::unique_ptr<PartiallyDownloadedBlock> partiallyDownloadedBlock;
 
     CNodeState(NodeId nodeIdValue,CAddrMan& addressManager);
     ~CNodeState();
@@ -10,6 +10,8 @@
 #include <blockmap.h>
 #include <Settings.h>
 #include <BlocksInFlightRegistry.h>
+#include <UnverifiedHeadersRegistry.h>
+#include <defaultValues.h>
 
 extern Settings& settings;
 extern CCriticalSection cs_main;
@@ -17,6 +19,10 @@ extern CCriticalSection cs_main;
 /** Number of blocks in flight with validated headers. */
 BlocksInFlightRegistry blocksInFlightRegistry;
 
+/** Proof-of-stake headers ahead of the active tip whose stake is not checked yet. */
+UnverifiedHeadersRegistry unverifiedHeadersRegistry(
+    BLOCK_DOWNLOAD_WINDOW, MAX_UNVERIFIED_HEADERS_PER_PEER, MAX_UNVERIFIED_HEADERS);
+
 /** Map maintaining per-node state. Requires cs_main. */
 std::map<NodeId, CNodeState*> mapNodeState;
 
@@ -41,7 +47,9 @@ void FinalizeNode(NodeId nodeId)
 {
     LOCK(cs_main);
     blocksInFlightRegistry.UnregisterNodeId(nodeId);
+    unverifiedHeadersRegistry.UnregisterNodeId(nodeId);
     mapNodeState.erase(nodeId);
+    EraseOrphansFor(nodeId);
 }
 
 bool Misbehaving(CNodeState* state, int howmuch, std::string cause)
@@ -141,6 +149,55 @@ void UpdateBlockAvailability(const BlockMap& blockIndicesByHash, CNodeState* sta
     }
 }
 
+bool CanAcceptUnverifiedHeader(NodeId nodeId, int height, const CChain& activeChain)
+{
+    AssertLockHeld(cs_main);
+    return unverifiedHeadersRegistry.CanRecordHeader(nodeId, height, activeChain);
+}
+void RecordUnverifiedHeader(NodeId nodeId, const CBlockIndex* header)
+{
+    AssertLockHeld(cs_main);
+    unverifiedHeadersRegistry.RecordHeader(nodeId, header);
+}
+/** Forget unverified headers that were checked or passed by the active chain,
+ *  and penalise the peers whose headers failed the deferred stake check. */
+void RemoveResolvedUnverifiedHeaders(const CChain& activeChain)
+{
+    AssertLockHeld(cs_main);
+    for (const NodeId nodeId : unverifiedHeadersRegistry.RemoveResolvedHeaders(activeChain))
+        Misbehaving(nodeId, 100, "Header failed the deferred proof-of-stake check");
+}
+
+/** Remember that a compact block was requested from a peer, unless it already has
+ *  MAX_REQUESTED_COMPACT_BLOCKS requests open.  Requests for blocks that reached
+ *  us some other way are dropped first.  */
+bool RecordCompactBlockRequest(const BlockMap& blockIndicesByHash, CNodeState* state, const uint256& hash)
+{
+    assert(state != NULL);
+    std::set<uint256>& requestedBlocks = state->requestedCompactBlocks;
+    if (requestedBlocks.size() >= MAX_REQUESTED_COMPACT_BLOCKS) {
+        for (std::set<uint256>::iterator it = requestedBlocks.begin(); it != requestedBlocks.end();) {
+            BlockMap::const_iterator mi = blockIndicesByHash.find(*it);
+            if (mi != blockIndicesByHash.end() && (mi->second->nStatus & BLOCK_HAVE_DATA))
+                it = requestedBlocks.erase(it);
+            else
+                ++it;
+        }
+        if (requestedBlocks.size() >= MAX_REQUESTED_COMPACT_BLOCKS)
+            return false;
+    }
+    requestedBlocks.insert(hash);
+    return true;
+}
+
+/** Check that a received compact block was requested from the peer, each request
+ *  is answered at most once.  */
+bool TakeCompactBlockRequest(CNodeState* state, const uint256& hash)
+{
+    assert(state != NULL);
+    return state->requestedCompactBlocks.erase(hash) > 0;
+}
+
 /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
  *  at most count entries. */
 void FindNextBlocksToDownload(
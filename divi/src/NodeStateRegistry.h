@@ -21,6 +21,11 @@ void MarkBlockAsReceived(const uint256& hash);
 void MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const CBlockIndex* pindex = nullptr);
 bool BlockIsInFlight(const uint256& hash);
 void UpdateBlockAvailability(const BlockMap& blockIndicesByHash, CNodeState* state, const uint256& hash);
+bool CanAcceptUnverifiedHeader(NodeId nodeId, int height, const CChain& activeChain);
+void RecordUnverifiedHeader(NodeId nodeId, const CBlockIndex* header);
+void RemoveResolvedUnverifiedHeaders(const CChain& activeChain);
+bool RecordCompactBlockRequest(const BlockMap& blockIndicesByHash, CNodeState* state, const uint256& hash);
+bool TakeCompactBlockRequest(CNodeState* state, const uint256& hash);
 void FindNextBlocksToDownload(
     const BlockMap& blockIndicesByHash,
     const CChain& activeChain,
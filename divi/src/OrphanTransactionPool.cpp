@@ -0,0 +1,208 @@
+#include <OrphanTransactionPool.h>
+
+#include <Logging.h>
+#include <random.h>
+#include <serialize.h>
+
+#include <algorithm>
+#include <limits>
+
+OrphanTransactionPool::OrphanTransactionPool(
+    unsigned maxOrphanSize,
+    unsigned maxBytesPerPeer,
+    int64_t expiryDuration
+    ): maxOrphanSize_(maxOrphanSize)
+    , maxBytesPerPeer_(maxBytesPerPeer)
+    , expiryDuration_(expiryDuration)
+    , orphans_()
+    , orphansByOutpoint_()
+    , bytesByPeer_()
+    , queuedForResolution_()
+    , nextExpirySweep_(std::numeric_limits<int64_t>::max())
+{
+}
+
+bool OrphanTransactionPool::Add(const CTransaction& tx, NodeId peer, int64_t currentTime)
+{
+    const uint256 hash = tx.GetHash();
+    if (IsKnown(hash))
+        return false;
+
+    // Ignore big transactions, to avoid a send-big-orphans memory exhaustion
+    // attack. If a peer has a legitimate large transaction with a missing
+    // parent then we assume it will rebroadcast it later, after the parent
+    // transaction(s) have been mined or received.
+    const unsigned size = tx.GetSerializeSize(SER_NETWORK, CTransaction::CURRENT_VERSION);
+    if (size > maxOrphanSize_) {
+        LogPrint("mempool", "ignoring large orphan tx (size: %u, hash: %s)\n", size, hash);
+        return false;
+    }
+
+    // A single peer can not push the orphans of everyone else out
+    unsigned& bytesFromPeer = bytesByPeer_[peer];
+    if (bytesFromPeer + size > maxBytesPerPeer_) {
+        LogPrint("mempool", "ignoring orphan tx %s, peer=%d is over its quota (%u bytes)\n", hash, peer, bytesFromPeer);
+        if (bytesFromPeer == 0)
+            bytesByPeer_.erase(peer);
+        return false;
+    }
+    bytesFromPeer += size;
+
+    Orphan& orphan = orphans_[hash];
+    orphan.tx = tx;
+    orphan.fromPeer = peer;
+    orphan.expiryTime = currentTime + expiryDuration_;
+    orphan.size = size;
+    nextExpirySweep_ = std::min(nextExpirySweep_, orphan.expiryTime);
+    for (const CTxIn& txin : tx.vin)
+        orphansByOutpoint_[txin.prevout].insert(hash);
+
+    LogPrint("mempool", "stored orphan tx %s (mapsz %u outsz %u)\n", hash,
+             orphans_.size(), orphansByOutpoint_.size());
+    return true;
+}
+
+void OrphanTransactionPool::Erase(std::map<uint256, Orphan>::iterator it)
+{
+    const uint256 hash = it->first;
+    const Orphan& orphan = it->second;
+    for (const CTxIn& txin : orphan.tx.vin) {
+        const auto itByOutpoint = orphansByOutpoint_.find(txin.prevout);
+        if (itByOutpoint == orphansByOutpoint_.end())
+            continue;
+        itByOutpoint->second.erase(hash);
+        if (itByOutpoint->second.empty())
+            orphansByOutpoint_.erase(itByOutpoint);
+    }
+
+    const auto itBytes = bytesByPeer_.find(orphan.fromPeer);
+    if (itBytes != bytesByPeer_.end()) {
+        itBytes->second -= std::min(itBytes->second, orphan.size);
+        if (itBytes->second == 0)
+            bytesByPeer_.erase(itBytes);
+    }
+    queuedForResolution_.erase(hash);
+    orphans_.erase(it);
+}
+
+bool OrphanTransactionPool::Erase(const uint256& hash)
+{
+    const auto it = orphans_.find(hash);
+    if (it == orphans_.end())
+        return false;
+    Erase(it);
+    return true;
+}
+
+unsigned OrphanTransactionPool::EraseForPeer(NodeId peer)
+{
+    if (bytesByPeer_.count(peer) == 0)
+        return 0;
+
+    unsigned numberErased = 0;
+    auto it = orphans_.begin();
+    while (it != orphans_.end()) {
+        const auto maybeErase = it++;
+        if (maybeErase->second.fromPeer == peer) {
+            Erase(maybeErase);
+            ++numberErased;
+        }
+    }
+    if (numberErased > 0)
+        LogPrint("mempool", "Erased %d orphan tx from peer %d\n", numberErased, peer);
+    return numberErased;
+}
+
+unsigned OrphanTransactionPool::EraseExpired(int64_t currentTime)
+{
+    if (currentTime < nextExpirySweep_)
+        return 0;
+
+    unsigned numberErased = 0;
+    nextExpirySweep_ = std::numeric_limits<int64_t>::max();
+    auto it = orphans_.begin();
+    while (it != orphans_.end()) {
+        const auto maybeErase = it++;
+        if (maybeErase->second.expiryTime <= currentTime) {
+            Erase(maybeErase);
+            ++numberErased;
+        } else {
+            nextExpirySweep_ = std::min(nextExpirySweep_, maybeErase->second.expiryTime);
+        }
+    }
+    if (numberErased > 0)
+        LogPrint("mempool", "Erased %d expired orphan tx\n", numberErased);
+    return numberErased;
+}
+
+unsigned OrphanTransactionPool::LimitSize(unsigned maxOrphans)
+{
+    unsigned numberEvicted = 0;
+    while (orphans_.size() > maxOrphans) {
+        // Evict a random orphan
+        auto it = orphans_.lower_bound(GetRandHash());
+        if (it == orphans_.end())
+            it = orphans_.begin();
+        Erase(it);
+        ++numberEvicted;
+    }
+    return numberEvicted;
+}
+
+bool OrphanTransactionPool::IsKnown(const uint256& hash) const
+{
+    return orphans_.count(hash) > 0;
+}
+
+const CTransaction& OrphanTransactionPool::SelectRandom() const
+{
+    auto it = orphans_.lower_bound(GetRandHash());
+    if (it == orphans_.end())
+        it = orphans_.begin();
+    return it->second.tx;
+}
+
+size_t OrphanTransactionPool::Size() const
+{
+    return orphans_.size();
+}
+
+unsigned OrphanTransactionPool::BytesFromPeer(NodeId peer) const
+{
+    const auto it = bytesByPeer_.find(peer);
+    return it == bytesByPeer_.end() ? 0u : it->second;
+}
+
+bool OrphanTransactionPool::IsEmpty() const
+{
+    return orphans_.empty() && orphansByOutpoint_.empty() && bytesByPeer_.empty() && queuedForResolution_.empty();
+}
+
+void OrphanTransactionPool::QueueChildrenForResolution(const CTransaction& parent)
+{
+    if (orphansByOutpoint_.empty())
+        return;
+    const uint256 parentHash = parent.GetHash();
+    for (uint32_t n = 0; n < parent.vout.size(); ++n) {
+        const auto it = orphansByOutpoint_.find(COutPoint(parentHash, n));
+        if (it != orphansByOutpoint_.end())
+            queuedForResolution_.insert(it->second.begin(), it->second.end());
+    }
+}
+
+bool OrphanTransactionPool::HasQueuedForResolution() const
+{
+    return !queuedForResolution_.empty();
+}
+
+void OrphanTransactionPool::TakeQueuedForResolution(unsigned maxCount, std::vector<Orphan>& orphans)
+{
+    orphans.clear();
+    auto it = queuedForResolution_.begin();
+    while (it != queuedForResolution_.end() && orphans.size() < maxCount) {
+        const auto itOrphan = orphans_.find(*it);
+        if (itOrphan != orphans_.end())
+            orphans.push_back(itOrphan->second);
+        it = queuedForResolution_.erase(it);
+    }
+}
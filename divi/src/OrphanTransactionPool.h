@@ -0,0 +1,70 @@
+#ifndef ORPHAN_TRANSACTION_POOL_H
+#define ORPHAN_TRANSACTION_POOL_H
+#include <NodeId.h>
+#include <OutPoint.h>
+#include <primitives/transaction.h>
+#include <uint256.h>
+
+#include <map>
+#include <set>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+/** Transactions received from peers whose inputs are not known yet.
+ *  Every orphan is indexed by the outpoints it spends, so the orphans
+ *  spending a newly accepted transaction are found without a scan.
+ *  Orphans expire after a fixed time and each peer can only keep a
+ *  bounded number of bytes in the pool.
+ *  Resolution is done in batches: accepting a parent queues its orphans
+ *  and callers take bounded batches off that queue.  */
+class OrphanTransactionPool
+{
+public:
+    struct Orphan
+    {
+        CTransaction tx;
+        NodeId fromPeer;
+        int64_t expiryTime;
+        unsigned size;
+    };
+
+private:
+    const unsigned maxOrphanSize_;
+    const unsigned maxBytesPerPeer_;
+    const int64_t expiryDuration_;
+
+    std::map<uint256, Orphan> orphans_;
+    std::map<COutPoint, std::set<uint256>> orphansByOutpoint_;
+    std::map<NodeId, unsigned> bytesByPeer_;
+    std::set<uint256> queuedForResolution_;
+    int64_t nextExpirySweep_;
+
+    void Erase(std::map<uint256, Orphan>::iterator it);
+
+public:
+    OrphanTransactionPool(
+        unsigned maxOrphanSize,
+        unsigned maxBytesPerPeer,
+        int64_t expiryDuration);
+
+    bool Add(const CTransaction& tx, NodeId peer, int64_t currentTime);
+    bool Erase(const uint256& hash);
+    unsigned EraseForPeer(NodeId peer);
+    unsigned EraseExpired(int64_t currentTime);
+    unsigned LimitSize(unsigned maxOrphans);
+
+    bool IsKnown(const uint256& hash) const;
+    const CTransaction& SelectRandom() const;
+    size_t Size() const;
+    unsigned BytesFromPeer(NodeId peer) const;
+    bool IsEmpty() const;
+
+    /** Queues every orphan spending an output of the given transaction. */
+    void QueueChildrenForResolution(const CTransaction& parent);
+    bool HasQueuedForResolution() const;
+    /** Removes up to maxCount orphans from the resolution queue and copies
+     *  them out; they stay in the pool until erased.  */
+    void TakeQueuedForResolution(unsigned maxCount, std::vector<Orphan>& orphans);
+};
+#endif// ORPHAN_TRANSACTION_POOL_H
@@ -1,17 +1,20 @@
 #ifndef ORPHAN_TRANSACTIONS_H
 #define ORPHAN_TRANSACTIONS_H
 #include <NodeId.h>
+#include <OrphanTransactionPool.h>
 #include <uint256.h>
-#include <set>
+#include <vector>
 class CTransaction;
-const std::set<uint256>& GetOrphanSpendingTransactionIds(const uint256& txHash);
-const CTransaction& GetOrphanTransaction(const uint256& txHash, NodeId& peer);
 bool OrphanTransactionIsKnown(const uint256& hash);
 bool AddOrphanTx(const CTransaction& tx, NodeId peer);
 void EraseOrphanTx(uint256 hash);
 void EraseOrphansFor(NodeId peer);
 unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans);
+unsigned EraseExpiredOrphans();
 const CTransaction& SelectRandomOrphan();
 size_t OrphanTotalCount();
 bool OrphanMapsAreEmpty();
+void QueueOrphansSpendingFrom(const CTransaction& tx);
+bool OrphansAreQueuedForResolution();
+void TakeOrphansQueuedForResolution(unsigned maxCount, std::vector<OrphanTransactionPool::Orphan>& orphans);
 #endif// ORPHAN_TRANSACTIONS_H
@@ -0,0 +1,141 @@
+#include <PartiallyDownloadedBlock.h>
+
+#include <CompactBlock.h>
+#include <txmempool.h>
+
+#include <map>
+
+PartiallyDownloadedBlock::PartiallyDownloadedBlock(
+    ): header_()
+    , vchBlockSig_()
+    , transactions_()
+    , isAvailable_()
+    , numberOfPrefilledTransactions_(0u)
+    , numberOfMempoolTransactions_(0u)
+{
+}
+
+PartiallyDownloadedBlock::ReadStatus PartiallyDownloadedBlock::InitData(const CompactBlock& compactBlock, CTxMemPool& mempool)
+{
+    if (compactBlock.header.IsNull() || compactBlock.BlockTransactionCount() == 0u)
+        return ReadStatus::INVALID;
+    if (compactBlock.BlockTransactionCount() > CompactBlock::MAX_TRANSACTIONS)
+        return ReadStatus::INVALID;
+
+    header_ = compactBlock.header;
+    vchBlockSig_ = compactBlock.vchBlockSig;
+    const size_t numberOfTransactions = compactBlock.BlockTransactionCount();
+    transactions_.assign(numberOfTransactions, CTransaction());
+    isAvailable_.assign(numberOfTransactions, false);
+    numberOfPrefilledTransactions_ = 0u;
+    numberOfMempoolTransactions_ = 0u;
+
+    for (const PrefilledTransaction& prefilled : compactBlock.prefilledTransactions) {
+        if (prefilled.index >= numberOfTransactions || isAvailable_[prefilled.index] || prefilled.tx.IsNull())
+            return ReadStatus::INVALID;
+        transactions_[prefilled.index] = prefilled.tx;
+        isAvailable_[prefilled.index] = true;
+        ++numberOfPrefilledTransactions_;
+    }
+
+    // The short ids fill the remaining slots in block order
+    std::map<uint64_t, size_t> slotByShortTxId;
+    size_t slot = 0u;
+    for (const uint64_t shortTxId : compactBlock.shortTxIds) {
+        while (isAvailable_[slot])
+            ++slot;
+        if (!slotByShortTxId.insert(std::make_pair(shortTxId, slot)).second) {
+            // Two transactions of the block share a short id, only the full block can tell them apart
+            return ReadStatus::FAILED;
+        }
+        ++slot;
+    }
+
+    const std::pair<uint64_t, uint64_t> keys = compactBlock.GetShortTxIdKeys();
+    std::vector<uint256> mempoolTxids;
+    mempool.queryHashes(mempoolTxids);
+    std::vector<bool> hasCollision(numberOfTransactions, false);
+    for (const uint256& txid : mempoolTxids) {
+        const auto it = slotByShortTxId.find(CompactBlock::GetShortTxId(keys, txid));
+        if (it == slotByShortTxId.end() || hasCollision[it->second])
+            continue;
+
+        const size_t matchedSlot = it->second;
+        if (isAvailable_[matchedSlot]) {
+            // Another mempool transaction has the same short id, ask the peer for the right one
+            transactions_[matchedSlot] = CTransaction();
+            isAvailable_[matchedSlot] = false;
+            hasCollision[matchedSlot] = true;
+            --numberOfMempoolTransactions_;
+            continue;
+        }
+        if (mempool.lookup(txid, transactions_[matchedSlot])) {
+            isAvailable_[matchedSlot] = true;
+            ++numberOfMempoolTransactions_;
+        }
+    }
+
+    return ReadStatus::OK;
+}
+
+uint256 PartiallyDownloadedBlock::GetBlockHash() const
+{
+    return header_.GetHash();
+}
+
+bool PartiallyDownloadedBlock::IsTxAvailable(size_t index) const
+{
+    return index < isAvailable_.size() && isAvailable_[index];
+}
+
+void PartiallyDownloadedBlock::GetMissingTransactionIndices(std::vector<uint32_t>& missingIndices) const
+{
+    missingIndices.clear();
+    for (size_t index = 0; index < isAvailable_.size(); ++index) {
+        if (!isAvailable_[index])
+            missingIndices.push_back(index);
+    }
+}
+
+unsigned PartiallyDownloadedBlock::GetPrefilledTransactionCount() const
+{
+    return numberOfPrefilledTransactions_;
+}
+
+unsigned PartiallyDownloadedBlock::GetMempoolTransactionCount() const
+{
+    return numberOfMempoolTransactions_;
+}
+
+PartiallyDownloadedBlock::ReadStatus PartiallyDownloadedBlock::FillBlock(
+    CBlock& block,
+    const std::vector<CTransaction>& missingTransactions) const
+{
+    if (header_.IsNull())
+        return ReadStatus::INVALID;
+
+    block.SetNull();
+    *static_cast<CBlockHeader*>(&block) = header_;
+    block.vchBlockSig = vchBlockSig_;
+    block.vtx.reserve(transactions_.size());
+
+    auto missingTransaction = missingTransactions.begin();
+    for (size_t index = 0; index < transactions_.size(); ++index) {
+        if (isAvailable_[index]) {
+            block.vtx.push_back(transactions_[index]);
+        } else {
+            if (missingTransaction == missingTransactions.end())
+                return ReadStatus::INVALID;
+            block.vtx.push_back(*missingTransaction++);
+        }
+    }
+    if (missingTransaction != missingTransactions.end())
+        return ReadStatus::INVALID;
+
+    // A wrong mempool match (a short id collision) shows up as a different merkle root
+    bool mutated = false;
+    if (block.BuildMerkleTree(&mutated) != header_.hashMerkleRoot || mutated)
+        return ReadStatus::FAILED;
+
+    return ReadStatus::OK;
+}
@@ -0,0 +1,55 @@
+#ifndef PARTIALLY_DOWNLOADED_BLOCK_H
+#define PARTIALLY_DOWNLOADED_BLOCK_H
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <vector>
+
+class CompactBlock;
+class CTxMemPool;
+
+/** Rebuilds a block from a compact block, the transactions in our mempool
+ *  and, for those the mempool does not have, the transactions asked from
+ *  the peer with "getblocktxn".  */
+class PartiallyDownloadedBlock
+{
+public:
+    enum class ReadStatus
+    {
+        OK,
+        /** The peer sent something no valid block can produce */
+        INVALID,
+        /** The block could not be rebuilt, it should be downloaded in full */
+        FAILED,
+    };
+
+private:
+    CBlockHeader header_;
+    std::vector<unsigned char> vchBlockSig_;
+    std::vector<CTransaction> transactions_;
+    std::vector<bool> isAvailable_;
+    unsigned numberOfPrefilledTransactions_;
+    unsigned numberOfMempoolTransactions_;
+
+public:
+    PartiallyDownloadedBlock();
+
+    /** Places the prefilled transactions and looks up the others in the
+     *  mempool by their short id.  Mempool transactions sharing a short id
+     *  are not used, they are asked from the peer instead.  */
+    ReadStatus InitData(const CompactBlock& compactBlock, CTxMemPool& mempool);
+
+    uint256 GetBlockHash() const;
+    bool IsTxAvailable(size_t index) const;
+    void GetMissingTransactionIndices(std::vector<uint32_t>& missingIndices) const;
+    unsigned GetPrefilledTransactionCount() const;
+    unsigned GetMempoolTransactionCount() const;
+
+    /** Builds the block with the missing transactions, in the order of
+     *  GetMissingTransactionIndices, and checks it against the merkle root
+     *  of the header.  */
+    ReadStatus FillBlock(CBlock& block, const std::vector<CTransaction>& missingTransactions) const;
+};
+#endif// PARTIALLY_DOWNLOADED_BLOCK_H
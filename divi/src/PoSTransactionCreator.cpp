@@ -24,6 +24,7 @@ class StakedCoins
 private:
     std::set<StakableCoin> underlyingSet_;
     std::vector<const StakableCoin*> shuffledSet_;
+    StakeCoinsSelectionValidity validity_;
     int64_t timestampOfLastUpdate_;
     bool utxoPermutationEnabled_;
 public:
@@ -36,6 +37,7 @@ public:
         bool utxoPermutationEnabled
         ): underlyingSet_()
         , shuffledSet_()
+        , validity_()
         , timestampOfLastUpdate_(0)
         , utxoPermutationEnabled_(utxoPermutationEnabled)
     {
@@ -77,6 +79,19 @@ public:
     {
         return underlyingSet_;
     }
+    StakeCoinsSelectionValidity& validity()
+    {
+        return validity_;
+    }
+    /** The selection only has to be redone once the wallet recorded a change
+     *  to its coins, or a coin that was left out matured or aged enough.  */
+    bool isCurrent(uint64_t walletVersion, int chainHeight, int64_t adjustedTime) const
+    {
+        return timestampOfLastUpdate_ > 0 &&
+            walletVersion == validity_.walletVersion &&
+            chainHeight < validity_.nextMaturityHeight &&
+            adjustedTime < validity_.nextCoinAgeTime;
+    }
 };
 
 PoSTransactionCreator::PoSTransactionCreator(
@@ -111,11 +126,13 @@ PoSTransactionCreator::~PoSTransactionCreator()
 bool PoSTransactionCreator::SelectCoins() const
 {
     if(wallet_ == nullptr) return false;
-    if (chainParameters_.NetworkID() == CBaseChainParams::REGTEST ||
+    const bool selectionIsCurrent =
+        stakedCoins_->isCurrent(wallet_->GetStakableCoinsVersion(), activeChain_.Height(), GetAdjustedTime());
+    if (chainParameters_.NetworkID() == CBaseChainParams::REGTEST || !selectionIsCurrent ||
         GetTime() - stakedCoins_->timestamp() > settings_.GetArg("-stakeupdatetime",300))
     {
         stakedCoins_->resetCoins();
-        if (!wallet_->SelectStakeCoins(stakedCoins_->asSet())) {
+        if (!wallet_->SelectStakeCoins(stakedCoins_->asSet(), stakedCoins_->validity())) {
             return error("failed to select coins for staking");
         }
         stakedCoins_->updateShuffledSet();
@@ -386,8 +403,6 @@ bool PoSTransactionCreator::attachBlockProof(
         return false;
     }
     LogPrintf("%s: proof-of-stake block was signed %s \n", __func__, block.GetHash());
-
-    stakedCoins_->resetTimestamp(); //this will trigger stake set to repopulate next round
     return true;
 }
 
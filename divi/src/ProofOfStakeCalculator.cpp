@@ -1,27 +1,24 @@
 #include <ProofOfStakeCalculator.h>
-#include <streams.h>
 #include <amount.h>
 #include <primitives/transaction.h>
-#include <hash.h>
 #include <StakingData.h>
 
 static constexpr unsigned int MAXIMUM_COIN_AGE_WEIGHT_FOR_STAKING = 60 * 60 * 24 * 7 - 60 * 60;
 
-static uint256 stakeHash(uint64_t stakeModifier, unsigned int hashproofTimestamp, const COutPoint& prevout, unsigned int coinstakeStartTime)
+//scale the difficulty target by the coin age weight, false if that overflows
+static bool weightedStakeTarget(int64_t nValueIn, const uint256& coinAgeTarget, int64_t nTimeWeight, uint256& target)
 {
-    //Divi will hash in the transaction hash and the index number in order to make sure each hash is unique
-    CDataStream ss(SER_GETHASH, 0);
-    ss << stakeModifier << coinstakeStartTime << prevout.n << prevout.hash << hashproofTimestamp;
-    return Hash(ss.begin(), ss.end());
+    const uint256 coinAgeWeight = (uint256(nValueIn) * nTimeWeight) / COIN / 400;
+
+    target = coinAgeTarget;
+    return target.MultiplyBy(coinAgeWeight);
 }
 
 //test hash vs target
 static bool stakeTargetHit(const uint256& hashProofOfStake, int64_t nValueIn, const uint256& coinAgeTarget, int64_t nTimeWeight)
 {
-    const uint256 coinAgeWeight = (uint256(nValueIn) * nTimeWeight) / COIN / 400;
-
-    uint256 target = coinAgeTarget;
-    if (!target.MultiplyBy(coinAgeWeight)) {
+    uint256 target;
+    if (!weightedStakeTarget(nValueIn, coinAgeTarget, nTimeWeight, target)) {
         // In regtest with minimal difficulty, it may happen that the
         // modification overflows the uint256, in which case it just means
         // that the target will always be hit.
@@ -36,12 +33,15 @@ static bool stakeTargetHit(const uint256& hashProofOfStake, int64_t nValueIn, co
 ProofOfStakeCalculator::ProofOfStakeCalculator(
     const StakingData& stakingData,
     const uint64_t stakeModifier
-    ): utxoToStake_(stakingData.utxoBeingStaked_)
-    , utxoValue_(stakingData.utxoValue_)
-    , stakeModifier_(stakeModifier)
+    ): utxoValue_(stakingData.utxoValue_)
     , coinAgeTarget_(uint256().SetCompact(stakingData.nBits_))
     , coinstakeStartTime_(stakingData.blockTimeOfFirstConfirmationBlock_)
+    //Divi will hash in the transaction hash and the index number in order to make sure each hash is unique
+    , kernelHasher_(stakeModifier, stakingData.blockTimeOfFirstConfirmationBlock_, stakingData.utxoBeingStaked_)
+    , fullWeightTargetOverflows_(false)
+    , fullWeightTarget_()
 {
+    fullWeightTargetOverflows_ = !weightedStakeTarget(utxoValue_, coinAgeTarget_, MAXIMUM_COIN_AGE_WEIGHT_FOR_STAKING, fullWeightTarget_);
 }
 
 bool ProofOfStakeCalculator::computeProofOfStakeAndCheckItMeetsTarget(
@@ -49,7 +49,9 @@ bool ProofOfStakeCalculator::computeProofOfStakeAndCheckItMeetsTarget(
     uint256& computedProofOfStake,
     bool checkOnly) const
 {
-    if(!checkOnly) computedProofOfStake = stakeHash(stakeModifier_,hashproofTimestamp, utxoToStake_,coinstakeStartTime_);
+    if(!checkOnly) computedProofOfStake = kernelHasher_.Hash(hashproofTimestamp);
     int64_t coinAgeWeightOfUtxo = std::min<int64_t>(hashproofTimestamp - coinstakeStartTime_, MAXIMUM_COIN_AGE_WEIGHT_FOR_STAKING);
+    if(coinAgeWeightOfUtxo == MAXIMUM_COIN_AGE_WEIGHT_FOR_STAKING)
+        return fullWeightTargetOverflows_ || computedProofOfStake < fullWeightTarget_;
     return stakeTargetHit(computedProofOfStake,utxoValue_,coinAgeTarget_, coinAgeWeightOfUtxo);
 }
\ No newline at end of file
@@ -3,16 +3,19 @@
 #include <stdint.h>
 #include <uint256.h>
 #include <I_ProofOfStakeCalculator.h>
+#include <ProofOfStakeKernelHasher.h>
 struct StakingData;
-class COutPoint;
 class ProofOfStakeCalculator: public I_ProofOfStakeCalculator
 {
 private:
-    const COutPoint& utxoToStake_;
     const int64_t& utxoValue_;
-    const uint64_t stakeModifier_;
     const uint256 coinAgeTarget_;
     const unsigned int& coinstakeStartTime_;
+    const ProofOfStakeKernelHasher kernelHasher_;
+
+    // Coins past the maximum coin age all share the same target
+    bool fullWeightTargetOverflows_;
+    uint256 fullWeightTarget_;
 public:
     ProofOfStakeCalculator(
         const StakingData& stakingData,
@@ -92,7 +92,7 @@ bool ProofOfStakeGenerator::ProofOfStakeTimeRequirementsAreMet(
 bool ProofOfStakeGenerator::CreateProofOfStakeCalculator(
     const StakingData& stakingData,
     const unsigned& initialHashproofTimestamp,
-    std::shared_ptr<I_ProofOfStakeCalculator>& calculator) const
+    std::unique_ptr<I_ProofOfStakeCalculator>& calculator) const
 {
     if(!ProofOfStakeTimeRequirementsAreMet(stakingData.blockTimeOfFirstConfirmationBlock_,initialHashproofTimestamp))
         return false;
@@ -102,7 +102,7 @@ bool ProofOfStakeGenerator::CreateProofOfStakeCalculator(
     {
         return error("%s: failed to get kernel stake modifier \n",__func__);
     }
-    calculator = std::make_shared<ProofOfStakeCalculator>(stakingData, stakeModifierData.first);
+    calculator.reset(new ProofOfStakeCalculator(stakingData, stakeModifierData.first));
 
     if(!calculator.get())
         return false;
@@ -115,7 +115,7 @@ bool ProofOfStakeGenerator::computeAndVerifyProofOfStake(
     const unsigned int& hashproofTimestamp,
     uint256& hashProofOfStake) const
 {
-    std::shared_ptr<I_ProofOfStakeCalculator> calculator;
+    std::unique_ptr<I_ProofOfStakeCalculator> calculator;
     if(!CreateProofOfStakeCalculator(stakingData,hashproofTimestamp,calculator))
         return false;
     return calculator->computeProofOfStakeAndCheckItMeetsTarget(
@@ -125,7 +125,7 @@ HashproofCreationResult ProofOfStakeGenerator::createHashproofTimestamp(
     const StakingData& stakingData,
     const unsigned initialTimestamp) const
 {
-    std::shared_ptr<I_ProofOfStakeCalculator> calculator;
+    std::unique_ptr<I_ProofOfStakeCalculator> calculator;
     if(!CreateProofOfStakeCalculator(stakingData,initialTimestamp,calculator))
         return HashproofCreationResult::FailedSetup();
 
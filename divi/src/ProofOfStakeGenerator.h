@@ -20,7 +20,7 @@ private:
     bool CreateProofOfStakeCalculator(
         const StakingData& stakingData,
         const unsigned& initialHashproofTimestamp,
-        std::shared_ptr<I_ProofOfStakeCalculator>& calculator) const;
+        std::unique_ptr<I_ProofOfStakeCalculator>& calculator) const;
 public:
     ProofOfStakeGenerator(
         const I_PoSStakeModifierService& stakeModifierService,
@@ -0,0 +1,35 @@
+#include <ProofOfStakeKernelHasher.h>
+
+#include <crypto/common.h>
+#include <crypto/sha256.h>
+#include <primitives/transaction.h>
+#include <string.h>
+
+constexpr unsigned ProofOfStakeKernelHasher::KERNEL_SIZE;
+constexpr unsigned ProofOfStakeKernelHasher::TIMESTAMP_OFFSET;
+
+ProofOfStakeKernelHasher::ProofOfStakeKernelHasher(
+    uint64_t stakeModifier,
+    unsigned int coinstakeStartTime,
+    const COutPoint& prevout)
+{
+    // Same layout as serializing the fields into a SER_GETHASH stream
+    WriteLE64(kernel_, stakeModifier);
+    WriteLE32(kernel_ + 8, coinstakeStartTime);
+    WriteLE32(kernel_ + 12, prevout.n);
+    memcpy(kernel_ + 16, prevout.hash.begin(), 32);
+    WriteLE32(kernel_ + TIMESTAMP_OFFSET, 0u);
+}
+
+uint256 ProofOfStakeKernelHasher::Hash(unsigned int hashproofTimestamp) const
+{
+    unsigned char kernel[KERNEL_SIZE];
+    memcpy(kernel, kernel_, TIMESTAMP_OFFSET);
+    WriteLE32(kernel + TIMESTAMP_OFFSET, hashproofTimestamp);
+
+    unsigned char firstHash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(kernel, KERNEL_SIZE).Finalize(firstHash);
+    uint256 hashproof;
+    CSHA256().Write(firstHash, CSHA256::OUTPUT_SIZE).Finalize(hashproof.begin());
+    return hashproof;
+}
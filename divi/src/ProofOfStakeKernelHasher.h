@@ -0,0 +1,29 @@
+#ifndef PROOF_OF_STAKE_KERNEL_HASHER_H
+#define PROOF_OF_STAKE_KERNEL_HASHER_H
+#include <stdint.h>
+#include <uint256.h>
+
+class COutPoint;
+
+/** Hashes the proof-of-stake kernel of one coin for candidate timestamps.
+ *  The kernel is laid out once, so each hashproof only patches the
+ *  timestamp into a fixed-size buffer before hashing it.  */
+class ProofOfStakeKernelHasher
+{
+public:
+    // stake modifier, coinstake start time, prevout index and hash, hashproof timestamp
+    static constexpr unsigned KERNEL_SIZE = 8 + 4 + 4 + 32 + 4;
+    static constexpr unsigned TIMESTAMP_OFFSET = KERNEL_SIZE - 4;
+
+private:
+    unsigned char kernel_[KERNEL_SIZE];
+
+public:
+    ProofOfStakeKernelHasher(
+        uint64_t stakeModifier,
+        unsigned int coinstakeStartTime,
+        const COutPoint& prevout);
+
+    uint256 Hash(unsigned int hashproofTimestamp) const;
+};
+#endif// PROOF_OF_STAKE_KERNEL_HASHER_H
@@ -38,7 +38,7 @@ void TransactionInputChecker::InitializeScriptCheckingThreads(boost::thread_grou
 }
 
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128, MAX_SCRIPTCHECK_THREADS);
 void TransactionInputChecker::ThreadScriptCheck()
 {
     RenameThread("divi-scriptch");
@@ -62,6 +62,20 @@ void TransactionInputChecker::ScheduleBackgroundThreadScriptChecking()
     multiThreadedScriptChecker.Add(vChecks);
     vChecks.clear();
 }
+void TransactionInputChecker::ScheduleBackgroundThreadScriptChecking(std::vector<CScriptCheck>& scriptChecks)
+{
+    multiThreadedScriptChecker.Add(scriptChecks);
+    scriptChecks.clear();
+}
+void TransactionInputChecker::RecordCoinSupplyChange(
+    const CTransaction& tx,
+    const CAmount txInputAmount,
+    CBlockIndex* pindex)
+{
+    const CAmount supplyChange = tx.GetValueOut() - txInputAmount;
+    pindex->nMoneySupply += supplyChange;
+    pindex->nMint += (tx.IsCoinBase() || tx.IsCoinStake())? supplyChange : 0;
+}
 bool TransactionInputChecker::CheckInputsAndUpdateCoinSupplyRecords(
     const CTransaction& tx,
     const unsigned flags,
@@ -76,9 +90,7 @@ bool TransactionInputChecker::CheckInputsAndUpdateCoinSupplyRecords(
         return false;
     }
 
-    const CAmount supplyChange = tx.GetValueOut() - txInputAmount;
-    pindex->nMoneySupply += supplyChange;
-    pindex->nMint += (tx.IsCoinBase() || tx.IsCoinStake())? supplyChange : 0;
+    RecordCoinSupplyChange(tx, txInputAmount, pindex);
     return true;
 }
 
@@ -102,7 +114,14 @@ bool TransactionInputChecker::TotalSigOpsAreBelowMaximum(const CTransaction& tx)
 
 bool TransactionInputChecker::WaitForScriptsToBeChecked()
 {
-    return multiThreadedScriptChecker.Wait();
+    const bool scriptsAreValid = multiThreadedScriptChecker.Wait();
+    CCheckQueueRoundStats stats;
+    if (multiThreadedScriptChecker.GetRoundStats(stats) && stats.nChecks > 0)
+    {
+        LogPrint("bench", "    - Verify %u script checks: %.2fms, parallelism %.2f of %u threads, %.2fms idle\n",
+            stats.nChecks, stats.nWallMicros * 0.001, stats.Parallelism(), stats.nThreads, stats.IdleMicros() * 0.001);
+    }
+    return scriptsAreValid;
 }
 
 bool TransactionInputChecker::InputsAreValid(const CTransaction& tx) const
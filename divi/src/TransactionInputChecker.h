@@ -2,6 +2,7 @@
 #define TRANSACTION_INPUT_CHECKER_H
 #include <scriptCheck.h>
 #include <checkqueue.h>
+#include <amount.h>
 #include <vector>
 
 class BlockMap;
@@ -38,6 +39,11 @@ public:
         CValidationState& state);
 
     void ScheduleBackgroundThreadScriptChecking();
+    void ScheduleBackgroundThreadScriptChecking(std::vector<CScriptCheck>& scriptChecks);
+    static void RecordCoinSupplyChange(
+        const CTransaction& tx,
+        CAmount txInputAmount,
+        CBlockIndex* pindex);
     bool CheckInputsAndUpdateCoinSupplyRecords(
         const CTransaction& tx,
         unsigned flags,
@@ -0,0 +1,93 @@
+#include <UnverifiedHeadersRegistry.h>
+
+#include <chain.h>
+
+UnverifiedHeadersRegistry::UnverifiedHeadersRegistry(
+    unsigned maxHeightAheadOfTip,
+    unsigned maxHeadersPerNode,
+    unsigned maxHeaders
+    ): maxHeightAheadOfTip_(maxHeightAheadOfTip)
+    , maxHeadersPerNode_(maxHeadersPerNode)
+    , maxHeaders_(maxHeaders)
+    , sourceByHeader_()
+    , headerCountByNodeId_()
+    , tipAtLastRemoval_(nullptr)
+    , headersRecordedSinceLastRemoval_(false)
+{
+}
+
+// Requires cs_main.
+void UnverifiedHeadersRegistry::UnregisterNodeId(NodeId nodeId)
+{
+    if (headerCountByNodeId_.erase(nodeId) == 0)
+        return;
+    // The headers stay in the block index, they keep counting against the total
+    for (auto& headerAndSource : sourceByHeader_)
+    {
+        if (headerAndSource.second == nodeId)
+            headerAndSource.second = -1;
+    }
+}
+
+// Requires cs_main.
+bool UnverifiedHeadersRegistry::CanRecordHeader(NodeId nodeId, int height, const CChain& activeChain) const
+{
+    if (activeChain.Tip() == nullptr || height > activeChain.Height() + static_cast<int>(maxHeightAheadOfTip_))
+        return false;
+    if (sourceByHeader_.size() >= maxHeaders_)
+        return false;
+    return GetNumberOfHeadersFrom(nodeId) < maxHeadersPerNode_;
+}
+
+// Requires cs_main.
+void UnverifiedHeadersRegistry::RecordHeader(NodeId nodeId, const CBlockIndex* header)
+{
+    if (!sourceByHeader_.insert(std::make_pair(header, nodeId)).second)
+        return;
+    ++headerCountByNodeId_[nodeId];
+    headersRecordedSinceLastRemoval_ = true;
+}
+
+// Requires cs_main.
+std::vector<NodeId> UnverifiedHeadersRegistry::RemoveResolvedHeaders(const CChain& activeChain)
+{
+    std::vector<NodeId> sourcesOfFailedHeaders;
+    if (activeChain.Tip() == tipAtLastRemoval_ && !headersRecordedSinceLastRemoval_)
+        return sourcesOfFailedHeaders;
+    tipAtLastRemoval_ = activeChain.Tip();
+    headersRecordedSinceLastRemoval_ = false;
+
+    for (auto it = sourceByHeader_.begin(); it != sourceByHeader_.end();)
+    {
+        const CBlockIndex* header = it->first;
+        const bool failed = (header->nStatus & BLOCK_FAILED_MASK) != 0;
+        const bool resolved =
+            failed ||
+            !header->BlockProofIsPending() ||
+            header->nHeight <= activeChain.Height();
+        if (!resolved)
+        {
+            ++it;
+            continue;
+        }
+        // A failure before the stake was checked is a failure of the header
+        const NodeId source = it->second;
+        if (failed && header->BlockProofIsPending() && source >= 0)
+            sourcesOfFailedHeaders.push_back(source);
+        if (source >= 0 && --headerCountByNodeId_[source] == 0)
+            headerCountByNodeId_.erase(source);
+        sourceByHeader_.erase(it++);
+    }
+    return sourcesOfFailedHeaders;
+}
+
+unsigned UnverifiedHeadersRegistry::GetNumberOfHeaders() const
+{
+    return sourceByHeader_.size();
+}
+
+unsigned UnverifiedHeadersRegistry::GetNumberOfHeadersFrom(NodeId nodeId) const
+{
+    const auto it = headerCountByNodeId_.find(nodeId);
+    return it != headerCountByNodeId_.end()? it->second: 0u;
+}
@@ -0,0 +1,34 @@
+#ifndef UNVERIFIED_HEADERS_REGISTRY_H
+#define UNVERIFIED_HEADERS_REGISTRY_H
+#include <map>
+#include <vector>
+#include <NodeId.h>
+class CBlockIndex;
+class CChain;
+
+/** Proof-of-stake headers whose stake is not checked yet, by the peer that
+ *  sent them.  Their correct difficulty costs nothing to forge, so peers may
+ *  only add a bounded number of them, and only close to the active tip.  */
+class UnverifiedHeadersRegistry
+{
+private:
+    const unsigned maxHeightAheadOfTip_;
+    const unsigned maxHeadersPerNode_;
+    const unsigned maxHeaders_;
+    std::map<const CBlockIndex*, NodeId> sourceByHeader_;
+    std::map<NodeId, unsigned> headerCountByNodeId_;
+    const CBlockIndex* tipAtLastRemoval_;
+    bool headersRecordedSinceLastRemoval_;
+public:
+    UnverifiedHeadersRegistry(unsigned maxHeightAheadOfTip, unsigned maxHeadersPerNode, unsigned maxHeaders);
+    void UnregisterNodeId(NodeId nodeId);
+    bool CanRecordHeader(NodeId nodeId, int height, const CChain& activeChain) const;
+    void RecordHeader(NodeId nodeId, const CBlockIndex* header);
+    /** Forgets the headers whose stake was checked, that failed, or that the
+     *  active chain has passed.  Returns the peers whose headers failed the
+     *  deferred stake check, once per failed header.  */
+    std::vector<NodeId> RemoveResolvedHeaders(const CChain& activeChain);
+    unsigned GetNumberOfHeaders() const;
+    unsigned GetNumberOfHeadersFrom(NodeId nodeId) const;
+};
+#endif// UNVERIFIED_HEADERS_REGISTRY_H
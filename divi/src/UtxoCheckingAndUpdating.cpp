@@ -11,6 +11,7 @@
 #include <undo.h>
 #include <chainparams.h>
 #include <defaultValues.h>
+#include <script/SignatureCheckers.h>
 
 bool CheckInputs(
     const CTransaction& tx,
@@ -109,13 +110,17 @@ bool CheckInputs(
         // before the last block chain checkpoint. This is safe because block merkle hashes are
         // still computed and checked, and any change will be caught at the next checkpoint.
         if (fScriptChecks) {
+            // Shared by all of this transaction's checks, which may outlive this call
+            // when they are handed to the script checking threads
+            std::shared_ptr<const PrecomputedTransactionData> txdata =
+                std::make_shared<const PrecomputedTransactionData>(tx);
             for (unsigned int i = 0; i < tx.vin.size(); i++) {
                 const COutPoint& prevout = tx.vin[i].prevout;
                 const CCoins* coins = inputs.AccessCoins(prevout.hash);
                 assert(coins);
 
                 // Verify signature
-                CScriptCheck check(*coins, tx, i, flags);
+                CScriptCheck check(*coins, tx, i, flags, txdata);
                 if (pvChecks) {
                     pvChecks->push_back(CScriptCheck());
                     check.swap(pvChecks->back());
@@ -128,7 +133,7 @@ bool CheckInputs(
                         // avoid splitting the network between upgraded and
                         // non-upgraded nodes.
                         CScriptCheck check(*coins, tx, i,
-                                           flags & ~STANDARD_NOT_MANDATORY_VERIFY_FLAGS);
+                                           flags & ~STANDARD_NOT_MANDATORY_VERIFY_FLAGS, txdata);
                         if (check())
                             return state.Invalid(false, REJECT_NONSTANDARD, strprintf("non-mandatory-script-verify-flag (%s)", ScriptErrorString(check.GetScriptError())));
                     }
@@ -112,6 +112,8 @@ public:
         BLOCK_PROOF_OF_STAKE = (1 << 0), // is proof-of-stake block
         BLOCK_STAKE_ENTROPY = (1 << 1),  // entropy bit for stake modifier
         BLOCK_STAKE_MODIFIER = (1 << 2), // regenerated stake modifier
+        BLOCK_LOTTERY_PENDING = (1 << 3), // lottery winners not computed yet, the parent's were unknown
+        BLOCK_PROOF_PENDING = (1 << 4),   // proof of stake/work checked once the parent is connected
     };
 
     // proof-of-stake specific fields
@@ -289,6 +291,26 @@ public:
         return true;
     }
 
+    bool LotteryWinnersArePending() const
+    {
+        return (nFlags & BLOCK_LOTTERY_PENDING);
+    }
+
+    void SetLotteryWinnersPending(bool fPending)
+    {
+        nFlags = fPending ? (nFlags | BLOCK_LOTTERY_PENDING) : (nFlags & ~BLOCK_LOTTERY_PENDING);
+    }
+
+    bool BlockProofIsPending() const
+    {
+        return (nFlags & BLOCK_PROOF_PENDING);
+    }
+
+    void SetBlockProofPending(bool fPending)
+    {
+        nFlags = fPending ? (nFlags | BLOCK_PROOF_PENDING) : (nFlags & ~BLOCK_PROOF_PENDING);
+    }
+
     bool GeneratedStakeModifier() const
     {
         return (nFlags & BLOCK_STAKE_MODIFIER);
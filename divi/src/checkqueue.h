@@ -6,9 +6,13 @@
 #define BITCOIN_CHECKQUEUE_H
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <stdint.h>
 #include <vector>
 
-#include <boost/foreach.hpp>
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
@@ -16,7 +20,30 @@
 template <typename T>
 class CCheckQueueControl;
 
-/** 
+/** Timing of the verifications done between the first Add and the matching Wait. */
+struct CCheckQueueRoundStats
+{
+    unsigned int nChecks;
+    unsigned int nThreads;
+    int64_t nWallMicros;
+    int64_t nBusyMicros;
+
+    CCheckQueueRoundStats(): nChecks(0), nThreads(0), nWallMicros(0), nBusyMicros(0) {}
+
+    //! Average number of threads that were verifying during the round
+    double Parallelism() const
+    {
+        return nWallMicros > 0 ? static_cast<double>(nBusyMicros) / nWallMicros : 0.0;
+    }
+
+    //! Thread time spent waiting for work during the round
+    int64_t IdleMicros() const
+    {
+        return std::max<int64_t>(0, nThreads * nWallMicros - nBusyMicros);
+    }
+};
+
+/**
  * Queue for verifications that have to be performed.
   * The verifications are represented by a type T, which must provide an
   * operator(), returning a bool.
@@ -25,12 +52,26 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every thread owns a deque guarded by its own mutex. The master spreads
+  * added verifications over the workers' deques, workers drain their own
+  * deque and steal from the others once it is empty, so the shared mutex
+  * is only taken to go to sleep or to wake sleeping threads up.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    struct WorkerQueue
+    {
+        boost::mutex mutex;
+        std::deque<T> checks;
+    };
+
+    //! One deque per thread; slot 0 belongs to the master
+    std::vector<std::unique_ptr<WorkerQueue> > workerQueues;
+
+    //! Mutex to sleep on when out of work
     boost::mutex mutex;
 
     //! Worker threads block on this when out of work
@@ -39,25 +80,21 @@ private:
     //! Master thread blocks on this when out of work
     boost::condition_variable condMaster;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue;
-
-    //! The number of workers (including the master) that are idle.
-    int nIdle;
-
-    //! The total number of workers (including the master).
-    int nTotal;
+    //! The number of worker threads (excluding the master).
+    std::atomic<unsigned int> nWorkers;
 
-    //! The temporary evaluation result.
-    bool fAllOk;
+    //! Number of verifications sitting in the deques, waiting to be picked up.
+    std::atomic<int> nQueued;
 
     /**
      * Number of verifications that haven't completed yet.
-     * This includes elements that are not anymore in queue, but still in
-     * worker's own batches.
+     * This includes elements that are not anymore in a deque, but still in
+     * a thread's own batch.
      */
-    unsigned int nTodo;
+    std::atomic<unsigned int> nTodo;
+
+    //! The temporary evaluation result.
+    std::atomic<bool> fAllOk;
 
     //! Whether we're shutting down.
     bool fQuit;
@@ -65,95 +102,202 @@ private:
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
+    //! Round-robin start for distributing added checks; only used by the master
+    unsigned int nNextWorker;
+
+    //! Round bookkeeping; the start time is only touched by the master
+    std::chrono::steady_clock::time_point roundStart;
+    bool fRoundStarted;
+    unsigned int nRoundChecks;
+    std::atomic<int64_t> nRoundBusyMicros;
+    CCheckQueueRoundStats lastRoundStats;
+
+    static int64_t MicrosSince(const std::chrono::steady_clock::time_point& start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * Decide how many work units to process now.
+     * * Do not try to do everything at once, but aim for increasingly smaller batches so
+     *   all workers finish approximately simultaneously.
+     * * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
+     */
+    unsigned int AdaptiveBatchSize() const
+    {
+        const int nQueuedNow = std::max(0, nQueued.load(std::memory_order_relaxed));
+        const unsigned int nThreads = nWorkers.load(std::memory_order_relaxed) + 1;
+        return std::max(1U, std::min(nBatchSize, static_cast<unsigned int>(nQueuedNow) / (2 * nThreads)));
+    }
+
+    /** Move up to nMax checks into vChecks, from the back of a thread's own deque or the front of a victim's. */
+    static unsigned int TakeChecks(WorkerQueue& workerQueue, std::vector<T>& vChecks, unsigned int nMax, bool fOwnQueue)
+    {
+        boost::unique_lock<boost::mutex> lock(workerQueue.mutex);
+        std::deque<T>& checks = workerQueue.checks;
+        // Steal at most half of a victim's checks so that it keeps working on the rest
+        const unsigned int nAvailable = fOwnQueue ? checks.size() : (checks.size() + 1) / 2;
+        const unsigned int nNow = std::min(nMax, nAvailable);
+        vChecks.resize(nNow);
+        for (unsigned int i = 0; i < nNow; i++) {
+            if (fOwnQueue) {
+                vChecks[i].swap(checks.back());
+                checks.pop_back();
+            } else {
+                vChecks[i].swap(checks.front());
+                checks.pop_front();
+            }
+        }
+        return nNow;
+    }
+
+    bool TakeBatch(unsigned int nSlot, std::vector<T>& vChecks)
+    {
+        const unsigned int nMax = AdaptiveBatchSize();
+        unsigned int nTaken = TakeChecks(*workerQueues[nSlot], vChecks, nMax, true);
+        for (unsigned int i = 1; nTaken == 0 && i < workerQueues.size(); i++)
+            nTaken = TakeChecks(*workerQueues[(nSlot + i) % workerQueues.size()], vChecks, nMax, false);
+        nQueued -= nTaken;
+        return nTaken > 0;
+    }
+
+    void RunBatch(std::vector<T>& vChecks)
+    {
+        const std::chrono::steady_clock::time_point batchStart = std::chrono::steady_clock::now();
+        // Check whether we need to do work at all
+        bool fOk = fAllOk.load(std::memory_order_relaxed);
+        for (T& check : vChecks)
+            if (fOk)
+                fOk = check();
+        if (!fOk)
+            fAllOk = false;
+        const unsigned int nNow = vChecks.size();
+        vChecks.clear();
+        nRoundBusyMicros += MicrosSince(batchStart);
+        if (nTodo.fetch_sub(nNow) == nNow) {
+            // We processed the last element; inform the master he can exit and return the result
+            boost::unique_lock<boost::mutex> lock(mutex);
+            condMaster.notify_one();
+        }
+    }
+
+    bool FinishRound()
+    {
+        lastRoundStats = CCheckQueueRoundStats();
+        if (fRoundStarted) {
+            lastRoundStats.nChecks = nRoundChecks;
+            lastRoundStats.nThreads = nWorkers + 1;
+            lastRoundStats.nWallMicros = MicrosSince(roundStart);
+            lastRoundStats.nBusyMicros = nRoundBusyMicros;
+        }
+        fRoundStarted = false;
+        nRoundChecks = 0;
+        nRoundBusyMicros = 0;
+
+        const bool fRet = fAllOk;
+        // reset the status for new work later
+        fAllOk = true;
+        return fRet;
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster = false)
+    bool Loop(unsigned int nSlot, bool fMaster = false)
     {
-        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
         do {
-            {
-                boost::unique_lock<boost::mutex> lock(mutex);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master he can exit and return the result
-                        condMaster.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty()) {
-                    if ((fMaster || fQuit) && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        if (fMaster)
-                            fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
-                }
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
-                }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+            if (TakeBatch(nSlot, vChecks)) {
+                RunBatch(vChecks);
+                continue;
             }
-            // execute work
-            BOOST_FOREACH (T& check, vChecks)
-                if (fOk)
-                    fOk = check();
-            vChecks.clear();
+
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (nQueued > 0)
+                continue;
+            if (fMaster) {
+                // Only the master adds work, so everything left is already in some thread's batch
+                while (nTodo != 0)
+                    condMaster.wait(lock);
+                return FinishRound();
+            }
+            if (fQuit)
+                return false;
+            condWorker.wait(lock);
         } while (true);
     }
 
 public:
     //! Create a new check queue
-    CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), fQuit(false), nBatchSize(nBatchSizeIn) {}
+    CCheckQueue(
+        unsigned int nBatchSizeIn,
+        unsigned int nMaxWorkers = 64
+        ): workerQueues()
+        , nWorkers(0)
+        , nQueued(0)
+        , nTodo(0)
+        , fAllOk(true)
+        , fQuit(false)
+        , nBatchSize(nBatchSizeIn)
+        , nNextWorker(0)
+        , roundStart()
+        , fRoundStarted(false)
+        , nRoundChecks(0)
+        , nRoundBusyMicros(0)
+        , lastRoundStats()
+    {
+        for (unsigned int i = 0; i < nMaxWorkers + 1; i++)
+            workerQueues.emplace_back(new WorkerQueue());
+    }
 
     //! Worker thread
     void Thread()
     {
-        Loop();
+        // Threads beyond nMaxWorkers share a deque with an earlier one
+        const unsigned int nSlot = 1 + nWorkers++ % (workerQueues.size() - 1);
+        Loop(nSlot);
     }
 
     //! Wait until execution finishes, and return whether all evaluations where successful.
     bool Wait()
     {
-        return Loop(true);
+        return Loop(0, true);
     }
 
     //! Add a batch of checks to the queue
     void Add(std::vector<T>& vChecks)
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        BOOST_FOREACH (T& check, vChecks) {
-            queue.push_back(T());
-            check.swap(queue.back());
+        if (vChecks.empty())
+            return;
+        if (!fRoundStarted) {
+            fRoundStarted = true;
+            roundStart = std::chrono::steady_clock::now();
         }
+        nRoundChecks += vChecks.size();
+        // Account for the checks before they become visible, so a fast worker can never take nTodo to zero early
         nTodo += vChecks.size();
+
+        const unsigned int nTargets = std::max(1U, std::min<unsigned int>(nWorkers, workerQueues.size() - 1));
+        const unsigned int nChunk = (vChecks.size() + nTargets - 1) / nTargets;
+        unsigned int nAdded = 0;
+        while (nAdded < vChecks.size()) {
+            // Without workers the master keeps everything to itself
+            const unsigned int nSlot = nWorkers == 0 ? 0 : 1 + nNextWorker++ % nTargets;
+            const unsigned int nEnd = std::min<unsigned int>(vChecks.size(), nAdded + nChunk);
+            WorkerQueue& workerQueue = *workerQueues[nSlot];
+            boost::unique_lock<boost::mutex> lock(workerQueue.mutex);
+            for (; nAdded < nEnd; nAdded++) {
+                workerQueue.checks.push_back(T());
+                vChecks[nAdded].swap(workerQueue.checks.back());
+            }
+        }
+
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            nQueued += vChecks.size();
+        }
         if (vChecks.size() == 1)
             condWorker.notify_one();
-        else if (vChecks.size() > 1)
+        else
             condWorker.notify_all();
     }
 
@@ -164,11 +308,17 @@ public:
     bool IsIdle()
     {
         boost::unique_lock<boost::mutex> lock(mutex);
-        return (nTotal == nIdle && nTodo == 0 && fAllOk == true);
+        return (nQueued <= 0 && nTodo == 0 && fAllOk == true);
+    }
+
+    //! Statistics of the last completed Wait; only meaningful to the master
+    CCheckQueueRoundStats GetLastRoundStats() const
+    {
+        return lastRoundStats;
     }
 };
 
-/** 
+/**
  * RAII-style controller object for a CCheckQueue that guarantees the passed
  * queue is finished before continuing.
  */
@@ -204,6 +354,15 @@ public:
             pqueue->Add(vChecks);
     }
 
+    //! Statistics of the verifications finished by Wait(), if a queue is used
+    bool GetRoundStats(CCheckQueueRoundStats& stats) const
+    {
+        if (pqueue == NULL || !fDone)
+            return false;
+        stats = pqueue->GetLastRoundStats();
+        return true;
+    }
+
     ~CCheckQueueControl()
     {
         if (!fDone)
@@ -7,6 +7,7 @@
 
 #include "random.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <sstream>
 #include <TransactionLocationReference.h>
@@ -153,6 +154,16 @@ std::string CCoins::ToString() const
     return res.str();
 }
 
+size_t CCoins::DynamicMemoryUsage() const
+{
+    size_t ret = memusage::DynamicUsage(vout);
+    BOOST_FOREACH (const CTxOut& out, vout) {
+        const std::vector<unsigned char>& script = out.scriptPubKey;
+        ret += memusage::DynamicUsage(script);
+    }
+    return ret;
+}
+
 CCoinsViewBacked::CCoinsViewBacked()
   : roBase(nullptr), writeBase(nullptr)
 {}
@@ -195,9 +206,9 @@ bool CCoinsViewBacked::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
 
 CCoinsKeyHasher::CCoinsKeyHasher() : salt(GetRandHash()) {}
 
-CCoinsViewCache::CCoinsViewCache() : backed_(), hasModifier(false), hashBlock(0), cacheCoins() {}
-CCoinsViewCache::CCoinsViewCache(CCoinsView* baseIn) : backed_(baseIn), hasModifier(false), hashBlock(0), cacheCoins() {}
-CCoinsViewCache::CCoinsViewCache(const CCoinsView* baseIn) : backed_(baseIn), hasModifier(false), hashBlock(0), cacheCoins() {}
+CCoinsViewCache::CCoinsViewCache() : backed_(), hasModifier(false), hashBlock(0), cacheCoins(), cachedCoinsUsage(0), cacheHits(0), cacheMisses(0) {}
+CCoinsViewCache::CCoinsViewCache(CCoinsView* baseIn) : backed_(baseIn), hasModifier(false), hashBlock(0), cacheCoins(), cachedCoinsUsage(0), cacheHits(0), cacheMisses(0) {}
+CCoinsViewCache::CCoinsViewCache(const CCoinsView* baseIn) : backed_(baseIn), hasModifier(false), hashBlock(0), cacheCoins(), cachedCoinsUsage(0), cacheHits(0), cacheMisses(0) {}
 
 CCoinsViewCache::~CCoinsViewCache()
 {
@@ -207,18 +218,23 @@ CCoinsViewCache::~CCoinsViewCache()
 CCoinsMap::const_iterator CCoinsViewCache::FetchCoins(const uint256& txid) const
 {
     CCoinsMap::iterator it = cacheCoins.find(txid);
-    if (it != cacheCoins.end())
+    if (it != cacheCoins.end()) {
+        ++cacheHits;
         return it;
+    }
+    ++cacheMisses;
     CCoins tmp;
     if (!backed_.GetCoins(txid, tmp))
         return cacheCoins.end();
     CCoinsMap::iterator ret = cacheCoins.insert(std::make_pair(txid, CCoinsCacheEntry())).first;
     tmp.swap(ret->second.coins);
+    ret->second.nMaxOutputs = ret->second.coins.vout.size();
     if (ret->second.coins.IsPruned()) {
         // The parent only has an empty entry for this txid; we can consider our
         // version as fresh.
         ret->second.flags = CCoinsCacheEntry::FRESH;
     }
+    cachedCoinsUsage += ret->second.coins.DynamicMemoryUsage();
     return ret;
 }
 
@@ -236,7 +252,9 @@ CCoinsModifier CCoinsViewCache::ModifyCoins(const uint256& txid)
 {
     assert(!hasModifier);
     std::pair<CCoinsMap::iterator, bool> ret = cacheCoins.insert(std::make_pair(txid, CCoinsCacheEntry()));
+    size_t cachedCoinUsage = 0;
     if (ret.second) {
+        ++cacheMisses;
         if (!backed_.GetCoins(txid, ret.first->second.coins)) {
             // The parent view does not have this entry; mark it as fresh.
             ret.first->second.coins.Clear();
@@ -245,10 +263,14 @@ CCoinsModifier CCoinsViewCache::ModifyCoins(const uint256& txid)
             // The parent view only has a pruned entry for this; mark it as fresh.
             ret.first->second.flags = CCoinsCacheEntry::FRESH;
         }
+    } else {
+        ++cacheHits;
+        cachedCoinUsage = ret.first->second.coins.DynamicMemoryUsage();
     }
     // Assume that whenever ModifyCoins is called, the entry will be modified.
     ret.first->second.flags |= CCoinsCacheEntry::DIRTY;
-    return CCoinsModifier(*this, ret.first);
+    ret.first->second.nMaxOutputs = std::max<unsigned int>(ret.first->second.nMaxOutputs, ret.first->second.coins.vout.size());
+    return CCoinsModifier(*this, ret.first, cachedCoinUsage);
 }
 
 const CCoins* CCoinsViewCache::AccessCoins(const uint256& txid) const
@@ -298,19 +320,26 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap& coinUpdates, const uint256& hashBloc
                 assert(coinUpdate->second.flags & CCoinsCacheEntry::FRESH);
                 CCoinsCacheEntry& entry = cacheCoins[coinUpdate->first];
                 entry.coins.swap(coinUpdate->second.coins);
+                entry.nMaxOutputs = coinUpdate->second.nMaxOutputs;
+                cachedCoinsUsage += entry.coins.DynamicMemoryUsage();
                 entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
             }
             else if(matchingCoinExistInCache)
             {
                 if ((matchingCachedCoin->second.flags & CCoinsCacheEntry::FRESH) && coinUpdateIsPruned)
                 { // coinUpdate is a pruned coin, so remove the matching entry from the local cache
+                    cachedCoinsUsage -= matchingCachedCoin->second.coins.DynamicMemoryUsage();
                     cacheCoins.erase(matchingCachedCoin);
                 }
                 else
                 {
                     // A normal modification.
+                    cachedCoinsUsage -= matchingCachedCoin->second.coins.DynamicMemoryUsage();
                     matchingCachedCoin->second.coins.swap(coinUpdate->second.coins);
+                    cachedCoinsUsage += matchingCachedCoin->second.coins.DynamicMemoryUsage();
                     matchingCachedCoin->second.flags |= CCoinsCacheEntry::DIRTY;
+                    matchingCachedCoin->second.nMaxOutputs =
+                        std::max(matchingCachedCoin->second.nMaxOutputs, coinUpdate->second.nMaxOutputs);
                 }
             }
         }
@@ -323,14 +352,66 @@ bool CCoinsViewCache::Flush()
 {
     bool fOk = backed_.BatchWrite(cacheCoins, hashBlock);
     cacheCoins.clear();
+    cachedCoinsUsage = 0;
     return fOk;
 }
 
+bool CCoinsViewCache::HaveCoinsInCache(const uint256& txid) const
+{
+    return cacheCoins.count(txid) > 0;
+}
+
+void CCoinsViewCache::CacheCoinsFromParent(const uint256& txid, CCoins& coins)
+{
+    std::pair<CCoinsMap::iterator, bool> ret = cacheCoins.insert(std::make_pair(txid, CCoinsCacheEntry()));
+    if (!ret.second)
+        return;
+    coins.swap(ret.first->second.coins);
+    ret.first->second.nMaxOutputs = ret.first->second.coins.vout.size();
+    if (ret.first->second.coins.IsPruned()) {
+        ret.first->second.flags = CCoinsCacheEntry::FRESH;
+    }
+    cachedCoinsUsage += ret.first->second.coins.DynamicMemoryUsage();
+}
+
+unsigned int CCoinsViewCache::UncacheNonDirtyEntries()
+{
+    assert(!hasModifier);
+    unsigned int evicted = 0;
+    for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end();)
+    {
+        if (it->second.flags & CCoinsCacheEntry::DIRTY)
+        {
+            ++it;
+            continue;
+        }
+        cachedCoinsUsage -= it->second.coins.DynamicMemoryUsage();
+        cacheCoins.erase(it++);
+        ++evicted;
+    }
+    return evicted;
+}
+
 unsigned int CCoinsViewCache::GetCacheSize() const
 {
     return cacheCoins.size();
 }
 
+size_t CCoinsViewCache::DynamicMemoryUsage() const
+{
+    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
+}
+
+uint64_t CCoinsViewCache::GetCacheHits() const
+{
+    return cacheHits;
+}
+
+uint64_t CCoinsViewCache::GetCacheMisses() const
+{
+    return cacheMisses;
+}
+
 const CTxOut& CCoinsViewCache::GetOutputFor(const CTxIn& input) const
 {
     const CCoins* coins = AccessCoins(input.prevout.hash);
@@ -477,7 +558,7 @@ TxReversalStatus CCoinsViewCache::UpdateWithReversedTransaction(const CTransacti
     return fClean? TxReversalStatus::OK : TxReversalStatus::CONTINUE_WITH_ERRORS;
 }
 
-CCoinsModifier::CCoinsModifier(CCoinsViewCache& cache_, CCoinsMap::iterator it_) : cache(cache_), it(it_)
+CCoinsModifier::CCoinsModifier(CCoinsViewCache& cache_, CCoinsMap::iterator it_, size_t usage) : cache(cache_), it(it_), cachedCoinUsage(usage)
 {
     assert(!cache.hasModifier);
     cache.hasModifier = true;
@@ -487,8 +568,13 @@ CCoinsModifier::~CCoinsModifier()
 {
     assert(cache.hasModifier);
     cache.hasModifier = false;
+    it->second.nMaxOutputs = std::max<unsigned int>(it->second.nMaxOutputs, it->second.coins.vout.size());
     it->second.coins.Cleanup();
+    cache.cachedCoinsUsage -= cachedCoinUsage; // Subtract the old usage
     if ((it->second.flags & CCoinsCacheEntry::FRESH) && it->second.coins.IsPruned()) {
         cache.cacheCoins.erase(it);
+    } else {
+        // If the coin still exists after the modification, add the new usage
+        cache.cachedCoinsUsage += it->second.coins.DynamicMemoryUsage();
     }
 }
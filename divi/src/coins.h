@@ -7,6 +7,7 @@
 #define BITCOIN_COINS_H
 
 #include "compressor.h"
+#include "memusage.h"
 #include "script/standard.h"
 #include "serialize.h"
 #include "uint256.h"
@@ -229,6 +230,8 @@ public:
 
     std::string ToString() const;
 
+    //! heap memory owned by this entry (the vout array and every script buffer)
+    size_t DynamicMemoryUsage() const;
 };
 
 class CCoinsKeyHasher
@@ -253,13 +256,16 @@ public:
 struct CCoinsCacheEntry {
     CCoins coins; // The actual cached data.
     unsigned char flags;
+    // The largest number of outputs the coins had since they came from the parent view. Spent
+    // outputs at the end of vout are dropped, the parent may still have them up to this index.
+    unsigned int nMaxOutputs;
 
     enum Flags {
         DIRTY = (1 << 0), // This cache entry is potentially different from the version in the parent view.
         FRESH = (1 << 1), // The parent view does not have this entry (or it is pruned).
     };
 
-    CCoinsCacheEntry() : coins(), flags(0) {}
+    CCoinsCacheEntry() : coins(), flags(0), nMaxOutputs(0) {}
 };
 
 typedef boost::unordered_map<uint256, CCoinsCacheEntry, CCoinsKeyHasher> CCoinsMap;
@@ -332,7 +338,8 @@ class CCoinsModifier
 private:
     CCoinsViewCache& cache;
     CCoinsMap::iterator it;
-    CCoinsModifier(CCoinsViewCache& cache_, CCoinsMap::iterator it_);
+    size_t cachedCoinUsage; // Cached memory usage of the CCoins object before modification
+    CCoinsModifier(CCoinsViewCache& cache_, CCoinsMap::iterator it_, size_t usage);
 
 public:
     CCoins* operator->() { return &it->second.coins; }
@@ -355,6 +362,13 @@ protected:
      */
     mutable uint256 hashBlock;
     mutable CCoinsMap cacheCoins;
+
+    /* Cached dynamic memory usage for the inner CCoins objects. */
+    mutable size_t cachedCoinsUsage;
+
+    /* Lookup statistics, counted in FetchCoins. */
+    mutable uint64_t cacheHits;
+    mutable uint64_t cacheMisses;
 public:
     CCoinsViewCache();
     explicit CCoinsViewCache(CCoinsView* baseIn);
@@ -391,9 +405,32 @@ public:
      */
     bool Flush();
 
+    //! Whether the txid has an entry in this cache, without consulting the parent view
+    bool HaveCoinsInCache(const uint256& txid) const;
+
+    /**
+     * Adds coins that were read from the parent view ahead of time as an
+     * unmodified entry. Existing entries take precedence and are kept.
+     */
+    void CacheCoinsFromParent(const uint256& txid, CCoins& coins);
+
+    /**
+     * Removes every non-dirty entry from the cache, releasing memory without
+     * having to write anything to the parent view. Returns the number of
+     * entries that were evicted.
+     */
+    unsigned int UncacheNonDirtyEntries();
+
     //! Calculate the size of the cache (in number of transactions)
     unsigned int GetCacheSize() const;
 
+    //! Calculate the size of the cache (in bytes)
+    size_t DynamicMemoryUsage() const;
+
+    //! Number of lookups served from this cache / forwarded to the parent view
+    uint64_t GetCacheHits() const;
+    uint64_t GetCacheMisses() const;
+
     /**
      * Amount of divi coming in to a transaction
      * Note that lightweight clients may not know anything besides the hash of previous transactions,
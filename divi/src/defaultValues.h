@@ -30,6 +30,14 @@ constexpr int64_t MAX_DB_CACHE_SIZE = sizeof(void*) > 4 ? 4096 : 1024;
 //! min. -dbcache in (MiB)
 constexpr int64_t MIN_DB_CACHE_SIZE = 4;
 
+//! -sigcachesize default (MiB)
+constexpr int64_t DEFAULT_MAX_SIG_CACHE_SIZE = 32;
+//! max. -sigcachesize (MiB)
+constexpr int64_t MAX_SIG_CACHE_SIZE = sizeof(void*) > 4 ? 16384 : 1024;
+
+//! -outpointcoinsdb default
+constexpr bool DEFAULT_OUTPOINT_COINS_DB = false;
+
 //! -maxtxfee default
 constexpr CAmount DEFAULT_TRANSACTION_MAXFEE = 100 * COIN;
 
@@ -62,6 +70,20 @@ constexpr unsigned int MAX_TX_SIGOPS_CURRENT = MAX_BLOCK_SIGOPS_CURRENT / 5;
 constexpr unsigned int MAX_TX_SIGOPS_LEGACY = MAX_BLOCK_SIGOPS_LEGACY / 5;
 /** Default for -maxorphantx, maximum number of orphan transactions kept in memory */
 constexpr unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
+/** The maximum serialized size of a single orphan transaction */
+constexpr unsigned int MAX_ORPHAN_TRANSACTION_SIZE = 5000;
+/** The maximum number of bytes of orphan transactions kept from a single peer */
+constexpr unsigned int MAX_ORPHAN_BYTES_PER_PEER = 100000;
+/** Seconds after which an orphan transaction is dropped if its inputs never showed up */
+constexpr int64_t ORPHAN_TRANSACTION_EXPIRY = 20 * 60;
+/** Number of orphan transactions revalidated per batch once their parents are accepted */
+constexpr unsigned int MAX_ORPHANS_RESOLVED_PER_BATCH = 100;
+/** Default for -maxmempool, maximum megabytes of memory used by the mempool */
+constexpr unsigned int DEFAULT_MAX_MEMPOOL_SIZE = 300;
+/** -persistmempool default (save the mempool on shutdown and load it on restart) */
+constexpr bool DEFAULT_PERSIST_MEMPOOL = true;
+/** Number of dumped mempool transactions revalidated per cs_main acquisition while loading */
+constexpr unsigned int MEMPOOL_LOAD_BATCH_SIZE = 100;
 /** The maximum size of a blk?????.dat file (since 0.8) */
 constexpr unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 /** The pre-allocation chunk size for blk?????.dat files (since 0.8) */
@@ -76,6 +98,18 @@ constexpr unsigned int LOCKTIME_THRESHOLD = 500000000; // Tue Nov  5 00:53:20 19
 constexpr int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 constexpr int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** -prefetchblocks default (number of blocks ahead of the tip whose inputs are loaded into the coins cache, 0 = off) */
+constexpr int DEFAULT_PREFETCH_BLOCKS = 8;
+/** Maximum number of threads reading coins from the database for the prefetcher */
+constexpr unsigned int COINS_PREFETCH_THREADS = 8;
+/** Do not start another prefetch thread for fewer coins than this */
+constexpr unsigned int MIN_COINS_PER_PREFETCH_THREAD = 16;
+/** Blocks with fewer transactions spending only pre-block coins have their inputs checked serially */
+constexpr unsigned int MIN_TRANSACTIONS_FOR_PARALLEL_PREVALIDATION = 8;
+/** Maximum number of threads processing peer messages */
+constexpr int MAX_MESSAGE_HANDLER_THREADS = 16;
+/** -msghandlerthreads default (number of threads processing peer messages) */
+constexpr int DEFAULT_MESSAGE_HANDLER_THREADS = 4;
 /** Number of blocks that can be requested at any given time from a single peer. */
 constexpr int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -83,11 +117,26 @@ constexpr unsigned int BLOCK_STALLING_TIMEOUT = 2;
 /** Number of headers sent in one getheaders result. We rely on the assumption that if a peer sends
  *  less than this number, we reached their tip. Changing this value is a protocol upgrade. */
 constexpr unsigned int MAX_HEADERS_RESULTS = 2000;
+/** Number of headers messages in a row that may fail to connect to our block index before the peer is
+ *  penalised. Each of them is answered with a getheaders from our best header. */
+constexpr int MAX_UNCONNECTING_HEADERS = 10;
+/** Number of headers a peer may add to our block index on chains with no more work than our active tip
+ *  before it is penalised. */
+constexpr unsigned int MAX_NON_IMPROVING_HEADERS = MAX_HEADERS_RESULTS;
+/** Number of compact blocks that may be requested from a peer without being received. Further new
+ *  blocks are requested from it as full blocks. */
+constexpr unsigned int MAX_REQUESTED_COMPACT_BLOCKS = 16;
 /** Size of the "block download window": how far ahead of our current height do we fetch?
  *  Larger windows tolerate larger download speed differences between peer, but increase the potential
  *  degree of disordering of blocks on disk (which make reindexing and in the future perhaps pruning
  *  harder). We'll probably want to make this a per-peer adaptive value at some point. */
 constexpr unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
+/** Number of proof-of-stake headers with unchecked stakes that one peer may add ahead of the active tip.
+ *  Headers are only accepted up to BLOCK_DOWNLOAD_WINDOW blocks ahead of it. */
+constexpr unsigned int MAX_UNVERIFIED_HEADERS_PER_PEER = BLOCK_DOWNLOAD_WINDOW;
+/** Number of proof-of-stake headers with unchecked stakes that all peers together may add ahead of the
+ *  active tip, including those of peers that have disconnected since. */
+constexpr unsigned int MAX_UNVERIFIED_HEADERS = 4 * BLOCK_DOWNLOAD_WINDOW;
 /** Time to wait (in seconds) between writing blockchain state to disk. */
 constexpr unsigned int DATABASE_WRITE_INTERVAL = 3600;
 /** Maximum length of reject messages. */
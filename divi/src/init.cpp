@@ -43,7 +43,9 @@
 #include <uiMessenger.h>
 #include <timeIntervalConstants.h>
 #include <TransactionInputChecker.h>
+#include <BlockTransactionPrevalidator.h>
 #include <txmempool.h>
+#include <MempoolDB.h>
 #include <StartAndShutdownSignals.h>
 #include <I_MerkleTxConfirmationNumberCalculator.h>
 #include <I_BlockSubmitter.h>
@@ -64,6 +66,7 @@
 #include <LegacyWalletDatabaseEndpointFactory.h>
 #endif
 
+#include <atomic>
 #include <fstream>
 #include <stdint.h>
 #include <stdio.h>
@@ -100,6 +103,9 @@ CTxMemPool& GetTransactionMemoryPool()
 {
     return mempool;
 }
+/** Set once the mempool dump has been loaded, so that an interrupted load
+ *  does not overwrite it with a partial pool on shutdown.  */
+static std::atomic<bool> fDumpMempoolLater(false);
 /** Global instance of the SporkManager, managed through startup/shutdown.  */
 std::unique_ptr<CSporkManager> sporkManagerInstance;
 /** Global instance of the ChainstateManager.  The lifetime is managed through
@@ -378,6 +384,8 @@ void PrepareShutdown()
     RenameThread("divi-shutoff");
     StopRPCThreads();
     StopNode();
+    if (fDumpMempoolLater && settings.GetBoolArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL))
+        MempoolDB().Write(GetTransactionMemoryPool());
     ShutdownCoinMintingModule();
     InterruptTorControl();
     StopTorControl();
@@ -460,7 +468,7 @@ bool VerifyChain(int nCheckLevel, int nCheckDepth, bool useCoinTip)
         coinView,
         GetSporkManager(),
         uiInterface,
-        chainstate->GetNominalViewCacheSize(),
+        chainstate->GetNominalViewCacheUsage(),
         &ShutdownRequested);
     return dbVerifier.VerifyDB(nCheckLevel, nCheckDepth);
 }
@@ -733,6 +741,12 @@ void ReindexAndImportBlockFiles(ChainstateManager* chainstate, Settings& setting
         LogPrintf("Stopping after block import\n");
         StartShutdown();
     }
+
+    if (settings.GetBoolArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
+        if (!MempoolDB().Load(GetTransactionMemoryPool(), &ShutdownRequested))
+            LogPrintf("Could not load the mempool from disk, continuing with an empty pool\n");
+        fDumpMempoolLater = !ShutdownRequested();
+    }
 }
 
 
@@ -900,6 +914,7 @@ bool CheckWalletFileExists(std::string strDataDir)
 void StartScriptVerificationThreads(boost::thread_group& threadGroup)
 {
     TransactionInputChecker::InitializeScriptCheckingThreads(threadGroup);
+    BlockTransactionPrevalidator::InitializeThreads(threadGroup);
 }
 
 
@@ -1032,12 +1047,12 @@ struct CoinCacheSizes
     size_t nTotalCache;
     size_t nBlockTreeDBCache;
     size_t nCoinDBCache;
-    unsigned int nCoinCacheSize;
+    size_t nCoinCacheUsage;
     CoinCacheSizes(
         ): nTotalCache(settings.GetArg("-dbcache", DEFAULT_DB_CACHE_SIZE) << 20)
         , nBlockTreeDBCache(0)
         , nCoinDBCache(0)
-        , nCoinCacheSize(5000)
+        , nCoinCacheUsage(5000 * 300)
     {
     }
 };
@@ -1048,7 +1063,7 @@ CoinCacheSizes CalculateDBCacheSizes()
     size_t& nTotalCache = cacheSizes.nTotalCache;
     size_t& nBlockTreeDBCache = cacheSizes.nBlockTreeDBCache;
     size_t& nCoinDBCache = cacheSizes.nCoinDBCache;
-    unsigned int& nCoinCacheSize = cacheSizes.nCoinCacheSize;
+    size_t& nCoinCacheUsage = cacheSizes.nCoinCacheUsage;
 
     if (nTotalCache < (MIN_DB_CACHE_SIZE << 20))
         nTotalCache = (MIN_DB_CACHE_SIZE << 20); // total cache cannot be less than MIN_DB_CACHE_SIZE
@@ -1060,7 +1075,7 @@ CoinCacheSizes CalculateDBCacheSizes()
     nTotalCache -= nBlockTreeDBCache;
     nCoinDBCache = nTotalCache / 2; // use half of the remaining cache for coindb cache
     nTotalCache -= nCoinDBCache;
-    nCoinCacheSize = nTotalCache / 300; // coins in memory require around 300 bytes
+    nCoinCacheUsage = nTotalCache; // the rest goes to the in-memory coins cache
 
     return cacheSizes;
 }
@@ -1079,6 +1094,12 @@ BlockLoadingStatus TryToLoadBlocks(CSporkManager& sporkManager, std::string& str
         if (settings.isReindexingBlocks())
             chainstate->BlockTree().WriteReindexing(true);
 
+        if (settings.GetBoolArg("-outpointcoinsdb", DEFAULT_OUTPOINT_COINS_DB)) uiInterface.InitMessage(translate("Upgrading coins database..."));
+        if (!chainstate->UpgradeCoinsDatabase()) {
+            strLoadError = translate("Error upgrading coins database");
+            return BlockLoadingStatus::RETRY_LOADING;
+        }
+
         // DIVI: load previous sessions sporks if we have them.
         uiInterface.InitMessage(translate("Loading sporks..."));
         sporkManager.LoadSporksFromDB();
@@ -1316,9 +1337,10 @@ void InitializeMainBlockchainModules()
         new ChainstateManager (
             unitTestMode? (1 << 20) : cacheSizes.nBlockTreeDBCache,
             unitTestMode? (1 << 23) : cacheSizes.nCoinDBCache,
-            unitTestMode? (  5000 ) : cacheSizes.nCoinCacheSize,
+            unitTestMode? (5000 * 300) : cacheSizes.nCoinCacheUsage,
             unitTestMode?      true : false,
-            unitTestMode?     false : settings.isReindexingBlocks()));
+            unitTestMode?     false : settings.isReindexingBlocks(),
+            unitTestMode?     false : settings.GetBoolArg("-outpointcoinsdb", DEFAULT_OUTPOINT_COINS_DB)));
     sporkManagerInstance.reset(new CSporkManager(*chainstateInstance));
     InitializeMultiWalletModule();
     InitializeChainExtensionModule();
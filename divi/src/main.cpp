@@ -17,12 +17,15 @@
 #include <addrman.h>
 #include <alert.h>
 #include <BlockDiskAccessor.h>
+#include <BlockTransactions.h>
 #include <blockmap.h>
 #include <chainparams.h>
 #include <ChainstateManager.h>
 #include <ChainSyncHelpers.h>
 #include <coins.h>
+#include <CompactBlock.h>
 #include <I_BlockSubmitter.h>
+#include <I_ChainExtensionService.h>
 #include <defaultValues.h>
 #include <init.h>
 #include <MempoolConsensus.h>
@@ -32,6 +35,7 @@
 #include <NodeState.h>
 #include <NodeStateRegistry.h>
 #include <OrphanTransactions.h>
+#include <PartiallyDownloadedBlock.h>
 #include <PeerBanningService.h>
 #include <Settings.h>
 #include <spork.h>
@@ -62,6 +66,12 @@ extern Settings& settings;
 
 extern CCriticalSection cs_main;
 
+/** Held by the message handler workers while they process any message that
+ *  changes node or peer state, and while they send to a peer.  Only the
+ *  read-only requests (see IsReadOnlyRequest) are served without it, so they
+ *  can run concurrently with each other and with everything else.  */
+static CCriticalSection cs_serialMessageProcessing;
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // Helper functions
@@ -112,6 +122,7 @@ bool PeersLocalAddressIsGood(CNode* pnode)
 // pushes our own address to a peer
 void AdvertizeLocal(CNode* pnode)
 {
+    LOCK(cs_serialMessageProcessing);
     if (IsListening() && pnode->IsSuccessfullyConnected()) {
         CAddress addrLocal = GetLocalAddress(&pnode->GetCAddress());
         // If discovery is enabled, sometimes give our peer the address it
@@ -140,7 +151,9 @@ bool static AlreadyHave(const CTxMemPool& mempool, const CInv& inv)
     case MSG_TX: {
         bool txInMap = false;
         txInMap = mempool.exists(inv.GetHash());
-        return txInMap || OrphanTransactionIsKnown(inv.GetHash());
+        if (txInMap) return true;
+        LOCK(cs_main);
+        return OrphanTransactionIsKnown(inv.GetHash());
     }
 
     case MSG_BLOCK: {
@@ -174,7 +187,10 @@ static bool PushKnownInventory(const CTxMemPool& mempool, CNode* pfrom, const CI
         }
         break;
     case InventoryType::MSG_SPORK:
-        pushed = ShareSporkDataWithPeer(pfrom,inv.GetHash());
+        {
+            LOCK(cs_serialMessageProcessing);
+            pushed = ShareSporkDataWithPeer(pfrom,inv.GetHash());
+        }
         break;
     case InventoryType::MSG_FILTERED_BLOCK:
     default:
@@ -183,17 +199,20 @@ static bool PushKnownInventory(const CTxMemPool& mempool, CNode* pfrom, const CI
     return pushed;
 }
 
+/** The status of block indices and the best header change under cs_main
+ *  alone, so the block index lock is not enough to decide what to send.  A
+ *  block's disk position is written before it is marked BLOCK_HAVE_DATA and
+ *  never changes afterwards, it can be read without the lock once this
+ *  returns true for the block.  */
 static std::pair<const CBlockIndex*, bool> GetBlockIndexOfRequestedBlock(
-    CCriticalSection& mainCriticalSection,
     NodeId nodeId,
     const uint256& blockHash)
 {
     bool send = false;
     CBlockIndex* pindex = nullptr;
     {
-        LOCK(mainCriticalSection);
-
         const ChainstateManager::Reference chainstate;
+        LOCK(cs_main);
         const auto& blockMap = chainstate->GetBlockMap();
         const auto& chain = chainstate->ActiveChain();
 
@@ -214,23 +233,36 @@ static std::pair<const CBlockIndex*, bool> GetBlockIndexOfRequestedBlock(
                     LogPrintf("%s: ignoring request from peer=%i for old block that isn't in the main chain\n",__func__, nodeId);
                 }
             }
+            // Don't send not-validated blocks
+            send = send && (pindex->nStatus & BLOCK_HAVE_DATA);
         }
     }
     return std::make_pair(pindex,send);
 }
 
-static void PushCorrespondingBlockToPeer(CNode* pfrom, const CBlockIndex* blockToPush,bool isBlock)
+static void PushCorrespondingBlockToPeer(CNode* pfrom, const CBlockIndex* blockToPush, int inventoryType)
 {
     // Send block from disk
-    CBlock block;
-    if (!ReadBlockFromDisk(block, blockToPush))
-        assert(!"cannot load block from disk");
-    if (isBlock)
+    if (inventoryType == MSG_BLOCK)
     {
-        pfrom->PushMessage("block", block);
+        // The bytes on disk are the network serialization, they are sent as they are
+        CDataStream rawBlock(SER_NETWORK, PROTOCOL_VERSION);
+        if (!ReadRawBlockFromDisk(rawBlock, blockToPush))
+            assert(!"cannot load block from disk");
+        pfrom->PushMessage("block", rawBlock);
+    }
+    else if (inventoryType == MSG_CMPCT_BLOCK)
+    {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, blockToPush))
+            assert(!"cannot load block from disk");
+        pfrom->PushMessage("cmpctblock", CompactBlock(block, GetRand(std::numeric_limits<uint64_t>::max())));
     }
     else // MSG_FILTERED_BLOCK)
     {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, blockToPush))
+            assert(!"cannot load block from disk");
         LOCK(pfrom->cs_filter);
         if (pfrom->pfilter) {
             CMerkleBlock merkleBlock(block, *pfrom->pfilter);
@@ -253,7 +285,7 @@ static void PushCorrespondingBlockToPeer(CNode* pfrom, const CBlockIndex* blockT
     }
 }
 
-void static ProcessGetData(const CTxMemPool& mempool, CCriticalSection& mainCriticalSection, CNode* pfrom, std::deque<CInv>& requestsForData)
+void static ProcessGetData(const CTxMemPool& mempool, CNode* pfrom, std::deque<CInv>& requestsForData)
 {
     const ChainstateManager::Reference chainstate;
 
@@ -270,14 +302,12 @@ void static ProcessGetData(const CTxMemPool& mempool, CCriticalSection& mainCrit
             boost::this_thread::interruption_point();
             it++;
 
-            if (inv.GetType() == MSG_BLOCK || inv.GetType() == MSG_FILTERED_BLOCK)
+            if (inv.GetType() == MSG_BLOCK || inv.GetType() == MSG_FILTERED_BLOCK || inv.GetType() == MSG_CMPCT_BLOCK)
             {
-                std::pair<const CBlockIndex*, bool> blockIndexAndSendStatus = GetBlockIndexOfRequestedBlock(mainCriticalSection, pfrom->GetId(),inv.GetHash());
-                // Don't send not-validated blocks
-                if (blockIndexAndSendStatus.second &&
-                    (blockIndexAndSendStatus.first->nStatus & BLOCK_HAVE_DATA))
+                std::pair<const CBlockIndex*, bool> blockIndexAndSendStatus = GetBlockIndexOfRequestedBlock(pfrom->GetId(),inv.GetHash());
+                if (blockIndexAndSendStatus.second)
                 {
-                    PushCorrespondingBlockToPeer(pfrom, blockIndexAndSendStatus.first,inv.GetType() == MSG_BLOCK);
+                    PushCorrespondingBlockToPeer(pfrom, blockIndexAndSendStatus.first, inv.GetType());
 
                     // Trigger them to send a getblocks request for the next batch of inventory
                     if (inv.GetHash() == pfrom->hashContinue) {
@@ -285,7 +315,10 @@ void static ProcessGetData(const CTxMemPool& mempool, CCriticalSection& mainCrit
                         // and we want it right after the last block so they don't
                         // wait for other stuff first.
                         std::vector<CInv> vInv;
-                        vInv.push_back(CInv(MSG_BLOCK, chainstate->ActiveChain().Tip()->GetBlockHash()));
+                        {
+                            boost::shared_lock<boost::shared_mutex> blockIndexLock(chainstate->BlockIndexAccess());
+                            vInv.push_back(CInv(MSG_BLOCK, chainstate->ActiveChain().Tip()->GetBlockHash()));
+                        }
                         pfrom->PushMessage("inv", vInv);
                         pfrom->hashContinue = 0;
                     }
@@ -300,7 +333,7 @@ void static ProcessGetData(const CTxMemPool& mempool, CCriticalSection& mainCrit
                 }
             }
 
-            if (inv.GetType() == MSG_BLOCK || inv.GetType() == MSG_FILTERED_BLOCK)
+            if (inv.GetType() == MSG_BLOCK || inv.GetType() == MSG_FILTERED_BLOCK || inv.GetType() == MSG_CMPCT_BLOCK)
                 break;
         }
     }
@@ -322,7 +355,7 @@ void static ProcessGetData(const CTxMemPool& mempool, CCriticalSection& mainCrit
 void RespondToRequestForDataFrom(CNode* pfrom)
 {
     const CTxMemPool& mempool = GetTransactionMemoryPool();
-    ProcessGetData(mempool, cs_main, pfrom, pfrom->GetRequestForDataQueue());
+    ProcessGetData(mempool, pfrom, pfrom->GetRequestForDataQueue());
 }
 
 constexpr const char* NetworkMessageType_VERSION = "version";
@@ -440,6 +473,110 @@ static bool SetPeerVersionAndServices(CCriticalSection& mainCriticalSection, CNo
     return true;
 }
 
+/** Revalidates one batch of the orphans whose parents were accepted.  The
+ *  orphans accepted here queue their own children for a later batch, so a
+ *  long chain of orphans is worked off between messages instead of in one go.  */
+static void ResolveQueuedOrphanTransactions(CTxMemPool& mempool)
+{
+    AssertLockHeld(cs_main);
+    std::vector<OrphanTransactionPool::Orphan> orphans;
+    TakeOrphansQueuedForResolution(MAX_ORPHANS_RESOLVED_PER_BATCH, orphans);
+    if (orphans.empty())
+        return;
+
+    std::vector<std::pair<CTransaction, int64_t>> orphanBatch;
+    orphanBatch.reserve(orphans.size());
+    const int64_t acceptTime = GetTime();
+    for (const OrphanTransactionPool::Orphan& orphan : orphans)
+        orphanBatch.emplace_back(orphan.tx, acceptTime);
+
+    // The results come with their own validation states, so someone can't setup nodes to counter-DoS
+    // based on orphan resolution (that is, feeding people an invalid transaction based on LegitTxX in
+    // order to get anyone relaying LegitTxX banned)
+    std::vector<MempoolConsensus::TransactionAcceptanceResult> orphanResults;
+    MempoolConsensus::AcceptTransactionsToMemoryPool(mempool, orphanBatch, true, orphanResults);
+
+    std::set<NodeId> setMisbehaving;
+    for (unsigned orphanIndex = 0; orphanIndex < orphans.size(); ++orphanIndex)
+    {
+        const OrphanTransactionPool::Orphan& orphan = orphans[orphanIndex];
+        const uint256 orphanHash = orphan.tx.GetHash();
+        const MempoolConsensus::TransactionAcceptanceResult& result = orphanResults[orphanIndex];
+        if (result.accepted) {
+            LogPrint("mempool", "   accepted orphan tx %s\n", orphanHash);
+            RelayTransactionToAllPeers(orphan.tx);
+            EraseOrphanTx(orphanHash);
+            QueueOrphansSpendingFrom(orphan.tx);
+        } else if (!result.missingInputs) {
+            int nDos = 0;
+            if (result.state.IsInvalid(nDos) && nDos > 0 && !setMisbehaving.count(orphan.fromPeer)) {
+                // Punish peer that gave us an invalid orphan tx
+                Misbehaving(orphan.fromPeer, nDos, "Invalid orphan transaction required by mempool transaction");
+                setMisbehaving.insert(orphan.fromPeer);
+                LogPrint("mempool", "   invalid orphan tx %s\n", orphanHash);
+            }
+            // Has inputs but not accepted to mempool
+            // Probably non-standard or insufficient fee/priority
+            LogPrint("mempool", "   removed orphan tx %s\n", orphanHash);
+            EraseOrphanTx(orphanHash);
+        }
+    }
+
+    const ChainstateManager::Reference chainstate;
+    mempool.check(&chainstate->CoinsTip(), chainstate->GetBlockMap());
+}
+
+/** Hands a block received in full, or rebuilt from a compact block, to
+ *  the chain extension.  A block whose parent we do not know makes us ask
+ *  the peer for the blocks leading up to it.  */
+static void ProcessReceivedBlock(CCriticalSection& mainCriticalSection, CNode* pfrom, CBlock& block)
+{
+    const ChainstateManager::Reference chainstate;
+    const auto& blockMap = chainstate->GetBlockMap();
+    const auto& chain = chainstate->ActiveChain();
+
+    uint256 hashBlock = block.GetHash();
+    CInv inv(MSG_BLOCK, hashBlock);
+    LogPrint("net", "received block %s peer=%d\n", inv.GetHash(), pfrom->id);
+
+    //sometimes we will be sent their most recent block and its not the one we want, in that case tell where we are
+    if (!blockMap.count(block.hashPrevBlock)) {
+        if (find(pfrom->vBlockRequested.begin(), pfrom->vBlockRequested.end(), hashBlock) != pfrom->vBlockRequested.end()) {
+            //we already asked for this block, so lets work backwards and ask for the previous block
+            pfrom->PushMessage("getblocks", chain.GetLocator(), block.hashPrevBlock);
+            pfrom->vBlockRequested.push_back(block.hashPrevBlock);
+        } else {
+            //ask to sync to this block
+            pfrom->PushMessage("getblocks", chain.GetLocator(), hashBlock);
+            pfrom->vBlockRequested.push_back(hashBlock);
+        }
+    } else {
+        pfrom->AddInventoryKnown(inv);
+
+        CValidationState state;
+        const auto it = blockMap.find(hashBlock);
+        if (it == blockMap.end() || !(it->second->nStatus & BLOCK_HAVE_DATA)) {
+            GetBlockSubmitter().acceptBlockForChainExtension(state,block,pfrom);
+            int nDoS;
+            if(state.IsInvalid(nDoS)) {
+                pfrom->PushMessage("reject", std::string("block"), state.GetRejectCode(),
+                                   state.GetRejectReason().substr(0, MAX_REJECT_MESSAGE_LENGTH), inv.GetHash());
+                if(nDoS > 0) {
+                    TRY_LOCK(mainCriticalSection, lockMain);
+                    if(lockMain) Misbehaving(pfrom->GetNodeState(), nDoS, "Bad block processed");
+                }
+            }
+            //disconnect this node if its old protocol version
+            if(pfrom->DisconnectOldProtocol(ActiveProtocol(), "block"))
+            {
+                PeerBanningService::Ban(GetTime(),pfrom->GetCAddress());
+            }
+        } else {
+            LogPrint("net", "%s : Already processed block %s, skipping block processing()\n", __func__, block.GetHash());
+        }
+    }
+}
+
 bool static ProcessMessage(
     CTxMemPool& mempool,
     CCriticalSection& mainCriticalSection,
@@ -575,13 +712,21 @@ bool static ProcessMessage(
                 return error("Peer %d has exceeded send buffer size", pfrom->GetId());
             }
         }
+        // Newly announced blocks are asked for as compact blocks once we are
+        // synced, most of their transactions should already be in our mempool
+        const bool requestCompactBlocks =
+            pfrom->GetVersion() >= COMPACT_BLOCKS_VERSION && !IsInitialBlockDownload(mainCriticalSection, settings);
         {
             LOCK(mainCriticalSection);
             for(const CInv* blockInventoryReference: blockInventory)
             {
                 if(!BlockIsInFlight(blockInventoryReference->GetHash()))
                 {
-                    vToFetch.push_back(*blockInventoryReference);
+                    const bool requestCompactBlock =
+                        requestCompactBlocks &&
+                        RecordCompactBlockRequest(blockMap, pfrom->GetNodeState(), blockInventoryReference->GetHash());
+                    vToFetch.push_back(
+                        requestCompactBlock? CInv(MSG_CMPCT_BLOCK, blockInventoryReference->GetHash()): *blockInventoryReference);
                     LogPrint("net", "getblocks (%d) %s to peer=%d\n", GetBestHeaderBlockHeight(), blockInventoryReference->GetHash(), pfrom->id);
                 }
             }
@@ -601,19 +746,52 @@ bool static ProcessMessage(
 
         pfrom->HandleRequestForData(vInv);
     }
+    else if (strCommand == "getheaders" && Params().HeadersFirstSyncingActive() && pfrom->GetVersion() >= HEADERS_FIRST_SYNC_VERSION)
+    {
+        CBlockLocator locator;
+        uint256 hashStop;
+        vRecv >> locator >> hashStop;
+
+        boost::shared_lock<boost::shared_mutex> blockIndexLock(chainstate->BlockIndexAccess());
+
+        const CBlockIndex* pindex = nullptr;
+        if (locator.IsNull()) {
+            // If locator is null, return the hashStop block
+            const auto mi = blockMap.find(hashStop);
+            if (mi == blockMap.end())
+                return true;
+            pindex = (*mi).second;
+        } else {
+            // Find the last block the caller has in the main chain
+            pindex = FindForkInGlobalIndex(blockMap, chain, locator);
+            if (pindex)
+                pindex = chain.Next(pindex);
+        }
+
+        // we must use CBlocks, as CBlockHeaders won't include the 0x00 nTx count at the end
+        std::vector<CBlock> vHeaders;
+        int nLimit = MAX_HEADERS_RESULTS;
+        LogPrint("net","getheaders %d to %s from peer=%d\n", (pindex ? pindex->nHeight : -1), hashStop, pfrom->id);
+        for (; pindex; pindex = chain.Next(pindex)) {
+            vHeaders.push_back(pindex->GetBlockHeader());
+            if (--nLimit <= 0 || pindex->GetBlockHash() == hashStop)
+                break;
+        }
+        pfrom->PushMessage("headers", vHeaders);
+    }
     else if (strCommand == "getblocks" || strCommand == "getheaders")
     {
         CBlockLocator locator;
         uint256 hashStop;
         vRecv >> locator >> hashStop;
 
-        /* We build up the inventory while holding the main critical section (since we access
-           a lot of global state, especially chainActive), but then send it
-           to the peer without holding onto the lock anymore.  */
+        /* We build up the inventory while holding the block index lock (since we access
+           the block map and chainActive), but then send it to the peer without
+           holding onto the lock anymore.  */
         std::vector<CInv> vInv;
 
         {
-        LOCK(mainCriticalSection);
+        boost::shared_lock<boost::shared_mutex> blockIndexLock(chainstate->BlockIndexAccess());
 
         // Find the last block the caller has in the main chain
         const CBlockIndex* pindex = FindForkInGlobalIndex(blockMap,chain, locator);
@@ -648,44 +826,100 @@ bool static ProcessMessage(
     }
     else if (strCommand == "headers" && Params().HeadersFirstSyncingActive())
     {
-        CBlockLocator locator;
-        uint256 hashStop;
-        vRecv >> locator >> hashStop;
+        std::vector<CBlock> vHeaders;
+        vRecv >> vHeaders;
+        if (vHeaders.size() > MAX_HEADERS_RESULTS) {
+            Misbehaving(pfrom->GetNodeState(), 20, "Headers message too large");
+            return error("headers message size = %u", vHeaders.size());
+        }
 
+        const CBlockIndex* pindexLast = nullptr;
+        {
         LOCK(mainCriticalSection);
 
-        if (IsInitialBlockDownload(mainCriticalSection,settings))
+        CNodeState* state = pfrom->GetNodeState();
+        if (!state->fHeadersRequested) {
+            LogPrint("net", "ignoring unsolicited headers from peer=%d\n", pfrom->id);
+            return true;
+        }
+        state->fHeadersRequested = false;
+        if (vHeaders.empty())
             return true;
 
-        const CBlockIndex* pindex = nullptr;
-        if (locator.IsNull()) {
-            // If locator is null, return the hashStop block
-            const auto mi = blockMap.find(hashStop);
-            if (mi == blockMap.end())
-                return true;
-            pindex = (*mi).second;
-        } else {
-            // Find the last block the caller has in the main chain
-            pindex = FindForkInGlobalIndex(blockMap, chain, locator);
-            if (pindex)
-                pindex = chain.Next(pindex);
+        // Headers that do not connect may follow a reorg we have not heard of,
+        // ask for the headers leading up to them instead of penalising the peer
+        if (blockMap.count(vHeaders.front().hashPrevBlock) == 0) {
+            if (++state->nUnconnectingHeaders > MAX_UNCONNECTING_HEADERS)
+                Misbehaving(state, 20, "Too many unconnecting headers");
+            LogPrint("net", "headers from peer=%d do not connect (%d in a row), getheaders (%d)\n",
+                     pfrom->id, state->nUnconnectingHeaders, GetBestHeaderBlockHeight());
+            pfrom->PushMessage("getheaders", chain.GetLocator(GetBestHeaderBlockIndex()), uint256(0));
+            state->fHeadersRequested = true;
+            return true;
+        }
+        state->nUnconnectingHeaders = 0;
+
+        // Headers checked or passed by the active chain since make room for new ones
+        RemoveResolvedUnverifiedHeaders(chain);
+        state->fHeadersSyncPaused = false;
+
+        unsigned numberOfNewHeaders = 0;
+        uint256 hashLastHeader(0);
+        for (const CBlock& header : vHeaders) {
+            if (pindexLast != nullptr && header.hashPrevBlock != hashLastHeader) {
+                Misbehaving(pfrom->GetNodeState(), 20, "Non-continuous headers sequence");
+                return error("non-continuous headers sequence from peer=%d", pfrom->id);
+            }
+            const bool isNewHeader = blockMap.count(header.GetHash()) == 0;
+            if (isNewHeader) {
+                // Only a bounded number of headers with unchecked stakes may wait
+                // ahead of the active tip, the rest is asked for once they are checked
+                const auto mi = blockMap.find(header.hashPrevBlock);
+                const int height = mi != blockMap.end()? mi->second->nHeight + 1: 0;
+                if (height > Params().LAST_POW_BLOCK() && !CanAcceptUnverifiedHeader(pfrom->GetId(), height, chain)) {
+                    LogPrint("net", "pausing headers sync at height %d with peer=%d until the stakes ahead of the tip are checked\n",
+                             height, pfrom->id);
+                    state->fHeadersSyncPaused = true;
+                    break;
+                }
+                ++numberOfNewHeaders;
+            }
+            CValidationState validationState;
+            const std::pair<CBlockIndex*, bool> assignmentResult = GetChainExtensionService().assignBlockIndexToHeader(header, validationState);
+            if (!assignmentResult.second) {
+                int nDoS;
+                if (validationState.IsInvalid(nDoS) && nDoS > 0)
+                    Misbehaving(state, nDoS, "Invalid block header");
+                return error("invalid header %s received from peer=%d", header.GetHash(), pfrom->id);
+            }
+            pindexLast = assignmentResult.first;
+            hashLastHeader = pindexLast->GetBlockHash();
+            if (isNewHeader && pindexLast->BlockProofIsPending())
+                RecordUnverifiedHeader(pfrom->GetId(), pindexLast);
+        }
+        if (pindexLast == nullptr)
+            return true;
+        UpdateBlockAvailability(blockMap, state, hashLastHeader);
+
+        // Headers of chains that cannot overtake ours only take up memory
+        if (numberOfNewHeaders > 0 && pindexLast->nChainWork <= chain.Tip()->nChainWork) {
+            state->nNonImprovingHeaders += numberOfNewHeaders;
+            if (state->nNonImprovingHeaders > MAX_NON_IMPROVING_HEADERS) {
+                Misbehaving(state, 20, "Too many headers without more work");
+                return error("%u headers without more work than the active chain from peer=%d", state->nNonImprovingHeaders, pfrom->id);
+            }
         }
 
-        // we must use CBlocks, as CBlockHeaders won't include the 0x00 nTx count at the end
-        std::vector<CBlock> vHeaders;
-        int nLimit = MAX_HEADERS_RESULTS;
-        LogPrint("net","getheaders %d to %s from peer=%d\n", (pindex ? pindex->nHeight : -1), hashStop, pfrom->id);
-        for (; pindex; pindex = chain.Next(pindex)) {
-            vHeaders.push_back(pindex->GetBlockHeader());
-            if (--nLimit <= 0 || pindex->GetBlockHash() == hashStop)
-                break;
+        // A full batch means the peer has more headers to send
+        if (!state->fHeadersSyncPaused && vHeaders.size() == MAX_HEADERS_RESULTS) {
+            LogPrint("net", "more getheaders (%d) to end to peer=%d\n", pindexLast->nHeight, pfrom->id);
+            pfrom->PushMessage("getheaders", chain.GetLocator(pindexLast), uint256(0));
+            state->fHeadersRequested = true;
+        }
         }
-        pfrom->PushMessage("headers", vHeaders);
     }
     else if (strCommand == "tx" || strCommand == "dstx")
     {
-        std::vector<uint256> vWorkQueue;
-        std::vector<uint256> vEraseQueue;
         CTransaction tx;
 
         //masternode signed transaction
@@ -711,7 +945,6 @@ bool static ProcessMessage(
         {
             mempool.check(&coinsTip, blockMap);
             RelayTransactionToAllPeers(tx);
-            vWorkQueue.push_back(inv.GetHash());
 
             LogPrint("mempool", "%s: peer=%d %s : accepted %s (poolsz %u)\n",
                     __func__,
@@ -719,53 +952,16 @@ bool static ProcessMessage(
                      tx.ToStringShort(),
                      mempool.mapTx.size());
 
-            // Recursively process any orphan transactions that depended on this one
-            std::set<NodeId> setMisbehaving;
-            for(unsigned int i = 0; i < vWorkQueue.size(); i++)
-            {
-                const std::set<uint256>& spendingTransactionIds = GetOrphanSpendingTransactionIds(vWorkQueue[i]);
-                for(const uint256 &orphanHash: spendingTransactionIds)
-                {
-                    NodeId fromPeer;
-                    const CTransaction &orphanTx = GetOrphanTransaction(orphanHash,fromPeer);
-                    bool fMissingInputs2 = false;
-                    // Use a dummy CValidationState so someone can't setup nodes to counter-DoS based on orphan
-                    // resolution (that is, feeding people an invalid transaction based on LegitTxX in order to get
-                    // anyone relaying LegitTxX banned)
-                    CValidationState stateDummy;
-
-
-                    if(setMisbehaving.count(fromPeer))
-                        continue;
-                    if(MempoolConsensus::AcceptToMemoryPool(mempool, stateDummy, orphanTx, true, &fMissingInputs2)) {
-                        LogPrint("mempool", "   accepted orphan tx %s\n", orphanHash);
-                        RelayTransactionToAllPeers(orphanTx);
-                        vWorkQueue.push_back(orphanHash);
-                        vEraseQueue.push_back(orphanHash);
-                    } else if(!fMissingInputs2) {
-                        int nDos = 0;
-                        if(stateDummy.IsInvalid(nDos) && nDos > 0) {
-                            // Punish peer that gave us an invalid orphan tx
-                            Misbehaving(fromPeer, nDos, "Invalid orphan transaction required by mempool transaction");
-                            setMisbehaving.insert(fromPeer);
-                            LogPrint("mempool", "   invalid orphan tx %s\n", orphanHash);
-                        }
-                        // Has inputs but not accepted to mempool
-                        // Probably non-standard or insufficient fee/priority
-                        LogPrint("mempool", "   removed orphan tx %s\n", orphanHash);
-                        vEraseQueue.push_back(orphanHash);
-                    }
-                    mempool.check(&coinsTip, blockMap);
-                }
-            }
-
-            for(uint256 hash: vEraseQueue)EraseOrphanTx(hash);
+            // Orphans spending this transaction are revalidated one batch at a time,
+            // their own children are left for the batches run between messages
+            QueueOrphansSpendingFrom(tx);
+            ResolveQueuedOrphanTransactions(mempool);
         }
         else if (fMissingInputs)
         {
             AddOrphanTx(tx, pfrom->GetId());
 
-            // DoS prevention: do not allow mapOrphanTransactions to grow unbounded
+            // DoS prevention: do not allow the orphan pool to grow unbounded
             unsigned int nMaxOrphanTx = (unsigned int)std::max((int64_t)0, settings.GetArg("-maxorphantx", DEFAULT_MAX_ORPHAN_TRANSACTIONS));
             unsigned int nEvicted = LimitOrphanTxSize(nMaxOrphanTx);
             if (nEvicted > 0)
@@ -794,45 +990,131 @@ bool static ProcessMessage(
     {
         CBlock block;
         vRecv >> block;
-        uint256 hashBlock = block.GetHash();
-        CInv inv(MSG_BLOCK, hashBlock);
-        LogPrint("net", "received block %s peer=%d\n", inv.GetHash(), pfrom->id);
-
-        //sometimes we will be sent their most recent block and its not the one we want, in that case tell where we are
-        if (!blockMap.count(block.hashPrevBlock)) {
-            if (find(pfrom->vBlockRequested.begin(), pfrom->vBlockRequested.end(), hashBlock) != pfrom->vBlockRequested.end()) {
-                //we already asked for this block, so lets work backwards and ask for the previous block
-                pfrom->PushMessage("getblocks", chain.GetLocator(), block.hashPrevBlock);
-                pfrom->vBlockRequested.push_back(block.hashPrevBlock);
-            } else {
-                //ask to sync to this block
-                pfrom->PushMessage("getblocks", chain.GetLocator(), hashBlock);
-                pfrom->vBlockRequested.push_back(hashBlock);
+        ProcessReceivedBlock(mainCriticalSection, pfrom, block);
+    }
+    else if (strCommand == "cmpctblock" && !settings.isImportingFiles() && !settings.isReindexingBlocks())
+    {
+        CompactBlock compactBlock;
+        vRecv >> compactBlock;
+        const uint256 hashBlock = compactBlock.header.GetHash();
+        {
+            LOCK(mainCriticalSection);
+            // Compact blocks are only sent in answer to our getdata
+            if (!TakeCompactBlockRequest(pfrom->GetNodeState(), hashBlock)) {
+                LogPrint("net", "ignoring unrequested compact block %s from peer=%d\n", hashBlock, pfrom->id);
+                return true;
+            }
+            const auto it = blockMap.find(hashBlock);
+            if (it != blockMap.end() && (it->second->nStatus & BLOCK_HAVE_DATA)) {
+                LogPrint("net", "%s : Already processed block %s, skipping compact block\n", __func__, hashBlock);
+                return true;
+            }
+            // Only rebuild blocks on top of a known parent, a full block still
+            // goes through the orphan handling of ProcessReceivedBlock
+            if (blockMap.count(compactBlock.header.hashPrevBlock) == 0) {
+                LogPrint("net", "compact block %s from peer=%d does not connect, getdata\n", hashBlock, pfrom->id);
+                pfrom->PushMessage("getdata", std::vector<CInv>(1, CInv(MSG_BLOCK, hashBlock)));
+                return true;
+            }
+            CValidationState validationState;
+            if (!GetChainExtensionService().assignBlockIndexToHeader(CBlock(compactBlock.header), validationState).second) {
+                int nDoS;
+                if (validationState.IsInvalid(nDoS) && nDoS > 0)
+                    Misbehaving(pfrom->GetNodeState(), nDoS, "Invalid compact block header");
+                return error("invalid header of compact block %s from peer=%d", hashBlock, pfrom->id);
+            }
+        }
+
+        std::unique_ptr<PartiallyDownloadedBlock> partialBlock(new PartiallyDownloadedBlock());
+        const PartiallyDownloadedBlock::ReadStatus status = partialBlock->InitData(compactBlock, mempool);
+        if (status == PartiallyDownloadedBlock::ReadStatus::INVALID) {
+            LOCK(mainCriticalSection);
+            Misbehaving(pfrom->GetNodeState(), 100, "Invalid compact block");
+            return error("invalid compact block %s from peer=%d", hashBlock, pfrom->id);
+        }
+        if (status == PartiallyDownloadedBlock::ReadStatus::FAILED) {
+            pfrom->PushMessage("getdata", std::vector<CInv>(1, CInv(MSG_BLOCK, hashBlock)));
+            return true;
+        }
+
+        BlockTransactionsRequest request;
+        request.blockHash = hashBlock;
+        partialBlock->GetMissingTransactionIndices(request.indices);
+        LogPrint("net", "compact block %s peer=%d: %u prefilled, %u from mempool, %u requested\n",
+                 hashBlock, pfrom->id, partialBlock->GetPrefilledTransactionCount(),
+                 partialBlock->GetMempoolTransactionCount(), request.indices.size());
+
+        if (request.indices.empty()) {
+            CBlock block;
+            if (partialBlock->FillBlock(block, std::vector<CTransaction>()) != PartiallyDownloadedBlock::ReadStatus::OK) {
+                pfrom->PushMessage("getdata", std::vector<CInv>(1, CInv(MSG_BLOCK, hashBlock)));
+                return true;
             }
+            ProcessReceivedBlock(mainCriticalSection, pfrom, block);
         } else {
-            pfrom->AddInventoryKnown(inv);
+            {
+                LOCK(mainCriticalSection);
+                pfrom->GetNodeState()->partiallyDownloadedBlock = std::move(partialBlock);
+            }
+            pfrom->PushMessage("getblocktxn", request);
+        }
+    }
+    else if (strCommand == "getblocktxn")
+    {
+        BlockTransactionsRequest request;
+        vRecv >> request;
 
-            CValidationState state;
-            if (!blockMap.count(block.GetHash())) {
-                GetBlockSubmitter().acceptBlockForChainExtension(state,block,pfrom);
-                int nDoS;
-                if(state.IsInvalid(nDoS)) {
-                    pfrom->PushMessage("reject", strCommand, state.GetRejectCode(),
-                                       state.GetRejectReason().substr(0, MAX_REJECT_MESSAGE_LENGTH), inv.GetHash());
-                    if(nDoS > 0) {
-                        TRY_LOCK(mainCriticalSection, lockMain);
-                        if(lockMain) Misbehaving(pfrom->GetNodeState(), nDoS, "Bad block processed");
-                    }
-                }
-                //disconnect this node if its old protocol version
-                if(pfrom->DisconnectOldProtocol(ActiveProtocol(), strCommand))
-                {
-                    PeerBanningService::Ban(GetTime(),pfrom->GetCAddress());
-                }
-            } else {
-                LogPrint("net", "%s : Already processed block %s, skipping block processing()\n", __func__, block.GetHash());
+        std::pair<const CBlockIndex*, bool> blockIndexAndSendStatus = GetBlockIndexOfRequestedBlock(pfrom->GetId(), request.blockHash);
+        if (!blockIndexAndSendStatus.second) {
+            LogPrint("net", "peer=%d asked for transactions of unavailable block %s\n", pfrom->id, request.blockHash);
+            return true;
+        }
+        CBlock block;
+        if (!ReadBlockFromDisk(block, blockIndexAndSendStatus.first))
+            assert(!"cannot load block from disk");
+
+        BlockTransactions response;
+        response.blockHash = request.blockHash;
+        response.transactions.reserve(request.indices.size());
+        for (const uint32_t index : request.indices) {
+            if (index >= block.vtx.size()) {
+                LOCK(mainCriticalSection);
+                Misbehaving(pfrom->GetNodeState(), 100, "Out of range transaction index in getblocktxn");
+                return error("getblocktxn with out of range index %u from peer=%d", index, pfrom->id);
+            }
+            response.transactions.push_back(block.vtx[index]);
+        }
+        pfrom->PushMessage("blocktxn", response);
+    }
+    else if (strCommand == "blocktxn" && !settings.isImportingFiles() && !settings.isReindexingBlocks())
+    {
+        BlockTransactions response;
+        vRecv >> response;
+
+        std::unique_ptr<PartiallyDownloadedBlock> partialBlock;
+        {
+            LOCK(mainCriticalSection);
+            std::unique_ptr<PartiallyDownloadedBlock>& pendingBlock = pfrom->GetNodeState()->partiallyDownloadedBlock;
+            if (!pendingBlock || pendingBlock->GetBlockHash() != response.blockHash) {
+                LogPrint("net", "peer=%d sent unrequested transactions of block %s\n", pfrom->id, response.blockHash);
+                return true;
             }
+            partialBlock = std::move(pendingBlock);
+        }
+
+        CBlock block;
+        const PartiallyDownloadedBlock::ReadStatus status = partialBlock->FillBlock(block, response.transactions);
+        if (status == PartiallyDownloadedBlock::ReadStatus::INVALID) {
+            LOCK(mainCriticalSection);
+            Misbehaving(pfrom->GetNodeState(), 100, "Invalid blocktxn");
+            return error("invalid blocktxn for block %s from peer=%d", response.blockHash, pfrom->id);
+        }
+        if (status == PartiallyDownloadedBlock::ReadStatus::FAILED) {
+            // A short id collision picked the wrong mempool transaction
+            pfrom->PushMessage("getdata", std::vector<CInv>(1, CInv(MSG_BLOCK, response.blockHash)));
+            return true;
         }
+        ProcessReceivedBlock(mainCriticalSection, pfrom, block);
     }
     // This asymmetric behavior for inbound and outbound connections was introduced
     // to prevent a fingerprinting attack: an attacker can send specific fake addresses
@@ -841,8 +1123,9 @@ bool static ProcessMessage(
     // getaddr message mitigates the attack.
     else if ((strCommand == "getaddr") && (pfrom->fInbound))
     {
-        pfrom->vAddrToSend.clear();
         std::vector<CAddress> vAddr = addrman.GetAddr();
+        LOCK(cs_serialMessageProcessing);
+        pfrom->vAddrToSend.clear();
         for(const CAddress& addr: vAddr)
                 pfrom->PushAddress(addr);
     }
@@ -987,6 +1270,17 @@ static NetworkMessageState CheckNetworkMessageHeader(
     return NetworkMessageState::VALID;
 }
 
+/** Requests that only read the block index, the mempool or the address
+ *  manager and answer the requesting peer.  */
+static bool IsReadOnlyRequest(const std::string& strCommand)
+{
+    return strCommand == "getdata" ||
+        strCommand == "getheaders" ||
+        strCommand == "getblocks" ||
+        strCommand == "getblocktxn" ||
+        strCommand == "getaddr";
+}
+
 // requires LOCK(cs_vRecvMsg)
 bool ProcessReceivedMessages(CNode* pfrom)
 {
@@ -998,6 +1292,16 @@ bool ProcessReceivedMessages(CNode* pfrom)
     //  (x) data
     //
     bool fOk = true;
+    {
+        TRY_LOCK(cs_main, lockMain);
+        if (lockMain)
+        {
+            EraseExpiredOrphans();
+            RemoveResolvedUnverifiedHeaders(ChainstateManager::Reference()->ActiveChain());
+            ResolveQueuedOrphanTransactions(GetTransactionMemoryPool());
+        }
+    }
+
     std::deque<CNetMessage>& receivedMessageQueue = pfrom->GetReceivedMessageQueue();
     std::deque<CNetMessage>::iterator iteratorToCurrentMessageToProcess = receivedMessageQueue.begin();
     std::deque<CNetMessage>::iterator iteratorToNextMessageToProcess = receivedMessageQueue.begin();
@@ -1027,7 +1331,12 @@ bool ProcessReceivedMessages(CNode* pfrom)
         bool fRet = false;
         try {
             CTxMemPool& mempool = GetTransactionMemoryPool();
-            fRet = ProcessMessage(mempool, cs_main, pfrom, strCommand, msg.vRecv, msg.nTime);
+            if (IsReadOnlyRequest(strCommand)) {
+                fRet = ProcessMessage(mempool, cs_main, pfrom, strCommand, msg.vRecv, msg.nTime);
+            } else {
+                LOCK(cs_serialMessageProcessing);
+                fRet = ProcessMessage(mempool, cs_main, pfrom, strCommand, msg.vRecv, msg.nTime);
+            }
             boost::this_thread::interruption_point();
         } catch (std::ios_base::failure& e) {
             pfrom->PushMessage("reject", strCommand, REJECT_MALFORMED, string("error parsing message"));
@@ -1116,10 +1425,41 @@ static void BeginSyncingWithPeer(CNode* pto)
         // Only actively request headers from a single peer, unless we're close to end of initial download.
         if ( !CNodeState::NodeSyncStarted() || GetBestHeaderBlocktime() > GetAdjustedTime() - 6 * 60 * 60) { // NOTE: was "close to today" and 24h in Bitcoin
             state->RecordNodeStartedToSync();
-            pto->PushMessage("getblocks", chain.GetLocator(chain.Tip()), uint256(0));
+            if (Params().HeadersFirstSyncingActive() && pto->GetVersion() >= HEADERS_FIRST_SYNC_VERSION) {
+                // Blocks are then fetched from every peer known to have them, see CollectBlockDataToRequest
+                const CBlockIndex* pindexStart = GetBestHeaderBlockIndex();
+                if (pindexStart == nullptr)
+                    pindexStart = chain.Tip();
+                else if (pindexStart->pprev)
+                    pindexStart = pindexStart->pprev;
+                pto->PushMessage("getheaders", chain.GetLocator(pindexStart), uint256(0));
+                LOCK(cs_main);
+                state->fHeadersRequested = true;
+            } else {
+                pto->PushMessage("getblocks", chain.GetLocator(chain.Tip()), uint256(0));
+            }
         }
     }
 }
+/** Asks a peer whose headers sync was paused for the next headers, once there
+ *  is room for them ahead of the active tip. Requires cs_main. */
+static void ResumePausedHeadersSync(CNode* pto)
+{
+    CNodeState* state = pto->GetNodeState();
+    if (!state->fHeadersSyncPaused || state->fHeadersRequested || state->pindexBestKnownBlock == nullptr)
+        return;
+
+    const ChainstateManager::Reference chainstate;
+    const auto& chain = chainstate->ActiveChain();
+    RemoveResolvedUnverifiedHeaders(chain);
+    if (!CanAcceptUnverifiedHeader(pto->GetId(), state->pindexBestKnownBlock->nHeight + 1, chain))
+        return;
+
+    LogPrint("net", "resuming headers sync (%d) with peer=%d\n", state->pindexBestKnownBlock->nHeight, pto->id);
+    pto->PushMessage("getheaders", chain.GetLocator(state->pindexBestKnownBlock), uint256(0));
+    state->fHeadersSyncPaused = false;
+    state->fHeadersRequested = true;
+}
 static void SendInventoryToPeer(CNode* pto, bool fSendTrickle)
 {
     std::vector<CInv> vInv;
@@ -1232,19 +1572,11 @@ void RebroadcastSomeMempoolTxs(CCriticalSection& mainCriticalSection, CTxMemPool
         {
             LogPrintf("Rebroadcasting mempool transactions\n");
             int numberOfTransactionsCollected = 0;
-            const  std::map<uint256, CTxMemPoolEntry>& mempoolTxs = mempool.mapTx;
-            for(const auto& mempoolEntryByHash: mempoolTxs)
+            // Oldest first, so that transactions stuck the longest get another chance
+            for(const CTxMemPoolEntry& mempoolEntry: mempool.mapTx.get<entry_time>())
             {
-                const CTransaction& tx = mempoolEntryByHash.second.GetTx();
-                bool spendsOtherMempoolTransaction = false;
-                for(const auto& input: tx.vin)
-                {
-                    if(mempoolTxs.count(input.prevout.hash)>0)
-                    {
-                        spendsOtherMempoolTransaction = true;
-                        break;
-                    }
-                }
+                const CTransaction& tx = mempoolEntry.GetTx();
+                const bool spendsOtherMempoolTransaction = mempoolEntry.GetCountWithAncestors() > 1;
                 if(!spendsOtherMempoolTransaction)
                 {
                     RelayTransactionToAllPeers(tx);
@@ -1275,6 +1607,7 @@ void PeriodicallyRebroadcastMempoolTxs(CCriticalSection& mainCriticalSection, CT
 bool SendMessages(CNode* pto, bool fSendTrickle)
 {
     {
+        LOCK(cs_serialMessageProcessing);
         if (fSendTrickle) {
             SendAddresses(pto);
         }
@@ -1296,6 +1629,7 @@ bool SendMessages(CNode* pto, bool fSendTrickle)
         {
             LOCK(cs_main);
             RequestDisconnectionFromNodeIfStalling(nNow,pto);
+            if(fFetch) ResumePausedHeadersSync(pto);
             if(fFetch) CollectBlockDataToRequest(nNow,pto,vGetData);
         }
         CollectNonBlockDataToRequestAndRequestIt(mempool, pto,nNow,vGetData);
@@ -45,11 +45,15 @@
 #include <NodeState.h>
 #include <SocketChannel.h>
 #include <ChainSyncHelpers.h>
+#include <defaultValues.h>
 
 #ifdef WIN32
 #include <string.h>
 #else
 #include <fcntl.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #endif
 
 #ifdef USE_UPNP
@@ -66,6 +70,12 @@ bool OpenNetworkConnection(const CAddress& addrConnect, const char* strDest = NU
 
 /** -listen default */
 constexpr bool DEFAULT_LISTEN = true;
+/** -socketevents default */
+#ifdef HAVE_SYS_EPOLL_H
+constexpr char DEFAULT_SOCKET_EVENTS[] = "epoll";
+#else
+constexpr char DEFAULT_SOCKET_EVENTS[] = "select";
+#endif
 /** -upnp default */
 #ifdef USE_UPNP
 constexpr bool DEFAULT_UPNP = USE_UPNP;
@@ -115,6 +125,15 @@ struct ListenSocket {
 };
 }
 
+static bool UseEpollSocketEvents()
+{
+#ifdef HAVE_SYS_EPOLL_H
+    return settings.GetArg("-socketevents", DEFAULT_SOCKET_EVENTS) == "epoll";
+#else
+    return false;
+#endif
+}
+
 //
 // Global state variables
 //
@@ -485,7 +504,7 @@ NodeRef ConnectNode(CAddress addrConnect, const char* pszDest = NULL, const bool
     bool proxyConnectionFailed = false;
     if (pszDest ? ConnectSocketByName(addrConnect, hSocket, pszDest, Params().GetDefaultPort(), getConnectionTimeoutDuration(), &proxyConnectionFailed) :
                   ConnectSocket(addrConnect, hSocket, getConnectionTimeoutDuration(), &proxyConnectionFailed)) {
-        if (!IsSelectableSocket(hSocket)) {
+        if (!UseEpollSocketEvents() && !IsSelectableSocket(hSocket)) {
             LogPrintf("Cannot create connection: non-selectable socket created (fd >= FD_SETSIZE ?)\n");
             CloseSocket(hSocket);
             return NodeReferenceFactory::makeUniqueNodeReference(nullptr);
@@ -563,6 +582,49 @@ public:
     }
 };
 
+void AcceptConnection(
+    const ListenSocket& hListenSocket,
+    CCriticalSection& nodesLock,
+    std::vector<CNode*>& nodes,
+    bool requireSelectableSocket)
+{
+    struct sockaddr_storage sockaddr;
+    socklen_t len = sizeof(sockaddr);
+    SOCKET hSocket = accept(hListenSocket.socket, (struct sockaddr*)&sockaddr, &len);
+    CAddress addr;
+    int nInbound = 0;
+
+    if (hSocket != INVALID_SOCKET)
+        if (!addr.SetSockAddr((const struct sockaddr*)&sockaddr))
+            LogPrintf("Warning: Unknown socket family\n");
+
+    bool whitelisted = hListenSocket.whitelisted || IsWhitelistedRange(addr);
+    {
+        LOCK(nodesLock);
+        BOOST_FOREACH (CNode* pnode, nodes)
+            if (pnode->fInbound)
+                nInbound++;
+    }
+
+    if (hSocket == INVALID_SOCKET) {
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEWOULDBLOCK)
+            LogPrintf("socket error accept failed: %s\n", NetworkErrorString(nErr));
+    } else if (requireSelectableSocket && !IsSelectableSocket(hSocket)) {
+        LogPrintf("connection from %s dropped: non-selectable socket\n", addr);
+        CloseSocket(hSocket);
+    } else if (nInbound >= nMaxConnections - MAX_OUTBOUND_CONNECTIONS) {
+        LogPrint("net", "connection from %s dropped (full)\n", addr);
+        CloseSocket(hSocket);
+    } else if (PeerBanningService::IsBanned(GetTime(),addr) && !whitelisted) {
+        LogPrintf("connection from %s dropped (banned)\n", addr);
+        CloseSocket(hSocket);
+    } else {
+        ConnectionFlagBitmask flags = NodeConnectionFlags::INBOUND_CONN | (whitelisted? NodeConnectionFlags::WHITELISTED : NodeConnectionFlags::DEFAULT);
+        CreateNode(hSocket,&GetNodeSignals(),GetNetworkAddressManager(), addr, "", flags);
+    }
+}
+
 class SocketsProcessor final: public I_CommunicationRegistrar<SOCKET>
 {
 private:
@@ -687,43 +749,7 @@ public:
         for(const ListenSocket& hListenSocket: listeningSockets_)
         {
             if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
-            {
-                struct sockaddr_storage sockaddr;
-                socklen_t len = sizeof(sockaddr);
-                SOCKET hSocket = accept(hListenSocket.socket, (struct sockaddr*)&sockaddr, &len);
-                CAddress addr;
-                int nInbound = 0;
-
-                if (hSocket != INVALID_SOCKET)
-                    if (!addr.SetSockAddr((const struct sockaddr*)&sockaddr))
-                        LogPrintf("Warning: Unknown socket family\n");
-
-                bool whitelisted = hListenSocket.whitelisted || IsWhitelistedRange(addr);
-                {
-                    LOCK(nodesLock);
-                    BOOST_FOREACH (CNode* pnode, nodes)
-                        if (pnode->fInbound)
-                            nInbound++;
-                }
-
-                if (hSocket == INVALID_SOCKET) {
-                    int nErr = WSAGetLastError();
-                    if (nErr != WSAEWOULDBLOCK)
-                        LogPrintf("socket error accept failed: %s\n", NetworkErrorString(nErr));
-                } else if (!IsSelectableSocket(hSocket)) {
-                    LogPrintf("connection from %s dropped: non-selectable socket\n", addr);
-                    CloseSocket(hSocket);
-                } else if (nInbound >= nMaxConnections - MAX_OUTBOUND_CONNECTIONS) {
-                    LogPrint("net", "connection from %s dropped (full)\n", addr);
-                    CloseSocket(hSocket);
-                } else if (PeerBanningService::IsBanned(GetTime(),addr) && !whitelisted) {
-                    LogPrintf("connection from %s dropped (banned)\n", addr);
-                    CloseSocket(hSocket);
-                } else {
-                    ConnectionFlagBitmask flags = NodeConnectionFlags::INBOUND_CONN | (whitelisted? NodeConnectionFlags::WHITELISTED : NodeConnectionFlags::DEFAULT);
-                    CreateNode(hSocket,&GetNodeSignals(),GetNetworkAddressManager(), addr, "", flags);
-                }
-            }
+                AcceptConnection(hListenSocket, nodesLock, nodes, true);
         }
     }
 
@@ -748,20 +774,274 @@ public:
     }
 };
 
+#ifdef HAVE_SYS_EPOLL_H
+/** Waits for socket readiness with edge-triggered epoll, so that the work done
+ *  per wakeup depends on the number of ready sockets rather than of peers, and
+ *  sockets are not limited to FD_SETSIZE.
+ *  Readiness is only reported when it changes, so it is remembered per node
+ *  until the socket has been drained or written to until it would block.
+ *  Write readiness is only asked for while a node has data queued, and a
+ *  socket that took all data last time is written to again without waiting
+ *  for an event.  */
+class EpollSocketsProcessor
+{
+private:
+    static constexpr uint64_t LISTENING_SOCKET_TAG = uint64_t(1) << 63;
+    static constexpr int MAX_EVENTS_PER_WAIT = 256;
+    static constexpr int WAIT_TIMEOUT_MILLIS = 50; // frequency to poll pnode->vSend
+
+    struct RegisteredNode
+    {
+        CNode* node;
+        SOCKET socket;
+        bool writeInterest;
+        bool readable;
+        bool writable;
+        bool sendWouldBlock;
+        uint64_t generation;
+    };
+
+    const int epollFd_;
+    std::vector<ListenSocket>& listeningSockets_;
+    // Nodes are only deleted by the socket handler thread, before they are synchronized
+    std::map<NodeId, RegisteredNode> registeredNodes_;
+    std::vector<NodeId> readyNodeIds_;
+    std::vector<size_t> readyListeningSockets_;
+    uint64_t generation_;
+    int64_t nextInactivityCheck_;
+
+    bool UpdateRegistration(int operation, SOCKET socket, NodeId id, bool writeInterest) const
+    {
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLET | (writeInterest ? EPOLLOUT : 0u);
+        event.data.u64 = static_cast<uint64_t>(id);
+        return epoll_ctl(epollFd_, operation, socket, &event) == 0;
+    }
+    void MarkReady(NodeId id, RegisteredNode& registration, bool readable, bool writable)
+    {
+        const bool wasReady = registration.readable || registration.writable;
+        registration.readable |= readable;
+        registration.writable |= writable;
+        if (!wasReady && (registration.readable || registration.writable))
+            readyNodeIds_.push_back(id);
+    }
+
+public:
+    explicit EpollSocketsProcessor(
+        std::vector<ListenSocket>& listeningSockets
+        ): epollFd_(epoll_create1(EPOLL_CLOEXEC))
+        , listeningSockets_(listeningSockets)
+        , registeredNodes_()
+        , readyNodeIds_()
+        , readyListeningSockets_()
+        , generation_(0)
+        , nextInactivityCheck_(0)
+    {
+    }
+    ~EpollSocketsProcessor()
+    {
+        if (epollFd_ >= 0)
+            close(epollFd_);
+    }
+
+    bool IsValid() const
+    {
+        return epollFd_ >= 0;
+    }
+
+    void RegisterListeningSockets()
+    {
+        for (size_t index = 0; index < listeningSockets_.size(); ++index)
+        {
+            if (listeningSockets_[index].socket == INVALID_SOCKET)
+                continue;
+            // Level-triggered, pending connections are accepted one per wakeup as with select()
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.u64 = LISTENING_SOCKET_TAG | index;
+            if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, listeningSockets_[index].socket, &event) != 0)
+                LogPrintf("epoll: failed to register listening socket: %s\n", NetworkErrorString(errno));
+        }
+    }
+
+    // Registers new nodes and updates the write interest of known ones. Closing a
+    // socket removes it from the epoll set, so nodes that are gone are just forgotten.
+    void SynchronizeRegisteredNodes(CCriticalSection& nodesLock, std::vector<CNode*>& nodes)
+    {
+        const int64_t nNow = GetTime();
+        const bool checkInactivity = nNow >= nextInactivityCheck_;
+        if (checkInactivity)
+            nextInactivityCheck_ = nNow + 1;
+        ++generation_;
+
+        LOCK(nodesLock);
+        for (CNode* pnode: nodes)
+        {
+            if (!pnode->CommunicationChannelIsValid())
+                continue;
+            const NodeId id = pnode->GetId();
+            const bool writeInterest = pnode->HasQueuedSendData();
+            auto it = registeredNodes_.find(id);
+            if (it == registeredNodes_.end())
+            {
+                const SOCKET nodeSocket = NodeManager::Instance().getSocketByNodeId(id);
+                if (!UpdateRegistration(EPOLL_CTL_ADD, nodeSocket, id, writeInterest))
+                {
+                    LogPrintf("epoll: failed to register socket of peer=%d: %s\n", id, NetworkErrorString(errno));
+                    pnode->FlagForDisconnection();
+                    continue;
+                }
+                RegisteredNode registration = {pnode, nodeSocket, writeInterest, false, false, false, generation_};
+                it = registeredNodes_.insert(std::make_pair(id, registration)).first;
+                // Data may have arrived before the socket was registered
+                MarkReady(id, it->second, true, writeInterest);
+            }
+            else
+            {
+                RegisteredNode& registration = it->second;
+                registration.generation = generation_;
+                if (registration.writeInterest != writeInterest &&
+                    UpdateRegistration(EPOLL_CTL_MOD, registration.socket, id, writeInterest))
+                {
+                    registration.writeInterest = writeInterest;
+                }
+                // No event follows data queued after the socket took everything
+                if (writeInterest && !registration.sendWouldBlock)
+                    MarkReady(id, registration, false, true);
+            }
+            if (checkInactivity)
+                pnode->CheckForInnactivity();
+        }
+        for (auto it = registeredNodes_.begin(); it != registeredNodes_.end(); )
+        {
+            if (it->second.generation != generation_)
+                registeredNodes_.erase(it++);
+            else
+                ++it;
+        }
+    }
+
+    void WaitForEvents()
+    {
+        readyListeningSockets_.clear();
+        struct epoll_event events[MAX_EVENTS_PER_WAIT];
+        const int numberOfEvents = epoll_wait(epollFd_, events, MAX_EVENTS_PER_WAIT, WAIT_TIMEOUT_MILLIS);
+        if (numberOfEvents < 0)
+        {
+            if (errno != EINTR)
+            {
+                LogPrintf("socket epoll error %s\n", NetworkErrorString(errno));
+                MilliSleep(WAIT_TIMEOUT_MILLIS);
+            }
+            return;
+        }
+        for (int i = 0; i < numberOfEvents; ++i)
+        {
+            const uint64_t tag = events[i].data.u64;
+            if (tag & LISTENING_SOCKET_TAG)
+            {
+                readyListeningSockets_.push_back(static_cast<size_t>(tag & ~LISTENING_SOCKET_TAG));
+                continue;
+            }
+            const NodeId id = static_cast<NodeId>(tag);
+            auto it = registeredNodes_.find(id);
+            if (it == registeredNodes_.end())
+                continue;
+            // Errors and hang-ups are picked up by the next read
+            const bool readable = events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR);
+            const bool writable = events[i].events & EPOLLOUT;
+            if (writable)
+                it->second.sendWouldBlock = false;
+            MarkReady(id, it->second, readable, writable);
+        }
+    }
+
+    void AcceptNewConnections(CCriticalSection& nodesLock, std::vector<CNode*>& nodes)
+    {
+        for (const size_t index: readyListeningSockets_)
+        {
+            if (index < listeningSockets_.size())
+                AcceptConnection(listeningSockets_[index], nodesLock, nodes, false);
+        }
+    }
+
+    // Nodes whose buffers were busy or full stay ready for the next round
+    void ServiceReadyNodes(boost::condition_variable& messageHandlerCondition)
+    {
+        std::vector<NodeId> stillReadyNodeIds;
+        for (const NodeId id: readyNodeIds_)
+        {
+            boost::this_thread::interruption_point();
+            auto it = registeredNodes_.find(id);
+            if (it == registeredNodes_.end())
+                continue;
+            RegisteredNode& registration = it->second;
+            CNode* pnode = registration.node;
+            if (!pnode->CommunicationChannelIsValid())
+            {
+                registration.readable = false;
+                registration.writable = false;
+                continue;
+            }
+            if (registration.writable && pnode->SendQueuedData(registration.sendWouldBlock))
+                registration.writable = false;
+            if (registration.readable && pnode->ReceiveAvailableData(messageHandlerCondition))
+                registration.readable = false;
+            if (registration.readable || registration.writable)
+                stillReadyNodeIds.push_back(id);
+        }
+        readyNodeIds_.swap(stillReadyNodeIds);
+    }
+};
+#endif // HAVE_SYS_EPOLL_H
+
+static void DisconnectNodesAndNotify(unsigned int& nPrevNodeCount)
+{
+    NodeManager::Instance().disconnectUnusedNodes();
+    NodeManager::Instance().deleteDisconnectedNodes();
+    size_t vNodesSize = GetPeerCount();
+    if(vNodesSize != nPrevNodeCount) {
+        nPrevNodeCount = vNodesSize;
+        uiInterface.NotifyNumConnectionsChanged(nPrevNodeCount);
+    }
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+static void ThreadEpollSocketHandler(EpollSocketsProcessor& socketsProcessor)
+{
+    unsigned int nPrevNodeCount = 0;
+    socketsProcessor.RegisterListeningSockets();
+    while (true) {
+        DisconnectNodesAndNotify(nPrevNodeCount);
+
+        socketsProcessor.SynchronizeRegisteredNodes(cs_vNodes,vNodes);
+        socketsProcessor.WaitForEvents();
+        boost::this_thread::interruption_point();
+        socketsProcessor.AcceptNewConnections(cs_vNodes,vNodes);
+        socketsProcessor.ServiceReadyNodes(messageHandlerCondition);
+    }
+}
+#endif // HAVE_SYS_EPOLL_H
+
 void ThreadSocketHandler()
 {
+#ifdef HAVE_SYS_EPOLL_H
+    if (UseEpollSocketEvents()) {
+        EpollSocketsProcessor epollSocketsProcessor(NodeManager::Instance().listeningSockets());
+        if (epollSocketsProcessor.IsValid()) {
+            LogPrintf("Using epoll for socket events\n");
+            ThreadEpollSocketHandler(epollSocketsProcessor);
+            return;
+        }
+        LogPrintf("epoll is not available (%s), using select for socket events\n", NetworkErrorString(errno));
+    }
+#endif
     unsigned int nPrevNodeCount = 0;
     while (true) {
         //
         // Disconnect nodes
         //
-        NodeManager::Instance().disconnectUnusedNodes();
-        NodeManager::Instance().deleteDisconnectedNodes();
-        size_t vNodesSize = GetPeerCount();
-        if(vNodesSize != nPrevNodeCount) {
-            nPrevNodeCount = vNodesSize;
-            uiInterface.NotifyNumConnectionsChanged(nPrevNodeCount);
-        }
+        DisconnectNodesAndNotify(nPrevNodeCount);
 
         SocketsProcessor socketsProcessor(NodeManager::Instance().listeningSockets());
         socketsProcessor.ProcessListeningSockets();
@@ -797,10 +1077,18 @@ struct MessageHandlerDependencies
     const Settings& settings_;
     CCriticalSection& mainCriticalSection_;
 };
-void ThreadMessageHandler(MessageHandlerDependencies& dependencies)
+struct MessageHandlerWorker
 {
-    boost::mutex condition_mutex;
-    boost::unique_lock<boost::mutex> lock(condition_mutex);
+    MessageHandlerDependencies& dependencies_;
+    const unsigned workerIndex_;
+    const unsigned numberOfWorkers_;
+};
+static boost::mutex messageHandlerConditionMutex;
+void ThreadMessageHandler(MessageHandlerWorker& worker)
+{
+    MessageHandlerDependencies& dependencies = worker.dependencies_;
+    // The address rebroadcast and the trickle peer selection are done once per round, by the first worker
+    const bool handlesPeriodicTasks = worker.workerIndex_ == 0;
 
     /* We periodically rebroadcast our address.  This is the last time
        we did a broadcast.  */
@@ -811,17 +1099,25 @@ void ThreadMessageHandler(MessageHandlerDependencies& dependencies)
         ThreadSafeNodesCopy safeNodesCopy(cs_vNodes,vNodes);
         const std::vector<NodeRef>& vNodesCopy = safeNodesCopy.Nodes();
 
-        bool rebroadcast = (!IsInitialBlockDownload(dependencies.mainCriticalSection_,dependencies.settings_) && (GetTime() > nLastRebroadcast + 24 * 60 * 60));
+        bool rebroadcast = handlesPeriodicTasks && (!IsInitialBlockDownload(dependencies.mainCriticalSection_,dependencies.settings_) && (GetTime() > nLastRebroadcast + 24 * 60 * 60));
 
         // Poll the connected nodes for messages
-        CNode* pnodeTrickle = vNodesCopy.empty()? nullptr: vNodesCopy[GetRand(vNodesCopy.size())].get();
+        CNode* pnodeTrickle = (!handlesPeriodicTasks || vNodesCopy.empty())? nullptr: vNodesCopy[GetRand(vNodesCopy.size())].get();
         bool fSleep = true;
 
-        for(const NodeRef& pnode: vNodesCopy)
+        // Workers start at different peers, so that they do not all contend for the same ones
+        const size_t firstNode = vNodesCopy.size() * worker.workerIndex_ / worker.numberOfWorkers_;
+        for(size_t nodeOffset = 0; nodeOffset < vNodesCopy.size(); ++nodeOffset)
         {
+            const NodeRef& pnode = vNodesCopy[(firstNode + nodeOffset) % vNodesCopy.size()];
             if (pnode->IsFlaggedForDisconnection())
                 continue;
 
+            // A peer is handled by one worker at a time, which keeps its messages in order
+            TRY_LOCK(pnode->GetMessageProcessingLock(), lockProcessing);
+            if (!lockProcessing)
+                continue;
+
             // Receive messages
             pnode->ProcessReceiveMessages(fSleep);
             boost::this_thread::interruption_point();
@@ -859,7 +1155,10 @@ void ThreadMessageHandler(MessageHandlerDependencies& dependencies)
         safeNodesCopy.ClearCopy();
 
         if (fSleep)
+        {
+            boost::unique_lock<boost::mutex> lock(messageHandlerConditionMutex);
             messageHandlerCondition.timed_wait(lock, boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(100));
+        }
     }
 }
 
@@ -1423,8 +1722,16 @@ void StartNode(const Settings& settings, CCriticalSection& mainCriticalSection,
 
     // Process messages
     static MessageHandlerDependencies messageDependencies{settings,mainCriticalSection};
-    threadGroup.create_thread(
-        boost::bind(&TraceThread<void (*)(MessageHandlerDependencies&), MessageHandlerDependencies&>, "msghand", &ThreadMessageHandler, messageDependencies) );
+    static std::vector<std::unique_ptr<MessageHandlerWorker>> messageHandlerWorkers;
+    const unsigned numberOfMessageHandlers = static_cast<unsigned>(
+        std::max<int64_t>(1, std::min<int64_t>(settings.GetArg("-msghandlerthreads", DEFAULT_MESSAGE_HANDLER_THREADS), MAX_MESSAGE_HANDLER_THREADS)));
+    LogPrintf("Using %u message handler threads\n", numberOfMessageHandlers);
+    for (unsigned workerIndex = 0; workerIndex < numberOfMessageHandlers; ++workerIndex)
+    {
+        messageHandlerWorkers.emplace_back(new MessageHandlerWorker{messageDependencies, workerIndex, numberOfMessageHandlers});
+        threadGroup.create_thread(
+            boost::bind(&TraceThread<void (*)(MessageHandlerWorker&), MessageHandlerWorker&>, "msghand", &ThreadMessageHandler, boost::ref(*messageHandlerWorkers.back())) );
+    }
 
     // Dump network addresses
     threadGroup.create_thread(boost::bind(&LoopForever<void (*)()>, "dumpaddr", &DumpAddresses, DUMP_ADDRESSES_INTERVAL * 1000));
@@ -1672,7 +1979,10 @@ void SetNetworkingParameters()
     const int reservedFileDescriptors = MIN_CORE_FILEDESCRIPTORS;
     int nBind = std::max((int)settings.ParameterIsSet("-bind") + (int)settings.ParameterIsSet("-whitebind"), 1);
     nMaxConnections = settings.GetArg("-maxconnections", 125);
-    nMaxConnections = std::max(std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - reservedFileDescriptors)), 0);
+    if (UseEpollSocketEvents())
+        nMaxConnections = std::max(nMaxConnections, 0);
+    else
+        nMaxConnections = std::max(std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - reservedFileDescriptors)), 0);
 }
 
 bool InitializeP2PNetwork(UIMessenger& uiMessenger)
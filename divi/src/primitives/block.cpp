@@ -11,7 +11,46 @@
 #include "utilstrencodings.h"
 #include "Logging.h"
 
-uint256 CBlockHeader::GetHash() const
+#include <assert.h>
+#include <string.h>
+
+struct CBlockHeader::CachedHash
+{
+    //! nVersion through nAccumulatorCheckpoint, as laid out in memory
+    unsigned char header[4 + 32 + 32 + 4 + 4 + 4 + 32];
+    uint256 hash;
+};
+
+CBlockHeader::CBlockHeader(
+    const CBlockHeader& other
+    ): nVersion(other.nVersion)
+    , hashPrevBlock(other.hashPrevBlock)
+    , hashMerkleRoot(other.hashMerkleRoot)
+    , nTime(other.nTime)
+    , nBits(other.nBits)
+    , nNonce(other.nNonce)
+    , nAccumulatorCheckpoint(other.nAccumulatorCheckpoint)
+    , cachedHash(std::atomic_load(&other.cachedHash))
+{
+}
+
+CBlockHeader& CBlockHeader::operator=(const CBlockHeader& other)
+{
+    if (this == &other)
+        return *this;
+
+    nVersion = other.nVersion;
+    hashPrevBlock = other.hashPrevBlock;
+    hashMerkleRoot = other.hashMerkleRoot;
+    nTime = other.nTime;
+    nBits = other.nBits;
+    nNonce = other.nNonce;
+    nAccumulatorCheckpoint = other.nAccumulatorCheckpoint;
+    std::atomic_store(&cachedHash, std::atomic_load(&other.cachedHash));
+    return *this;
+}
+
+uint256 CBlockHeader::ComputeHash() const
 {
     if(nVersion < 4)
         return HashQuark(BEGIN(nVersion), END(nNonce));
@@ -19,6 +58,23 @@ uint256 CBlockHeader::GetHash() const
     return Hash(BEGIN(nVersion), END(nAccumulatorCheckpoint));
 }
 
+uint256 CBlockHeader::GetHash() const
+{
+    const unsigned char* headerBegin = (const unsigned char*)BEGIN(nVersion);
+    const size_t headerSize = (const unsigned char*)END(nAccumulatorCheckpoint) - headerBegin;
+
+    std::shared_ptr<const CachedHash> cached = std::atomic_load(&cachedHash);
+    if (cached && memcmp(cached->header, headerBegin, headerSize) == 0)
+        return cached->hash;
+
+    std::shared_ptr<CachedHash> updated = std::make_shared<CachedHash>();
+    assert(headerSize == sizeof(updated->header));
+    memcpy(updated->header, headerBegin, headerSize);
+    updated->hash = ComputeHash();
+    std::atomic_store(&cachedHash, std::shared_ptr<const CachedHash>(updated));
+    return updated->hash;
+}
+
 uint256 CBlock::BuildMerkleTree(bool* fMutated) const
 {
     /* WARNING! If you're reading this because you're learning about crypto
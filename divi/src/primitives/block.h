@@ -12,6 +12,8 @@
 #include "uint256.h"
 #include "defaultValues.h"
 
+#include <memory>
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -32,11 +34,28 @@ public:
     uint32_t nNonce;
     uint256 nAccumulatorCheckpoint;
 
+private:
+    struct CachedHash;
+
+    /** Memory only: the last computed hash together with the header fields it
+     *  was computed from. GetHash compares the fields before using it, so plain
+     *  assignments to the public members invalidate it. Shared immutably so that
+     *  concurrent GetHash calls on the same header stay race free. */
+    mutable std::shared_ptr<const CachedHash> cachedHash;
+
+    uint256 ComputeHash() const;
+
+public:
     CBlockHeader()
     {
         SetNull();
     }
 
+    /** Copies share the memoized hash, read and written atomically since
+     *  the source may be hashed concurrently. */
+    CBlockHeader(const CBlockHeader& other);
+    CBlockHeader& operator=(const CBlockHeader& other);
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
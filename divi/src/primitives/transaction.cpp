@@ -146,9 +146,42 @@ bool operator!=(const CTransaction& a, const CTransaction& b)
     return a.hash != b.hash;
 }
 
+namespace
+{
+
+/** Hashes the transaction as if all its scriptSigs were empty, without
+ *  copying it first.  Works for both CTransaction and CMutableTransaction.  */
+template <typename Transaction>
+uint256 ComputeBareTxid(const Transaction& tx, const uint256& txid)
+{
+    if (tx.vin.size() == 1 && tx.vin[0].prevout.IsNull())
+    {
+        /* For coinbase transactions, the bare txid equals the normal one.
+           They don't contain a real signature anyway, but the scriptSig
+           is needed to distinguish them and make sure we won't have two
+           transactions with the same bare txid.
+
+           In practice on mainnet, this has no influence, since no more
+           coinbases are created after the fork activation (since the network
+           is on PoS for a long time).  We still need this here to make sure
+           all works fine in tests and is just correct in general.  */
+        return txid;
+    }
+
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << tx.nVersion;
+    WriteCompactSize(ss, tx.vin.size());
+    for (const CTxIn& in : tx.vin)
+        ss << in.prevout << CScript() << in.nSequence;
+    ss << tx.vout << tx.nLockTime;
+    return ss.GetHash();
+}
+
+} // anonymous namespace
+
 uint256 CMutableTransaction::GetBareTxid() const
 {
-    return CTransaction(*this).GetBareTxid();
+    return ComputeBareTxid(*this, GetHash());
 }
 
 bool operator==(const CMutableTransaction& a, const CMutableTransaction& b)
@@ -203,31 +236,15 @@ CAmount CMutableTransaction::GetValueOut() const
 void CTransaction::UpdateHash() const
 {
     *const_cast<uint256*>(&hash) = SerializeHash(*this);
+    *const_cast<uint256*>(&bareTxid) = ComputeBareTxid(*this, hash);
 }
 
-uint256 CTransaction::GetBareTxid () const
+const uint256& CTransaction::GetBareTxid () const
 {
-    if (IsCoinBase())
-    {
-        /* For coinbase transactions, the bare txid equals the normal one.
-           They don't contain a real signature anyway, but the scriptSig
-           is needed to distinguish them and make sure we won't have two
-           transactions with the same bare txid.
-
-           In practice on mainnet, this has no influence, since no more
-           coinbases are created after the fork activation (since the network
-           is on PoS for a long time).  We still need this here to make sure
-           all works fine in tests and is just correct in general.  */
-        return GetHash();
-    }
-
-    CMutableTransaction withoutSigs(*this);
-    for (auto& in : withoutSigs.vin)
-        in.scriptSig.clear();
-    return withoutSigs.GetHash();
+    return bareTxid;
 }
 
-CTransaction::CTransaction() : hash(), nVersion(CTransaction::CURRENT_VERSION), vin(), vout(), nLockTime(0) { }
+CTransaction::CTransaction() : hash(), bareTxid(), nVersion(CTransaction::CURRENT_VERSION), vin(), vout(), nLockTime(0) { }
 
 CTransaction::CTransaction(const CMutableTransaction &tx) : nVersion(tx.nVersion), vin(tx.vin), vout(tx.vout), nLockTime(tx.nLockTime) {
     UpdateHash();
@@ -239,6 +256,7 @@ CTransaction& CTransaction::operator=(const CTransaction &tx) {
     *const_cast<std::vector<CTxOut>*>(&vout) = tx.vout;
     *const_cast<unsigned int*>(&nLockTime) = tx.nLockTime;
     *const_cast<uint256*>(&hash) = tx.hash;
+    *const_cast<uint256*>(&bareTxid) = tx.bareTxid;
     return *this;
 }
 
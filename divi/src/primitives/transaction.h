@@ -86,6 +86,8 @@ class CTransaction
 private:
     /** Memory only. */
     const uint256 hash;
+    /** Memory only; the txid with all scriptSigs blanked out. */
+    const uint256 bareTxid;
     void UpdateHash() const;
 
 public:
@@ -125,7 +127,7 @@ public:
 
     bool IsNull() const;
     const uint256& GetHash() const;
-    uint256 GetBareTxid () const;
+    const uint256& GetBareTxid () const;
     CAmount GetValueOut() const;
     bool IsCoinBase() const;
 
@@ -29,7 +29,8 @@ inventoryTypeByName = {
     {"tx",MSG_TX},
     {"block",MSG_BLOCK},
     {"filtered block",MSG_FILTERED_BLOCK},
-    {"spork",MSG_SPORK}};
+    {"spork",MSG_SPORK},
+    {"compact block",MSG_CMPCT_BLOCK}};
 static const std::map<int,std::string> inventoryNameByType = ReverseMap(inventoryTypeByName);
 
 static const int maxInventoryId = (int)inventoryTypeByName.size();
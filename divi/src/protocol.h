@@ -130,7 +130,9 @@ enum InventoryType {
     // Nodes may always request a MSG_FILTERED_BLOCK in a getdata, however,
     // MSG_FILTERED_BLOCK should not appear in any invs except as a part of getdata.
     MSG_FILTERED_BLOCK,
-    MSG_SPORK
+    MSG_SPORK,
+    // Only requested in getdata, from peers at COMPACT_BLOCKS_VERSION or later
+    MSG_CMPCT_BLOCK
 };
 class CInv
 {
@@ -27,9 +27,13 @@
 #include <spork.h>
 #include <I_ChainExtensionService.h>
 #include <ChainSyncHelpers.h>
+#include <script/sigcache.h>
+#include <Settings.h>
+#include <defaultValues.h>
 
 using namespace json_spirit;
 using namespace std;
+extern Settings& settings;
 
 Value getblockcount(const Array& params, bool fHelp, CWallet* pwallet)
 {
@@ -99,6 +103,12 @@ Value getrawmempool(const Array& params, bool fHelp, CWallet* pwallet)
             "    \"height\" : n,           (numeric) block height when transaction entered pool\n"
             "    \"startingpriority\" : n, (numeric) priority when transaction entered pool\n"
             "    \"currentpriority\" : n,  (numeric) transaction priority now\n"
+            "    \"descendantcount\" : n,  (numeric) number of in-mempool descendant transactions (including this one)\n"
+            "    \"descendantsize\" : n,   (numeric) size of in-mempool descendants (including this one)\n"
+            "    \"descendantfees\" : n,   (numeric) modified fees of in-mempool descendants (including this one)\n"
+            "    \"ancestorcount\" : n,    (numeric) number of in-mempool ancestor transactions (including this one)\n"
+            "    \"ancestorsize\" : n,     (numeric) size of in-mempool ancestors (including this one)\n"
+            "    \"ancestorfees\" : n,     (numeric) modified fees of in-mempool ancestors (including this one)\n"
             "    \"depends\" : [           (array) unconfirmed transactions used as inputs for this transaction\n"
             "        \"transactionid\",    (string) parent transaction id\n"
             "       ... ]\n"
@@ -116,9 +126,9 @@ Value getrawmempool(const Array& params, bool fHelp, CWallet* pwallet)
         const ChainstateManager::Reference chainstate;
         LOCK(mempool.cs);
         Object o;
-        BOOST_FOREACH (const PAIRTYPE(uint256, CTxMemPoolEntry) & entry, mempool.mapTx) {
-            const uint256& hash = entry.first;
-            const CTxMemPoolEntry& e = entry.second;
+        for (CTxMemPool::txiter it = mempool.mapTx.begin(); it != mempool.mapTx.end(); ++it) {
+            const CTxMemPoolEntry& e = *it;
+            const uint256& hash = e.GetTx().GetHash();
             Object info;
             info.push_back(Pair("size", (int)e.GetTxSize()));
             info.push_back(Pair("fee", ValueFromAmount(e.GetFee())));
@@ -126,13 +136,15 @@ Value getrawmempool(const Array& params, bool fHelp, CWallet* pwallet)
             info.push_back(Pair("height", (int)e.GetHeight()));
             info.push_back(Pair("startingpriority", e.ComputeInputCoinAgePerByte(e.GetHeight())));
             info.push_back(Pair("currentpriority", e.ComputeInputCoinAgePerByte(chainstate->ActiveChain().Height())));
-            const CTransaction& tx = e.GetTx();
+            info.push_back(Pair("descendantcount", e.GetCountWithDescendants()));
+            info.push_back(Pair("descendantsize", e.GetSizeWithDescendants()));
+            info.push_back(Pair("descendantfees", e.GetModFeesWithDescendants()));
+            info.push_back(Pair("ancestorcount", e.GetCountWithAncestors()));
+            info.push_back(Pair("ancestorsize", e.GetSizeWithAncestors()));
+            info.push_back(Pair("ancestorfees", e.GetModFeesWithAncestors()));
             set<string> setDepends;
-            for (const CTxIn& txin : tx.vin) {
-                CTransaction dummyResult;
-                if (mempool.lookupOutpoint(txin.prevout.hash, dummyResult))
-                    setDepends.insert(txin.prevout.hash.ToString());
-            }
+            for (const CTxMemPool::txiter& parent : mempool.GetMemPoolParents(it))
+                setDepends.insert(parent->GetTx().GetHash().ToString());
             Array depends(setDepends.begin(), setDepends.end());
             info.push_back(Pair("depends", depends));
             o.push_back(Pair(hash.ToString(), info));
@@ -327,6 +339,67 @@ Value gettxoutsetinfo(const Array& params, bool fHelp, CWallet* pwallet)
     return ret;
 }
 
+Value getcoinscacheinfo(const Array& params, bool fHelp, CWallet* pwallet)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getcoinscacheinfo\n"
+            "\nReturns statistics about the in-memory cache of the unspent transaction output set.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"entries\": n,       (numeric) The number of cached transactions\n"
+            "  \"usage\": n,         (numeric) The dynamic memory used by the cache in bytes\n"
+            "  \"maxusage\": n,      (numeric) The memory budget derived from -dbcache in bytes\n"
+            "  \"hits\": n,          (numeric) The number of lookups served from the cache\n"
+            "  \"misses\": n         (numeric) The number of lookups forwarded to the database\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getcoinscacheinfo", "") + HelpExampleRpc("getcoinscacheinfo", ""));
+
+    const ChainstateManager::Reference chainstate;
+    const CCoinsViewCache& coinsTip = chainstate->CoinsTip();
+
+    Object ret;
+    ret.push_back(Pair("entries", (int64_t)coinsTip.GetCacheSize()));
+    ret.push_back(Pair("usage", (int64_t)coinsTip.DynamicMemoryUsage()));
+    ret.push_back(Pair("maxusage", (int64_t)chainstate->GetNominalViewCacheUsage()));
+    ret.push_back(Pair("hits", (int64_t)coinsTip.GetCacheHits()));
+    ret.push_back(Pair("misses", (int64_t)coinsTip.GetCacheMisses()));
+    return ret;
+}
+
+Value getsigcacheinfo(const Array& params, bool fHelp, CWallet* pwallet)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getsigcacheinfo\n"
+            "\nReturns statistics about the cache of verified signatures.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"capacity\": n,      (numeric) The number of entries the cache can hold\n"
+            "  \"bytes\": n,         (numeric) The memory allocated for the cache\n"
+            "  \"lookups\": n,       (numeric) The number of signature checks that consulted the cache\n"
+            "  \"hits\": n,          (numeric) The number of signature checks answered by the cache\n"
+            "  \"hitrate\": x.xxx,   (numeric) The fraction of lookups that were hits\n"
+            "  \"insertions\": n,    (numeric) The number of verified signatures added\n"
+            "  \"evictions\": n      (numeric) The number of entries overwritten by newer ones\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getsigcacheinfo", "") + HelpExampleRpc("getsigcacheinfo", ""));
+
+    const SignatureCacheStats stats = GetSignatureCacheStats();
+
+    Object ret;
+    ret.push_back(Pair("capacity", (int64_t)stats.capacity));
+    ret.push_back(Pair("bytes", (int64_t)stats.bytes));
+    ret.push_back(Pair("lookups", (int64_t)stats.lookups));
+    ret.push_back(Pair("hits", (int64_t)stats.hits));
+    ret.push_back(Pair("hitrate", stats.lookups > 0 ? (double)stats.hits / (double)stats.lookups : 0.0));
+    ret.push_back(Pair("insertions", (int64_t)stats.insertions));
+    ret.push_back(Pair("evictions", (int64_t)stats.evictions));
+    return ret;
+}
+
 Value gettxout(const Array& params, bool fHelp, CWallet* pwallet)
 {
     if (fHelp || params.size() < 2 || params.size() > 3)
@@ -562,6 +635,9 @@ Value getmempoolinfo(const Array& params, bool fHelp, CWallet* pwallet)
             "{\n"
             "  \"size\": xxxxx                (numeric) Current tx count\n"
             "  \"bytes\": xxxxx               (numeric) Sum of all tx sizes\n"
+            "  \"usage\": xxxxx               (numeric) Total memory usage for the mempool\n"
+            "  \"maxmempool\": xxxxx          (numeric) Maximum memory usage for the mempool\n"
+            "  \"mempoolminfee\": xxxxx       (numeric) Minimum fee rate in DIVI per kB for a transaction to be accepted\n"
             "}\n"
             "\nExamples:\n" +
             HelpExampleCli("getmempoolinfo", "") + HelpExampleRpc("getmempoolinfo", ""));
@@ -570,6 +646,10 @@ Value getmempoolinfo(const Array& params, bool fHelp, CWallet* pwallet)
     CTxMemPool& mempool = GetTransactionMemoryPool();
     ret.push_back(Pair("size", (int64_t)mempool.size()));
     ret.push_back(Pair("bytes", (int64_t)mempool.GetTotalTxSize()));
+    const size_t maxMempoolSize = settings.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+    ret.push_back(Pair("usage", (int64_t)mempool.DynamicMemoryUsage()));
+    ret.push_back(Pair("maxmempool", (int64_t)maxMempoolSize));
+    ret.push_back(Pair("mempoolminfee", ValueFromAmount(mempool.GetMinFee(maxMempoolSize).GetFeePerK())));
 
     return ret;
 }
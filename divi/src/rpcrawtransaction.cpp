@@ -12,6 +12,8 @@
 #include <ChainstateManager.h>
 #include "core_io.h"
 #include <FeeAndPriorityCalculator.h>
+#include <MempoolConsensus.h>
+#include <MemPoolEntry.h>
 #include "init.h"
 #include "keystore.h"
 #include "net.h"
@@ -24,6 +26,7 @@
 #include <TransactionDiskAccessor.h>
 #include "uint256.h"
 #include "utilmoneystr.h"
+#include <utiltime.h>
 #include "wallet.h"
 #include <WalletTx.h>
 #include <txmempool.h>
@@ -807,14 +810,8 @@ Value signrawtransaction(const Array& params, bool fHelp, CWallet* pwallet)
     return result;
 }
 
-static std::pair<CAmount,bool> ComputeFeeTotalsAndIfInputsAreKnown(const CTransaction& tx)
+static std::pair<CAmount,bool> ComputeFeeTotalsAndIfInputsAreKnown(const CCoinsViewCache& view, const CTransaction& tx)
 {
-    CTxMemPool& mempool = GetTransactionMemoryPool();
-    LOCK(mempool.cs);
-    const ChainstateManager::Reference chainstate;
-    const CCoinsViewMemPool viewMemPool(&chainstate->CoinsTip(), mempool);
-    const CCoinsViewCache view(&viewMemPool);
-
     if(!view.HaveInputs(tx))
     {
         return std::make_pair(-1,false);
@@ -874,7 +871,13 @@ Value sendrawtransaction(const Array& params, bool fHelp, CWallet* pwallet)
     static const CFeeRate& feeRate = FeeAndPriorityCalculator::instance().getMinimumRelayFeeRate();
     if (!fHaveMempool && !fHaveChain) {
         // push to local node and sync with wallets
-        std::pair<CAmount,bool> feeTotalsAndStatus = ComputeFeeTotalsAndIfInputsAreKnown(tx);
+        std::pair<CAmount,bool> feeTotalsAndStatus;
+        {
+            LOCK(mempool.cs);
+            const CCoinsViewMemPool viewMemPool(&view, mempool);
+            const CCoinsViewCache viewWithMempool(&viewMemPool);
+            feeTotalsAndStatus = ComputeFeeTotalsAndIfInputsAreKnown(viewWithMempool, tx);
+        }
         if(!feeTotalsAndStatus.second)
         {
             throw JSONRPCError(RPC_TRANSACTION_REJECTED, "Unknown inputs being spent");
@@ -898,3 +901,125 @@ Value sendrawtransaction(const Array& params, bool fHelp, CWallet* pwallet)
 
     return hashTx.GetHex();
 }
+
+Value sendrawtransactions(const Array& params, bool fHelp, CWallet* pwallet)
+{
+    if (fHelp || params.size() < 1 || params.size() > 2)
+        throw runtime_error(
+            "sendrawtransactions [\"hexstring\",...] ( allowhighfees )\n"
+            "\nSubmits raw transactions (serialized, hex-encoded) to local node and network in a single batch.\n"
+            "Transactions are accepted in the given order and may spend outputs of earlier ones in the batch.\n"
+            "\nArguments:\n"
+            "1. \"hexstrings\"   (array, required) The hex strings of the raw transactions\n"
+            "2. allowhighfees    (boolean, optional, default=false) Allow high fees\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"txid\" : \"hex\",      (string) The transaction hash in hex\n"
+            "    \"accepted\" : true|false, (boolean) Whether the transaction is in the memory pool\n"
+            "    \"error\" : \"reason\"    (string, optional) Why the transaction was rejected\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n" +
+            HelpExampleCli("sendrawtransactions", "\"[\\\"signedhex\\\",\\\"signedhex\\\"]\"") +
+            "\nAs a json rpc call\n" + HelpExampleRpc("sendrawtransactions", "[\"signedhex\",\"signedhex\"]"));
+
+    RPCTypeCheck(params, list_of(array_type)(bool_type));
+
+    const Array& hexTransactions = params[0].get_array();
+    std::vector<CTransaction> transactions(hexTransactions.size());
+    for (unsigned transactionIndex = 0; transactionIndex < hexTransactions.size(); ++transactionIndex)
+    {
+        if (hexTransactions[transactionIndex].type() != str_type ||
+            !DecodeHexTx(transactions[transactionIndex], hexTransactions[transactionIndex].get_str()))
+        {
+            throw JSONRPCError(RPC_DESERIALIZATION_ERROR, strprintf("TX decode failed for transaction %u", transactionIndex));
+        }
+    }
+
+    bool fOverrideFees = false;
+    if (params.size() > 1)
+        fOverrideFees = params[1].get_bool();
+
+    const ChainstateManager::Reference chainstate;
+    const auto& coinsTip = chainstate->CoinsTip();
+    CTxMemPool& mempool = GetTransactionMemoryPool();
+    static const CFeeRate& feeRate = FeeAndPriorityCalculator::instance().getMinimumRelayFeeRate();
+
+    std::vector<std::string> errors(transactions.size());
+    std::vector<bool> accepted(transactions.size(), false);
+    std::vector<std::pair<CTransaction, int64_t>> batch;
+    std::vector<unsigned> batchIndices;
+    {
+        // Earlier transactions of the batch provide the inputs of later ones
+        LOCK(mempool.cs);
+        const CCoinsViewMemPool viewMemPool(&coinsTip, mempool);
+        CCoinsViewCache view(&viewMemPool);
+        const int64_t acceptTime = GetTime();
+        for (unsigned transactionIndex = 0; transactionIndex < transactions.size(); ++transactionIndex)
+        {
+            const CTransaction& tx = transactions[transactionIndex];
+            const uint256 hashTx = tx.GetHash();
+            if (mempool.exists(hashTx))
+            {
+                accepted[transactionIndex] = true;
+                continue;
+            }
+            const CCoins* existingCoins = coinsTip.AccessCoins(hashTx);
+            if (existingCoins == nullptr)
+                existingCoins = coinsTip.AccessCoins(tx.GetBareTxid());
+            if (existingCoins && existingCoins->nHeight < 1000000000)
+            {
+                errors[transactionIndex] = "transaction already in block chain";
+                continue;
+            }
+
+            const std::pair<CAmount,bool> feeTotalsAndStatus = ComputeFeeTotalsAndIfInputsAreKnown(view, tx);
+            if (!feeTotalsAndStatus.second)
+            {
+                errors[transactionIndex] = "Unknown inputs being spent";
+                continue;
+            }
+            if (!fOverrideFees && feeTotalsAndStatus.first > feeRate.GetMaxTxFee())
+            {
+                errors[transactionIndex] = "Fees being paid are in excess of maximum fee, but fee override is not provided";
+                continue;
+            }
+            *view.ModifyCoins(hashTx) = CCoins(tx, CTxMemPoolEntry::MEMPOOL_HEIGHT);
+            batch.emplace_back(tx, acceptTime);
+            batchIndices.push_back(transactionIndex);
+        }
+    }
+
+    std::vector<MempoolConsensus::TransactionAcceptanceResult> results;
+    MempoolConsensus::AcceptTransactionsToMemoryPool(mempool, batch, false, results);
+    for (unsigned batchIndex = 0; batchIndex < batch.size(); ++batchIndex)
+    {
+        const MempoolConsensus::TransactionAcceptanceResult& result = results[batchIndex];
+        const unsigned transactionIndex = batchIndices[batchIndex];
+        accepted[transactionIndex] = result.accepted;
+        if (result.accepted)
+            continue;
+        if (result.state.IsInvalid())
+            errors[transactionIndex] = strprintf("%i: %s", result.state.GetRejectCode(), result.state.GetRejectReason());
+        else if (result.missingInputs)
+            errors[transactionIndex] = "Unknown inputs being spent";
+        else
+            errors[transactionIndex] = result.state.GetRejectReason();
+    }
+
+    Array ret;
+    for (unsigned transactionIndex = 0; transactionIndex < transactions.size(); ++transactionIndex)
+    {
+        if (accepted[transactionIndex])
+            RelayTransactionToAllPeers(transactions[transactionIndex]);
+        Object entry;
+        entry.push_back(Pair("txid", transactions[transactionIndex].GetHash().GetHex()));
+        entry.push_back(Pair("accepted", static_cast<bool>(accepted[transactionIndex])));
+        if (!accepted[transactionIndex])
+            entry.push_back(Pair("error", errors[transactionIndex]));
+        ret.push_back(entry);
+    }
+    return ret;
+}
@@ -106,6 +106,7 @@ extern json_spirit::Value decoderawtransaction(const json_spirit::Array& params,
 extern json_spirit::Value decodescript(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
 extern json_spirit::Value signrawtransaction(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
 extern json_spirit::Value sendrawtransaction(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
+extern json_spirit::Value sendrawtransactions(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
 extern json_spirit::Value signtransactionwithaddresskey(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
 
 extern json_spirit::Value getlotteryblockwinners(const json_spirit::Array& params, bool fHelp, CWallet* pwallet); // in rpclottery.cpp
@@ -119,6 +120,8 @@ extern json_spirit::Value getblock(const json_spirit::Array& params, bool fHelp,
 extern json_spirit::Value getblockheader(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
 extern json_spirit::Value gettxoutsetinfo(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
 extern json_spirit::Value gettxout(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
+extern json_spirit::Value getcoinscacheinfo(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
+extern json_spirit::Value getsigcacheinfo(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
 extern json_spirit::Value verifychain(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
 extern json_spirit::Value getblockchaininfo(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
 extern json_spirit::Value getchaintips(const json_spirit::Array& params, bool fHelp, CWallet* pwallet);
@@ -334,9 +337,11 @@ static const CRPCCommand vRPCCommands[] =
         {"blockchain", "getblockhash", &getblockhash, true, false, false, false},
         {"blockchain", "getblockheader", &getblockheader, false, false, false, false},
         {"blockchain", "getchaintips", &getchaintips, true, false, false, false},
+        {"blockchain", "getcoinscacheinfo", &getcoinscacheinfo, true, false, false, false},
         {"blockchain", "getdifficulty", &getdifficulty, true, false, false, false},
         {"blockchain", "getmempoolinfo", &getmempoolinfo, true, true, false, false},
         {"blockchain", "getrawmempool", &getrawmempool, true, false, false, false},
+        {"blockchain", "getsigcacheinfo", &getsigcacheinfo, true, true, false, false},
         {"blockchain", "gettxout", &gettxout, true, false, false, false},
         {"blockchain", "gettxoutsetinfo", &gettxoutsetinfo, true, false, false, false},
         {"blockchain", "verifychain", &verifychain, true, false, false, false},
@@ -361,6 +366,7 @@ static const CRPCCommand vRPCCommands[] =
         {"rawtransactions", "decodescript", &decodescript, true, false, false, false},
         {"rawtransactions", "getrawtransaction", &getrawtransaction, true, false, false, false},
         {"rawtransactions", "sendrawtransaction", &sendrawtransaction, false, false, false, false},
+        {"rawtransactions", "sendrawtransactions", &sendrawtransactions, false, false, false, false},
         {"rawtransactions", "signtransactionwithaddresskey", &signtransactionwithaddresskey, false, false, false, true},
         {"rawtransactions", "signrawtransaction", &signrawtransaction, false, false, false, false}, /* uses wallet if enabled */
 
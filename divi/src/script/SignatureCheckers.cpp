@@ -6,6 +6,7 @@
 #include "script/scriptandsigflags.h"
 #include <eccryptoverify.h>
 #include <pubkey.h>
+#include <streams.h>
 
 MutableTransactionSignatureChecker::MutableTransactionSignatureChecker(
     const CMutableTransaction* txToIn,
@@ -264,8 +265,78 @@ public:
 
 } // anon namespace
 
-uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType)
+PrecomputedTransactionData::PrecomputedTransactionData(
+    const CTransaction& txToIn
+    ): txTo(&txToIn)
+    , prefixHashers()
+    , blankedInputs()
+    , blankedInputOffsets()
+    , outputsAndLockTime()
 {
+    CDataStream ss(SER_GETHASH, 0);
+    ss << txTo->nVersion;
+    ::WriteCompactSize(ss, txTo->vin.size());
+
+    CSHA256 hasher;
+    hasher.Write((const unsigned char*)&ss[0], ss.size());
+    ss.clear();
+
+    prefixHashers.reserve(txTo->vin.size());
+    blankedInputOffsets.reserve(txTo->vin.size() + 1);
+    for (const CTxIn& txin : txTo->vin) {
+        prefixHashers.push_back(hasher);
+        blankedInputOffsets.push_back(ss.size());
+        const size_t inputStart = ss.size();
+        ss << txin.prevout << CScript() << txin.nSequence;
+        hasher.Write((const unsigned char*)&ss[inputStart], ss.size() - inputStart);
+    }
+    blankedInputOffsets.push_back(ss.size());
+    blankedInputs.assign(ss.begin(), ss.end());
+
+    ss.clear();
+    ss << txTo->vout << txTo->nLockTime;
+    outputsAndLockTime.assign(ss.begin(), ss.end());
+}
+
+bool PrecomputedTransactionData::CanHash(const CTransaction& tx, unsigned int nIn, int nHashType) const
+{
+    const int nBaseHashType = nHashType & 0x1f;
+    return &tx == txTo &&
+        nIn < prefixHashers.size() &&
+        !(nHashType & SIGHASH_ANYONECANPAY) &&
+        nBaseHashType != SIGHASH_NONE &&
+        nBaseHashType != SIGHASH_SINGLE;
+}
+
+uint256 PrecomputedTransactionData::SignatureHash(const CScript& scriptCode, unsigned int nIn, int nHashType) const
+{
+    CSHA256 hasher(prefixHashers[nIn]);
+
+    CDataStream ss(SER_GETHASH, 0);
+    CTransactionSignatureSerializer(*txTo, scriptCode, nIn, nHashType).SerializeInput(ss, nIn, SER_GETHASH, 0);
+    hasher.Write((const unsigned char*)&ss[0], ss.size());
+
+    const size_t suffixStart = blankedInputOffsets[nIn + 1];
+    hasher.Write(blankedInputs.data() + suffixStart, blankedInputs.size() - suffixStart);
+    hasher.Write(outputsAndLockTime.data(), outputsAndLockTime.size());
+
+    ss.clear();
+    ss << nHashType;
+    hasher.Write((const unsigned char*)&ss[0], ss.size());
+
+    uint256 hash;
+    unsigned char singleHash[CSHA256::OUTPUT_SIZE];
+    hasher.Finalize(singleHash);
+    CSHA256().Write(singleHash, sizeof(singleHash)).Finalize((unsigned char*)&hash);
+    return hash;
+}
+
+uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType, const PrecomputedTransactionData* txdata)
+{
+    if (txdata && txdata->CanHash(txTo, nIn, nHashType)) {
+        return txdata->SignatureHash(scriptCode, nIn, nHashType);
+    }
+
     if (nIn >= txTo.vin.size()) {
         //  nIn out of range
         return 1;
@@ -306,7 +377,7 @@ bool TransactionSignatureChecker::CheckSig(const std::vector<unsigned char>& vch
     int nHashType = vchSig.back();
     vchSig.pop_back();
 
-    uint256 sighash = SignatureHash(scriptCode, *txTo, nIn, nHashType);
+    uint256 sighash = SignatureHash(scriptCode, *txTo, nIn, nHashType, txdata);
 
     if (!VerifySignature(vchSig, pubkey, sighash))
         return false;
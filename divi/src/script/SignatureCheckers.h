@@ -8,6 +8,7 @@
 #include <vector>
 #include <memory>
 #include <amount.h>
+#include <crypto/sha256.h>
 
 class CPubKey;
 class CScript;
@@ -16,7 +17,33 @@ class CTransaction;
 class uint256;
 class CMutableTransaction;
 
-uint256 SignatureHash(const CScript &scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType);
+class PrecomputedTransactionData;
+
+uint256 SignatureHash(const CScript &scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType, const PrecomputedTransactionData* txdata = NULL);
+
+/**
+ * Parts of the signature hash preimage that do not depend on the input being signed.
+ * For SIGHASH_ALL every other input is serialized with a blank script, so the
+ * preimage for input i is: the hash state over everything before input i, then
+ * input i with its script code, then the blanked inputs after it, then the outputs
+ * and lock time. Building these once per transaction avoids re-serializing the
+ * whole transaction for each input; other hash types use the generic path.
+ */
+class PrecomputedTransactionData
+{
+private:
+    const CTransaction* txTo;
+    std::vector<CSHA256> prefixHashers;
+    std::vector<unsigned char> blankedInputs;
+    std::vector<size_t> blankedInputOffsets;
+    std::vector<unsigned char> outputsAndLockTime;
+
+public:
+    explicit PrecomputedTransactionData(const CTransaction& txToIn);
+
+    bool CanHash(const CTransaction& tx, unsigned int nIn, int nHashType) const;
+    uint256 SignatureHash(const CScript& scriptCode, unsigned int nIn, int nHashType) const;
+};
 
 class BaseSignatureChecker
 {
@@ -53,12 +80,17 @@ class TransactionSignatureChecker : public BaseSignatureChecker
 protected:
     const CTransaction* txTo;
     unsigned int nIn;
+    const PrecomputedTransactionData* txdata;
 
 protected:
     virtual bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const;
 
 public:
-    TransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn) : txTo(txToIn), nIn(nInIn) {}
+    TransactionSignatureChecker(
+        const CTransaction* txToIn,
+        unsigned int nInIn,
+        const PrecomputedTransactionData* txdataIn = NULL
+        ) : txTo(txToIn), nIn(nInIn), txdata(txdataIn) {}
     bool CheckSig(const std::vector<unsigned char>& scriptSig, const std::vector<unsigned char>& vchPubKey, const CScript& scriptCode) const override;
     bool CheckCoinstake() const override;
     bool CheckLockTime(const CScriptNum& nLockTime) const override;
@@ -5,13 +5,20 @@
 
 #include "sigcache.h"
 
+#include "crypto/sha256.h"
+#include "defaultValues.h"
+#include "Logging.h"
 #include "pubkey.h"
 #include "random.h"
 #include "uint256.h"
 #include "util.h"
 
-#include <boost/thread.hpp>
-#include <boost/tuple/tuple_comparison.hpp>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string.h>
 #include "Settings.h"
 extern Settings& settings;
 namespace {
@@ -20,64 +27,219 @@ namespace {
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
  * again when accepted into the block chain)
+ *
+ * Entries are salted SHA256 digests of (signature hash, public key, signature),
+ * so each one takes 32 bytes and an attacker cannot predict where it is stored.
+ * The table is a fixed array of cache-line sized buckets with two entries each,
+ * and every entry may live in one of two buckets chosen from independent bits
+ * of its digest.  Lookups only read atomic words and never block; insertions
+ * are serialized per shard of buckets.
  */
 class CSignatureCache
 {
 private:
-     //! sigdata_type is (signature hash, signature, public key):
-    typedef boost::tuple<uint256, std::vector<unsigned char>, CPubKey> sigdata_type;
-    std::set< sigdata_type> setValid;
-    boost::shared_mutex cs_sigcache;
+    static const unsigned WORDS_PER_ENTRY = 4;
+    static const unsigned ENTRIES_PER_BUCKET = 2;
+    static const unsigned SHARD_COUNT = 64;
+    static const size_t CACHE_LINE_SIZE = 64;
 
-public:
-    bool
-    Get(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
+    struct Bucket {
+        std::atomic<uint64_t> words[ENTRIES_PER_BUCKET * WORDS_PER_ENTRY];
+    };
+    static_assert(sizeof(Bucket) == CACHE_LINE_SIZE, "signature cache buckets must fill exactly one cache line");
+
+    typedef uint64_t Entry[WORDS_PER_ENTRY];
+
+    CSHA256 saltedHasher;
+    std::unique_ptr<unsigned char[]> storage;
+    Bucket* buckets;
+    const size_t bucketCount;
+    std::mutex shardLocks[SHARD_COUNT];
+
+    std::atomic<uint64_t> lookups;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> insertions;
+    std::atomic<uint64_t> evictions;
+
+    void ComputeEntry(Entry& entry, const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey) const
     {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+        unsigned char digest[CSHA256::OUTPUT_SIZE];
+        CSHA256 hasher = saltedHasher;
+        hasher.Write(hash.begin(), 32).Write(pubKey.begin(), pubKey.size()).Write(vchSig.data(), vchSig.size()).Finalize(digest);
+        memcpy(entry, digest, sizeof(entry));
+    }
+
+    size_t FirstBucket(const Entry& entry) const { return entry[0] % bucketCount; }
+    size_t SecondBucket(const Entry& entry) const { return entry[1] % bucketCount; }
 
-        sigdata_type k(hash, vchSig, pubKey);
-        std::set<sigdata_type>::iterator mi = setValid.find(k);
-        if (mi != setValid.end())
-            return true;
+    bool SlotMatches(const Bucket& bucket, unsigned slot, const Entry& entry) const
+    {
+        const std::atomic<uint64_t>* words = &bucket.words[slot * WORDS_PER_ENTRY];
+        // The leading word is published last by StoreInSlot
+        if (words[0].load(std::memory_order_acquire) != entry[0])
+            return false;
+        for (unsigned i = 1; i < WORDS_PER_ENTRY; ++i) {
+            if (words[i].load(std::memory_order_relaxed) != entry[i])
+                return false;
+        }
+        return true;
+    }
+
+    bool SlotIsEmpty(const Bucket& bucket, unsigned slot) const
+    {
+        return bucket.words[slot * WORDS_PER_ENTRY].load(std::memory_order_relaxed) == 0;
+    }
+
+    void StoreInSlot(Bucket& bucket, unsigned slot, const Entry& entry)
+    {
+        std::atomic<uint64_t>* words = &bucket.words[slot * WORDS_PER_ENTRY];
+        words[0].store(0, std::memory_order_relaxed);
+        for (unsigned i = 1; i < WORDS_PER_ENTRY; ++i)
+            words[i].store(entry[i], std::memory_order_relaxed);
+        words[0].store(entry[0], std::memory_order_release);
+    }
+
+    bool Contains(const Entry& entry) const
+    {
+        const Bucket& first = buckets[FirstBucket(entry)];
+        const Bucket& second = buckets[SecondBucket(entry)];
+        for (unsigned slot = 0; slot < ENTRIES_PER_BUCKET; ++slot) {
+            if (SlotMatches(first, slot, entry) || SlotMatches(second, slot, entry))
+                return true;
+        }
         return false;
     }
 
-    void Set(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
+public:
+    static const unsigned BYTES_PER_ENTRY = WORDS_PER_ENTRY * sizeof(uint64_t);
+
+    explicit CSignatureCache(size_t maxBytes
+        ): saltedHasher()
+        , storage()
+        , buckets(nullptr)
+        , bucketCount(maxBytes / sizeof(Bucket))
+        , lookups(0)
+        , hits(0)
+        , insertions(0)
+        , evictions(0)
     {
-        // DoS prevention: limit cache size to less than 10MB
-        // (~200 bytes per cache entry times 50,000 entries)
-        // Since there are a maximum of 20,000 signature operations per block
-        // 50,000 is a reasonable default.
-        int64_t nMaxCacheSize = settings.GetArg("-maxsigcachesize", 50000);
-        if (nMaxCacheSize <= 0) return;
-
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-
-        while (static_cast<int64_t>(setValid.size()) > nMaxCacheSize)
-        {
-            // Evict a random entry. Random because that helps
-            // foil would-be DoS attackers who might try to pre-generate
-            // and re-use a set of valid signatures just-slightly-greater
-            // than our cache size.
-            uint256 randomHash = GetRandHash();
-            std::vector<unsigned char> unused;
-            std::set<sigdata_type>::iterator it =
-                setValid.lower_bound(sigdata_type(randomHash, unused, unused));
-            if (it == setValid.end())
-                it = setValid.begin();
-            setValid.erase(*it);
+        const uint256 nonce = GetRandHash();
+        saltedHasher.Write(nonce.begin(), 32);
+        if (bucketCount == 0)
+            return;
+
+        storage.reset(new unsigned char[bucketCount * sizeof(Bucket) + CACHE_LINE_SIZE]);
+        const uintptr_t unaligned = reinterpret_cast<uintptr_t>(storage.get());
+        buckets = reinterpret_cast<Bucket*>((unaligned + CACHE_LINE_SIZE - 1) & ~static_cast<uintptr_t>(CACHE_LINE_SIZE - 1));
+        for (size_t bucketIndex = 0; bucketIndex < bucketCount; ++bucketIndex) {
+            Bucket* bucket = new (&buckets[bucketIndex]) Bucket;
+            for (std::atomic<uint64_t>& word : bucket->words)
+                word.store(0, std::memory_order_relaxed);
         }
+    }
 
-        sigdata_type k(hash, vchSig, pubKey);
-        setValid.insert(k);
+    bool Get(const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
+    {
+        if (bucketCount == 0)
+            return false;
+
+        Entry entry;
+        ComputeEntry(entry, hash, vchSig, pubKey);
+        lookups.fetch_add(1, std::memory_order_relaxed);
+        if (!Contains(entry))
+            return false;
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Set(const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
+    {
+        if (bucketCount == 0)
+            return;
+
+        Entry entry;
+        ComputeEntry(entry, hash, vchSig, pubKey);
+        const size_t bucketIndices[2] = {FirstBucket(entry), SecondBucket(entry)};
+
+        // Shards are always locked in ascending order
+        const size_t firstShard = bucketIndices[0] % SHARD_COUNT;
+        const size_t secondShard = bucketIndices[1] % SHARD_COUNT;
+        std::unique_lock<std::mutex> firstLock(shardLocks[std::min(firstShard, secondShard)]);
+        std::unique_lock<std::mutex> secondLock;
+        if (firstShard != secondShard)
+            secondLock = std::unique_lock<std::mutex>(shardLocks[std::max(firstShard, secondShard)]);
+
+        if (Contains(entry))
+            return;
+
+        insertions.fetch_add(1, std::memory_order_relaxed);
+        for (size_t bucketIndex : bucketIndices) {
+            for (unsigned slot = 0; slot < ENTRIES_PER_BUCKET; ++slot) {
+                if (SlotIsEmpty(buckets[bucketIndex], slot)) {
+                    StoreInSlot(buckets[bucketIndex], slot, entry);
+                    return;
+                }
+            }
+        }
+
+        // Evict a random entry. Random because that helps foil would-be DoS
+        // attackers who might try to pre-generate and re-use a set of valid
+        // signatures just-slightly-greater than our cache size.  The salted
+        // digest itself is the source of randomness.
+        const unsigned victim = entry[2] % (2 * ENTRIES_PER_BUCKET);
+        StoreInSlot(buckets[bucketIndices[victim / ENTRIES_PER_BUCKET]], victim % ENTRIES_PER_BUCKET, entry);
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    SignatureCacheStats GetStats() const
+    {
+        SignatureCacheStats stats;
+        stats.capacity = bucketCount * ENTRIES_PER_BUCKET;
+        stats.bytes = bucketCount * sizeof(Bucket);
+        stats.lookups = lookups.load(std::memory_order_relaxed);
+        stats.hits = hits.load(std::memory_order_relaxed);
+        stats.insertions = insertions.load(std::memory_order_relaxed);
+        stats.evictions = evictions.load(std::memory_order_relaxed);
+        return stats;
     }
 };
 
+/** -sigcachesize in MiB, or the legacy -maxsigcachesize given in entries
+ *  converted to the MiB that many digests take.  */
+int64_t GetConfiguredSignatureCacheSize()
+{
+    if (!settings.ParameterIsSet("-sigcachesize") && settings.ParameterIsSet("-maxsigcachesize")) {
+        const int64_t legacyEntries = std::min<int64_t>(
+            std::max<int64_t>(0, settings.GetArg("-maxsigcachesize", 0)),
+            (MAX_SIG_CACHE_SIZE << 20) / CSignatureCache::BYTES_PER_ENTRY);
+        const int64_t convertedSizeInMiB = (legacyEntries * CSignatureCache::BYTES_PER_ENTRY + (1 << 20) - 1) >> 20;
+        LogPrintf("Warning: -maxsigcachesize=%d is a number of entries and is deprecated, using -sigcachesize=%d (MiB)\n",
+            legacyEntries, convertedSizeInMiB);
+        return convertedSizeInMiB;
+    }
+    return settings.GetArg("-sigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE);
+}
+
+CSignatureCache& GetSignatureCache()
+{
+    // The size is read once; the cache never allocates after construction
+    static const int64_t maxSizeInMiB = std::min<int64_t>(
+        std::max<int64_t>(0, GetConfiguredSignatureCacheSize()),
+        MAX_SIG_CACHE_SIZE);
+    static CSignatureCache signatureCache(static_cast<size_t>(maxSizeInMiB) << 20);
+    return signatureCache;
+}
+
+}
+
+SignatureCacheStats GetSignatureCacheStats()
+{
+    return GetSignatureCache().GetStats();
 }
 
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
-    static CSignatureCache signatureCache;
+    CSignatureCache& signatureCache = GetSignatureCache();
 
     if (signatureCache.Get(sighash, vchSig, pubkey))
         return true;
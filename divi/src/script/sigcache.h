@@ -8,14 +8,34 @@
 
 #include "script/SignatureCheckers.h"
 
+#include <stdint.h>
 #include <vector>
 
 class CPubKey;
 
+/** Snapshot of the signature cache counters, as reported over RPC. */
+struct SignatureCacheStats
+{
+    uint64_t capacity;
+    uint64_t bytes;
+    uint64_t lookups;
+    uint64_t hits;
+    uint64_t insertions;
+    uint64_t evictions;
+
+    SignatureCacheStats(): capacity(0), bytes(0), lookups(0), hits(0), insertions(0), evictions(0) {}
+};
+
+SignatureCacheStats GetSignatureCacheStats();
+
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn) : TransactionSignatureChecker(txToIn, nInIn) {}
+    CachingTransactionSignatureChecker(
+        const CTransaction* txToIn,
+        unsigned int nInIn,
+        const PrecomputedTransactionData* txdataIn = NULL
+        ) : TransactionSignatureChecker(txToIn, nInIn, txdataIn) {}
 
     bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const;
 };
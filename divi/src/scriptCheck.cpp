@@ -9,18 +9,20 @@
 #include <primitives/transaction.h>
 #include <coins.h>
 
-CScriptCheck::CScriptCheck() : ptxTo(0), nIn(0), nFlags(0), error(SCRIPT_ERR_UNKNOWN_ERROR) {}
+CScriptCheck::CScriptCheck() : ptxTo(0), nIn(0), nFlags(0), txdata(), error(SCRIPT_ERR_UNKNOWN_ERROR) {}
 
 CScriptCheck::CScriptCheck(
     const CCoins& txFromIn,
     const CTransaction& txToIn,
     unsigned int nInIn,
-    unsigned int nFlagsIn
+    unsigned int nFlagsIn,
+    std::shared_ptr<const PrecomputedTransactionData> txdataIn
     ) : scriptPubKey(txFromIn.vout[txToIn.vin[nInIn].prevout.n].scriptPubKey)
     , amountHeld(txFromIn.vout[txToIn.vin[nInIn].prevout.n].nValue)
     , ptxTo(&txToIn)
     , nIn(nInIn)
     , nFlags(nFlagsIn)
+    , txdata(txdataIn)
     , error(SCRIPT_ERR_UNKNOWN_ERROR)
 {}
 
@@ -28,7 +30,7 @@ bool CScriptCheck::operator()()
 {
     const CScript& scriptSig = ptxTo->vin[nIn].scriptSig;
     const CTxOut previousOutput(amountHeld,scriptPubKey);
-    if (!VerifyScript(scriptSig, previousOutput, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn), &error)) {
+    if (!VerifyScript(scriptSig, previousOutput, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, txdata.get()), &error)) {
         return ::error("CScriptCheck(): %s:%d VerifySignature failed: %s", ptxTo->ToStringShort(), nIn, ScriptErrorString(error));
     }
     return true;
@@ -42,6 +44,7 @@ void CScriptCheck::swap(CScriptCheck& check)
     std::swap(ptxTo, check.ptxTo);
     std::swap(nIn, check.nIn);
     std::swap(nFlags, check.nFlags);
+    txdata.swap(check.txdata);
     std::swap(error, check.error);
 }
 
@@ -9,9 +9,11 @@
 #include <script/script_error.h>
 #include <script/script.h>
 #include <amount.h>
+#include <memory>
 
 class CTransaction;
 class CCoins;
+class PrecomputedTransactionData;
 
 /**
  * Closure representing one script verification
@@ -25,12 +27,18 @@ private:
     const CTransaction* ptxTo;
     unsigned int nIn;
     unsigned int nFlags;
+    std::shared_ptr<const PrecomputedTransactionData> txdata;
     ScriptError error;
 
 public:
     CScriptCheck();
 
-    CScriptCheck(const CCoins& txFromIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn);
+    CScriptCheck(
+        const CCoins& txFromIn,
+        const CTransaction& txToIn,
+        unsigned int nInIn,
+        unsigned int nFlagsIn,
+        std::shared_ptr<const PrecomputedTransactionData> txdataIn = std::shared_ptr<const PrecomputedTransactionData>());
 
 
     bool operator()();
@@ -2,6 +2,8 @@
 
 #include <hash.h>
 #include <primitives/transaction.h>
+#include <streams.h>
+#include <version.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -125,6 +127,30 @@ BOOST_AUTO_TEST_CASE (equalsTxidForCoinbase)
   BOOST_CHECK (tx1.GetBareTxid () != tx2.GetBareTxid ());
 }
 
+BOOST_AUTO_TEST_CASE (matchesBetweenMutableAndCachedForms)
+{
+  CMutableTransaction stripped(mtx);
+  for (auto& in : stripped.vin)
+    in.scriptSig.clear ();
+
+  BOOST_CHECK (mtx.GetBareTxid () == tx.GetBareTxid ());
+  BOOST_CHECK (stripped.GetHash () == tx.GetBareTxid ());
+}
+
+BOOST_AUTO_TEST_CASE (isRestoredOnDeserialisationAndAssignment)
+{
+  CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+  ss << tx;
+
+  CTransaction deserialised;
+  ss >> deserialised;
+  BOOST_CHECK (deserialised.GetBareTxid () == tx.GetBareTxid ());
+
+  CTransaction assigned;
+  assigned = deserialised;
+  BOOST_CHECK (assigned.GetBareTxid () == tx.GetBareTxid ());
+}
+
 BOOST_AUTO_TEST_SUITE_END ()
 
 } // anonymous namespace
@@ -0,0 +1,99 @@
+#include <primitives/block.h>
+
+#include <hash.h>
+#include <random.h>
+#include <utilstrencodings.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+#include <atomic>
+
+namespace
+{
+
+uint256 UncachedHash(const CBlockHeader& header)
+{
+    if (header.nVersion < 4)
+        return HashQuark(BEGIN(header.nVersion), END(header.nNonce));
+    return Hash(BEGIN(header.nVersion), END(header.nAccumulatorCheckpoint));
+}
+
+CBlockHeader RandomHeader(int32_t version)
+{
+    CBlockHeader header;
+    header.nVersion = version;
+    header.hashPrevBlock = GetRandHash();
+    header.hashMerkleRoot = GetRandHash();
+    header.nTime = GetRand(1u << 31);
+    header.nBits = GetRand(1u << 31);
+    header.nNonce = GetRand(1u << 31);
+    header.nAccumulatorCheckpoint = GetRandHash();
+    return header;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(BlockHeaderHash_tests)
+
+BOOST_AUTO_TEST_CASE(cachedHashFollowsEveryHeaderField)
+{
+    for (int32_t version = 1; version <= CBlockHeader::CURRENT_VERSION; ++version)
+    {
+        CBlockHeader header = RandomHeader(version);
+        BOOST_CHECK(header.GetHash() == UncachedHash(header));
+        BOOST_CHECK(header.GetHash() == UncachedHash(header));
+
+        header.nNonce++;
+        BOOST_CHECK(header.GetHash() == UncachedHash(header));
+        header.nTime++;
+        BOOST_CHECK(header.GetHash() == UncachedHash(header));
+        header.hashMerkleRoot = GetRandHash();
+        BOOST_CHECK(header.GetHash() == UncachedHash(header));
+        header.nAccumulatorCheckpoint = GetRandHash();
+        BOOST_CHECK(header.GetHash() == UncachedHash(header));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(copiesAndBlocksKeepTheirOwnHash)
+{
+    CBlockHeader header = RandomHeader(CBlockHeader::CURRENT_VERSION);
+    const uint256 originalHash = header.GetHash();
+
+    CBlockHeader copy = header;
+    copy.nNonce++;
+    BOOST_CHECK(copy.GetHash() != originalHash);
+    BOOST_CHECK(header.GetHash() == originalHash);
+
+    CBlock block(header);
+    BOOST_CHECK(block.GetHash() == originalHash);
+    BOOST_CHECK(block.GetBlockHeader().GetHash() == originalHash);
+    block.SetNull();
+    BOOST_CHECK(block.GetHash() == UncachedHash(block));
+}
+
+BOOST_AUTO_TEST_CASE(copiesRacingGetHashSeeAConsistentHash)
+{
+    const CBlockHeader header = RandomHeader(CBlockHeader::CURRENT_VERSION);
+    const uint256 expectedHash = UncachedHash(header);
+
+    boost::thread_group threads;
+    std::atomic<bool> allCopiesMatched(true);
+    for (unsigned threadIndex = 0; threadIndex < 4; ++threadIndex)
+    {
+        threads.create_thread([&header, &expectedHash, &allCopiesMatched]() {
+            CBlockHeader assigned;
+            for (unsigned iteration = 0; iteration < 1000; ++iteration)
+            {
+                CBlockHeader copy(header);
+                assigned = header;
+                if (header.GetHash() != expectedHash || copy.GetHash() != expectedHash || assigned.GetHash() != expectedHash)
+                    allCopiesMatched = false;
+            }
+        });
+    }
+    threads.join_all();
+    BOOST_CHECK(allCopiesMatched);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
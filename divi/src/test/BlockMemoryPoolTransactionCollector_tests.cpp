@@ -0,0 +1,135 @@
+#include <BlockMemoryPoolTransactionCollector.h>
+
+#include <BlockTemplate.h>
+#include <chain.h>
+#include <coins.h>
+#include <FeeRate.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <Settings.h>
+#include <sync.h>
+#include <txmempool.h>
+#include <utiltime.h>
+#include <FakeBlockIndexChain.h>
+
+#include <boost/test/unit_test.hpp>
+
+extern Settings& settings;
+
+class BlockMemoryPoolTransactionCollectorTestFixture
+{
+protected:
+    FakeBlockIndexWithHashes fakeChain;
+    CCoinsViewBacked dummyView;
+    CCoinsViewCache coins;
+    CMutableTransaction fundingTx;
+    CTxMemPool mempool;
+    CCriticalSection mainCS;
+    const CFeeRate txFeeRate;
+    BlockMemoryPoolTransactionCollector collector;
+
+public:
+    BlockMemoryPoolTransactionCollectorTestFixture(
+        ): fakeChain(1, 1500000000, 1)
+        , dummyView()
+        , coins(&dummyView)
+        , fundingTx()
+        , mempool()
+        , mainCS()
+        , txFeeRate(0)
+        , collector(settings, coins, *fakeChain.activeChain, *fakeChain.blockIndexByHash, mempool, mainCS, txFeeRate)
+    {
+        fundingTx.vin.resize(1);
+        fundingTx.vin[0].prevout = COutPoint(GetRandHash(), 0);
+        for (unsigned outputIndex = 0; outputIndex < 3; ++outputIndex)
+            fundingTx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+        coins.ModifyCoins(fundingTx.GetHash())->FromTx(fundingTx, 0);
+        coins.SetBestBlock(fakeChain.activeChain->Tip()->GetBlockHash());
+    }
+    ~BlockMemoryPoolTransactionCollectorTestFixture()
+    {
+        SetMockTime(0);
+    }
+
+    CTransaction AddSpendToMempool(unsigned outputIndex, uint32_t lockTime = 0)
+    {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(fundingTx.GetHash(), outputIndex);
+        if (lockTime != 0)
+            tx.vin[0].nSequence = 0;
+        tx.nLockTime = lockTime;
+        tx.vout.emplace_back(COIN / 2, CScript() << OP_TRUE);
+        mempool.addUnchecked(tx.GetHash(), CTxMemPoolEntry(tx, COIN / 2, 0, 0.0, 1));
+        return tx;
+    }
+
+    void SpendFundingOutputOutsideTheMempool(unsigned outputIndex)
+    {
+        coins.ModifyCoins(fundingTx.GetHash())->Spend(outputIndex);
+    }
+
+    std::vector<uint256> CollectTransactionHashes()
+    {
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vin[0].prevout.SetNull();
+        coinbase.vout.emplace_back(0, CScript() << OP_TRUE);
+
+        CBlockTemplate blockTemplate;
+        blockTemplate.previousBlockIndex = fakeChain.activeChain->Tip();
+        blockTemplate.block.vtx.push_back(coinbase);
+        BOOST_REQUIRE(collector.CollectTransactionsIntoBlock(blockTemplate));
+
+        std::vector<uint256> hashes;
+        for (unsigned transactionIndex = 1; transactionIndex < blockTemplate.block.vtx.size(); ++transactionIndex)
+            hashes.push_back(blockTemplate.block.vtx[transactionIndex].GetHash());
+        return hashes;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(BlockMemoryPoolTransactionCollector_tests, BlockMemoryPoolTransactionCollectorTestFixture)
+
+BOOST_AUTO_TEST_CASE(willReuseSelectionWhileTipAndMempoolAreUnchanged)
+{
+    const CTransaction tx = AddSpendToMempool(0);
+    BOOST_CHECK(CollectTransactionHashes() == std::vector<uint256>({tx.GetHash()}));
+
+    // A fresh selection would drop the transaction, the cached one still has it
+    SpendFundingOutputOutsideTheMempool(0);
+    BOOST_CHECK(CollectTransactionHashes() == std::vector<uint256>({tx.GetHash()}));
+}
+
+BOOST_AUTO_TEST_CASE(willRebuildSelectionWhenTheMempoolChanges)
+{
+    const CTransaction tx = AddSpendToMempool(0);
+    BOOST_CHECK(CollectTransactionHashes() == std::vector<uint256>({tx.GetHash()}));
+
+    SpendFundingOutputOutsideTheMempool(0);
+    const CTransaction otherTx = AddSpendToMempool(1);
+    BOOST_CHECK(CollectTransactionHashes() == std::vector<uint256>({otherTx.GetHash()}));
+}
+
+BOOST_AUTO_TEST_CASE(willRebuildSelectionWhenTheTipChanges)
+{
+    const CTransaction tx = AddSpendToMempool(0);
+    BOOST_CHECK(CollectTransactionHashes() == std::vector<uint256>({tx.GetHash()}));
+
+    SpendFundingOutputOutsideTheMempool(0);
+    fakeChain.addBlocks(1, 1);
+    BOOST_CHECK(CollectTransactionHashes().empty());
+}
+
+BOOST_AUTO_TEST_CASE(willNotReuseSelectionThatSkippedTimeLockedTransactions)
+{
+    const int64_t lockTime = 1600000000;
+    SetMockTime(lockTime - 1000);
+    const CTransaction tx = AddSpendToMempool(0, lockTime);
+    BOOST_CHECK(CollectTransactionHashes().empty());
+
+    // Neither the tip nor the mempool change while the lock time passes
+    SetMockTime(lockTime + 1000);
+    BOOST_CHECK(CollectTransactionHashes() == std::vector<uint256>({tx.GetHash()}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
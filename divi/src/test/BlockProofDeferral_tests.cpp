@@ -0,0 +1,76 @@
+#include <BlockProofDeferral.h>
+
+#include <blockmap.h>
+#include <chain.h>
+#include <defaultValues.h>
+#include <FakeBlockIndexChain.h>
+
+#include <boost/test/unit_test.hpp>
+
+class BlockProofDeferralTestFixture
+{
+protected:
+    FakeBlockIndexWithHashes fakeChain;
+    CChain& activeChain;
+
+public:
+    BlockProofDeferralTestFixture(
+        ): fakeChain(BLOCK_DOWNLOAD_WINDOW + 20, 1500000000, 1)
+        , activeChain(*fakeChain.activeChain)
+    {
+    }
+
+    /** Moves the active tip back, the blocks above it stand in for synced headers */
+    const CBlockIndex* RewindActiveChainTo(int height)
+    {
+        const CBlockIndex* tip = activeChain.Tip();
+        activeChain.SetTip(tip->GetAncestor(height));
+        return tip;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(BlockProofDeferral_tests, BlockProofDeferralTestFixture)
+
+BOOST_AUTO_TEST_CASE(willCheckBlocksExtendingTheActiveChainInFull)
+{
+    const CBlockIndex* headersTip = RewindActiveChainTo(10);
+    BOOST_CHECK(!BlockProofCanWaitForParent(activeChain, headersTip->GetAncestor(11)));
+    BOOST_CHECK(!BlockProofCanWaitForParent(activeChain, nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(willDeferBlocksDescendingFromTheActiveTip)
+{
+    const CBlockIndex* headersTip = RewindActiveChainTo(10);
+    BOOST_CHECK(BlockProofCanWaitForParent(activeChain, headersTip->GetAncestor(12)));
+    BOOST_CHECK(BlockProofCanWaitForParent(activeChain, headersTip->GetAncestor(30)));
+}
+
+BOOST_AUTO_TEST_CASE(willOnlyDeferBlocksWithinTheDownloadWindow)
+{
+    const CBlockIndex* headersTip = RewindActiveChainTo(10);
+    BOOST_CHECK(BlockProofCanWaitForParent(activeChain, headersTip->GetAncestor(10 + BLOCK_DOWNLOAD_WINDOW)));
+    BOOST_CHECK(!BlockProofCanWaitForParent(activeChain, headersTip->GetAncestor(10 + BLOCK_DOWNLOAD_WINDOW + 1)));
+}
+
+BOOST_AUTO_TEST_CASE(willCheckBlocksForkingOffBelowTheActiveTipInFull)
+{
+    const CBlockIndex* mainTip = activeChain.Tip();
+    fakeChain.fork(8, 10);
+    const CBlockIndex* forkTip = activeChain.Tip();
+    const int forkHeight = mainTip->nHeight - 10;
+    activeChain.SetTip(mainTip->GetAncestor(forkHeight + 5));
+
+    BOOST_CHECK(!BlockProofCanWaitForParent(activeChain, forkTip->GetAncestor(forkHeight + 3)));
+    BOOST_CHECK(!BlockProofCanWaitForParent(activeChain, forkTip->GetAncestor(forkHeight + 5)));
+    BOOST_CHECK(!BlockProofCanWaitForParent(activeChain, forkTip));
+}
+
+BOOST_AUTO_TEST_CASE(willCheckChildrenOfFailedBlocksInFull)
+{
+    const CBlockIndex* headersTip = RewindActiveChainTo(10);
+    const uint256 failedBlockHash = headersTip->GetAncestor(11)->GetBlockHash();
+    fakeChain.blockIndexByHash->find(failedBlockHash)->second->nStatus |= BLOCK_FAILED_VALID;
+    BOOST_CHECK(!BlockProofCanWaitForParent(activeChain, headersTip->GetAncestor(12)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,157 @@
+#include <BlockTransactionPrevalidator.h>
+
+#include <BlockRewards.h>
+#include <blockmap.h>
+#include <chain.h>
+#include <coins.h>
+#include <defaultValues.h>
+#include <IndexDatabaseUpdates.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <script/standard.h>
+#include <FakeBlockIndexChain.h>
+
+#include <boost/test/unit_test.hpp>
+
+class BlockTransactionPrevalidatorTestFixture
+{
+protected:
+    FakeBlockIndexWithHashes fakeChain;
+    CCoinsViewBacked dummyView;
+    CCoinsViewCache coins;
+    CMutableTransaction fundingTx;
+    CBlockIndex blockIndex;
+    CBlock block;
+    const CBlockRewards expectedRewards;
+    const IndexDatabaseUpdates indexingOptions;
+
+public:
+    BlockTransactionPrevalidatorTestFixture(
+        ): fakeChain(1, 1500000000, 1)
+        , dummyView()
+        , coins(&dummyView)
+        , fundingTx()
+        , blockIndex()
+        , block()
+        , expectedRewards(0, 0, 0, 0, 0, 0)
+        , indexingOptions(&blockIndex, false, false)
+    {
+        fundingTx.vin.resize(1);
+        fundingTx.vin[0].prevout = COutPoint(GetRandHash(), 0);
+        for (unsigned outputIndex = 0; outputIndex < 2 * MIN_TRANSACTIONS_FOR_PARALLEL_PREVALIDATION; ++outputIndex)
+            fundingTx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+        coins.ModifyCoins(fundingTx.GetHash())->FromTx(fundingTx, 0);
+        coins.SetBestBlock(fakeChain.activeChain->Tip()->GetBlockHash());
+
+        blockIndex.nHeight = fakeChain.activeChain->Tip()->nHeight + 1;
+
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vin[0].prevout.SetNull();
+        coinbase.vin[0].scriptSig = CScript() << OP_1 << OP_2;
+        coinbase.vout.emplace_back(0, CScript() << OP_TRUE);
+        block.vtx.push_back(coinbase);
+    }
+
+    CTransaction Spend(const COutPoint& outpoint, CAmount value = COIN / 2) const
+    {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = outpoint;
+        tx.vout.emplace_back(value, CScript() << OP_TRUE);
+        return tx;
+    }
+
+    void AddSpendsOfFundingOutputs(unsigned numberOfSpends)
+    {
+        for (unsigned outputIndex = 0; outputIndex < numberOfSpends; ++outputIndex)
+            block.vtx.push_back(Spend(COutPoint(fundingTx.GetHash(), outputIndex)));
+    }
+
+    void Prevalidate(BlockTransactionPrevalidator& prevalidator) const
+    {
+        prevalidator.Prevalidate(
+            &blockIndex, coins, *fakeChain.blockIndexByHash, MANDATORY_SCRIPT_VERIFY_FLAGS, expectedRewards, indexingOptions);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(BlockTransactionPrevalidator_tests, BlockTransactionPrevalidatorTestFixture)
+
+BOOST_AUTO_TEST_CASE(willPrevalidateTransactionsSpendingOnlyPreBlockCoins)
+{
+    AddSpendsOfFundingOutputs(MIN_TRANSACTIONS_FOR_PARALLEL_PREVALIDATION);
+
+    BlockTransactionPrevalidator prevalidator(block);
+    Prevalidate(prevalidator);
+
+    BOOST_CHECK(prevalidator.GetResult(0u) == nullptr);
+    for (unsigned transactionIndex = 1; transactionIndex < block.vtx.size(); ++transactionIndex)
+    {
+        const BlockTransactionPrevalidator::Result* result = prevalidator.GetResult(transactionIndex);
+        BOOST_REQUIRE(result != nullptr);
+        BOOST_CHECK(result->inputsAreValid);
+        BOOST_CHECK_EQUAL(result->inputAmount, COIN);
+        BOOST_CHECK_EQUAL(result->scriptChecks.size(), 1u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(willLeaveBlocksWithFewIndependentTransactionsToTheSerialPass)
+{
+    AddSpendsOfFundingOutputs(MIN_TRANSACTIONS_FOR_PARALLEL_PREVALIDATION - 1);
+
+    BlockTransactionPrevalidator prevalidator(block);
+    Prevalidate(prevalidator);
+
+    for (unsigned transactionIndex = 0; transactionIndex < block.vtx.size(); ++transactionIndex)
+        BOOST_CHECK(prevalidator.GetResult(transactionIndex) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(willLeaveTransactionsSpendingOutputsOfTheSameBlockToTheSerialPass)
+{
+    AddSpendsOfFundingOutputs(MIN_TRANSACTIONS_FOR_PARALLEL_PREVALIDATION);
+    const unsigned childIndex = block.vtx.size();
+    block.vtx.push_back(Spend(COutPoint(block.vtx[1].GetHash(), 0), COIN / 4));
+
+    BlockTransactionPrevalidator prevalidator(block);
+    Prevalidate(prevalidator);
+
+    BOOST_CHECK(prevalidator.GetResult(1u) != nullptr);
+    BOOST_CHECK(prevalidator.GetResult(childIndex) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(willLeaveInBlockDoubleSpendsToTheSerialPass)
+{
+    AddSpendsOfFundingOutputs(MIN_TRANSACTIONS_FOR_PARALLEL_PREVALIDATION);
+    const COutPoint doubleSpentOutpoint(fundingTx.GetHash(), MIN_TRANSACTIONS_FOR_PARALLEL_PREVALIDATION);
+    const unsigned firstSpendIndex = block.vtx.size();
+    block.vtx.push_back(Spend(doubleSpentOutpoint, COIN / 2));
+    const unsigned secondSpendIndex = block.vtx.size();
+    block.vtx.push_back(Spend(doubleSpentOutpoint, COIN / 3));
+
+    BlockTransactionPrevalidator prevalidator(block);
+    Prevalidate(prevalidator);
+
+    // Both spends would pass against the pre-block coins, so neither may be
+    // taken out of block order
+    BOOST_CHECK(prevalidator.GetResult(firstSpendIndex) == nullptr);
+    BOOST_CHECK(prevalidator.GetResult(secondSpendIndex) == nullptr);
+    for (unsigned transactionIndex = 1; transactionIndex < firstSpendIndex; ++transactionIndex)
+        BOOST_CHECK(prevalidator.GetResult(transactionIndex) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(willRecordInvalidInputsForTheSerialPassToReport)
+{
+    AddSpendsOfFundingOutputs(MIN_TRANSACTIONS_FOR_PARALLEL_PREVALIDATION);
+    const unsigned overspendIndex = block.vtx.size();
+    block.vtx.push_back(Spend(COutPoint(fundingTx.GetHash(), MIN_TRANSACTIONS_FOR_PARALLEL_PREVALIDATION), 2 * COIN));
+
+    BlockTransactionPrevalidator prevalidator(block);
+    Prevalidate(prevalidator);
+
+    const BlockTransactionPrevalidator::Result* result = prevalidator.GetResult(overspendIndex);
+    BOOST_REQUIRE(result != nullptr);
+    BOOST_CHECK(!result->inputsAreValid);
+    BOOST_CHECK_EQUAL(result->state.GetRejectReason(), "bad-txns-in-belowout");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,160 @@
+#include <txdb.h>
+
+#include <blockmap.h>
+#include <chain.h>
+#include <coins.h>
+#include <random.h>
+#include <script/opcodes.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+CCoins CreateCoins(unsigned numberOfOutputs, int height)
+{
+    CCoins coins;
+    coins.nVersion = 1;
+    coins.nHeight = height;
+    coins.fCoinStake = true;
+    coins.vout.resize(numberOfOutputs);
+    for (unsigned i = 0; i < numberOfOutputs; ++i) {
+        coins.vout[i].nValue = 1000 + i;
+        coins.vout[i].scriptPubKey = CScript() << OP_DUP << std::vector<unsigned char>(20, i) << OP_EQUAL;
+    }
+    return coins;
+}
+
+void WriteCoins(CCoinsViewDB& db, const uint256& txid, const CCoins& coins, const uint256& bestBlock)
+{
+    CCoinsViewCache cache(&db);
+    *cache.ModifyCoins(txid) = coins;
+    cache.SetBestBlock(bestBlock);
+    BOOST_CHECK(cache.Flush());
+}
+
+class CoinsViewDBTestFixture
+{
+public:
+    BlockMap blockMap;
+    CBlockIndex bestBlockIndex;
+    uint256 bestBlock;
+
+    CoinsViewDBTestFixture(): blockMap(), bestBlockIndex(), bestBlock(GetRandHash())
+    {
+        bestBlockIndex.nHeight = 100;
+        blockMap[bestBlock] = &bestBlockIndex;
+    }
+};
+
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(CoinsViewDB_tests, CoinsViewDBTestFixture)
+
+BOOST_AUTO_TEST_CASE(perOutpointLayoutRoundTripsCoinsAndSpends)
+{
+    CCoinsViewDB db(blockMap, 1 << 20, true, false, true);
+    BOOST_CHECK(db.UsesPerOutpointLayout());
+
+    const uint256 txid = GetRandHash();
+    const CCoins coins = CreateCoins(300, 42);
+    WriteCoins(db, txid, coins, bestBlock);
+
+    CCoins readCoins;
+    BOOST_CHECK(db.HaveCoins(txid));
+    BOOST_CHECK(db.GetCoins(txid, readCoins));
+    BOOST_CHECK(readCoins == coins);
+    BOOST_CHECK(!db.HaveCoins(GetRandHash()));
+
+    CCoins expectedCoins = coins;
+    expectedCoins.Spend(0);
+    expectedCoins.Spend(299);
+    {
+        CCoinsViewCache cache(&db);
+        {
+            CCoinsModifier modifier = cache.ModifyCoins(txid);
+            modifier->Spend(0);
+            modifier->Spend(299);
+        }
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(db.GetCoins(txid, readCoins));
+    BOOST_CHECK(readCoins == expectedCoins);
+
+    {
+        CCoinsViewCache cache(&db);
+        cache.ModifyCoins(txid)->Clear();
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(!db.HaveCoins(txid));
+}
+
+BOOST_AUTO_TEST_CASE(perOutpointLayoutErasesTrailingOutputsSpentInNestedCaches)
+{
+    CCoinsViewDB db(blockMap, 1 << 20, true, false, true);
+    const uint256 txid = GetRandHash();
+    const CCoins coins = CreateCoins(10, 42);
+    WriteCoins(db, txid, coins, bestBlock);
+
+    CCoins expectedCoins = coins;
+    CCoinsViewCache tipCache(&db);
+    BOOST_CHECK(tipCache.AccessCoins(txid) != nullptr);
+    for (unsigned outputIndex = 9; outputIndex > 5; --outputIndex) {
+        // Each spend drops the output from the end of vout
+        CCoinsViewCache blockCache(&tipCache);
+        blockCache.ModifyCoins(txid)->Spend(outputIndex);
+        BOOST_CHECK(blockCache.Flush());
+        expectedCoins.Spend(outputIndex);
+    }
+    BOOST_CHECK_EQUAL(tipCache.AccessCoins(txid)->vout.size(), 6u);
+    BOOST_CHECK(tipCache.Flush());
+
+    CCoins readCoins;
+    BOOST_CHECK(db.GetCoins(txid, readCoins));
+    BOOST_CHECK(readCoins == expectedCoins);
+    BOOST_CHECK_EQUAL(readCoins.vout.size(), 6u);
+}
+
+BOOST_AUTO_TEST_CASE(upgradeFromLegacyLayoutPreservesTheUtxoSet)
+{
+    std::map<uint256, CCoins> utxos;
+    CCoinsStats legacyStats;
+    {
+        CCoinsViewDB legacyDb(blockMap, 1 << 20, false, true);
+        BOOST_CHECK(!legacyDb.UsesPerOutpointLayout());
+        for (unsigned i = 0; i < 20; ++i) {
+            const uint256 txid = GetRandHash();
+            utxos[txid] = CreateCoins(1 + i * 17, i);
+            WriteCoins(legacyDb, txid, utxos[txid], bestBlock);
+        }
+        BOOST_CHECK(legacyDb.GetStats(legacyStats));
+        // Without the request, nothing is converted
+        BOOST_CHECK(legacyDb.UpgradeToPerOutpointLayout());
+        BOOST_CHECK(!legacyDb.UsesPerOutpointLayout());
+    }
+
+    {
+        CCoinsViewDB upgradedDb(blockMap, 1 << 20, false, false, true);
+        BOOST_CHECK(!upgradedDb.UsesPerOutpointLayout());
+        BOOST_CHECK(upgradedDb.UpgradeToPerOutpointLayout());
+        BOOST_CHECK(upgradedDb.UsesPerOutpointLayout());
+    }
+
+    // The layout is remembered by the database itself
+    CCoinsViewDB db(blockMap, 1 << 20, false, false, false);
+    BOOST_CHECK(db.UsesPerOutpointLayout());
+    for (const auto& utxo : utxos) {
+        CCoins readCoins;
+        BOOST_CHECK(db.GetCoins(utxo.first, readCoins));
+        BOOST_CHECK(readCoins == utxo.second);
+    }
+
+    CCoinsStats upgradedStats;
+    BOOST_CHECK(db.GetStats(upgradedStats));
+    BOOST_CHECK_EQUAL(upgradedStats.nTransactions, legacyStats.nTransactions);
+    BOOST_CHECK_EQUAL(upgradedStats.nTransactionOutputs, legacyStats.nTransactionOutputs);
+    BOOST_CHECK_EQUAL(upgradedStats.nTotalAmount, legacyStats.nTotalAmount);
+    BOOST_CHECK(upgradedStats.hashSerialized == legacyStats.hashSerialized);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,162 @@
+#include <CompactBlock.h>
+#include <PartiallyDownloadedBlock.h>
+
+#include <primitives/block.h>
+#include <random.h>
+#include <streams.h>
+#include <txmempool.h>
+#include <version.h>
+
+#include <boost/test/unit_test.hpp>
+
+class CompactBlockTestFixture
+{
+protected:
+    CBlock block;
+    CTxMemPool mempool;
+
+    static CTransaction CreateTransaction(unsigned inputIndex)
+    {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(GetRandHash(), inputIndex);
+        tx.vin[0].scriptSig = CScript() << OP_11;
+        tx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+        return tx;
+    }
+
+public:
+    CompactBlockTestFixture(
+        ): block()
+        , mempool()
+    {
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vin[0].prevout.SetNull();
+        coinbase.vin[0].scriptSig = CScript() << OP_1 << OP_2;
+        coinbase.vout.emplace_back(50 * COIN, CScript() << OP_TRUE);
+        block.vtx.push_back(coinbase);
+        for (unsigned index = 0; index < 5; ++index)
+            block.vtx.push_back(CreateTransaction(index));
+
+        block.nVersion = 4;
+        block.hashPrevBlock = GetRandHash();
+        block.nTime = 1500000000;
+        block.nBits = 0x207fffff;
+        block.hashMerkleRoot = block.BuildMerkleTree();
+    }
+
+    void AddToMempool(const CTransaction& tx)
+    {
+        mempool.addUnchecked(tx.GetHash(), CTxMemPoolEntry(tx, 0, 0, 0.0, 1));
+    }
+
+    static CompactBlock RoundTrip(const CompactBlock& compactBlock)
+    {
+        CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+        stream << compactBlock;
+        CompactBlock deserialized;
+        stream >> deserialized;
+        return deserialized;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(CompactBlock_tests, CompactBlockTestFixture)
+
+BOOST_AUTO_TEST_CASE(willSerializeShortIdsInSixBytes)
+{
+    const CompactBlock compactBlock(block, 42u);
+    BOOST_CHECK_EQUAL(compactBlock.prefilledTransactions.size(), 1u);
+    BOOST_CHECK_EQUAL(compactBlock.shortTxIds.size(), block.vtx.size() - 1u);
+
+    const CompactBlock deserialized = RoundTrip(compactBlock);
+    BOOST_CHECK(deserialized.header.GetHash() == block.GetHash());
+    BOOST_CHECK_EQUAL(deserialized.nonce, 42u);
+    BOOST_CHECK(deserialized.shortTxIds == compactBlock.shortTxIds);
+    BOOST_CHECK(deserialized.prefilledTransactions[0].tx.GetHash() == block.vtx[0].GetHash());
+
+    CDataStream withoutShortIds(SER_NETWORK, PROTOCOL_VERSION);
+    CompactBlock emptied = compactBlock;
+    emptied.shortTxIds.clear();
+    withoutShortIds << emptied;
+    CDataStream withShortIds(SER_NETWORK, PROTOCOL_VERSION);
+    withShortIds << compactBlock;
+    BOOST_CHECK_EQUAL(withShortIds.size() - withoutShortIds.size(), 6u * compactBlock.shortTxIds.size());
+}
+
+BOOST_AUTO_TEST_CASE(willRebuildBlockFromMempool)
+{
+    for (size_t index = 1; index < block.vtx.size(); ++index)
+        AddToMempool(block.vtx[index]);
+
+    PartiallyDownloadedBlock partialBlock;
+    BOOST_CHECK(partialBlock.InitData(RoundTrip(CompactBlock(block, GetRand(1000u))), mempool) == PartiallyDownloadedBlock::ReadStatus::OK);
+    BOOST_CHECK_EQUAL(partialBlock.GetPrefilledTransactionCount(), 1u);
+    BOOST_CHECK_EQUAL(partialBlock.GetMempoolTransactionCount(), block.vtx.size() - 1u);
+
+    std::vector<uint32_t> missingIndices;
+    partialBlock.GetMissingTransactionIndices(missingIndices);
+    BOOST_CHECK(missingIndices.empty());
+
+    CBlock rebuiltBlock;
+    BOOST_CHECK(partialBlock.FillBlock(rebuiltBlock, std::vector<CTransaction>()) == PartiallyDownloadedBlock::ReadStatus::OK);
+    BOOST_CHECK(rebuiltBlock.GetHash() == block.GetHash());
+    BOOST_CHECK_EQUAL(rebuiltBlock.vtx.size(), block.vtx.size());
+}
+
+BOOST_AUTO_TEST_CASE(willRequestTransactionsMissingFromMempool)
+{
+    AddToMempool(block.vtx[1]);
+    AddToMempool(block.vtx[3]);
+    AddToMempool(block.vtx[5]);
+
+    PartiallyDownloadedBlock partialBlock;
+    BOOST_CHECK(partialBlock.InitData(CompactBlock(block, 7u), mempool) == PartiallyDownloadedBlock::ReadStatus::OK);
+
+    std::vector<uint32_t> missingIndices;
+    partialBlock.GetMissingTransactionIndices(missingIndices);
+    BOOST_CHECK(missingIndices == std::vector<uint32_t>({2u, 4u}));
+
+    CBlock rebuiltBlock;
+    BOOST_CHECK(partialBlock.FillBlock(rebuiltBlock, std::vector<CTransaction>()) == PartiallyDownloadedBlock::ReadStatus::INVALID);
+
+    const std::vector<CTransaction> missingTransactions = {block.vtx[2], block.vtx[4]};
+    BOOST_CHECK(partialBlock.FillBlock(rebuiltBlock, missingTransactions) == PartiallyDownloadedBlock::ReadStatus::OK);
+    BOOST_CHECK(rebuiltBlock.hashMerkleRoot == block.hashMerkleRoot);
+}
+
+BOOST_AUTO_TEST_CASE(willFailToRebuildBlockWithWrongTransactions)
+{
+    PartiallyDownloadedBlock partialBlock;
+    BOOST_CHECK(partialBlock.InitData(CompactBlock(block, 7u), mempool) == PartiallyDownloadedBlock::ReadStatus::OK);
+
+    std::vector<CTransaction> missingTransactions(block.vtx.begin() + 1, block.vtx.end());
+    missingTransactions[2] = CreateTransaction(2u);
+    CBlock rebuiltBlock;
+    BOOST_CHECK(partialBlock.FillBlock(rebuiltBlock, missingTransactions) == PartiallyDownloadedBlock::ReadStatus::FAILED);
+}
+
+BOOST_AUTO_TEST_CASE(willRejectPrefilledTransactionsOutOfRange)
+{
+    CompactBlock compactBlock(block, 7u);
+    compactBlock.prefilledTransactions[0].index = block.vtx.size();
+
+    PartiallyDownloadedBlock partialBlock;
+    BOOST_CHECK(partialBlock.InitData(compactBlock, mempool) == PartiallyDownloadedBlock::ReadStatus::INVALID);
+
+    compactBlock.prefilledTransactions[0].index = 0u;
+    compactBlock.prefilledTransactions.push_back(compactBlock.prefilledTransactions[0]);
+    compactBlock.shortTxIds.pop_back();
+    BOOST_CHECK(partialBlock.InitData(compactBlock, mempool) == PartiallyDownloadedBlock::ReadStatus::INVALID);
+}
+
+BOOST_AUTO_TEST_CASE(willFallBackToFullBlockOnDuplicateShortIds)
+{
+    CompactBlock compactBlock(block, 7u);
+    compactBlock.shortTxIds[1] = compactBlock.shortTxIds[0];
+
+    PartiallyDownloadedBlock partialBlock;
+    BOOST_CHECK(partialBlock.InitData(compactBlock, mempool) == PartiallyDownloadedBlock::ReadStatus::FAILED);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,7 @@
 
 #include <amount.h>
 #include <chainparams.h>
+#include <defaultValues.h>
 #include "keystore.h"
 #include "net.h"
 #include "script/sign.h"
@@ -36,6 +37,7 @@
 
 // Tests this internal-to-main.cpp method:
 extern Settings& settings;
+extern CCriticalSection cs_main;
 
 CService ToIP(uint32_t i)
 {
@@ -135,8 +137,7 @@ BOOST_AUTO_TEST_CASE(DoS_bantime)
 
 BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
 {
-
-
+    LOCK(cs_main);
 
     CKey key;
     key.MakeNewKey(true);
@@ -217,4 +218,29 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
 
 }
 
+BOOST_AUTO_TEST_CASE(DoS_orphansExpireWithoutNewOrphansArriving)
+{
+    LOCK(cs_main);
+
+    const int64_t startTime = 1600000000;
+    SetMockTime(startTime);
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(GetRandHash(), 0);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1*CENT;
+    BOOST_CHECK(AddOrphanTx(tx, 0));
+
+    SetMockTime(startTime + ORPHAN_TRANSACTION_EXPIRY - 1);
+    BOOST_CHECK_EQUAL(EraseExpiredOrphans(), 0u);
+    BOOST_CHECK_EQUAL(OrphanTotalCount(), 1u);
+
+    SetMockTime(startTime + ORPHAN_TRANSACTION_EXPIRY);
+    BOOST_CHECK_EQUAL(EraseExpiredOrphans(), 1u);
+    BOOST_CHECK(OrphanMapsAreEmpty());
+
+    SetMockTime(0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -43,6 +43,11 @@ public:
         return *(fakeBlockIndexWithHashes_->activeChain);
     }
 
+    void rewindActiveChainTo(CBlockIndex* newTip)
+    {
+        fakeBlockIndexWithHashes_->activeChain->SetTip(newTip);
+    }
+
     static StakingData fromBlockHash(const uint256& blockhash)
     {
         StakingData stakingData;
@@ -157,4 +162,26 @@ BOOST_AUTO_TEST_CASE(willGetEarliestStakeModifierSetThatIsOutsideTheSelectionInt
     }
 }
 
+BOOST_AUTO_TEST_CASE(willNotReuseASelectedStakeModifierOnceItsBlockLeftTheActiveChain)
+{
+    Init(200); // Initialize to 200 blocks;
+    const CBlockIndex* chainTip = getActiveChain().Tip();
+    CBlockIndex* blockIndexWithStakeModifierSet = const_cast<CBlockIndex*>(chainTip->GetAncestor(150));
+    const CBlockIndex* oldBlockIndex = blockIndexWithStakeModifierSet->GetAncestor(100);
+
+    uint64_t stakeModifier = 0x26929c2;
+    blockIndexWithStakeModifierSet->SetStakeModifier(stakeModifier,true);
+    for(unsigned repetition = 0; repetition < 2; ++repetition)
+    {
+        std::pair<uint64_t,bool> stakeModifierQuery = stakeModifierService_->getStakeModifier(fromBlockHash(oldBlockIndex->GetBlockHash()));
+        BOOST_CHECK(stakeModifierQuery.second);
+        BOOST_CHECK_EQUAL(stakeModifierQuery.first, stakeModifier);
+    }
+
+    rewindActiveChainTo(blockIndexWithStakeModifierSet->pprev);
+    std::pair<uint64_t,bool> stakeModifierQuery = stakeModifierService_->getStakeModifier(fromBlockHash(oldBlockIndex->GetBlockHash()));
+    BOOST_CHECK(stakeModifierQuery.second);
+    BOOST_CHECK_EQUAL(stakeModifierQuery.first, uint64_t(0));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,59 @@
+#include <LotteryCoinstakeScriptPool.h>
+
+#include <LotteryCoinstakes.h>
+#include <random.h>
+#include <script/opcodes.h>
+#include <script/script.h>
+#include <streams.h>
+#include <clientversion.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+CScript CreatePaymentScript(unsigned char index)
+{
+    return CScript() << OP_DUP << std::vector<unsigned char>(20, index) << OP_EQUAL;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(LotteryCoinstakeScriptPool_tests)
+
+BOOST_AUTO_TEST_CASE(willShareEqualScriptsAndReleaseUnreferencedOnes)
+{
+    LotteryCoinstakeScriptPool pool;
+    std::shared_ptr<const CScript> firstScript = pool.Intern(CreatePaymentScript(1));
+    std::shared_ptr<const CScript> secondScript = pool.Intern(CreatePaymentScript(2));
+    BOOST_CHECK(pool.Intern(CreatePaymentScript(1)) == firstScript);
+    BOOST_CHECK(firstScript != secondScript);
+    BOOST_CHECK_EQUAL(pool.size(), 2u);
+
+    const size_t usageWithBothScripts = pool.DynamicMemoryUsage();
+    secondScript.reset();
+    BOOST_CHECK(pool.DynamicMemoryUsage() < usageWithBothScripts);
+    BOOST_CHECK(*pool.Intern(CreatePaymentScript(2)) == CreatePaymentScript(2));
+}
+
+BOOST_AUTO_TEST_CASE(willSerializeInternedWinnersInTheirExpandedForm)
+{
+    LotteryCoinstakes coinstakes;
+    for(unsigned char index = 0; index < 11; ++index)
+        coinstakes.emplace_back(GetRandHash(), CreatePaymentScript(index % 3));
+    const LotteryCoinstakeData data(42, coinstakes);
+
+    CDataStream internedStream(SER_DISK, CLIENT_VERSION);
+    internedStream << data;
+    CDataStream expandedStream(SER_DISK, CLIENT_VERSION);
+    expandedStream << true << coinstakes << 42;
+    BOOST_CHECK(internedStream.str() == expandedStream.str());
+
+    LotteryCoinstakeData readData;
+    internedStream >> readData;
+    BOOST_CHECK_EQUAL(readData.height(), 42);
+    BOOST_CHECK(readData.getLotteryCoinstakes() == coinstakes);
+    BOOST_CHECK(readData.storage->front().second == data.storage->front().second);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
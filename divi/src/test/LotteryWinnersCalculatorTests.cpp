@@ -111,7 +111,7 @@ public:
         }
     }
 
-    const LotteryCoinstakes& getLotteryCoinstakes(int blockHeight) const
+    LotteryCoinstakes getLotteryCoinstakes(int blockHeight) const
     {
         return fakeBlockIndexWithHashes_->activeChain->operator[](blockHeight)->vLotteryWinnersCoinstakes.getLotteryCoinstakes();
     }
@@ -233,4 +233,61 @@ BOOST_AUTO_TEST_CASE(willRemoveLowestScoringDuplicateIfNewWinnersAreAvailable)
         }
     }
 }
+
+BOOST_AUTO_TEST_CASE(willKeepWinnersSortedByTheirScoreAcrossLotteryCycles)
+{
+    SetDefaultLotteryStartAndCycleLength(100, 20);
+    InitializeChainToFixedBlockCount(161,unixTimestampForDec31stMidnight+1);
+
+    UpdateNextLotteryBlocks(101,constructDistinctDummyScript());
+    for(unsigned count = 0; count < 60; ++count)
+    {
+        UpdateNextLotteryBlocks(1,constructDistinctDummyScript());
+    }
+
+    for(int blockHeight = 101; blockHeight < 161; ++blockHeight)
+    {
+        const LotteryCoinstakes& coinstakes = getLotteryCoinstakes(blockHeight);
+        if(coinstakes.empty()) continue;
+        const uint256 lastLotteryBlockHash = calculator_->GetLastLotteryBlockIndexBeforeHeight(blockHeight)->GetBlockHash();
+        const RankedScoreAwareCoinstakes scores =
+            LotteryWinnersCalculator::computeRankedScoreAwareCoinstakes(lastLotteryBlockHash, coinstakes);
+        for(unsigned index = 1; index < coinstakes.size(); ++index)
+        {
+            BOOST_CHECK(scores.find(coinstakes[index-1].first)->second.score > scores.find(coinstakes[index].first)->second.score);
+        }
+    }
+    BOOST_CHECK_EQUAL(getLotteryCoinstakes(160-1).size(),11u);
+}
+
+BOOST_AUTO_TEST_CASE(willReuseCachedScoresUntilTheTipEntersANewLotteryCycle)
+{
+    SetDefaultLotteryStartAndCycleLength(100, 20);
+    InitializeChainToFixedBlockCount(131,unixTimestampForDec31stMidnight+1);
+
+    UpdateNextLotteryBlocks(101,constructDistinctDummyScript());
+    for(unsigned count = 0; count < 10; ++count)
+    {
+        UpdateNextLotteryBlocks(1,constructDistinctDummyScript());
+    }
+    const uint256 firstLotteryBlockHash = calculator_->GetLastLotteryBlockIndexBeforeHeight(111)->GetBlockHash();
+    BOOST_CHECK_EQUAL(calculator_->GetCachedLotteryScoreCount(firstLotteryBlockHash),10u);
+
+    // Ranking the same coinstakes again is served from the cache
+    const LotteryCoinstakes coinstakes = getLotteryCoinstakes(110);
+    LotteryCoinstakes rerankedCoinstakes = coinstakes;
+    calculator_->UpdateCoinstakes(111,rerankedCoinstakes);
+    BOOST_CHECK_EQUAL(calculator_->GetCachedLotteryScoreCount(firstLotteryBlockHash),10u);
+    BOOST_CHECK(rerankedCoinstakes == coinstakes);
+
+    // A tip past the next lottery block starts over with the new cycle's scores
+    for(unsigned count = 0; count < 11; ++count)
+    {
+        UpdateNextLotteryBlocks(1,constructDistinctDummyScript());
+    }
+    const uint256 secondLotteryBlockHash = calculator_->GetLastLotteryBlockIndexBeforeHeight(121)->GetBlockHash();
+    BOOST_CHECK(secondLotteryBlockHash != firstLotteryBlockHash);
+    BOOST_CHECK_EQUAL(calculator_->GetCachedLotteryScoreCount(firstLotteryBlockHash),0u);
+    BOOST_CHECK_EQUAL(calculator_->GetCachedLotteryScoreCount(secondLotteryBlockHash),1u);
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+#include <MempoolDB.h>
+
+#include <ChainstateManager.h>
+#include <coins.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <Settings.h>
+#include <txmempool.h>
+#include <util.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+extern Settings& settings;
+
+class MempoolDBTestFixture
+{
+protected:
+    const boost::filesystem::path pathMempool;
+    CMutableTransaction fundingTx;
+    CTxMemPool mempool;
+
+    static bool NeverInterrupt()
+    {
+        return false;
+    }
+
+    static CTransaction Spend(const COutPoint& outpoint, CAmount value)
+    {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = outpoint;
+        tx.vout.emplace_back(value, CScript() << OP_TRUE);
+        return tx;
+    }
+
+public:
+    MempoolDBTestFixture(
+        ): pathMempool(GetTempPath() / boost::filesystem::unique_path("mempool_%%%%%%%%.dat"))
+        , fundingTx()
+        , mempool()
+    {
+        // The test transactions pay to OP_TRUE, which is not a standard output
+        settings.SetParameter("-acceptnonstandard", "1");
+
+        fundingTx.vin.resize(1);
+        fundingTx.vin[0].prevout = COutPoint(GetRandHash(), 0);
+        fundingTx.vout.emplace_back(10 * COIN, CScript() << OP_TRUE);
+        fundingTx.vout.emplace_back(10 * COIN, CScript() << OP_TRUE);
+        ChainstateManager::Reference chainstate;
+        chainstate->CoinsTip().ModifyCoins(fundingTx.GetHash())->FromTx(fundingTx, 0);
+    }
+    ~MempoolDBTestFixture()
+    {
+        settings.ForceRemoveArg("-acceptnonstandard");
+        boost::filesystem::remove(pathMempool);
+    }
+
+    int64_t GetEntryTime(const CTxMemPool& pool, const uint256& hash) const
+    {
+        LOCK(pool.cs);
+        const auto it = pool.mapTx.find(hash);
+        BOOST_REQUIRE(it != pool.mapTx.end());
+        return it->GetTime();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(MempoolDB_tests, MempoolDBTestFixture)
+
+BOOST_AUTO_TEST_CASE(willLoadNothingWithoutADump)
+{
+    BOOST_CHECK(!boost::filesystem::exists(pathMempool));
+    BOOST_CHECK(MempoolDB(pathMempool).Load(mempool, &NeverInterrupt));
+    BOOST_CHECK_EQUAL(mempool.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(willRestoreDumpedTransactionsWithTheirTimesAndFeeDeltas)
+{
+    const CTransaction parent = Spend(COutPoint(fundingTx.GetHash(), 0), 9 * COIN);
+    const CTransaction child = Spend(COutPoint(parent.GetHash(), 0), 8 * COIN);
+    const CTransaction unrelated = Spend(COutPoint(fundingTx.GetHash(), 1), 9 * COIN);
+    mempool.addUnchecked(parent.GetHash(), CTxMemPoolEntry(parent, COIN, 2000, 0.0, 1));
+    mempool.addUnchecked(child.GetHash(), CTxMemPoolEntry(child, COIN, 1000, 0.0, 1));
+    mempool.addUnchecked(unrelated.GetHash(), CTxMemPoolEntry(unrelated, COIN, 3000, 0.0, 1));
+    mempool.PrioritiseTransaction(unrelated.GetHash(), 12345);
+    BOOST_CHECK(MempoolDB(pathMempool).Write(mempool));
+
+    CTxMemPool restoredMempool;
+    BOOST_CHECK(MempoolDB(pathMempool).Load(restoredMempool, &NeverInterrupt));
+    BOOST_CHECK_EQUAL(restoredMempool.size(), 3u);
+    BOOST_CHECK(restoredMempool.exists(parent.GetHash()));
+    BOOST_CHECK(restoredMempool.exists(child.GetHash()));
+    BOOST_CHECK(restoredMempool.exists(unrelated.GetHash()));
+    BOOST_CHECK_EQUAL(GetEntryTime(restoredMempool, child.GetHash()), 1000);
+    BOOST_CHECK_EQUAL(GetEntryTime(restoredMempool, parent.GetHash()), 2000);
+    BOOST_CHECK_EQUAL(GetEntryTime(restoredMempool, unrelated.GetHash()), 3000);
+
+    std::map<uint256, CAmount> feeDeltas;
+    restoredMempool.queryFeeDeltas(feeDeltas);
+    BOOST_CHECK_EQUAL(feeDeltas.size(), 1u);
+    BOOST_CHECK_EQUAL(feeDeltas[unrelated.GetHash()], 12345);
+}
+
+BOOST_AUTO_TEST_CASE(willSkipTransactionsThatNoLongerFitTheChain)
+{
+    const CTransaction spendsUnknownCoin = Spend(COutPoint(GetRandHash(), 0), COIN);
+    const CTransaction valid = Spend(COutPoint(fundingTx.GetHash(), 0), 9 * COIN);
+    mempool.addUnchecked(spendsUnknownCoin.GetHash(), CTxMemPoolEntry(spendsUnknownCoin, 0, 1000, 0.0, 1));
+    mempool.addUnchecked(valid.GetHash(), CTxMemPoolEntry(valid, COIN, 1000, 0.0, 1));
+    BOOST_CHECK(MempoolDB(pathMempool).Write(mempool));
+
+    CTxMemPool restoredMempool;
+    BOOST_CHECK(MempoolDB(pathMempool).Load(restoredMempool, &NeverInterrupt));
+    BOOST_CHECK(!restoredMempool.exists(spendsUnknownCoin.GetHash()));
+    BOOST_CHECK(restoredMempool.exists(valid.GetHash()));
+}
+
+BOOST_AUTO_TEST_CASE(willRejectACorruptDump)
+{
+    {
+        boost::filesystem::ofstream file(pathMempool);
+        file << "not a mempool dump";
+    }
+    BOOST_CHECK(!MempoolDB(pathMempool).Load(mempool, &NeverInterrupt));
+    BOOST_CHECK_EQUAL(mempool.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,70 @@
+#include <NodeStateRegistry.h>
+
+#include <addrman.h>
+#include <blockmap.h>
+#include <chain.h>
+#include <defaultValues.h>
+#include <NodeState.h>
+#include <random.h>
+#include <FakeBlockIndexChain.h>
+
+#include <boost/test/unit_test.hpp>
+
+class NodeStateRegistryTestFixture
+{
+protected:
+    FakeBlockIndexWithHashes fakeChain;
+    CAddrMan addressManager;
+    CNodeState nodeState;
+
+public:
+    NodeStateRegistryTestFixture(
+        ): fakeChain(MAX_REQUESTED_COMPACT_BLOCKS, 1500000000, 1)
+        , addressManager()
+        , nodeState(0, addressManager)
+    {
+    }
+
+    void RequestCompactBlocksUpToTheLimit()
+    {
+        for (unsigned requestCount = 0; requestCount < MAX_REQUESTED_COMPACT_BLOCKS; ++requestCount)
+            BOOST_REQUIRE(RecordCompactBlockRequest(*fakeChain.blockIndexByHash, &nodeState, GetRandHash()));
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(NodeStateRegistry_tests, NodeStateRegistryTestFixture)
+
+BOOST_AUTO_TEST_CASE(willOnlyAcceptRequestedCompactBlocksOnce)
+{
+    const uint256 requestedBlock = GetRandHash();
+    BOOST_CHECK(RecordCompactBlockRequest(*fakeChain.blockIndexByHash, &nodeState, requestedBlock));
+
+    BOOST_CHECK(!TakeCompactBlockRequest(&nodeState, GetRandHash()));
+    BOOST_CHECK(TakeCompactBlockRequest(&nodeState, requestedBlock));
+    BOOST_CHECK(!TakeCompactBlockRequest(&nodeState, requestedBlock));
+}
+
+BOOST_AUTO_TEST_CASE(willNotRecordMoreThanTheLimitOfOpenRequests)
+{
+    RequestCompactBlocksUpToTheLimit();
+    const uint256 blockOverTheLimit = GetRandHash();
+    BOOST_CHECK(!RecordCompactBlockRequest(*fakeChain.blockIndexByHash, &nodeState, blockOverTheLimit));
+    BOOST_CHECK(!TakeCompactBlockRequest(&nodeState, blockOverTheLimit));
+}
+
+BOOST_AUTO_TEST_CASE(willDropRequestsForBlocksReceivedOtherwiseWhenFull)
+{
+    const CBlockIndex* tip = fakeChain.activeChain->Tip();
+    BOOST_CHECK(RecordCompactBlockRequest(*fakeChain.blockIndexByHash, &nodeState, tip->GetBlockHash()));
+    for (unsigned requestCount = 1; requestCount < MAX_REQUESTED_COMPACT_BLOCKS; ++requestCount)
+        BOOST_REQUIRE(RecordCompactBlockRequest(*fakeChain.blockIndexByHash, &nodeState, GetRandHash()));
+    BOOST_CHECK(!RecordCompactBlockRequest(*fakeChain.blockIndexByHash, &nodeState, GetRandHash()));
+
+    fakeChain.blockIndexByHash->find(tip->GetBlockHash())->second->nStatus |= BLOCK_HAVE_DATA;
+    const uint256 nextBlock = GetRandHash();
+    BOOST_CHECK(RecordCompactBlockRequest(*fakeChain.blockIndexByHash, &nodeState, nextBlock));
+    BOOST_CHECK(!TakeCompactBlockRequest(&nodeState, tip->GetBlockHash()));
+    BOOST_CHECK(TakeCompactBlockRequest(&nodeState, nextBlock));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
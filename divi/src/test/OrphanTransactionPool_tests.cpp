@@ -0,0 +1,136 @@
+#include <OrphanTransactionPool.h>
+
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/opcodes.h>
+#include <script/script.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+CTransaction CreateTransactionSpending(const std::vector<COutPoint>& outpoints, unsigned numberOfOutputs = 1u)
+{
+    CMutableTransaction tx;
+    for (const COutPoint& outpoint : outpoints) {
+        tx.vin.emplace_back(outpoint);
+        tx.vin.back().scriptSig << OP_1;
+    }
+    tx.vout.resize(numberOfOutputs);
+    for (CTxOut& output : tx.vout) {
+        output.nValue = 1000;
+        output.scriptPubKey = CScript() << OP_TRUE;
+    }
+    return tx;
+}
+
+CTransaction CreateTransactionSpending(const COutPoint& outpoint, unsigned numberOfOutputs = 1u)
+{
+    return CreateTransactionSpending(std::vector<COutPoint>(1, outpoint), numberOfOutputs);
+}
+
+unsigned SerializedSize(const CTransaction& tx)
+{
+    return tx.GetSerializeSize(SER_NETWORK, CTransaction::CURRENT_VERSION);
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(OrphanTransactionPool_tests)
+
+BOOST_AUTO_TEST_CASE(willQueueOnlyTheOrphansSpendingOutputsOfTheAcceptedParent)
+{
+    OrphanTransactionPool pool(5000u, 100000u, 1200);
+    const CTransaction parent = CreateTransactionSpending(COutPoint(GetRandHash(), 0), 3u);
+    const CTransaction firstChild = CreateTransactionSpending(COutPoint(parent.GetHash(), 0));
+    const CTransaction secondChild = CreateTransactionSpending(COutPoint(parent.GetHash(), 2));
+    const CTransaction unrelated = CreateTransactionSpending(COutPoint(GetRandHash(), 0));
+    BOOST_CHECK(pool.Add(firstChild, 1, 0));
+    BOOST_CHECK(pool.Add(secondChild, 2, 0));
+    BOOST_CHECK(pool.Add(unrelated, 1, 0));
+    BOOST_CHECK(!pool.Add(unrelated, 1, 0));
+    BOOST_CHECK(!pool.HasQueuedForResolution());
+
+    pool.QueueChildrenForResolution(parent);
+    std::vector<OrphanTransactionPool::Orphan> orphans;
+    pool.TakeQueuedForResolution(1u, orphans);
+    BOOST_CHECK_EQUAL(orphans.size(), 1u);
+    BOOST_CHECK(pool.HasQueuedForResolution());
+    std::set<uint256> resolvedHashes;
+    resolvedHashes.insert(orphans[0].tx.GetHash());
+    pool.TakeQueuedForResolution(10u, orphans);
+    BOOST_CHECK_EQUAL(orphans.size(), 1u);
+    resolvedHashes.insert(orphans[0].tx.GetHash());
+    BOOST_CHECK(!pool.HasQueuedForResolution());
+
+    const std::set<uint256> expectedHashes = {firstChild.GetHash(), secondChild.GetHash()};
+    BOOST_CHECK(resolvedHashes == expectedHashes);
+    // Taking orphans off the queue leaves them in the pool
+    BOOST_CHECK_EQUAL(pool.Size(), 3u);
+
+    // Erased orphans are not handed out anymore
+    pool.QueueChildrenForResolution(parent);
+    BOOST_CHECK(pool.Erase(firstChild.GetHash()));
+    pool.TakeQueuedForResolution(10u, orphans);
+    BOOST_CHECK_EQUAL(orphans.size(), 1u);
+    BOOST_CHECK(orphans[0].tx.GetHash() == secondChild.GetHash());
+    BOOST_CHECK_EQUAL(orphans[0].fromPeer, 2);
+}
+
+BOOST_AUTO_TEST_CASE(willLimitTheBytesKeptFromEachPeer)
+{
+    const CTransaction firstOrphan = CreateTransactionSpending(COutPoint(GetRandHash(), 0));
+    const unsigned orphanSize = SerializedSize(firstOrphan);
+    OrphanTransactionPool pool(5000u, 2u * orphanSize, 1200);
+
+    BOOST_CHECK(pool.Add(firstOrphan, 1, 0));
+    BOOST_CHECK(pool.Add(CreateTransactionSpending(COutPoint(GetRandHash(), 0)), 1, 0));
+    BOOST_CHECK(!pool.Add(CreateTransactionSpending(COutPoint(GetRandHash(), 0)), 1, 0));
+    BOOST_CHECK_EQUAL(pool.BytesFromPeer(1), 2u * orphanSize);
+
+    // Other peers have their own quota, and erasing frees it up again
+    BOOST_CHECK(pool.Add(CreateTransactionSpending(COutPoint(GetRandHash(), 0)), 2, 0));
+    BOOST_CHECK(pool.Erase(firstOrphan.GetHash()));
+    BOOST_CHECK_EQUAL(pool.BytesFromPeer(1), orphanSize);
+    BOOST_CHECK(pool.Add(CreateTransactionSpending(COutPoint(GetRandHash(), 0)), 1, 0));
+
+    BOOST_CHECK_EQUAL(pool.EraseForPeer(1), 2u);
+    BOOST_CHECK_EQUAL(pool.BytesFromPeer(1), 0u);
+    BOOST_CHECK_EQUAL(pool.Size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(willRejectOrphansLargerThanTheMaximumSize)
+{
+    std::vector<COutPoint> outpoints;
+    for (unsigned n = 0; n < 200; ++n)
+        outpoints.emplace_back(GetRandHash(), n);
+    const CTransaction largeOrphan = CreateTransactionSpending(outpoints);
+    OrphanTransactionPool pool(SerializedSize(largeOrphan) - 1u, 1000000u, 1200);
+    BOOST_CHECK(!pool.Add(largeOrphan, 1, 0));
+    BOOST_CHECK(pool.IsEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(willEraseOrphansOnceTheyExpire)
+{
+    OrphanTransactionPool pool(5000u, 100000u, 1200);
+    const CTransaction parent = CreateTransactionSpending(COutPoint(GetRandHash(), 0));
+    const CTransaction olderOrphan = CreateTransactionSpending(COutPoint(parent.GetHash(), 0));
+    const CTransaction newerOrphan = CreateTransactionSpending(COutPoint(GetRandHash(), 0));
+    BOOST_CHECK(pool.Add(olderOrphan, 1, 1000));
+    BOOST_CHECK(pool.Add(newerOrphan, 1, 1500));
+
+    BOOST_CHECK_EQUAL(pool.EraseExpired(2199), 0u);
+    BOOST_CHECK_EQUAL(pool.EraseExpired(2200), 1u);
+    BOOST_CHECK(!pool.IsKnown(olderOrphan.GetHash()));
+    BOOST_CHECK(pool.IsKnown(newerOrphan.GetHash()));
+
+    // The outpoint index forgets the expired orphan as well
+    pool.QueueChildrenForResolution(parent);
+    BOOST_CHECK(!pool.HasQueuedForResolution());
+
+    BOOST_CHECK_EQUAL(pool.EraseExpired(2700), 1u);
+    BOOST_CHECK(pool.IsEmpty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,11 +8,15 @@
 #include <primitives/block.h>
 #include <StakingData.h>
 #include <ProofOfStakeCalculator.h>
+#include <ProofOfStakeKernelHasher.h>
+#include <hash.h>
+#include <streams.h>
 #include <I_PoSStakeModifierService.h>
 #include <ProofOfStakeGenerator.h>
 #include <I_ProofOfStakeCalculator.h>
 #include <MockPoSStakeModifierService.h>
 #include <sstream>
+#include <limits>
 
 #include <gmock/gmock.h>
 
@@ -89,6 +93,21 @@ BOOST_AUTO_TEST_CASE(willRecoverCorrectTimestampIfSuccessAndRecoverZeroOtherwise
     BOOST_CHECK(HashproofCreationResult::FailedGeneration().timestamp() == 0u);
 }
 
+BOOST_AUTO_TEST_CASE(kernelHasherMatchesTheSerializedKernel)
+{
+    const uint64_t stakeModifier = GetRand(std::numeric_limits<uint64_t>::max());
+    const unsigned coinstakeStartTime = GetRandInt(1<<30);
+    const COutPoint utxo(GetRandHash(),GetRandInt(10));
+    ProofOfStakeKernelHasher kernelHasher(stakeModifier, coinstakeStartTime, utxo);
+    for(unsigned hashproofTimestamp = coinstakeStartTime; hashproofTimestamp < coinstakeStartTime + 10; ++hashproofTimestamp)
+    {
+        CDataStream ss(SER_GETHASH, 0);
+        ss << stakeModifier << coinstakeStartTime << utxo.n << utxo.hash << hashproofTimestamp;
+        BOOST_CHECK_EQUAL(ss.size(), ProofOfStakeKernelHasher::KERNEL_SIZE);
+        BOOST_CHECK(kernelHasher.Hash(hashproofTimestamp) == Hash(ss.begin(), ss.end()));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(willEnsureBackwardCompatibilityWithMainnetHashproofs)
 {
     struct PoSTestCase
@@ -0,0 +1,119 @@
+#if defined(HAVE_CONFIG_H)
+#include "config/divi-config.h"
+#endif
+
+#include <Node.h>
+
+#include <compat.h>
+#include <SocketChannel.h>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#ifdef HAVE_SYS_EPOLL_H
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** The epoll socket handler relies on edge-triggered write readiness being
+ *  reported only after a send would have blocked.  */
+class QueuedMessageConnectionTestFixture
+{
+protected:
+    int sockets[2];
+    int epollFd;
+    SocketChannel channel;
+    const bool fSuccessfullyConnected;
+    CommunicationLogger dataLogger;
+    QueuedMessageConnection connection;
+    const std::vector<unsigned char> payload;
+
+public:
+    QueuedMessageConnectionTestFixture(
+        ): sockets{INVALID_SOCKET, INVALID_SOCKET}
+        , epollFd(epoll_create1(EPOLL_CLOEXEC))
+        , channel(CreateSocketPair(sockets))
+        , fSuccessfullyConnected(true)
+        , dataLogger()
+        , connection(channel, fSuccessfullyConnected, dataLogger)
+        , payload(64 * 1024, 0xab)
+    {
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        event.data.u64 = 0;
+        BOOST_REQUIRE(epoll_ctl(epollFd, EPOLL_CTL_ADD, sockets[0], &event) == 0);
+    }
+    ~QueuedMessageConnectionTestFixture()
+    {
+        close(epollFd);
+        close(sockets[0]);
+        close(sockets[1]);
+    }
+
+    static SOCKET CreateSocketPair(int* socketPair)
+    {
+        BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, socketPair) == 0);
+        BOOST_REQUIRE(fcntl(socketPair[0], F_SETFL, O_NONBLOCK) == 0);
+        BOOST_REQUIRE(fcntl(socketPair[1], F_SETFL, O_NONBLOCK) == 0);
+        return socketPair[0];
+    }
+
+    bool WriteReadinessIsReported()
+    {
+        struct epoll_event event;
+        return epoll_wait(epollFd, &event, 1, 0) == 1 && (event.events & EPOLLOUT);
+    }
+
+    void QueueMessages(unsigned numberOfMessages)
+    {
+        unsigned int messageDataSize = 0;
+        for (unsigned messageIndex = 0; messageIndex < numberOfMessages; ++messageIndex)
+            connection.PushMessageAndRecordDataSize(messageDataSize, "block", payload);
+    }
+
+    void DrainPeerSocket()
+    {
+        std::vector<char> buffer(payload.size());
+        while (read(sockets[1], buffer.data(), buffer.size()) > 0) {}
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(QueuedMessageConnection_tests, QueuedMessageConnectionTestFixture)
+
+BOOST_AUTO_TEST_CASE(willNotReportBlockingWhenTheQueueIsSent)
+{
+    BOOST_CHECK(WriteReadinessIsReported());
+    QueueMessages(1);
+
+    bool channelWouldBlock = true;
+    BOOST_CHECK(connection.SendQueuedData(channelWouldBlock));
+    BOOST_CHECK(!channelWouldBlock);
+    BOOST_CHECK(!connection.HasQueuedSendData());
+
+    // The socket stays writable without a new event, which is why the handler
+    // writes newly queued data without waiting for one
+    BOOST_CHECK(!WriteReadinessIsReported());
+}
+
+BOOST_AUTO_TEST_CASE(willReportBlockingUntilTheSocketTakesDataAgain)
+{
+    BOOST_CHECK(WriteReadinessIsReported());
+    QueueMessages(64);
+
+    bool channelWouldBlock = false;
+    BOOST_CHECK(connection.SendQueuedData(channelWouldBlock));
+    BOOST_CHECK(channelWouldBlock);
+    BOOST_CHECK(connection.HasQueuedSendData());
+
+    while (connection.HasQueuedSendData())
+    {
+        DrainPeerSocket();
+        BOOST_REQUIRE(WriteReadinessIsReported());
+        BOOST_CHECK(connection.SendQueuedData(channelWouldBlock));
+    }
+    BOOST_CHECK(!channelWouldBlock);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif // HAVE_SYS_EPOLL_H
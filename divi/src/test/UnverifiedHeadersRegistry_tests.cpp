@@ -0,0 +1,124 @@
+#include <UnverifiedHeadersRegistry.h>
+
+#include <chain.h>
+#include <FakeBlockIndexChain.h>
+
+#include <memory>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+const unsigned maxHeightAheadOfTip = 10;
+const unsigned maxHeadersPerNode = 3;
+const unsigned maxHeaders = 5;
+}
+
+class UnverifiedHeadersRegistryTestFixture
+{
+protected:
+    FakeBlockIndexWithHashes fakeChain;
+    std::vector<std::unique_ptr<CBlockIndex>> headers;
+    UnverifiedHeadersRegistry registry;
+
+public:
+    UnverifiedHeadersRegistryTestFixture(
+        ): fakeChain(100, 1500000000, 1)
+        , headers()
+        , registry(maxHeightAheadOfTip, maxHeadersPerNode, maxHeaders)
+    {
+    }
+
+    const CBlockIndex* createPendingHeader(int height)
+    {
+        headers.emplace_back(new CBlockIndex());
+        CBlockIndex* header = headers.back().get();
+        header->nHeight = height;
+        header->SetBlockProofPending(true);
+        return header;
+    }
+
+    const CBlockIndex* recordPendingHeader(NodeId nodeId, int height)
+    {
+        BOOST_REQUIRE(registry.CanRecordHeader(nodeId, height, *fakeChain.activeChain));
+        const CBlockIndex* header = createPendingHeader(height);
+        registry.RecordHeader(nodeId, header);
+        return header;
+    }
+
+    int tipHeight() const
+    {
+        return fakeChain.activeChain->Height();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(UnverifiedHeadersRegistry_tests, UnverifiedHeadersRegistryTestFixture)
+
+BOOST_AUTO_TEST_CASE(willOnlyAcceptHeadersWithinTheWindowAheadOfTheTip)
+{
+    BOOST_CHECK(registry.CanRecordHeader(0, tipHeight() + maxHeightAheadOfTip, *fakeChain.activeChain));
+    BOOST_CHECK(!registry.CanRecordHeader(0, tipHeight() + maxHeightAheadOfTip + 1, *fakeChain.activeChain));
+}
+
+BOOST_AUTO_TEST_CASE(willLimitTheNumberOfHeadersFromASingleNode)
+{
+    for (unsigned headerCount = 0; headerCount < maxHeadersPerNode; ++headerCount)
+        recordPendingHeader(0, tipHeight() + 1 + headerCount);
+    BOOST_CHECK(!registry.CanRecordHeader(0, tipHeight() + 1, *fakeChain.activeChain));
+    BOOST_CHECK(registry.CanRecordHeader(1, tipHeight() + 1, *fakeChain.activeChain));
+}
+
+BOOST_AUTO_TEST_CASE(willLimitTheTotalNumberOfHeaders)
+{
+    for (unsigned headerCount = 0; headerCount < maxHeaders; ++headerCount)
+        recordPendingHeader(headerCount, tipHeight() + 1);
+    BOOST_CHECK_EQUAL(registry.GetNumberOfHeaders(), maxHeaders);
+    BOOST_CHECK(!registry.CanRecordHeader(maxHeaders, tipHeight() + 1, *fakeChain.activeChain));
+}
+
+BOOST_AUTO_TEST_CASE(willForgetHeadersThatWereCheckedOrPassedByTheTip)
+{
+    CBlockIndex* checkedHeader = const_cast<CBlockIndex*>(recordPendingHeader(0, tipHeight() + 1));
+    recordPendingHeader(0, tipHeight() + 2);
+    recordPendingHeader(0, tipHeight() + 3);
+    checkedHeader->SetBlockProofPending(false);
+
+    BOOST_CHECK(registry.RemoveResolvedHeaders(*fakeChain.activeChain).empty());
+    BOOST_CHECK_EQUAL(registry.GetNumberOfHeadersFrom(0), 2u);
+
+    fakeChain.addBlocks(2, 1);
+    BOOST_CHECK(registry.RemoveResolvedHeaders(*fakeChain.activeChain).empty());
+    BOOST_CHECK_EQUAL(registry.GetNumberOfHeadersFrom(0), 1u);
+
+    fakeChain.addBlocks(1, 1);
+    BOOST_CHECK(registry.RemoveResolvedHeaders(*fakeChain.activeChain).empty());
+    BOOST_CHECK_EQUAL(registry.GetNumberOfHeadersFrom(0), 0u);
+    BOOST_CHECK_EQUAL(registry.GetNumberOfHeaders(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(willReturnTheSourcesOfHeadersThatFailedTheirStakeCheck)
+{
+    CBlockIndex* failedHeader = const_cast<CBlockIndex*>(recordPendingHeader(1, tipHeight() + 1));
+    recordPendingHeader(2, tipHeight() + 1);
+    failedHeader->nStatus |= BLOCK_FAILED_VALID;
+
+    const std::vector<NodeId> sourcesOfFailedHeaders = registry.RemoveResolvedHeaders(*fakeChain.activeChain);
+    BOOST_CHECK(sourcesOfFailedHeaders == std::vector<NodeId>(1, 1));
+    BOOST_CHECK_EQUAL(registry.GetNumberOfHeadersFrom(1), 0u);
+    BOOST_CHECK_EQUAL(registry.GetNumberOfHeadersFrom(2), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(willKeepCountingTheHeadersOfUnregisteredNodes)
+{
+    CBlockIndex* failedHeader = const_cast<CBlockIndex*>(recordPendingHeader(0, tipHeight() + 1));
+    registry.UnregisterNodeId(0);
+    BOOST_CHECK_EQUAL(registry.GetNumberOfHeadersFrom(0), 0u);
+    BOOST_CHECK_EQUAL(registry.GetNumberOfHeaders(), 1u);
+
+    failedHeader->nStatus |= BLOCK_FAILED_VALID;
+    BOOST_CHECK(registry.RemoveResolvedHeaders(*fakeChain.activeChain).empty());
+    BOOST_CHECK_EQUAL(registry.GetNumberOfHeaders(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,107 @@
+#include <checkqueue.h>
+
+#include <atomic>
+#include <vector>
+
+#include <boost/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+std::atomic<unsigned> checksRun(0);
+
+class CountingCheck
+{
+private:
+    bool result;
+
+public:
+    CountingCheck(): result(true) {}
+    explicit CountingCheck(bool resultIn): result(resultIn) {}
+
+    bool operator()()
+    {
+        ++checksRun;
+        return result;
+    }
+
+    void swap(CountingCheck& other)
+    {
+        std::swap(result, other.result);
+    }
+};
+
+class CheckQueueTestFixture
+{
+public:
+    CCheckQueue<CountingCheck> queue;
+    boost::thread_group workers;
+
+    CheckQueueTestFixture(): queue(16, 4), workers()
+    {
+        checksRun = 0;
+        for (unsigned i = 0; i < 3; i++)
+            workers.create_thread([this]() { queue.Thread(); });
+    }
+    ~CheckQueueTestFixture()
+    {
+        workers.interrupt_all();
+        workers.join_all();
+    }
+
+    void AddChecks(CCheckQueueControl<CountingCheck>& control, unsigned numberOfChecks, bool result)
+    {
+        std::vector<CountingCheck> checks(numberOfChecks, CountingCheck(result));
+        control.Add(checks);
+    }
+};
+
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(checkqueue_tests, CheckQueueTestFixture)
+
+BOOST_AUTO_TEST_CASE(allChecksAreRunAcrossManyRounds)
+{
+    for (unsigned round = 1; round <= 200; round++) {
+        const unsigned before = checksRun;
+        CCheckQueueControl<CountingCheck> control(&queue);
+        AddChecks(control, round, true);
+        AddChecks(control, 1, true);
+        BOOST_CHECK(control.Wait());
+        BOOST_CHECK_EQUAL(checksRun - before, round + 1);
+
+        CCheckQueueRoundStats stats;
+        BOOST_CHECK(control.GetRoundStats(stats));
+        BOOST_CHECK_EQUAL(stats.nChecks, round + 1);
+        BOOST_CHECK(stats.nThreads >= 1 && stats.nThreads <= 4);
+    }
+    BOOST_CHECK(queue.IsIdle());
+}
+
+BOOST_AUTO_TEST_CASE(aFailingCheckFailsOnlyItsOwnRound)
+{
+    {
+        CCheckQueueControl<CountingCheck> control(&queue);
+        AddChecks(control, 500, true);
+        AddChecks(control, 1, false);
+        AddChecks(control, 500, true);
+        BOOST_CHECK(!control.Wait());
+    }
+    BOOST_CHECK(queue.IsIdle());
+
+    CCheckQueueControl<CountingCheck> control(&queue);
+    AddChecks(control, 100, true);
+    BOOST_CHECK(control.Wait());
+}
+
+BOOST_AUTO_TEST_CASE(controlWithoutQueueSucceedsImmediately)
+{
+    CCheckQueueControl<CountingCheck> control(NULL);
+    AddChecks(control, 10, false);
+    BOOST_CHECK(control.Wait());
+    CCheckQueueRoundStats stats;
+    BOOST_CHECK(!control.GetRoundStats(stats));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
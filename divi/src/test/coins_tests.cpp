@@ -176,4 +176,97 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
     BOOST_CHECK(missed_an_entry);
 }
 
+BOOST_AUTO_TEST_CASE(coins_cache_tracks_dynamic_memory_usage)
+{
+    CCoinsViewTest base;
+    const uint256 txid = GetRandHash();
+    {
+        CCoinsViewCache writer(&base);
+        CCoinsModifier coins = writer.ModifyCoins(txid);
+        coins->nVersion = 1;
+        coins->vout.resize(20);
+        for (CTxOut& out : coins->vout) {
+            out.nValue = 1;
+            out.scriptPubKey = CScript(std::vector<unsigned char>(1000, OP_TRUE));
+        }
+    }
+
+    CCoinsViewCache cache(&base);
+    {
+        // Creating and dropping an unknown entry sizes the hash table buckets, so
+        // that from here on only the entries themselves change the usage.
+        cache.ModifyCoins(GetRandHash());
+    }
+    const size_t emptyUsage = cache.DynamicMemoryUsage();
+    const uint64_t initialMisses = cache.GetCacheMisses();
+
+    const CCoins* coins = cache.AccessCoins(txid);
+    BOOST_REQUIRE(coins != nullptr);
+    BOOST_CHECK_EQUAL(cache.GetCacheMisses(), initialMisses + 1);
+    BOOST_CHECK(coins->DynamicMemoryUsage() >= 20 * 1000);
+    BOOST_CHECK(cache.DynamicMemoryUsage() >= emptyUsage + coins->DynamicMemoryUsage());
+    const size_t entryOverhead = cache.DynamicMemoryUsage() - coins->DynamicMemoryUsage();
+
+    const uint64_t initialHits = cache.GetCacheHits();
+    cache.AccessCoins(txid);
+    BOOST_CHECK_EQUAL(cache.GetCacheHits(), initialHits + 1);
+
+    // Spending outputs releases their script buffers from the accounting.
+    const size_t usageBeforeSpend = cache.DynamicMemoryUsage();
+    {
+        CCoinsModifier modified = cache.ModifyCoins(txid);
+        for (unsigned int i = 10; i < 20; ++i)
+            modified->Spend(i);
+    }
+    BOOST_CHECK(cache.DynamicMemoryUsage() < usageBeforeSpend);
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), entryOverhead + cache.AccessCoins(txid)->DynamicMemoryUsage());
+
+    // Dirty entries survive eviction; clean ones do not.
+    BOOST_CHECK_EQUAL(cache.UncacheNonDirtyEntries(), 0u);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), emptyUsage);
+
+    BOOST_REQUIRE(cache.AccessCoins(txid) != nullptr);
+    BOOST_CHECK(cache.DynamicMemoryUsage() > emptyUsage);
+    BOOST_CHECK_EQUAL(cache.UncacheNonDirtyEntries(), 1u);
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), emptyUsage);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(prefetched_coins_are_cached_clean_and_never_override_entries)
+{
+    CCoinsViewTest base;
+    const uint256 txid = GetRandHash();
+    CCoins parentCoins;
+    parentCoins.nVersion = 1;
+    parentCoins.vout.resize(2, CTxOut(5, CScript() << OP_TRUE));
+    {
+        CCoinsViewCache writer(&base);
+        *writer.ModifyCoins(txid) = parentCoins;
+        BOOST_CHECK(writer.Flush());
+    }
+
+    CCoinsViewCache cache(&base);
+    BOOST_CHECK(!cache.HaveCoinsInCache(txid));
+    CCoins prefetched;
+    BOOST_CHECK(base.GetCoins(txid, prefetched));
+    cache.CacheCoinsFromParent(txid, prefetched);
+    BOOST_CHECK(cache.HaveCoinsInCache(txid));
+
+    const uint64_t initialMisses = cache.GetCacheMisses();
+    BOOST_REQUIRE(cache.AccessCoins(txid) != nullptr);
+    BOOST_CHECK(*cache.AccessCoins(txid) == parentCoins);
+    BOOST_CHECK_EQUAL(cache.GetCacheMisses(), initialMisses);
+
+    // A modified entry is newer than anything read from the parent
+    cache.ModifyCoins(txid)->Spend(0);
+    CCoins stale = parentCoins;
+    cache.CacheCoinsFromParent(txid, stale);
+    BOOST_CHECK(cache.AccessCoins(txid)->vout[0].IsNull());
+
+    BOOST_CHECK(cache.Flush());
+    cache.CacheCoinsFromParent(txid, stale);
+    BOOST_CHECK_EQUAL(cache.UncacheNonDirtyEntries(), 1u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -46,4 +46,28 @@ BOOST_AUTO_TEST_CASE(murmurhash3)
 #undef T
 }
 
+BOOST_AUTO_TEST_CASE(siphash)
+{
+    // Test vectors from the SipHash-2-4 reference, with key 00..0f
+    CSipHasher hasher(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL);
+    BOOST_CHECK_EQUAL(hasher.Finalize(),  0x726fdb47dd0e0e31ull);
+    static const unsigned char t0[1] = {0};
+    hasher.Write(t0, 1);
+    BOOST_CHECK_EQUAL(hasher.Finalize(),  0x74f839c593dc67fdull);
+    static const unsigned char t1[7] = {1,2,3,4,5,6,7};
+    hasher.Write(t1, 7);
+    BOOST_CHECK_EQUAL(hasher.Finalize(),  0x93f5f5799a932462ull);
+    hasher.Write(0x0F0E0D0C0B0A0908ULL);
+    BOOST_CHECK_EQUAL(hasher.Finalize(),  0x3f2acc7f57c29bdbull);
+
+    // The uint256 specialization hashes the 32 bytes of the value
+    uint256 value;
+    for (unsigned i = 0; i < value.size(); ++i)
+        value.begin()[i] = static_cast<unsigned char>(i);
+    CSipHasher byteHasher(1, 2);
+    byteHasher.Write(value.begin(), value.size());
+    BOOST_CHECK_EQUAL(SipHashUint256(1, 2, value), byteHasher.Finalize());
+    BOOST_CHECK(SipHashUint256(1, 2, value) != SipHashUint256(2, 1, value));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
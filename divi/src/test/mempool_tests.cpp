@@ -203,6 +203,31 @@ BOOST_AUTO_TEST_CASE(MempoolOutpointLookup)
     BOOST_CHECK(!viewPool.GetCoins(txChild[0].GetBareTxid(), c));
 }
 
+BOOST_AUTO_TEST_CASE(MempoolLinksParentsTheWayOutpointsAreLookedUp)
+{
+    CMutableTransaction spendsBareTxid;
+    spendsBareTxid.vin.resize(1);
+    spendsBareTxid.vin[0].scriptSig = CScript() << OP_11;
+    spendsBareTxid.vin[0].prevout = COutPoint(txParent.GetBareTxid(), 1);
+    spendsBareTxid.vout.emplace_back(COIN, CScript() << OP_11 << OP_EQUAL);
+
+    testPool.addUnchecked(txParent.GetHash(), CTxMemPoolEntry(txParent, 0, 0, 0.0, 1));
+    testPool.addUnchecked(txChild[0].GetHash(), CTxMemPoolEntry(txChild[0], 0, 0, 0.0, 1));
+    testPool.addUnchecked(spendsBareTxid.GetHash(), CTxMemPoolEntry(spendsBareTxid, 0, 0, 0.0, 1));
+    CCoinsViewMemPool viewPool(&coins, testPool);
+
+    // A parent is linked exactly when the coins view resolves the input to it
+    const CTxMemPool::txiter parentIt = testPool.mapTx.find(txParent.GetHash());
+    const CTxMemPool::txiter childIt = testPool.mapTx.find(txChild[0].GetHash());
+    const CTxMemPool::txiter bareTxidSpendIt = testPool.mapTx.find(spendsBareTxid.GetHash());
+    BOOST_CHECK(viewPool.HaveCoins(txChild[0].vin[0].prevout.hash));
+    BOOST_CHECK(testPool.GetMemPoolParents(childIt) == CTxMemPool::setEntries({parentIt}));
+    BOOST_CHECK(!viewPool.HaveCoins(spendsBareTxid.vin[0].prevout.hash));
+    BOOST_CHECK(testPool.GetMemPoolParents(bareTxidSpendIt).empty());
+    BOOST_CHECK_EQUAL(bareTxidSpendIt->GetCountWithAncestors(), 1u);
+    BOOST_CHECK_EQUAL(parentIt->GetCountWithDescendants(), 2u);
+}
+
 BOOST_AUTO_TEST_CASE(MempoolExists)
 {
     CTransaction tx;
@@ -220,4 +245,116 @@ BOOST_AUTO_TEST_CASE(MempoolExists)
     BOOST_CHECK(!testPool.existsBareTxid(txParent.GetBareTxid()));
 }
 
+BOOST_AUTO_TEST_CASE(MempoolTracksDynamicMemoryUsage)
+{
+    std::list<CTransaction> removed;
+    BOOST_CHECK_EQUAL(testPool.DynamicMemoryUsage(), 0u);
+
+    AddAll();
+    const size_t usageWithAll = testPool.DynamicMemoryUsage();
+    BOOST_CHECK(usageWithAll > 0u);
+    testPool.check(&coins, *fakeChain.blockIndexByHash);
+
+    testPool.remove(txChild[0], removed, true);
+    BOOST_CHECK(testPool.DynamicMemoryUsage() < usageWithAll);
+    testPool.check(&coins, *fakeChain.blockIndexByHash);
+
+    testPool.remove(txParent, removed, true);
+    BOOST_CHECK_EQUAL(testPool.DynamicMemoryUsage(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolTracksAncestorAndDescendantPackages)
+{
+    std::list<CTransaction> removed;
+    const CTransaction parent(txParent);
+    const CTransaction child(txChild[0]);
+    const CTransaction grandChild(txGrandChild[0]);
+    const uint64_t packageSize = ::GetSerializeSize(parent, SER_NETWORK, PROTOCOL_VERSION) +
+        ::GetSerializeSize(child, SER_NETWORK, PROTOCOL_VERSION) +
+        ::GetSerializeSize(grandChild, SER_NETWORK, PROTOCOL_VERSION);
+
+    testPool.addUnchecked(parent.GetHash(), CTxMemPoolEntry(parent, 100, 0, 0.0, 1));
+    testPool.addUnchecked(child.GetHash(), CTxMemPoolEntry(child, 200, 0, 0.0, 1));
+    testPool.addUnchecked(grandChild.GetHash(), CTxMemPoolEntry(grandChild, 400, 0, 0.0, 1));
+    testPool.check(&coins, *fakeChain.blockIndexByHash);
+
+    const CTxMemPool::txiter parentIt = testPool.mapTx.find(parent.GetHash());
+    const CTxMemPool::txiter childIt = testPool.mapTx.find(child.GetHash());
+    const CTxMemPool::txiter grandChildIt = testPool.mapTx.find(grandChild.GetHash());
+    BOOST_CHECK_EQUAL(parentIt->GetCountWithDescendants(), 3u);
+    BOOST_CHECK_EQUAL(parentIt->GetSizeWithDescendants(), packageSize);
+    BOOST_CHECK_EQUAL(parentIt->GetModFeesWithDescendants(), 700);
+    BOOST_CHECK_EQUAL(grandChildIt->GetCountWithAncestors(), 3u);
+    BOOST_CHECK_EQUAL(grandChildIt->GetSizeWithAncestors(), packageSize);
+    BOOST_CHECK_EQUAL(grandChildIt->GetModFeesWithAncestors(), 700);
+    BOOST_CHECK(testPool.GetMemPoolParents(childIt) == CTxMemPool::setEntries({parentIt}));
+    BOOST_CHECK(testPool.GetMemPoolChildren(childIt) == CTxMemPool::setEntries({grandChildIt}));
+
+    // Fee deltas are carried over to the packages
+    testPool.PrioritiseTransaction(child.GetHash(), 1000);
+    BOOST_CHECK_EQUAL(childIt->GetModifiedFee(), 1200);
+    BOOST_CHECK_EQUAL(parentIt->GetModFeesWithDescendants(), 1700);
+    BOOST_CHECK_EQUAL(grandChildIt->GetModFeesWithAncestors(), 1700);
+    testPool.check(&coins, *fakeChain.blockIndexByHash);
+
+    // Removing the confirmed parent leaves the others in place
+    testPool.remove(parent, removed, false);
+    BOOST_CHECK_EQUAL(childIt->GetCountWithAncestors(), 1u);
+    BOOST_CHECK_EQUAL(grandChildIt->GetCountWithAncestors(), 2u);
+    BOOST_CHECK_EQUAL(grandChildIt->GetModFeesWithAncestors(), 1600);
+    testPool.check(&coins, *fakeChain.blockIndexByHash);
+
+    // A parent coming back after its children, as in a reorg, is linked to them
+    testPool.addUnchecked(parent.GetHash(), CTxMemPoolEntry(parent, 100, 0, 0.0, 1));
+    const CTxMemPool::txiter readdedParentIt = testPool.mapTx.find(parent.GetHash());
+    BOOST_CHECK_EQUAL(readdedParentIt->GetCountWithDescendants(), 3u);
+    BOOST_CHECK_EQUAL(readdedParentIt->GetModFeesWithDescendants(), 1700);
+    BOOST_CHECK_EQUAL(grandChildIt->GetCountWithAncestors(), 3u);
+    BOOST_CHECK_EQUAL(grandChildIt->GetModFeesWithAncestors(), 1700);
+    testPool.check(&coins, *fakeChain.blockIndexByHash);
+
+    testPool.remove(parent, removed, true);
+    BOOST_CHECK_EQUAL(testPool.size(), 0u);
+    testPool.ClearPrioritisation(child.GetHash());
+    BOOST_CHECK_EQUAL(testPool.DynamicMemoryUsage(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolTrimEvictsLowestFeeRatePackages)
+{
+    std::list<CTransaction> removed;
+    testPool.addUnchecked(txParent.GetHash(), CTxMemPoolEntry(txParent, 1000000, 0, 0.0, 1));
+    for (int i = 0; i < 3; i++)
+    {
+        testPool.addUnchecked(txChild[i].GetHash(), CTxMemPoolEntry(txChild[i], 100 + 50000 * i, 0, 0.0, 1));
+        testPool.addUnchecked(txGrandChild[i].GetHash(), CTxMemPoolEntry(txGrandChild[i], 200000, 0, 0.0, 1));
+    }
+    BOOST_CHECK(testPool.GetMinFee(1) == CFeeRate(0));
+
+    // The cheapest child goes, together with its child
+    testPool.TrimToSize(testPool.DynamicMemoryUsage() - 1, removed);
+    BOOST_CHECK_EQUAL(removed.size(), 2u);
+    BOOST_CHECK_EQUAL(testPool.size(), 5u);
+    BOOST_CHECK(!testPool.exists(txChild[0].GetHash()));
+    BOOST_CHECK(!testPool.exists(txGrandChild[0].GetHash()));
+    BOOST_CHECK(testPool.GetMinFee(1) > CFeeRate(0));
+    testPool.check(&coins, *fakeChain.blockIndexByHash);
+    removed.clear();
+
+    // Packages are scored by the better of their own and their descendants'
+    // fee rate, and fee deltas count towards both
+    testPool.PrioritiseTransaction(txChild[1].GetHash(), 1000000);
+    testPool.TrimToSize(testPool.DynamicMemoryUsage() - 1, removed);
+    BOOST_CHECK_EQUAL(removed.size(), 2u);
+    BOOST_CHECK(testPool.exists(txChild[1].GetHash()));
+    BOOST_CHECK(!testPool.exists(txChild[2].GetHash()));
+    testPool.check(&coins, *fakeChain.blockIndexByHash);
+    removed.clear();
+
+    testPool.TrimToSize(0, removed);
+    BOOST_CHECK_EQUAL(removed.size(), 3u);
+    BOOST_CHECK_EQUAL(testPool.size(), 0u);
+    testPool.ClearPrioritisation(txChild[1].GetHash());
+    BOOST_CHECK_EQUAL(testPool.DynamicMemoryUsage(), 0u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
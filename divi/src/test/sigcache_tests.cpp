@@ -0,0 +1,58 @@
+#include <script/sigcache.h>
+
+#include <key.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(sigcache_tests)
+
+BOOST_AUTO_TEST_CASE(repeatedValidSignatureIsServedFromTheCache)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const uint256 sighash = GetRandHash();
+    std::vector<unsigned char> signature;
+    BOOST_REQUIRE(key.Sign(sighash, signature));
+
+    const CTransaction tx;
+    const CachingTransactionSignatureChecker checker(&tx, 0);
+    const SignatureCacheStats before = GetSignatureCacheStats();
+    BOOST_CHECK(before.capacity > 0);
+
+    BOOST_CHECK(checker.VerifySignature(signature, key.GetPubKey(), sighash));
+    BOOST_CHECK(checker.VerifySignature(signature, key.GetPubKey(), sighash));
+
+    const SignatureCacheStats after = GetSignatureCacheStats();
+    BOOST_CHECK_EQUAL(after.lookups - before.lookups, 2u);
+    BOOST_CHECK_EQUAL(after.hits - before.hits, 1u);
+    BOOST_CHECK_EQUAL(after.insertions - before.insertions, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(invalidSignaturesAreNeverCached)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    CKey otherKey;
+    otherKey.MakeNewKey(true);
+    const uint256 sighash = GetRandHash();
+    std::vector<unsigned char> signature;
+    BOOST_REQUIRE(key.Sign(sighash, signature));
+
+    const CTransaction tx;
+    const CachingTransactionSignatureChecker checker(&tx, 0);
+    const SignatureCacheStats before = GetSignatureCacheStats();
+
+    BOOST_CHECK(checker.VerifySignature(signature, key.GetPubKey(), sighash));
+    BOOST_CHECK(!checker.VerifySignature(signature, otherKey.GetPubKey(), sighash));
+    BOOST_CHECK(!checker.VerifySignature(signature, key.GetPubKey(), GetRandHash()));
+    BOOST_CHECK(!checker.VerifySignature(signature, otherKey.GetPubKey(), sighash));
+
+    const SignatureCacheStats after = GetSignatureCacheStats();
+    BOOST_CHECK_EQUAL(after.hits - before.hits, 0u);
+    BOOST_CHECK_EQUAL(after.insertions - before.insertions, 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
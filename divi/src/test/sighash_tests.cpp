@@ -24,6 +24,8 @@
 #include <script/SignatureCheckers.h>
 #include <script/scriptandsigflags.h>
 #include <hash.h>
+#include <tinyformat.h>
+#include <utiltime.h>
 
 static FastRandomContext random_source;
 auto insecure_rand = []() -> uint32_t { return random_source.rand32();};
@@ -151,6 +153,9 @@ BOOST_AUTO_TEST_CASE(sighash_test)
         uint256 sh, sho;
         sho = SignatureHashOld(scriptCode, txTo, nIn, nHashType);
         sh = SignatureHash(scriptCode, txTo, nIn, nHashType);
+        const CTransaction tx(txTo);
+        const PrecomputedTransactionData txdata(tx);
+        BOOST_CHECK(SignatureHash(scriptCode, tx, nIn, nHashType, &txdata) == sho);
         #if defined(PRINT_SIGHASH_JSON)
         CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
         ss << txTo;
@@ -173,6 +178,40 @@ BOOST_AUTO_TEST_CASE(sighash_test)
     #endif
 }
 
+// Micro-benchmark: hashing every input of an N input transaction with SIGHASH_ALL
+// re-serializes the transaction N times, unless the invariant parts are precomputed
+BOOST_AUTO_TEST_CASE(sighash_precomputed_scaling)
+{
+    seed_insecure_rand(false);
+    const CScript scriptCode = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0x42) << OP_EQUALVERIFY << OP_CHECKSIG;
+    for (unsigned int nInputs = 10; nInputs <= 1000; nInputs *= 10) {
+        CMutableTransaction txTo;
+        RandomTransaction(txTo, false);
+        txTo.vin.resize(nInputs);
+        for (unsigned int i = 0; i < nInputs; i++) {
+            txTo.vin[i].prevout = COutPoint(GetRandHash(), i);
+            txTo.vin[i].scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+        }
+        const CTransaction tx(txTo);
+
+        int64_t nStart = GetTimeMicros();
+        std::vector<uint256> genericHashes;
+        for (unsigned int i = 0; i < nInputs; i++)
+            genericHashes.push_back(SignatureHash(scriptCode, tx, i, SIGHASH_ALL));
+        const int64_t nGenericTime = GetTimeMicros() - nStart;
+
+        nStart = GetTimeMicros();
+        const PrecomputedTransactionData txdata(tx);
+        std::vector<uint256> precomputedHashes;
+        for (unsigned int i = 0; i < nInputs; i++)
+            precomputedHashes.push_back(SignatureHash(scriptCode, tx, i, SIGHASH_ALL, &txdata));
+        const int64_t nPrecomputedTime = GetTimeMicros() - nStart;
+
+        BOOST_CHECK(genericHashes == precomputedHashes);
+        BOOST_TEST_MESSAGE(strprintf("sighash of %u inputs: generic %dus, precomputed %dus", nInputs, nGenericTime, nPrecomputedTime));
+    }
+}
+
 // Goal: check that SignatureHash generates correct hash
 BOOST_AUTO_TEST_CASE(sighash_from_data)
 {
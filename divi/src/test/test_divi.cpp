@@ -13,6 +13,7 @@
 #include <random.h>
 #include <Settings.h>
 #include <tinyformat.h>
+#include <BlockTransactionPrevalidator.h>
 #include <TransactionInputChecker.h>
 #include <util.h>
 #include <utiltime.h>
@@ -56,6 +57,7 @@ struct TestingSetup {
         GetChainExtensionService().connectGenesisBlock();
         TransactionInputChecker::SetScriptCheckingThreadCount(3);
         TransactionInputChecker::InitializeScriptCheckingThreads(threadGroup);
+        BlockTransactionPrevalidator::InitializeThreads(threadGroup);
         RegisterNodeSignals();
         EnableUnitTestSignals();
     }
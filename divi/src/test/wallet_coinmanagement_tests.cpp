@@ -16,8 +16,12 @@
 #include <blockmap.h>
 #include <test/FakeWallet.h>
 #include <StakableCoin.h>
+#include <I_StakingCoinSelector.h>
+#include <NotificationInterface.h>
 #include <I_MerkleTxConfirmationNumberCalculator.h>
 
+extern CCriticalSection cs_main;
+
 class WalletCoinManagementTestFixture
 {
 public:
@@ -444,4 +448,47 @@ BOOST_AUTO_TEST_CASE(willEnsureStakingBalanceAndTotalBalanceAgreeEvenIfTxsBelong
     BOOST_CHECK_EQUAL_MESSAGE(stakableCoins.size(),2,"Missing coins in the stakable set");
 }
 
+BOOST_AUTO_TEST_CASE(willRefreshStakableCoinsAfterReceivingSpendingAndNewBlocks)
+{
+    LOCK(cs_main);
+    MainNotificationSignals notificationSignals;
+    wallet.RegisterWith(notificationSignals);
+    CScript normalScript = GetScriptForDestination(walletKeyForTests.GetID());
+    std::set<StakableCoin> stakableCoins;
+    StakeCoinsSelectionValidity validity;
+    BOOST_CHECK(wallet.SelectStakeCoins(stakableCoins,validity));
+    BOOST_CHECK_MESSAGE(stakableCoins.empty(),"Empty wallet should have no stakable coins");
+
+    CMutableTransaction receivingTx;
+    receivingTx.vin.emplace_back(COutPoint(GetRandHash(),0));
+    receivingTx.vout.emplace_back(100*COIN,normalScript);
+    notificationSignals.SyncTransactions(TransactionVector({receivingTx}),nullptr,TransactionSyncType::MEMPOOL_TX_ADD);
+    BOOST_CHECK_MESSAGE(wallet.GetStakableCoinsVersion() != validity.walletVersion,"Receiving a coin should outdate the selection");
+
+    const CWalletTx* receivedTx = wallet.GetWalletTx(CTransaction(receivingTx).GetHash());
+    BOOST_REQUIRE(receivedTx != nullptr);
+    fakeWallet.FakeAddToChain(*receivedTx);
+    BOOST_CHECK(wallet.SelectStakeCoins(stakableCoins,validity));
+    BOOST_CHECK_MESSAGE(stakableCoins.empty(),"Coin with a single confirmation should not be stakable");
+    BOOST_CHECK_EQUAL(validity.nextMaturityHeight, fakeChain.activeChain->Height() + 9);
+
+    fakeWallet.AddConfirmations(9);
+    BOOST_CHECK_MESSAGE(fakeChain.activeChain->Height() >= validity.nextMaturityHeight,"New blocks should outdate the selection");
+    BOOST_CHECK(wallet.SelectStakeCoins(stakableCoins,validity));
+    BOOST_CHECK_EQUAL_MESSAGE(stakableCoins.size(),1u,"Matured coin should be stakable");
+    BOOST_CHECK(stakableCoins.begin()->utxo == COutPoint(receivedTx->GetHash(),0));
+
+    const uint64_t versionBeforeSpending = validity.walletVersion;
+    CMutableTransaction spendingTx;
+    spendingTx.vin.emplace_back(COutPoint(receivedTx->GetHash(),0));
+    spendingTx.vout.emplace_back(99*COIN,CScript() << OP_TRUE);
+    notificationSignals.SyncTransactions(TransactionVector({spendingTx}),nullptr,TransactionSyncType::MEMPOOL_TX_ADD);
+    BOOST_CHECK_MESSAGE(wallet.GetStakableCoinsVersion() != versionBeforeSpending,"Spending a coin should outdate the selection");
+
+    stakableCoins.clear();
+    BOOST_CHECK(wallet.SelectStakeCoins(stakableCoins,validity));
+    BOOST_CHECK_MESSAGE(stakableCoins.empty(),"Spent coin should not be stakable");
+    wallet.UnregisterWith(notificationSignals);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -31,6 +31,8 @@ constexpr char DB_ADDRESSUNSPENTINDEX = 'u';
 constexpr char DB_TXINDEX = 't';
 constexpr char DB_BARETXIDINDEX = 'T';
 constexpr char DB_COINS = 'c';
+constexpr char DB_COIN_OUTPOINT = 'o';
+constexpr char DB_COINS_LAYOUT = 'L';
 constexpr char DB_BESTBLOCKHASH = 'B';
 constexpr char DB_BLOCKINDEX = 'b';
 constexpr char DB_BLOCKFILEINFO = 'f';
@@ -38,6 +40,114 @@ constexpr char DB_LASTBLOCKFILE = 'l';
 constexpr char DB_REINDEXINGFLAG = 'R';
 constexpr char DB_NAMEDFLAG = 'F';
 
+constexpr char PER_OUTPOINT_LAYOUT = '1';
+constexpr unsigned UPGRADE_BATCH_TRANSACTIONS = 10000;
+
+/** On-disk value of a single unspent output in the per-outpoint layout.
+ *  It repeats the metadata of the creating transaction, so that any one
+ *  output can be read and erased on its own. */
+class OutpointCoinRecord
+{
+public:
+    int nVersion;
+    int nHeight;
+    bool fCoinBase;
+    bool fCoinStake;
+    CTxOut txout;
+
+    OutpointCoinRecord(): nVersion(0), nHeight(0), fCoinBase(false), fCoinStake(false), txout() {}
+    OutpointCoinRecord(const CCoins& coins, unsigned outputIndex
+        ): nVersion(coins.nVersion)
+        , nHeight(coins.nHeight)
+        , fCoinBase(coins.fCoinBase)
+        , fCoinStake(coins.fCoinStake)
+        , txout(coins.vout[outputIndex])
+    {
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersionIn) {
+        unsigned int nCode = 4 * static_cast<unsigned int>(nHeight) + (fCoinBase ? 1 : 0) + (fCoinStake ? 2 : 0);
+        READWRITE(VARINT(nVersion));
+        READWRITE(VARINT(nCode));
+        READWRITE(REF(CTxOutCompressor(txout)));
+        if (ser_action.ForRead()) {
+            nHeight = nCode / 4;
+            fCoinBase = (nCode & 1) != 0;
+            fCoinStake = (nCode & 2) != 0;
+        }
+    }
+};
+
+/** Raw values of all per-outpoint records of one transaction, by output index. */
+typedef std::map<uint32_t, std::string> OutpointRecordValues;
+
+/** Collects the per-outpoint records of txid into values.  The cursor is left
+ *  at the first record that belongs to some other key.  */
+void ReadOutpointRecordValues(leveldb::Iterator& cursor, const uint256& txid, OutpointRecordValues& values)
+{
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << std::make_pair(DB_COIN_OUTPOINT, COutPoint(txid, 0));
+    cursor.Seek(ssKeySet.str());
+    for (; cursor.Valid(); cursor.Next()) {
+        const leveldb::Slice slKey = cursor.key();
+        CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+        std::pair<char, COutPoint> key;
+        ssKey >> key;
+        if (key.first != DB_COIN_OUTPOINT || key.second.hash != txid)
+            break;
+        values[key.second.n] = cursor.value().ToString();
+    }
+}
+
+/** Rebuilds the CCoins of one transaction from its per-outpoint records. */
+void CoinsFromOutpointRecordValues(const OutpointRecordValues& values, CCoins& coins)
+{
+    coins.Clear();
+    if (values.empty())
+        return;
+    coins.vout.resize(values.rbegin()->first + 1);
+    for (const auto& value : values) {
+        CDataStream ssValue(value.second.data(), value.second.data() + value.second.size(), SER_DISK, CLIENT_VERSION);
+        OutpointCoinRecord record;
+        ssValue >> record;
+        coins.nVersion = record.nVersion;
+        coins.nHeight = record.nHeight;
+        coins.fCoinBase = record.fCoinBase;
+        coins.fCoinStake = record.fCoinStake;
+        coins.vout[value.first] = record.txout;
+    }
+}
+
+/** Adds one transaction's unspent outputs to the UTXO set statistics.  The
+ *  hashed data does not depend on the database layout.  */
+void AccumulateCoinStats(
+    CHashWriter& ss,
+    CCoinsStats& stats,
+    const uint256& txhash,
+    const CCoins& coins,
+    uint64_t serializedSize)
+{
+    ss << txhash;
+    ss << VARINT(coins.nVersion);
+    ss << (coins.fCoinBase ? 'c' : 'n');
+    ss << VARINT(coins.nHeight);
+    stats.nTransactions++;
+    for (unsigned int i = 0; i < coins.vout.size(); i++) {
+        const CTxOut& out = coins.vout[i];
+        if (!out.IsNull()) {
+            stats.nTransactionOutputs++;
+            ss << VARINT(i + 1);
+            ss << out;
+            stats.nTotalAmount += out.nValue;
+        }
+    }
+    stats.nSerializedSize += serializedSize;
+    ss << VARINT(0);
+}
+
 } // anonymous namespace
 
 
@@ -58,19 +168,52 @@ CCoinsViewDB::CCoinsViewDB(
     const BlockMap& blockIndicesByHash,
     size_t nCacheSize,
     bool fMemory,
-    bool fWipe
+    bool fWipe,
+    bool perOutpointLayout
     ): db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe)
     , blockIndicesByHash_(blockIndicesByHash)
+    , perOutpointLayoutRequested_(perOutpointLayout)
+    , perOutpointLayout_(false)
+{
+    char layout;
+    if (db.Read(DB_COINS_LAYOUT, layout)) {
+        perOutpointLayout_ = layout == PER_OUTPOINT_LAYOUT;
+    } else if (perOutpointLayoutRequested_ && !db.Exists(DB_BESTBLOCKHASH)) {
+        // A fresh database has nothing to convert
+        db.Write(DB_COINS_LAYOUT, PER_OUTPOINT_LAYOUT);
+        perOutpointLayout_ = true;
+    }
+}
+
+bool CCoinsViewDB::UsesPerOutpointLayout() const
+{
+    return perOutpointLayout_;
+}
+
+bool CCoinsViewDB::GetCoinsFromOutpointRecords(const uint256& txid, CCoins& coins) const
 {
+    boost::scoped_ptr<leveldb::Iterator> pcursor(const_cast<CLevelDBWrapper*>(&db)->NewIterator());
+    OutpointRecordValues values;
+    ReadOutpointRecordValues(*pcursor, txid, values);
+    if (values.empty())
+        return false;
+    CoinsFromOutpointRecordValues(values, coins);
+    return true;
 }
 
 bool CCoinsViewDB::GetCoins(const uint256& txid, CCoins& coins) const
 {
+    if (perOutpointLayout_)
+        return GetCoinsFromOutpointRecords(txid, coins);
     return db.Read(std::make_pair(DB_COINS, txid), coins);
 }
 
 bool CCoinsViewDB::HaveCoins(const uint256& txid) const
 {
+    if (perOutpointLayout_) {
+        CCoins coins;
+        return GetCoinsFromOutpointRecords(txid, coins);
+    }
     return db.Exists(std::make_pair(DB_COINS, txid));
 }
 
@@ -82,6 +225,22 @@ uint256 CCoinsViewDB::GetBestBlock() const
     return bestBlockHash;
 }
 
+void CCoinsViewDB::BatchWriteOutpointRecords(CLevelDBBatch& batch, const uint256& txid, const CCoinsCacheEntry& entry) const
+{
+    // The records to erase follow from the spent outputs of the entry, so a
+    // flush never reads the database.  Entries the database is known not to
+    // have cannot have stale records.
+    const CCoins& coins = entry.coins;
+    const unsigned int numberOfOutputs =
+        (entry.flags & CCoinsCacheEntry::FRESH)? coins.vout.size(): std::max<unsigned int>(entry.nMaxOutputs, coins.vout.size());
+    for (unsigned int i = 0; i < numberOfOutputs; i++) {
+        if (i < coins.vout.size() && !coins.vout[i].IsNull())
+            batch.Write(std::make_pair(DB_COIN_OUTPOINT, COutPoint(txid, i)), OutpointCoinRecord(coins, i));
+        else
+            batch.Erase(std::make_pair(DB_COIN_OUTPOINT, COutPoint(txid, i)));
+    }
+}
+
 bool CCoinsViewDB::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
 {
     CLevelDBBatch batch;
@@ -90,7 +249,10 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
     for (auto it = mapCoins.begin(); it != mapCoins.end(); mapCoins.erase(it++))
     {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
-            BatchWriteCoins(batch, it->first, it->second.coins);
+            if (perOutpointLayout_)
+                BatchWriteOutpointRecords(batch, it->first, it->second);
+            else
+                BatchWriteCoins(batch, it->first, it->second.coins);
             changed++;
         }
         count++;
@@ -102,6 +264,63 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
     return db.WriteBatch(batch);
 }
 
+bool CCoinsViewDB::UpgradeToPerOutpointLayout()
+{
+    if (!perOutpointLayoutRequested_ && !perOutpointLayout_)
+        return true;
+
+    if (!perOutpointLayout_) {
+        // Record the layout first, so that an interrupted upgrade is resumed on the next start
+        if (!db.Write(DB_COINS_LAYOUT, PER_OUTPOINT_LAYOUT, true))
+            return error("%s : failed to write coins database layout", __func__);
+        perOutpointLayout_ = true;
+    }
+
+    boost::scoped_ptr<leveldb::Iterator> pcursor(db.NewIterator());
+    CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+    ssKeySet << std::make_pair(DB_COINS, uint256(0));
+    pcursor->Seek(ssKeySet.str());
+
+    CLevelDBBatch batch;
+    unsigned batchedTransactions = 0;
+    uint64_t convertedTransactions = 0;
+    for (; pcursor->Valid(); pcursor->Next()) {
+        boost::this_thread::interruption_point();
+        try {
+            const leveldb::Slice slKey = pcursor->key();
+            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+            std::pair<char, uint256> key;
+            ssKey >> key;
+            if (key.first != DB_COINS)
+                break;
+
+            const leveldb::Slice slValue = pcursor->value();
+            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CCoinsCacheEntry entry;
+            ssValue >> entry.coins;
+            entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+
+            BatchWriteOutpointRecords(batch, key.second, entry);
+            batch.Erase(key);
+        } catch (const std::exception& e) {
+            return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+
+        ++convertedTransactions;
+        if (++batchedTransactions >= UPGRADE_BATCH_TRANSACTIONS) {
+            if (!db.WriteBatch(batch))
+                return false;
+            batch = CLevelDBBatch();
+            batchedTransactions = 0;
+            LogPrintf("%s : converted %u transactions\n", __func__, convertedTransactions);
+        }
+    }
+    if (!db.WriteBatch(batch, true))
+        return false;
+    LogPrintf("%s : coins database uses per-outpoint records (%u transactions converted)\n", __func__, convertedTransactions);
+    return true;
+}
+
 bool CCoinsViewDB::GetStats(CCoinsStats& stats) const
 {
     /* It seems that there are no "const iterators" for LevelDB.  Since we
@@ -113,7 +332,22 @@ bool CCoinsViewDB::GetStats(CCoinsStats& stats) const
     CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
     stats.hashBlock = GetBestBlock();
     ss << stats.hashBlock;
-    CAmount nTotalAmount = 0;
+
+    // Per-outpoint records of one transaction are adjacent; they are grouped
+    // back together so that the statistics match those of the legacy layout.
+    uint256 pendingTxHash;
+    OutpointRecordValues pendingValues;
+    uint64_t pendingSerializedSize = 0;
+    const auto flushPendingTransaction = [&]() {
+        if (pendingValues.empty())
+            return;
+        CCoins coins;
+        CoinsFromOutpointRecordValues(pendingValues, coins);
+        AccumulateCoinStats(ss, stats, pendingTxHash, coins, pendingSerializedSize);
+        pendingValues.clear();
+        pendingSerializedSize = 0;
+    };
+
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         try {
@@ -128,35 +362,27 @@ bool CCoinsViewDB::GetStats(CCoinsStats& stats) const
                 ssValue >> coins;
                 uint256 txhash;
                 ssKey >> txhash;
-                ss << txhash;
-                ss << VARINT(coins.nVersion);
-                ss << (coins.fCoinBase ? 'c' : 'n');
-                ss << VARINT(coins.nHeight);
-                stats.nTransactions++;
-                for (unsigned int i = 0; i < coins.vout.size(); i++) {
-                    const CTxOut& out = coins.vout[i];
-                    if (!out.IsNull()) {
-                        stats.nTransactionOutputs++;
-                        ss << VARINT(i + 1);
-                        ss << out;
-                        nTotalAmount += out.nValue;
-                    }
-                }
-                stats.nSerializedSize += 32 + slValue.size();
-                ss << VARINT(0);
+                AccumulateCoinStats(ss, stats, txhash, coins, 32 + slValue.size());
+            } else if (chType == DB_COIN_OUTPOINT) {
+                COutPoint outpoint;
+                ssKey >> outpoint;
+                if (outpoint.hash != pendingTxHash)
+                    flushPendingTransaction();
+                pendingTxHash = outpoint.hash;
+                pendingValues[outpoint.n] = pcursor->value().ToString();
+                pendingSerializedSize += slKey.size() - 1 + pcursor->value().size();
             }
             pcursor->Next();
         } catch (std::exception& e) {
             return error("%s : Deserialize or I/O error - %s", __func__, e.what());
         }
     }
+    flushPendingTransaction();
     stats.nHeight = blockIndicesByHash_.find(GetBestBlock())->second->nHeight;
     stats.hashSerialized = ss.GetHash();
-    stats.nTotalAmount = nTotalAmount;
     return true;
 }
 
-
 CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe
     ) : CLevelDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe)
     , addressIndexing_(false)
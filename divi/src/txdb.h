@@ -44,19 +44,37 @@ struct CCoinsStats {
     CCoinsStats() : nHeight(0), hashBlock(0), nTransactions(0), nTransactionOutputs(0), nSerializedSize(0), hashSerialized(0), nTotalAmount(0) {}
 };
 
+/**
+ * The coins database can store the UTXO set in one of two layouts:
+ * - legacy: one CCoins record per txid (see coins.h for the encoding)
+ * - per outpoint: one record per unspent output, keyed by COutPoint, so that
+ *   spending an output of a large transaction only erases that output's record.
+ * The layout in use is recorded in the database itself. A legacy database
+ * is converted when the per-outpoint layout is requested.
+ */
 class CCoinsViewDB final: public CCoinsView
 {
 protected:
     CLevelDBWrapper db;
     const BlockMap& blockIndicesByHash_;
+    const bool perOutpointLayoutRequested_;
+    bool perOutpointLayout_;
+
+    bool GetCoinsFromOutpointRecords(const uint256& txid, CCoins& coins) const;
+    void BatchWriteOutpointRecords(CLevelDBBatch& batch, const uint256& txid, const CCoinsCacheEntry& entry) const;
 public:
-    CCoinsViewDB(const BlockMap& blockIndicesByHash, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    CCoinsViewDB(const BlockMap& blockIndicesByHash, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool perOutpointLayout = false);
 
     bool GetCoins(const uint256& txid, CCoins& coins) const override;
     bool HaveCoins(const uint256& txid) const override;
     uint256 GetBestBlock() const override;
     bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override;
     bool GetStats(CCoinsStats& stats) const;
+
+    bool UsesPerOutpointLayout() const;
+    //! Converts remaining legacy records if the per-outpoint layout was requested
+    //! (or a previous conversion was interrupted); no-op otherwise.
+    bool UpgradeToPerOutpointLayout();
 };
 
 /** Access to the block database (blocks/index/) */
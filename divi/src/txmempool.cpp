@@ -10,12 +10,15 @@
 #include "streams.h"
 #include "Logging.h"
 #include "utilmoneystr.h"
+#include "utiltime.h"
 #include "version.h"
 #include <UtxoCheckingAndUpdating.h>
 #include <chainparams.h>
 #include <MempoolConsensus.h>
 
+#include <algorithm>
 #include <boost/circular_buffer.hpp>
+#include <math.h>
 
 
 #include "FeeAndPriorityCalculator.h"
@@ -28,11 +31,93 @@ bool IsMemPoolHeight(unsigned coinHeight)
     return coinHeight == CTxMemPoolEntry::MEMPOOL_HEIGHT;
 }
 
+namespace
+{
+
+struct update_descendant_state
+{
+    update_descendant_state(int64_t _modifySize, CAmount _modifyFee, int64_t _modifyCount):
+        modifySize(_modifySize), modifyFee(_modifyFee), modifyCount(_modifyCount)
+    {}
+
+    void operator()(CTxMemPoolEntry& e)
+        { e.UpdateDescendantState(modifySize, modifyFee, modifyCount); }
+
+    private:
+        int64_t modifySize;
+        CAmount modifyFee;
+        int64_t modifyCount;
+};
+
+struct update_ancestor_state
+{
+    update_ancestor_state(int64_t _modifySize, CAmount _modifyFee, int64_t _modifyCount):
+        modifySize(_modifySize), modifyFee(_modifyFee), modifyCount(_modifyCount)
+    {}
+
+    void operator()(CTxMemPoolEntry& e)
+        { e.UpdateAncestorState(modifySize, modifyFee, modifyCount); }
+
+    private:
+        int64_t modifySize;
+        CAmount modifyFee;
+        int64_t modifyCount;
+};
+
+struct update_fee_delta
+{
+    explicit update_fee_delta(CAmount _feeDelta): feeDelta(_feeDelta) { }
+
+    void operator()(CTxMemPoolEntry& e) { e.UpdateFeeDelta(feeDelta); }
+
+private:
+    CAmount feeDelta;
+};
+
+/** Replaces both package statistics of an entry with freshly computed totals */
+struct set_package_state
+{
+    set_package_state(
+        uint64_t _countWithAncestors, uint64_t _sizeWithAncestors, CAmount _modFeesWithAncestors,
+        uint64_t _countWithDescendants, uint64_t _sizeWithDescendants, CAmount _modFeesWithDescendants
+        ): countWithAncestors(_countWithAncestors), sizeWithAncestors(_sizeWithAncestors), modFeesWithAncestors(_modFeesWithAncestors)
+        , countWithDescendants(_countWithDescendants), sizeWithDescendants(_sizeWithDescendants), modFeesWithDescendants(_modFeesWithDescendants)
+    {}
+
+    void operator()(CTxMemPoolEntry& e)
+    {
+        e.UpdateAncestorState(
+            int64_t(sizeWithAncestors) - int64_t(e.GetSizeWithAncestors()),
+            modFeesWithAncestors - e.GetModFeesWithAncestors(),
+            int64_t(countWithAncestors) - int64_t(e.GetCountWithAncestors()));
+        e.UpdateDescendantState(
+            int64_t(sizeWithDescendants) - int64_t(e.GetSizeWithDescendants()),
+            modFeesWithDescendants - e.GetModFeesWithDescendants(),
+            int64_t(countWithDescendants) - int64_t(e.GetCountWithDescendants()));
+    }
+
+private:
+    uint64_t countWithAncestors;
+    uint64_t sizeWithAncestors;
+    CAmount modFeesWithAncestors;
+    uint64_t countWithDescendants;
+    uint64_t sizeWithDescendants;
+    CAmount modFeesWithDescendants;
+};
+
+} // anonymous namespace
+
 CTxMemPool::CTxMemPool(
     ): fSanityCheck_(false)
     , mapDeltas()
+    , cachedInnerUsage(0u)
+    , mapLinks()
+    , lastRollingFeeUpdate(GetTime())
+    , blockSinceLastRollingFeeBump(false)
+    , rollingMinimumFeeRate(0.0)
     , mapBareTxid()
     , timeOfLastChainTipUpdate_(0)
+    , nTransactionsUpdated(0u)
     , cs()
     , mapTx()
     , mapNextTx()
@@ -67,73 +152,287 @@ void CTxMemPool::pruneSpent(const uint256& hashTx, CCoins& coins) const
     }
 }
 
+void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
+{
+    setEntries& parents = mapLinks[entry].parents;
+    if (add && parents.insert(parent).second) {
+        cachedInnerUsage += memusage::IncrementalDynamicUsage(parents);
+    } else if (!add && parents.erase(parent)) {
+        cachedInnerUsage -= memusage::IncrementalDynamicUsage(parents);
+    }
+}
+
+void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
+{
+    setEntries& children = mapLinks[entry].children;
+    if (add && children.insert(child).second) {
+        cachedInnerUsage += memusage::IncrementalDynamicUsage(children);
+    } else if (!add && children.erase(child)) {
+        cachedInnerUsage -= memusage::IncrementalDynamicUsage(children);
+    }
+}
+
+const CTxMemPool::setEntries& CTxMemPool::GetMemPoolParents(txiter entry) const
+{
+    assert(entry != mapTx.end());
+    const auto it = mapLinks.find(entry);
+    assert(it != mapLinks.end());
+    return it->second.parents;
+}
+
+const CTxMemPool::setEntries& CTxMemPool::GetMemPoolChildren(txiter entry) const
+{
+    assert(entry != mapTx.end());
+    const auto it = mapLinks.find(entry);
+    assert(it != mapLinks.end());
+    return it->second.children;
+}
+
+void CTxMemPool::CalculateMemPoolAncestors(txiter entry, setEntries& ancestors) const
+{
+    std::vector<txiter> pending(GetMemPoolParents(entry).begin(), GetMemPoolParents(entry).end());
+    while (!pending.empty()) {
+        const txiter current = pending.back();
+        pending.pop_back();
+        if (!ancestors.insert(current).second)
+            continue;
+        for (const txiter& parent : GetMemPoolParents(current))
+            if (ancestors.count(parent) == 0)
+                pending.push_back(parent);
+    }
+}
+
+void CTxMemPool::CalculateDescendants(txiter entry, setEntries& descendants) const
+{
+    std::vector<txiter> pending(1, entry);
+    while (!pending.empty()) {
+        const txiter current = pending.back();
+        pending.pop_back();
+        if (!descendants.insert(current).second)
+            continue;
+        for (const txiter& child : GetMemPoolChildren(current))
+            if (descendants.count(child) == 0)
+                pending.push_back(child);
+    }
+}
+
+void CTxMemPool::UpdateAncestorsOf(bool add, txiter it, const setEntries& ancestors)
+{
+    const int64_t updateCount = (add ? 1 : -1);
+    const int64_t updateSize = updateCount * it->GetTxSize();
+    const CAmount updateFee = updateCount * it->GetModifiedFee();
+    for (const txiter& ancestor : ancestors)
+        mapTx.modify(ancestor, update_descendant_state(updateSize, updateFee, updateCount));
+}
+
+void CTxMemPool::UpdateEntryForAncestors(txiter it, const setEntries& ancestors)
+{
+    int64_t updateCount = ancestors.size();
+    int64_t updateSize = 0;
+    CAmount updateFee = 0;
+    for (const txiter& ancestor : ancestors) {
+        updateSize += ancestor->GetTxSize();
+        updateFee += ancestor->GetModifiedFee();
+    }
+    mapTx.modify(it, update_ancestor_state(updateSize, updateFee, updateCount));
+}
+
+void CTxMemPool::RecomputePackageStatistics(txiter it)
+{
+    setEntries ancestors;
+    CalculateMemPoolAncestors(it, ancestors);
+    ancestors.insert(it);
+    setEntries descendants;
+    CalculateDescendants(it, descendants);
+
+    uint64_t sizeWithAncestors = 0;
+    CAmount modFeesWithAncestors = 0;
+    for (const txiter& ancestor : ancestors) {
+        sizeWithAncestors += ancestor->GetTxSize();
+        modFeesWithAncestors += ancestor->GetModifiedFee();
+    }
+    uint64_t sizeWithDescendants = 0;
+    CAmount modFeesWithDescendants = 0;
+    for (const txiter& descendant : descendants) {
+        sizeWithDescendants += descendant->GetTxSize();
+        modFeesWithDescendants += descendant->GetModifiedFee();
+    }
+    mapTx.modify(it, set_package_state(
+        ancestors.size(), sizeWithAncestors, modFeesWithAncestors,
+        descendants.size(), sizeWithDescendants, modFeesWithDescendants));
+}
+
+void CTxMemPool::UpdateFeeDelta(txiter it, CAmount feeDelta)
+{
+    const CAmount modifyFee = feeDelta - (it->GetModifiedFee() - it->GetFee());
+    if (modifyFee == 0)
+        return;
+    mapTx.modify(it, update_fee_delta(feeDelta));
+    // The packages the entry belongs to change by the same amount
+    setEntries ancestors;
+    CalculateMemPoolAncestors(it, ancestors);
+    for (const txiter& ancestor : ancestors)
+        mapTx.modify(ancestor, update_descendant_state(0, modifyFee, 0));
+    setEntries descendants;
+    CalculateDescendants(it, descendants);
+    descendants.erase(it);
+    for (const txiter& descendant : descendants)
+        mapTx.modify(descendant, update_ancestor_state(0, modifyFee, 0));
+}
+
 bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry& entry)
 {
     // Add to memory pool without checking anything.
     // Used by main.cpp AcceptToMemoryPool(), which DOES do
     // all the appropriate checks.
     LOCK(cs);
+    const auto inserted = mapTx.insert(entry);
+    if (!inserted.second)
+        return false;
+    const txiter newit = inserted.first;
+    mapLinks.insert(std::make_pair(newit, TxLinks()));
+
+    const auto pos = mapDeltas.find(hash);
+    if (pos != mapDeltas.end() && pos->second.second != 0)
+        mapTx.modify(newit, update_fee_delta(pos->second.second));
+
+    const CTransaction& tx = newit->GetTx();
+    mapBareTxid.emplace(tx.GetBareTxid(), &*newit);
+    for (unsigned int i = 0; i < tx.vin.size(); i++)
     {
-        mapTx.emplace(hash,entry);
-        const auto* entryInMap = &mapTx.find(hash)->second;
-        const CTransaction& tx = entryInMap->GetTx();
-        mapBareTxid.emplace(tx.GetBareTxid(), entryInMap);
-        for (unsigned int i = 0; i < tx.vin.size(); i++)
-        {
-            mapNextTx[tx.vin[i].prevout] = CInPoint(&tx, i);
+        mapNextTx[tx.vin[i].prevout] = CInPoint(&tx, i);
+        const txiter parent = lookupOutpointEntry(tx.vin[i].prevout.hash);
+        if (parent != mapTx.end()) {
+            UpdateParent(newit, parent, true);
+            UpdateChild(parent, newit, true);
         }
-        totalTxSize += entry.GetTxSize();
+    }
+    totalTxSize += newit->GetTxSize();
+    cachedInnerUsage += newit->DynamicMemoryUsage();
+    ++nTransactionsUpdated;
+
+    // Transactions disconnected in a reorg can come back after their
+    // children, in which case the packages around them are rebuilt from the links.
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        const auto spend = mapNextTx.find(COutPoint(hash, i));
+        if (spend == mapNextTx.end())
+            continue;
+        const txiter child = mapTx.find(spend->second.ptx->GetHash());
+        UpdateChild(newit, child, true);
+        UpdateParent(child, newit, true);
+    }
+    if (!GetMemPoolChildren(newit).empty()) {
+        setEntries package;
+        CalculateMemPoolAncestors(newit, package);
+        CalculateDescendants(newit, package);
+        for (const txiter& member : package)
+            RecomputePackageStatistics(member);
+        return true;
     }
 
+    setEntries ancestors;
+    CalculateMemPoolAncestors(newit, ancestors);
+    UpdateAncestorsOf(true, newit, ancestors);
+    UpdateEntryForAncestors(newit, ancestors);
     return true;
 }
 
+void CTxMemPool::UpdateForRemoveFromMempool(const setEntries& entriesToRemove, bool updateDescendants)
+{
+    if (updateDescendants) {
+        // Descendants that stay in the pool lose the removed entry from their ancestors
+        for (const txiter& removeIt : entriesToRemove) {
+            setEntries descendants;
+            CalculateDescendants(removeIt, descendants);
+            descendants.erase(removeIt);
+            const int64_t modifySize = -((int64_t)removeIt->GetTxSize());
+            const CAmount modifyFee = -removeIt->GetModifiedFee();
+            for (const txiter& descendant : descendants)
+                if (entriesToRemove.count(descendant) == 0)
+                    mapTx.modify(descendant, update_ancestor_state(modifySize, modifyFee, -1));
+        }
+    }
+    for (const txiter& removeIt : entriesToRemove) {
+        setEntries ancestors;
+        CalculateMemPoolAncestors(removeIt, ancestors);
+        // Ancestors that are removed as well are not worth updating
+        setEntries survivingAncestors;
+        for (const txiter& ancestor : ancestors)
+            if (entriesToRemove.count(ancestor) == 0)
+                survivingAncestors.insert(ancestor);
+        UpdateAncestorsOf(false, removeIt, survivingAncestors);
+    }
+    // Links are only dropped once all the statistics above were computed from them
+    for (const txiter& removeIt : entriesToRemove)
+        UpdateChildrenForRemoval(removeIt);
+}
+
+void CTxMemPool::UpdateChildrenForRemoval(txiter entry)
+{
+    for (const txiter& child : GetMemPoolChildren(entry))
+        UpdateParent(child, entry, false);
+    for (const txiter& parent : GetMemPoolParents(entry))
+        UpdateChild(parent, entry, false);
+}
+
+void CTxMemPool::removeUnchecked(txiter entry, std::list<CTransaction>& removed)
+{
+    const CTransaction& tx = entry->GetTx();
+    mapBareTxid.erase(tx.GetBareTxid());
+    for (const auto& txin : tx.vin)
+        mapNextTx.erase(txin.prevout);
+
+    removed.push_back(tx);
+    totalTxSize -= entry->GetTxSize();
+    cachedInnerUsage -= entry->DynamicMemoryUsage();
+    cachedInnerUsage -= memusage::DynamicUsage(mapLinks[entry].parents) + memusage::DynamicUsage(mapLinks[entry].children);
+    mapLinks.erase(entry);
+    mapTx.erase(entry);
+    ++nTransactionsUpdated;
+}
+
+void CTxMemPool::RemoveStaged(const setEntries& stage, bool updateDescendants, std::list<CTransaction>& removed)
+{
+    UpdateForRemoveFromMempool(stage, updateDescendants);
+    // Parents go first, so that removed lists replay in dependency order
+    std::vector<txiter> ordered(stage.begin(), stage.end());
+    std::stable_sort(ordered.begin(), ordered.end(), [](const txiter& a, const txiter& b) {
+        return a->GetCountWithAncestors() < b->GetCountWithAncestors();
+    });
+    for (const txiter& it : ordered)
+        removeUnchecked(it, removed);
+}
+
 void CTxMemPool::remove(const CTransaction& origTx, std::list<CTransaction>& removed, bool fRecursive)
 {
     // Remove transaction from memory pool
-    {
-        LOCK(cs);
-        std::deque<uint256> txToRemove;
-        txToRemove.push_back(origTx.GetHash());
-        if (fRecursive && !mapTx.count(origTx.GetHash())) {
-            // If recursively removing but origTx isn't in the mempool
-            // be sure to remove any children that are in the pool. This can
-            // happen during chain re-orgs if origTx isn't re-accepted into
-            // the mempool for any reason.
-            for (unsigned int i = 0; i < origTx.vout.size(); i++) {
-                std::map<COutPoint, CInPoint>::iterator it = mapNextTx.find(COutPoint(origTx.GetHash(), i));
-                if (it == mapNextTx.end())
-                    continue;
-                txToRemove.push_back(it->second.ptx->GetHash());
-            }
-        }
-        while (!txToRemove.empty()) {
-            const uint256 hash = txToRemove.front();
-            txToRemove.pop_front();
-            if (!mapTx.count(hash))
+    LOCK(cs);
+    setEntries txToRemove;
+    const txiter origit = mapTx.find(origTx.GetHash());
+    if (origit != mapTx.end()) {
+        txToRemove.insert(origit);
+    } else if (fRecursive) {
+        // If recursively removing but origTx isn't in the mempool
+        // be sure to remove any children that are in the pool. This can
+        // happen during chain re-orgs if origTx isn't re-accepted into
+        // the mempool for any reason.
+        for (unsigned int i = 0; i < origTx.vout.size(); i++) {
+            std::map<COutPoint, CInPoint>::iterator it = mapNextTx.find(COutPoint(origTx.GetHash(), i));
+            if (it == mapNextTx.end())
                 continue;
-
-            {
-                const CTxMemPoolEntry& mempoolTx = mapTx.find(hash)->second;
-                const CTransaction& tx = mempoolTx.GetTx();
-                if (fRecursive) {
-                    for (unsigned int i = 0; i < tx.vout.size(); i++) {
-                        std::map<COutPoint, CInPoint>::iterator it = mapNextTx.find(COutPoint(hash, i));
-                        if (it == mapNextTx.end())
-                            continue;
-                        txToRemove.push_back(it->second.ptx->GetHash());
-                    }
-                }
-                mapBareTxid.erase(tx.GetBareTxid());
-                for (const auto& txin : tx.vin)
-                    mapNextTx.erase(txin.prevout);
-
-                removed.push_back(tx);
-                totalTxSize -= mempoolTx.GetTxSize();
-            }
-            mapTx.erase(hash);
+            const txiter nextit = mapTx.find(it->second.ptx->GetHash());
+            assert(nextit != mapTx.end());
+            txToRemove.insert(nextit);
         }
     }
+    setEntries setAllRemoves;
+    if (fRecursive) {
+        for (const txiter& it : txToRemove)
+            CalculateDescendants(it, setAllRemoves);
+    } else {
+        setAllRemoves.swap(txToRemove);
+    }
+    RemoveStaged(setAllRemoves, !fRecursive, removed);
 }
 
 void CTxMemPool::removeCoinbaseSpends(const CCoinsViewCache* pcoins, unsigned int nMemPoolHeight)
@@ -142,7 +441,7 @@ void CTxMemPool::removeCoinbaseSpends(const CCoinsViewCache* pcoins, unsigned in
     LOCK(cs);
     list<CTransaction> transactionsToRemove;
     for (const auto& entry : mapTx) {
-        const CTransaction& tx = entry.second.GetTx();
+        const CTransaction& tx = entry.GetTx();
         for (const auto& txin : tx.vin) {
             CTransaction tx2;
             if (lookupOutpoint(txin.prevout.hash, tx2))
@@ -183,18 +482,14 @@ void CTxMemPool::removeConflicts(const CTransaction& tx, std::list<CTransaction>
 void CTxMemPool::removeConfirmedTransactions(const std::vector<CTransaction>& vtx, unsigned int nBlockHeight, std::list<CTransaction>& conflicts)
 {
     LOCK(cs);
-    std::vector<const CTxMemPoolEntry*> entries;
-    BOOST_FOREACH (const CTransaction& tx, vtx) {
-        uint256 hash = tx.GetHash();
-        if (mapTx.count(hash))
-            entries.push_back(&mapTx.find(hash)->second);
-    }
     BOOST_FOREACH (const CTransaction& tx, vtx) {
         std::list<CTransaction> dummy;
         remove(tx, dummy, false);
         removeConflicts(tx, conflicts);
         ClearPrioritisation(tx.GetHash());
     }
+    lastRollingFeeUpdate = GetTime();
+    blockSinceLastRollingFeeBump = true;
 }
 
 
@@ -204,7 +499,13 @@ void CTxMemPool::clear()
     mapTx.clear();
     mapNextTx.clear();
     mapBareTxid.clear();
+    mapLinks.clear();
+    ++nTransactionsUpdated;
     totalTxSize = 0;
+    cachedInnerUsage = 0;
+    lastRollingFeeUpdate = GetTime();
+    blockSinceLastRollingFeeBump = false;
+    rollingMinimumFeeRate = 0.0;
 }
 
 void CTxMemPool::check(const CCoinsViewCache* pcoins, const BlockMap& blockIndexMap) const
@@ -215,22 +516,32 @@ void CTxMemPool::check(const CCoinsViewCache* pcoins, const BlockMap& blockIndex
     LogPrint("mempool", "Checking mempool with %u transactions and %u inputs\n", (unsigned int)mapTx.size(), (unsigned int)mapNextTx.size());
 
     uint64_t checkTotal = 0;
+    uint64_t innerUsage = 0;
 
     CCoinsViewCache mempoolDuplicate(pcoins);
 
     LOCK(cs);
     list<const CTxMemPoolEntry*> waitingOnDependants;
-    for (const auto& entry : mapTx) {
+    for (txiter it = mapTx.begin(); it != mapTx.end(); ++it) {
+        const CTxMemPoolEntry& entry = *it;
         unsigned int i = 0;
-        checkTotal += entry.second.GetTxSize();
-        const CTransaction& tx = entry.second.GetTx();
+        checkTotal += entry.GetTxSize();
+        innerUsage += entry.DynamicMemoryUsage();
+        const auto linksiter = mapLinks.find(it);
+        assert(linksiter != mapLinks.end());
+        const TxLinks& links = linksiter->second;
+        innerUsage += memusage::DynamicUsage(links.parents) + memusage::DynamicUsage(links.children);
+        const CTransaction& tx = entry.GetTx();
         bool fDependsWait = false;
+        setEntries setParentCheck;
         for (const auto& txin : tx.vin) {
             // Check that every mempool transaction's inputs refer to available coins, or other mempool tx's.
-            CTransaction tx2;
-            if (lookupOutpoint(txin.prevout.hash, tx2)) {
+            const txiter parentit = lookupOutpointEntry(txin.prevout.hash);
+            if (parentit != mapTx.end()) {
+                const CTransaction& tx2 = parentit->GetTx();
                 assert(tx2.vout.size() > txin.prevout.n && !tx2.vout[txin.prevout.n].IsNull());
                 fDependsWait = true;
+                setParentCheck.insert(parentit);
             } else {
                 const CCoins* coins = mempoolDuplicate.AccessCoins(txin.prevout.hash);
                 assert(coins && coins->IsAvailable(txin.prevout.n));
@@ -242,8 +553,46 @@ void CTxMemPool::check(const CCoinsViewCache* pcoins, const BlockMap& blockIndex
             assert(mit->second.n == i);
             i++;
         }
+        assert(setParentCheck == links.parents);
+
+        // The package statistics have to match the ones computed from the links
+        setEntries ancestors;
+        CalculateMemPoolAncestors(it, ancestors);
+        uint64_t nSizeCheck = entry.GetTxSize();
+        CAmount nFeesCheck = entry.GetModifiedFee();
+        for (const txiter& ancestor : ancestors) {
+            nSizeCheck += ancestor->GetTxSize();
+            nFeesCheck += ancestor->GetModifiedFee();
+        }
+        assert(entry.GetCountWithAncestors() == ancestors.size() + 1);
+        assert(entry.GetSizeWithAncestors() == nSizeCheck);
+        assert(entry.GetModFeesWithAncestors() == nFeesCheck);
+
+        setEntries setChildrenCheck;
+        for (unsigned int n = 0; n < tx.vout.size(); n++) {
+            const auto spend = mapNextTx.find(COutPoint(tx.GetHash(), n));
+            if (spend != mapNextTx.end()) {
+                const txiter childit = mapTx.find(spend->second.ptx->GetHash());
+                assert(childit != mapTx.end());
+                setChildrenCheck.insert(childit);
+            }
+        }
+        assert(setChildrenCheck == links.children);
+
+        setEntries descendants;
+        CalculateDescendants(it, descendants);
+        nSizeCheck = 0;
+        nFeesCheck = 0;
+        for (const txiter& descendant : descendants) {
+            nSizeCheck += descendant->GetTxSize();
+            nFeesCheck += descendant->GetModifiedFee();
+        }
+        assert(entry.GetCountWithDescendants() == descendants.size());
+        assert(entry.GetSizeWithDescendants() == nSizeCheck);
+        assert(entry.GetModFeesWithDescendants() == nFeesCheck);
+
         if (fDependsWait)
-            waitingOnDependants.push_back(&entry.second);
+            waitingOnDependants.push_back(&entry);
         else {
             CValidationState state;
             CTxUndo undo;
@@ -271,13 +620,15 @@ void CTxMemPool::check(const CCoinsViewCache* pcoins, const BlockMap& blockIndex
         const uint256 hash = entry.second.ptx->GetHash();
         const auto mit = mapTx.find(hash);
         assert(mit != mapTx.end());
-        const CTransaction& tx = mit->second.GetTx();
+        const CTransaction& tx = mit->GetTx();
         assert(&tx == entry.second.ptx);
         assert(tx.vin.size() > entry.second.n);
         assert(entry.first == entry.second.ptx->vin[entry.second.n].prevout);
     }
 
     assert(totalTxSize == checkTotal);
+    assert(cachedInnerUsage == innerUsage);
+    assert(mapLinks.size() == mapTx.size());
 }
 
 void CTxMemPool::queryHashes(std::vector<uint256>& vtxid)
@@ -286,16 +637,16 @@ void CTxMemPool::queryHashes(std::vector<uint256>& vtxid)
 
     LOCK(cs);
     vtxid.reserve(mapTx.size());
-    for (std::map<uint256, CTxMemPoolEntry>::iterator mi = mapTx.begin(); mi != mapTx.end(); ++mi)
-        vtxid.push_back((*mi).first);
+    for (const CTxMemPoolEntry& entry : mapTx)
+        vtxid.push_back(entry.GetTx().GetHash());
 }
 
 bool CTxMemPool::lookup(const uint256& hash, CTransaction& result) const
 {
     LOCK(cs);
-    std::map<uint256, CTxMemPoolEntry>::const_iterator i = mapTx.find(hash);
+    const txiter i = mapTx.find(hash);
     if (i == mapTx.end()) return false;
-    result = i->second.GetTx();
+    result = i->GetTx();
     return true;
 }
 
@@ -308,11 +659,20 @@ bool CTxMemPool::lookupBareTxid(const uint256& btxid, CTransaction& result) cons
     return true;
 }
 
-bool CTxMemPool::lookupOutpoint(const uint256& hash, CTransaction& result) const
+CTxMemPool::txiter CTxMemPool::lookupOutpointEntry(const uint256& hash) const
 {
     /* For now (until we add the UTXO hasher and segwit light), the outpoint
        is just the transaction ID.  */
-    return lookup(hash, result);
+    return mapTx.find(hash);
+}
+
+bool CTxMemPool::lookupOutpoint(const uint256& hash, CTransaction& result) const
+{
+    LOCK(cs);
+    const txiter i = lookupOutpointEntry(hash);
+    if (i == mapTx.end()) return false;
+    result = i->GetTx();
+    return true;
 }
 
 void CTxMemPool::PrioritiseTransaction(const uint256 hash, const CAmount nFeeDelta)
@@ -323,6 +683,10 @@ void CTxMemPool::PrioritiseTransaction(const uint256 hash, const CAmount nFeeDel
         std::pair<double, CAmount>& deltas = mapDeltas[hash];
         deltas.first += proxyForPriorityDelta;
         deltas.second += nFeeDelta;
+        ++nTransactionsUpdated;
+        const txiter it = mapTx.find(hash);
+        if (it != mapTx.end())
+            UpdateFeeDelta(it, deltas.second);
     }
     LogPrintf("PrioritiseTransaction: %s priority += %f, fee += %d\n", hash. ToString(), proxyForPriorityDelta, FormatMoney(nFeeDelta));
 }
@@ -350,9 +714,88 @@ void CTxMemPool::ApplyDeltas(const uint256 hash, double& dPriorityDelta, CAmount
 void CTxMemPool::ClearPrioritisation(const uint256 hash)
 {
     LOCK(cs);
-    mapDeltas.erase(hash);
+    if (mapDeltas.erase(hash) > 0)
+        ++nTransactionsUpdated;
+    const txiter it = mapTx.find(hash);
+    if (it != mapTx.end())
+        UpdateFeeDelta(it, 0);
+}
+
+void CTxMemPool::queryFeeDeltas(std::map<uint256, CAmount>& feeDeltas) const
+{
+    LOCK(cs);
+    feeDeltas.clear();
+    for (const auto& delta : mapDeltas)
+        feeDeltas[delta.first] = delta.second.second;
+}
+
+size_t CTxMemPool::DynamicMemoryUsage() const
+{
+    LOCK(cs);
+    // Each multi-index node holds the entry plus three pointers for each of the four indexes
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) * mapTx.size() +
+        memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapBareTxid) +
+        memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + cachedInnerUsage;
 }
 
+CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const
+{
+    LOCK(cs);
+    const CFeeRate& incrementalRelayFee = FeeAndPriorityCalculator::instance().getMinimumRelayFeeRate();
+    if (!blockSinceLastRollingFeeBump || rollingMinimumFeeRate == 0)
+        return CFeeRate(llround(rollingMinimumFeeRate));
+
+    const int64_t time = GetTime();
+    if (time > lastRollingFeeUpdate + 10) {
+        // Decay faster while the pool has a lot of room left
+        double halflife = ROLLING_FEE_HALFLIFE;
+        if (DynamicMemoryUsage() < sizelimit / 4)
+            halflife /= 4;
+        else if (DynamicMemoryUsage() < sizelimit / 2)
+            halflife /= 2;
+
+        rollingMinimumFeeRate = rollingMinimumFeeRate / pow(2.0, (time - lastRollingFeeUpdate) / halflife);
+        lastRollingFeeUpdate = time;
+
+        if (rollingMinimumFeeRate < (double)incrementalRelayFee.GetFeePerK() / 2) {
+            rollingMinimumFeeRate = 0;
+            return CFeeRate(0);
+        }
+    }
+    return std::max(CFeeRate(llround(rollingMinimumFeeRate)), incrementalRelayFee);
+}
+
+void CTxMemPool::trackPackageRemoved(const CFeeRate& rate)
+{
+    if (rate.GetFeePerK() > rollingMinimumFeeRate) {
+        rollingMinimumFeeRate = rate.GetFeePerK();
+        blockSinceLastRollingFeeBump = false;
+    }
+}
+
+void CTxMemPool::TrimToSize(size_t sizelimit, std::list<CTransaction>& removed)
+{
+    LOCK(cs);
+    const CFeeRate& incrementalRelayFee = FeeAndPriorityCalculator::instance().getMinimumRelayFeeRate();
+    const size_t numberRemovedBefore = removed.size();
+    CFeeRate maxFeeRateRemoved(0);
+    while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
+        const auto it = mapTx.get<descendant_score>().begin();
+
+        // Replacements have to pay more than the package they push out
+        const CFeeRate removedFeeRate(
+            CFeeRate(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants()).GetFeePerK() + incrementalRelayFee.GetFeePerK());
+        trackPackageRemoved(removedFeeRate);
+        maxFeeRateRemoved = std::max(maxFeeRateRemoved, removedFeeRate);
+
+        setEntries stage;
+        CalculateDescendants(mapTx.project<0>(it), stage);
+        RemoveStaged(stage, false, removed);
+    }
+
+    if (maxFeeRateRemoved > CFeeRate(0))
+        LogPrint("mempool", "Removed %u txn, rolling minimum fee bumped to %s\n", removed.size() - numberRemovedBefore, maxFeeRateRemoved.ToString());
+}
 
 CCoinsViewMemPool::CCoinsViewMemPool(
     const CTxMemPool& mempoolIn
@@ -8,13 +8,19 @@
 #define BITCOIN_TXMEMPOOL_H
 
 #include <list>
+#include <set>
 
 #include "amount.h"
+#include "FeeRate.h"
 #include "coins.h"
 #include "primitives/transaction.h"
 #include "sync.h"
 #include <MemPoolEntry.h>
 
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+
 class BlockMap;
 class CAutoFile;
 
@@ -42,6 +48,122 @@ public:
     bool IsNull() const { return (ptx == NULL && n == (uint32_t)-1); }
 };
 
+/** Extracts the txid a pool entry is indexed by */
+struct mempoolentry_txid
+{
+    typedef uint256 result_type;
+    result_type operator()(const CTxMemPoolEntry& entry) const
+    {
+        return entry.GetTx().GetHash();
+    }
+};
+
+/** Sorts by the higher of the entry's own modified fee rate and the fee rate
+ *  of the entry together with its descendants, lowest first; this is the
+ *  order in which packages are evicted from a full pool.  */
+class CompareTxMemPoolEntryByDescendantScore
+{
+public:
+    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const
+    {
+        double aModFee, aSize, bModFee, bSize;
+        GetModFeeAndSize(a, aModFee, aSize);
+        GetModFeeAndSize(b, bModFee, bSize);
+
+        // Avoid division by rewriting (a/b > c/d) as (a*d > c*b)
+        const double f1 = aModFee * bSize;
+        const double f2 = aSize * bModFee;
+        if (f1 == f2)
+            return a.GetTime() != b.GetTime() ? a.GetTime() > b.GetTime() : a.GetTx().GetHash() < b.GetTx().GetHash();
+        return f1 < f2;
+    }
+
+    static void GetModFeeAndSize(const CTxMemPoolEntry& a, double& modFee, double& size)
+    {
+        const double f1 = (double)a.GetModifiedFee() * a.GetSizeWithDescendants();
+        const double f2 = (double)a.GetModFeesWithDescendants() * a.GetTxSize();
+        if (f2 > f1) {
+            modFee = a.GetModFeesWithDescendants();
+            size = a.GetSizeWithDescendants();
+        } else {
+            modFee = a.GetModifiedFee();
+            size = a.GetTxSize();
+        }
+    }
+};
+
+/** Sorts by the time transactions entered the pool, oldest first */
+class CompareTxMemPoolEntryByEntryTime
+{
+public:
+    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const
+    {
+        return a.GetTime() < b.GetTime();
+    }
+};
+
+/** Sorts by the lower of the entry's own modified fee rate and the fee rate
+ *  of the entry together with its ancestors, highest first; this is the
+ *  order in which a miner would want to include packages.  */
+class CompareTxMemPoolEntryByAncestorScore
+{
+public:
+    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const
+    {
+        double aModFee, aSize, bModFee, bSize;
+        GetModFeeAndSize(a, aModFee, aSize);
+        GetModFeeAndSize(b, bModFee, bSize);
+
+        // Avoid division by rewriting (a/b > c/d) as (a*d > c*b)
+        const double f1 = aModFee * bSize;
+        const double f2 = aSize * bModFee;
+        if (f1 == f2)
+            return a.GetTx().GetHash() < b.GetTx().GetHash();
+        return f1 > f2;
+    }
+
+    static void GetModFeeAndSize(const CTxMemPoolEntry& a, double& modFee, double& size)
+    {
+        const double f1 = (double)a.GetModifiedFee() * a.GetSizeWithAncestors();
+        const double f2 = (double)a.GetModFeesWithAncestors() * a.GetTxSize();
+        if (f1 > f2) {
+            modFee = a.GetModFeesWithAncestors();
+            size = a.GetSizeWithAncestors();
+        } else {
+            modFee = a.GetModifiedFee();
+            size = a.GetTxSize();
+        }
+    }
+};
+
+// Tags for the secondary indexes of the pool
+struct descendant_score {};
+struct entry_time {};
+struct ancestor_score {};
+
+typedef boost::multi_index_container<
+    CTxMemPoolEntry,
+    boost::multi_index::indexed_by<
+        // sorted by txid
+        boost::multi_index::ordered_unique<mempoolentry_txid>,
+        // sorted by fee rate, for eviction
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<descendant_score>,
+            boost::multi_index::identity<CTxMemPoolEntry>,
+            CompareTxMemPoolEntryByDescendantScore>,
+        // sorted by entry time
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<entry_time>,
+            boost::multi_index::identity<CTxMemPoolEntry>,
+            CompareTxMemPoolEntryByEntryTime>,
+        // sorted by fee rate with ancestors, for block templates
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<ancestor_score>,
+            boost::multi_index::identity<CTxMemPoolEntry>,
+            CompareTxMemPoolEntryByAncestorScore>
+    >
+> indexed_transaction_set;
+
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain
  * transactions that may be included in the next block.
@@ -51,28 +173,86 @@ public:
  * are added to the pool: if a new transaction double-spends
  * an input of a transaction in the pool, it is dropped,
  * as are non-standard transactions.
+ *
+ * Besides the transactions themselves, the pool links every entry to its
+ * in-pool parents and children, and keeps the count, size and modified fees
+ * of each entry's ancestor and descendant packages up to date as entries
+ * come and go, so that eviction and block assembly can read them from the
+ * secondary indexes of mapTx.
  */
 class CTxMemPool
 {
+public:
+    typedef indexed_transaction_set::nth_index<0>::type::const_iterator txiter;
+    struct CompareIteratorByHash
+    {
+        bool operator()(const txiter& a, const txiter& b) const
+        {
+            return a->GetTx().GetHash() < b->GetTx().GetHash();
+        }
+    };
+    typedef std::set<txiter, CompareIteratorByHash> setEntries;
+
 private:
     bool fSanityCheck_; //! Normally false, true if -checkmempool or -regtest
     uint64_t totalTxSize; //! sum of all mempool tx' byte sizes
 
     std::map<uint256, std::pair<double, CAmount> > mapDeltas;
+    uint64_t cachedInnerUsage; //! sum of dynamic memory usage of the entries' transactions and links
+
+    struct TxLinks
+    {
+        setEntries parents;
+        setEntries children;
+    };
+    typedef std::map<txiter, TxLinks, CompareIteratorByHash> txlinksMap;
+    txlinksMap mapLinks;
+
+    mutable int64_t lastRollingFeeUpdate;
+    mutable bool blockSinceLastRollingFeeBump;
+    mutable double rollingMinimumFeeRate; //! minimum fee rate to get into the pool, decays exponentially
 
     /** Maps bare txid's of transactions to the corresponding mempool entries.
      *  This is used for lookups of outputs available in the mempool instead
      *  of mapTx in case of segwit light.  */
     std::map<uint256, const CTxMemPoolEntry*> mapBareTxid;
 
+    /** The entry whose outputs are spent through the given outpoint hash, so
+     *  that the links between entries agree with CCoinsViewMemPool on which
+     *  in-pool transaction an input refers to.  Requires cs.  */
+    txiter lookupOutpointEntry(const uint256& hash) const;
+
     void removeConflicts(const CTransaction& tx, std::list<CTransaction>& removed);
+    void trackPackageRemoved(const CFeeRate& rate);
+
+    void UpdateParent(txiter entry, txiter parent, bool add);
+    void UpdateChild(txiter entry, txiter child, bool add);
+    /** Adds or removes the entry to or from the descendant statistics of its ancestors */
+    void UpdateAncestorsOf(bool add, txiter it, const setEntries& ancestors);
+    /** Sets the ancestor statistics of a new entry */
+    void UpdateEntryForAncestors(txiter it, const setEntries& ancestors);
+    /** Recomputes both package statistics of an entry by walking its links */
+    void RecomputePackageStatistics(txiter it);
+    /** Sets the fee delta of an entry and carries the change over to its packages */
+    void UpdateFeeDelta(txiter it, CAmount feeDelta);
+    void UpdateForRemoveFromMempool(const setEntries& entriesToRemove, bool updateDescendants);
+    void UpdateChildrenForRemoval(txiter entry);
+    void removeUnchecked(txiter entry, std::list<CTransaction>& removed);
+    /** Removes a set of entries that contains all of its members' descendants
+     *  unless updateDescendants is set, in which case the descendants left in
+     *  the pool get their ancestor statistics updated.  */
+    void RemoveStaged(const setEntries& stage, bool updateDescendants, std::list<CTransaction>& removed);
 
     int64_t timeOfLastChainTipUpdate_;
+    uint64_t nTransactionsUpdated; //! bumped whenever the contents or the prioritisation of the pool change
 public:
     mutable CCriticalSection cs;
-    std::map<uint256, CTxMemPoolEntry> mapTx;
+    indexed_transaction_set mapTx;
     std::map<COutPoint, CInPoint> mapNextTx;
 
+    /** Time in seconds after which the rolling minimum fee has halved */
+    static const int ROLLING_FEE_HALFLIFE = 60 * 60 * 12;
+
     int64_t getLastTimeOfChainTipUpdate() const
     {
         return timeOfLastChainTipUpdate_;
@@ -101,11 +281,19 @@ public:
     void queryHashes(std::vector<uint256>& vtxid);
     void pruneSpent(const uint256& hash, CCoins& coins) const;
 
+    const setEntries& GetMemPoolParents(txiter entry) const;
+    const setEntries& GetMemPoolChildren(txiter entry) const;
+    /** All in-pool ancestors of an entry, not including itself */
+    void CalculateMemPoolAncestors(txiter entry, setEntries& ancestors) const;
+    /** An entry and all of its in-pool descendants, added to descendants */
+    void CalculateDescendants(txiter entry, setEntries& descendants) const;
+
     /** Affect CreateNewBlock prioritisation of transactions */
     bool IsPrioritizedTransaction(const uint256 hash);
     void PrioritiseTransaction(const uint256 hash, const CAmount nFeeDelta);
     void ApplyDeltas(const uint256 hash, double& dPriorityDelta, CAmount& nFeeDelta);
     void ClearPrioritisation(const uint256 hash);
+    void queryFeeDeltas(std::map<uint256, CAmount>& feeDeltas) const;
 
     unsigned long size()
     {
@@ -117,6 +305,24 @@ public:
         LOCK(cs);
         return totalTxSize;
     }
+    /** Changes whenever transactions enter or leave the pool, or their
+     *  prioritisation does, so that derived data can be cached against it.  */
+    uint64_t GetTransactionsUpdated() const
+    {
+        LOCK(cs);
+        return nTransactionsUpdated;
+    }
+
+    /** Memory used by the pool entries and all of the pool's indexes */
+    size_t DynamicMemoryUsage() const;
+
+    /** The minimum fee rate to get into the pool, raised when transactions
+     *  are evicted to stay below sizelimit bytes and decaying afterwards.  */
+    CFeeRate GetMinFee(size_t sizelimit) const;
+
+    /** Evicts the lowest fee rate transactions, together with everything
+     *  spending them, until DynamicMemoryUsage() <= sizelimit.  */
+    void TrimToSize(size_t sizelimit, std::list<CTransaction>& removed);
 
     bool exists(const uint256& hash) const
     {
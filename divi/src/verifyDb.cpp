@@ -32,7 +32,7 @@ CVerifyDB::CVerifyDB(
     const CCoinsView& coinView,
     const CSporkManager& sporkManager,
     CClientUIInterface& clientInterface,
-    const unsigned& coinsCacheSize,
+    const size_t& coinsCacheUsage,
     ShutdownListener shutdownListener
     ): blockDiskReader_(new BlockDiskDataReader())
     , coinView_(coinView)
@@ -52,7 +52,7 @@ CVerifyDB::CVerifyDB(
             true))
     , activeChain_(chainstate.ActiveChain())
     , clientInterface_(clientInterface)
-    , coinsCacheSize_(coinsCacheSize)
+    , coinsCacheUsage_(coinsCacheUsage)
     , shutdownListener_(shutdownListener)
 {
     clientInterface_.ShowProgress(translate("Verifying blocks..."), 0);
@@ -68,7 +68,7 @@ bool CVerifyDB::VerifyDB(int nCheckLevel, int nCheckDepth) const
     if (activeChain_.Tip() == NULL || activeChain_.Tip()->pprev == NULL)
         return true;
 
-    const unsigned coinsTipCacheSize = chainstate_.CoinsTip().GetCacheSize();
+    const size_t coinsTipCacheUsage = chainstate_.CoinsTip().DynamicMemoryUsage();
     // Verify blocks in the best chain
     if (nCheckDepth <= 0)
         nCheckDepth = 1000000000; // suffices until the year 19000
@@ -105,10 +105,10 @@ bool CVerifyDB::VerifyDB(int nCheckLevel, int nCheckDepth) const
             }
         }
         // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
-        const unsigned int coinCacheSize = coinsViewCache_->GetCacheSize();
+        const size_t coinCacheUsage = coinsViewCache_->DynamicMemoryUsage();
         if (nCheckLevel >= 3 &&
             pindex == pindexState &&
-            (coinCacheSize + coinsTipCacheSize) <= coinsCacheSize_)
+            (coinCacheUsage + coinsTipCacheUsage) <= coinsCacheUsage_)
         {
             if (!blockConnectionService_->DisconnectBlock(state, pindex, true).second)
                 return error("VerifyDB() : *** inconsistency in block data at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash());
@@ -38,7 +38,7 @@ private:
     std::unique_ptr<const BlockConnectionService> blockConnectionService_;
     const CChain& activeChain_;
     CClientUIInterface& clientInterface_;
-    const unsigned coinsCacheSize_;
+    const size_t coinsCacheUsage_;
     ShutdownListener shutdownListener_;
 public:
     CVerifyDB(
@@ -49,7 +49,7 @@ public:
         const CCoinsView& coinView,
         const CSporkManager& sporkManager,
         CClientUIInterface& clientInterface,
-        const unsigned& coinsCacheSize,
+        const size_t& coinsCacheUsage,
         ShutdownListener shutdownListener);
     ~CVerifyDB();
     bool VerifyDB(int nCheckLevel, int nCheckDepth) const;
@@ -20,6 +20,12 @@ static constexpr int GETHEADERS_VERSION = 70077;
 //! disconnect from peers older than this proto version
 static constexpr int MIN_PEER_PROTO_VERSION_AFTER_ENFORCEMENT = 70915;
 
+//! "getheaders" is answered with "headers", blocks are then downloaded from several peers
+static constexpr int HEADERS_FIRST_SYNC_VERSION = 70916;
+
+//! new blocks can be requested as "cmpctblock", with "getblocktxn" for transactions missing from the mempool
+static constexpr int COMPACT_BLOCKS_VERSION = 70917;
+
 //! nTime field added to CAddress, starting with this version;
 //! if possible, avoid requesting addresses nodes older than this
 static constexpr int CADDR_TIME_VERSION = 31402;
@@ -191,6 +191,7 @@ CWallet::CWallet(
     , setExternalKeyPool()
     , walletStakingOnly(false)
     , defaultKeyPoolTopUp_(defaultKeyTopUp)
+    , stakableCoinsVersion_(0u)
 {
 }
 
@@ -672,6 +673,7 @@ bool CWallet::AddCScript(const CScript& redeemScript)
     if (!CCryptoKeyStore::AddCScript(redeemScript))
         return false;
 
+    ++stakableCoinsVersion_;
     return walletDatabaseEndpointFactory_.getDatabaseEndpoint()->WriteCScript(Hash160(redeemScript), redeemScript);
 }
 
@@ -1279,6 +1281,7 @@ bool CWallet::addToWallet(const CWalletTx& wtxIn,bool blockDisconnection)
     cachedUtxoBalanceCalculator_->recomputeCachedTxEntries(wtx);
     cachedTxDeltasCalculator_->recomputeCachedTxEntries(wtx);
 
+    ++stakableCoinsVersion_;
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(wtxIn.GetHash(), (transactionHashIsNewToWallet) ? TransactionNotificationType::NEW : TransactionNotificationType::UPDATED);
     return true;
@@ -1430,8 +1433,14 @@ void CWallet::AvailableCoins(
     availableUtxoCollector_->setCoinTypeAndGetAvailableUtxos(fOnlyConfirmed, nCoinType, vCoins);
 }
 
-bool CWallet::SelectStakeCoins(std::set<StakableCoin>& setCoins) const
+bool CWallet::SelectStakeCoins(std::set<StakableCoin>& setCoins, StakeCoinsSelectionValidity& validity) const
 {
+    LOCK2(cs_main, cs_wallet);
+    validity = StakeCoinsSelectionValidity();
+    validity.walletVersion = stakableCoinsVersion_;
+    const int chainHeight = activeChain_.Height();
+    const int64_t adjustedTime = GetAdjustedTime();
+
     CAmount nTargetAmount = GetStakingBalance();
     std::vector<COutput> vCoins;
     AvailableCoins(vCoins, true,  AvailableCoinsType::STAKABLE_COINS);
@@ -1449,12 +1458,19 @@ bool CWallet::SelectStakeCoins(std::set<StakableCoin>& setCoins) const
         const int64_t nTxTime = mit->second->GetBlockTime();
 
         //check for min age
-        if (std::max(int64_t(0),GetAdjustedTime() - nTxTime) < Params().GetMinCoinAgeForStaking())
+        if (std::max(int64_t(0),adjustedTime - nTxTime) < Params().GetMinCoinAgeForStaking())
+        {
+            validity.nextCoinAgeTime = std::min(validity.nextCoinAgeTime, nTxTime + Params().GetMinCoinAgeForStaking());
             continue;
+        }
 
         //check that it is matured
-        if (out.nDepth < (out.tx->IsCoinStake() ? Params().COINBASE_MATURITY() : 10))
+        const int requiredDepth = out.tx->IsCoinStake() ? Params().COINBASE_MATURITY() : 10;
+        if (out.nDepth < requiredDepth)
+        {
+            validity.nextMaturityHeight = std::min(validity.nextMaturityHeight, chainHeight + requiredDepth - out.nDepth);
             continue;
+        }
 
         //add to our stake set
         setCoins.emplace(*out.tx, COutPoint(out.tx->GetHash(), out.i), out.tx->hashBlock);
@@ -1463,6 +1479,11 @@ bool CWallet::SelectStakeCoins(std::set<StakableCoin>& setCoins) const
     return true;
 }
 
+uint64_t CWallet::GetStakableCoinsVersion() const
+{
+    return stakableCoinsVersion_;
+}
+
 bool CWallet::HasAgedCoins() const
 {
     if (GetStakingBalance() <= 0)
@@ -1893,6 +1914,7 @@ bool CWallet::CommitTransaction(CWalletTx& wtxNew, CReserveKey& reservekey)
                     }
                     cachedUtxoBalanceCalculator_->recomputeCachedTxEntries(*coinPtr);
                     cachedTxDeltasCalculator_->recomputeCachedTxEntries(*coinPtr);
+                    ++stakableCoinsVersion_;
                     NotifyTransactionChanged(coinPtr->GetHash(), TransactionNotificationType::SPEND_FROM);
                     updated_hashes.insert(txin.prevout.hash);
                 }
@@ -1999,6 +2021,7 @@ void CWallet::loadWhitelistedVaults(const std::vector<SerializedScript>& vaultSc
         {
             if(AddCScript(vaultScript) && ownershipDetector_->isMine(CTxOut(0,vaultScript)) != isminetype::ISMINE_MANAGED_VAULT)
                 RemoveCScript(vaultScript);
+            ++stakableCoinsVersion_;
         }
     }
 }
@@ -2204,6 +2227,7 @@ void CWallet::LockCoin(const COutPoint& output)
 {
     AssertLockHeld(cs_wallet); // setLockedCoins
     setLockedCoins.insert(output);
+    ++stakableCoinsVersion_;
     CWalletTx* txPtr = const_cast<CWalletTx*>(GetWalletTx(output.hash));
     if (txPtr != nullptr)
     {
@@ -2216,12 +2240,14 @@ void CWallet::UnlockCoin(const COutPoint& output)
 {
     AssertLockHeld(cs_wallet); // setLockedCoins
     setLockedCoins.erase(output);
+    ++stakableCoinsVersion_;
 }
 
 void CWallet::UnlockAllCoins()
 {
     AssertLockHeld(cs_wallet); // setLockedCoins
     setLockedCoins.clear();
+    ++stakableCoinsVersion_;
 }
 
 void CWallet::ListLockedCoins(std::vector<COutPoint>& vOutpts)
@@ -8,6 +8,7 @@
 #ifndef BITCOIN_WALLET_H
 #define BITCOIN_WALLET_H
 
+#include <atomic>
 #include <amount.h>
 #include <base58address.h>
 #include <pubkey.h>
@@ -193,6 +194,7 @@ private:
     std::set<int64_t> setExternalKeyPool;
     bool walletStakingOnly;
     int64_t defaultKeyPoolTopUp_;
+    std::atomic<uint64_t> stakableCoinsVersion_;
 
     void deriveNewChildKey(const CKeyMetadata& metadata, CKey& secretRet, uint32_t nAccountIndex, bool fInternal /*= false*/);
     void addTransactions(const TransactionVector& txs, const CBlock* pblock,const TransactionSyncType syncType);
@@ -281,7 +283,8 @@ public:
     bool SetAddressLabel(const CTxDestination& address, const std::string& strName);
 
     bool HasAgedCoins() const override;
-    bool SelectStakeCoins(std::set<StakableCoin>& setCoins) const override;
+    bool SelectStakeCoins(std::set<StakableCoin>& setCoins, StakeCoinsSelectionValidity& validity) const override;
+    uint64_t GetStakableCoinsVersion() const override;
     bool CanStakeCoins() const override;
 
     bool PruneWallet();